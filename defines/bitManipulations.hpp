@@ -15,6 +15,7 @@
  *              splicing the values together.
  *          -   arraynificator, takes a big number and splits it into an array
  *              of bytes.
+ *          -   toBytes/fromBytes, serializes an integer with a given byte order.
  *
  * @version 2020/07/02 - Switch to C++17
  */
@@ -30,6 +31,15 @@
 namespace cep
 {
 
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+//! Order in which the bytes of a value are sent or stored.
+enum class Endianness
+{
+    Little,    //!< Least significant byte first.
+    Big,       //!< Most significant byte first.
+};
+
 /*************************************************************************************************/
 /* Function declarations ----------------------------------------------------------------------- */
 template<typename T>
@@ -148,6 +158,47 @@ constexpr void arraynificator(void* src, size_t len, void* dest)
     }
 }
 
+/**
+ * @brief   Writes the bytes of an integer in a buffer, in the requested order.
+ *
+ * @param   value:  The value to write
+ * @param   dest:   Buffer of at least sizeof(T) bytes
+ * @retval  None
+ */
+template<Endianness E, typename T>
+constexpr void toBytes(T value, uint8_t* dest)
+{
+    static_assert(std::is_integral_v<T>, "toBytes requires an integral type");
+    using U = std::make_unsigned_t<T>;
+
+    U v = static_cast<U>(value);
+    for (size_t i = 0; i < sizeof(T); i++)
+    {
+        size_t idx = (E == Endianness::Little) ? i : (sizeof(T) - 1 - i);
+        dest[idx]  = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+/**
+ * @brief   Reads an integer from a buffer holding its bytes in the given order.
+ *
+ * @param   src:    Buffer of at least sizeof(T) bytes
+ * @retval  The value
+ */
+template<Endianness E, typename T>
+constexpr T fromBytes(const uint8_t* src)
+{
+    static_assert(std::is_integral_v<T>, "fromBytes requires an integral type");
+    using U = std::make_unsigned_t<T>;
+
+    U v = 0;
+    for (size_t i = 0; i < sizeof(T); i++)
+    {
+        size_t idx = (E == Endianness::Little) ? i : (sizeof(T) - 1 - i);
+        v |= static_cast<U>(static_cast<U>(src[idx]) << (8 * i));
+    }
+    return static_cast<T>(v);
+}
 
 /*************************************************************************************************/
 }    // namespace cep
@@ -0,0 +1,180 @@
+/**
+ * @addtogroup defines
+ * @{
+ * @addtogroup inplaceFunction
+ * @{
+ * @file    inplaceFunction.hpp
+ * @author  Samuel Martel
+ * @date    2021/11/09
+ *
+ * @brief   Type-erased callable that never allocates.
+ *
+ * Works like std::function, except that the callable is stored inside the object itself. Trying
+ * to store a callable that is bigger than the storage fails at compile time instead of going to
+ * the heap, which makes it safe to construct, copy and call from an interrupt.
+ */
+#pragma once
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cep
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+//! Default storage size, large enough for a lambda capturing a few pointers or a std::function.
+static constexpr size_t INPLACE_FUNCTION_DEFAULT_CAPACITY = 4 * sizeof(void*);
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+template<typename Signature, size_t Capacity = INPLACE_FUNCTION_DEFAULT_CAPACITY>
+class InplaceFunction;
+
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+public:
+    InplaceFunction() = default;
+    InplaceFunction(std::nullptr_t) {}
+
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InplaceFunction>>>
+    InplaceFunction(F&& f)
+    {
+        using Callable = std::decay_t<F>;
+        static_assert(sizeof(Callable) <= Capacity,
+                      "Callable is too big for this InplaceFunction's storage");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t),
+                      "Callable is over-aligned for this InplaceFunction's storage");
+        static_assert(std::is_invocable_r_v<R, Callable&, Args...>,
+                      "Callable doesn't match the InplaceFunction's signature");
+
+        new (&m_storage) Callable(std::forward<F>(f));
+        m_invoke = &Invoke<Callable>;
+        m_manage = &Manage<Callable>;
+    }
+
+    InplaceFunction(const InplaceFunction& other) { CopyFrom(other); }
+    InplaceFunction(InplaceFunction&& other) noexcept { MoveFrom(other); }
+
+    ~InplaceFunction() { Reset(); }
+
+    InplaceFunction& operator=(const InplaceFunction& other)
+    {
+        if (this != &other)
+        {
+            Reset();
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator=(std::nullptr_t)
+    {
+        Reset();
+        return *this;
+    }
+
+    R operator()(Args... args) const
+    {
+        return m_invoke(const_cast<void*>(static_cast<const void*>(&m_storage)),
+                        std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const { return m_invoke != nullptr; }
+
+    void Reset()
+    {
+        if (m_manage != nullptr)
+        {
+            m_manage(Operation::Destroy, &m_storage, nullptr);
+        }
+        m_invoke = nullptr;
+        m_manage = nullptr;
+    }
+
+private:
+    enum class Operation
+    {
+        Copy,
+        Move,
+        Destroy,
+    };
+
+    using InvokeFn = R (*)(void*, Args&&...);
+    using ManageFn = void (*)(Operation, void*, const void*);
+
+    template<typename Callable>
+    static R Invoke(void* storage, Args&&... args)
+    {
+        return (*static_cast<Callable*>(storage))(std::forward<Args>(args)...);
+    }
+
+    template<typename Callable>
+    static void Manage(Operation op, void* dst, const void* src)
+    {
+        switch (op)
+        {
+            case Operation::Copy:
+                new (dst) Callable(*static_cast<const Callable*>(src));
+                break;
+            case Operation::Move:
+                new (dst) Callable(std::move(*static_cast<Callable*>(const_cast<void*>(src))));
+                static_cast<Callable*>(const_cast<void*>(src))->~Callable();
+                break;
+            case Operation::Destroy:
+                static_cast<Callable*>(dst)->~Callable();
+                break;
+        }
+    }
+
+    void CopyFrom(const InplaceFunction& other)
+    {
+        if (other.m_manage != nullptr)
+        {
+            other.m_manage(Operation::Copy, &m_storage, &other.m_storage);
+        }
+        m_invoke = other.m_invoke;
+        m_manage = other.m_manage;
+    }
+
+    void MoveFrom(InplaceFunction& other)
+    {
+        if (other.m_manage != nullptr)
+        {
+            other.m_manage(Operation::Move, &m_storage, &other.m_storage);
+        }
+        m_invoke       = other.m_invoke;
+        m_manage       = other.m_manage;
+        other.m_invoke = nullptr;
+        other.m_manage = nullptr;
+    }
+
+private:
+    std::aligned_storage_t<Capacity, alignof(std::max_align_t)> m_storage;
+
+    InvokeFn m_invoke = nullptr;
+    ManageFn m_manage = nullptr;
+};
+
+
+/*************************************************************************************************/
+}    // namespace cep
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
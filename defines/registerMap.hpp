@@ -0,0 +1,177 @@
+/**
+ * @addtogroup defines
+ * @{
+ * @addtogroup registerMap
+ * @{
+ * @file    registerMap.hpp
+ * @author  Samuel Martel
+ * @date    2021/11/18
+ *
+ * @brief   Shadow copy of a device's registers, written back only when they change.
+ *
+ * Drivers update the shadow with @ref RegisterMap::Set and @ref RegisterMap::Modify, which only
+ * mark a register as dirty if its value actually changes. @ref RegisterMap::Flush then writes the
+ * dirty registers, merging contiguous ones into a single burst for devices that auto-increment
+ * their register address.
+ */
+#pragma once
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+namespace cep
+{
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+/**
+ * @brief   Shadow copy of `N` consecutive 8-bit registers.
+ *
+ * Registers are accessed by their address on the device. Every register starts dirty, since the
+ * shadow doesn't know what the device holds until it has been flushed once.
+ *
+ * Addresses that don't exist on the device can be part of the map as long as they are declared
+ * with @ref RegisterMap::Reserve, they are then never written. Bursts stop at them.
+ *
+ * The class is not protected against concurrent access.
+ *
+ * @tparam  N   Number of registers in the map.
+ */
+template<size_t N>
+class RegisterMap
+{
+    static_assert(N != 0, "A RegisterMap must hold at least one register");
+
+public:
+    //! @param  baseAddress Address of the first register of the map.
+    explicit RegisterMap(uint16_t baseAddress = 0) : m_base(baseAddress) { m_dirty.set(); }
+
+    [[nodiscard]] static constexpr size_t Size() { return N; }
+    [[nodiscard]] constexpr uint16_t      GetBaseAddress() const { return m_base; }
+    [[nodiscard]] constexpr bool          Contains(uint16_t address) const
+    {
+        return (address >= m_base) && ((size_t)(address - m_base) < N);
+    }
+
+    [[nodiscard]] uint8_t Get(uint16_t address) const { return m_values[address - m_base]; }
+
+    /**
+     * @brief   Changes the shadow value of a register.
+     * @return  True if the value changed, in which case the register is now dirty.
+     */
+    bool Set(uint16_t address, uint8_t value)
+    {
+        size_t i = address - m_base;
+        if ((m_values[i] == value) || m_reserved.test(i))
+        {
+            return false;
+        }
+        m_values[i] = value;
+        m_dirty.set(i);
+        return true;
+    }
+
+    /**
+     * @brief   Changes the bits of a register selected by `mask`.
+     * @return  True if the value changed, in which case the register is now dirty.
+     */
+    bool Modify(uint16_t address, uint8_t mask, uint8_t value)
+    {
+        return Set(address, (uint8_t)((Get(address) & ~mask) | (value & mask)));
+    }
+
+    //! Declares `count` addresses starting at `address` as not being registers of the device.
+    void Reserve(uint16_t address, size_t count = 1)
+    {
+        for (size_t i = address - m_base; (i < N) && (count != 0); i++, count--)
+        {
+            m_reserved.set(i);
+            m_dirty.reset(i);
+        }
+    }
+
+    //! Forces `count` registers starting at `address` to be written on the next flush.
+    void MarkDirty(uint16_t address, size_t count = 1)
+    {
+        for (size_t i = address - m_base; (i < N) && (count != 0); i++, count--)
+        {
+            m_dirty.set(i);
+        }
+        m_dirty &= ~m_reserved;
+    }
+
+    //! Forces every register to be written on the next flush, after a reset of the device for
+    //! example.
+    void MarkAllDirty() { m_dirty = ~m_reserved; }
+
+    [[nodiscard]] bool IsDirty(uint16_t address) const { return m_dirty.test(address - m_base); }
+    [[nodiscard]] bool IsAnyDirty() const { return m_dirty.any(); }
+
+    //! Values of all the registers, the first one being at the base address.
+    [[nodiscard]] const uint8_t* Data() const { return m_values.data(); }
+
+    /**
+     * @brief   Writes the dirty registers to the device.
+     *
+     * Consecutive dirty registers are written by a single call to `writer`. A burst never crosses
+     * a multiple of `pageSize`, for devices whose auto-increment wraps around at the end of a bank
+     * or of a page. A `pageSize` of 1 writes the registers one at a time, 0 doesn't limit bursts.
+     *
+     * Registers are marked clean as soon as `writer` returns true. The flush stops at the first
+     * failure, leaving the remaining registers dirty for the next attempt.
+     *
+     * `writer` has the signature `bool(uint16_t address, const uint8_t* data, size_t count)`.
+     * `data` points into the map and holds the values of the `count` registers starting at
+     * `address`, it must return false if the write failed.
+     *
+     * @param   writer      Called once per burst.
+     * @param   pageSize    Alignment that bursts can't cross.
+     * @return  True if every dirty register was written.
+     */
+    template<typename Writer>
+    bool Flush(Writer&& writer, size_t pageSize = 0)
+    {
+        size_t i = 0;
+        while (i < N)
+        {
+            if (!m_dirty.test(i))
+            {
+                i++;
+                continue;
+            }
+
+            size_t end = i + 1;
+            while ((end < N) && m_dirty.test(end) &&
+                   ((pageSize == 0) || (((size_t)m_base + end) % pageSize) != 0))
+            {
+                end++;
+            }
+
+            if (!writer((uint16_t)(m_base + i), &m_values[i], end - i))
+            {
+                return false;
+            }
+
+            for (; i < end; i++)
+            {
+                m_dirty.reset(i);
+            }
+        }
+
+        return true;
+    }
+
+private:
+    uint16_t               m_base   = 0;
+    std::array<uint8_t, N> m_values = {};
+    std::bitset<N>         m_dirty;
+    std::bitset<N>         m_reserved;
+};
+}    // namespace cep
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,120 @@
+/**
+ * @addtogroup defines
+ * @{
+ * @addtogroup ringBuffer
+ * @{
+ * @file    ringBuffer.hpp
+ * @author  Samuel Martel
+ * @date    2021/11/10
+ *
+ * @brief   Fixed-size, allocation-free FIFO shared between one producer and one consumer.
+ *
+ * The producer (typically an interrupt) and the consumer (typically the main loop) can both use
+ * the buffer at the same time without disabling interrupts, as long as there is only one of each.
+ *
+ * Items can be pushed one at a time, or written directly in place with @ref RingBuffer::Slot and
+ * made visible to the consumer all at once with @ref RingBuffer::Commit.
+ */
+#pragma once
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace cep
+{
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+template<typename T, size_t N>
+class RingBuffer
+{
+    static_assert((N != 0) && ((N & (N - 1)) == 0), "RingBuffer size must be a power of two");
+
+public:
+    [[nodiscard]] static constexpr size_t Capacity() { return N; }
+
+    [[nodiscard]] size_t Size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+    [[nodiscard]] size_t Free() const { return N - Size(); }
+    [[nodiscard]] bool   Empty() const { return Size() == 0; }
+    [[nodiscard]] bool   Full() const { return Size() == N; }
+
+    /*********************************************************************************************/
+    /* Producer side */
+    /**
+     * @brief   Adds an item at the end of the buffer.
+     * @return  True if the item was added, false if the buffer is full.
+     */
+    bool Push(const T& item)
+    {
+        if (Full())
+        {
+            return false;
+        }
+        Slot(0) = item;
+        Commit(1);
+        return true;
+    }
+
+    /**
+     * @brief   Gets the free slot `offset` positions after the end of the buffer.
+     *
+     * The item written in the slot is not visible to the consumer until it is committed.
+     * `offset` must be smaller than @ref Free.
+     */
+    T& Slot(size_t offset)
+    {
+        return m_buffer[(m_head.load(std::memory_order_relaxed) + offset) & MASK];
+    }
+
+    /**
+     * @brief   Makes the next `count` slots visible to the consumer.
+     */
+    void Commit(size_t count)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    /*********************************************************************************************/
+    /* Consumer side */
+    /**
+     * @brief   Removes the oldest item of the buffer.
+     * @return  True if an item was removed, false if the buffer is empty.
+     */
+    bool Pop(T& item)
+    {
+        if (Empty())
+        {
+            return false;
+        }
+        item = Front();
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Oldest item of the buffer. The buffer must not be empty.
+    const T& Front() const { return m_buffer[m_tail.load(std::memory_order_relaxed) & MASK]; }
+
+    void Clear() { m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+    static constexpr size_t MASK = N - 1;
+
+    std::array<T, N> m_buffer = {};
+
+    //! Both indices only ever increase, they are masked when accessing the buffer.
+    std::atomic<size_t> m_head = 0;
+    std::atomic<size_t> m_tail = 0;
+};
+
+
+/*************************************************************************************************/
+}    // namespace cep
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,91 @@
+/**
+ * @addtogroup defines
+ * @{
+ * @addtogroup span
+ * @{
+ * @file    span.hpp
+ * @author  Samuel Martel
+ * @date    2021/11/17
+ *
+ * @brief   Non-owning view over a contiguous sequence of objects, until C++20's std::span.
+ *
+ * Lets an API take a buffer from a C array, an std::array, an std::vector or a pointer and a
+ * length without copying it or allocating.
+ */
+#pragma once
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace cep
+{
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+template<typename T>
+class Span
+{
+public:
+    constexpr Span() noexcept = default;
+    constexpr Span(T* data, size_t size) noexcept : m_data(data), m_size(size) {}
+
+    template<size_t N>
+    constexpr Span(T (&array)[N]) noexcept : m_data(array), m_size(N)
+    {
+    }
+
+    template<typename U, size_t N, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr Span(std::array<U, N>& array) noexcept : m_data(array.data()), m_size(N)
+    {
+    }
+
+    template<typename U, size_t N, typename = std::enable_if_t<std::is_convertible_v<const U (*)[], T (*)[]>>>
+    constexpr Span(const std::array<U, N>& array) noexcept : m_data(array.data()), m_size(N)
+    {
+    }
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    Span(std::vector<U>& vector) noexcept : m_data(vector.data()), m_size(vector.size())
+    {
+    }
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<const U (*)[], T (*)[]>>>
+    Span(const std::vector<U>& vector) noexcept : m_data(vector.data()), m_size(vector.size())
+    {
+    }
+
+    //! Span<T> converts to Span<const T>.
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr Span(const Span<U>& other) noexcept : m_data(other.data()), m_size(other.size())
+    {
+    }
+
+    /* These methods do not respect CEP's naming convention because they mirror std::span. */
+    [[nodiscard]] constexpr T*     data() const noexcept { return m_data; }
+    [[nodiscard]] constexpr size_t size() const noexcept { return m_size; }
+    [[nodiscard]] constexpr bool   empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] constexpr T*     begin() const noexcept { return m_data; }
+    [[nodiscard]] constexpr T*     end() const noexcept { return m_data + m_size; }
+    constexpr T&                   operator[](size_t i) const { return m_data[i]; }
+
+    [[nodiscard]] constexpr Span first(size_t count) const { return Span(m_data, count); }
+    //! The `count` elements starting at `offset`, or all of them up to the end if `count` is
+    //! omitted. `offset` must be within the span.
+    [[nodiscard]] constexpr Span subspan(size_t offset, size_t count = SIZE_MAX) const
+    {
+        return Span(m_data + offset, count > (m_size - offset) ? (m_size - offset) : count);
+    }
+
+private:
+    T*     m_data = nullptr;
+    size_t m_size = 0;
+};
+}    // namespace cep
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
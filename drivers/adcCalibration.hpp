@@ -0,0 +1,256 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  adc
+ * @{
+ * @file        adcCalibration.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/23
+ *
+ * @brief       Fixed-point conversion of raw ADC samples to calibrated values.
+ *
+ * Each channel converts its samples with either a gain and an offset, or a piecewise-linear table
+ * for sensors and front-ends that aren't linear. Both only use integer operations and produce
+ * values in Q16.16: the integer part in the upper 16 bits, the fraction in the lower 16 bits.
+ * The unit is whatever the calibration was built with, volts by default.
+ */
+#ifndef ADC_CALIBRATION_HPP_
+#define ADC_CALIBRATION_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_ADC) || defined(NILAI_TEST)
+#include "drivers/adcStream.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace CEP_ADC
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+//! Number of fractional bits of the calibrated values.
+static constexpr int Q_FRAC = 16;
+//! Number of fractional bits of a linear calibration's gain, on top of Q_FRAC.
+static constexpr int GAIN_FRAC = 16;
+
+//! A calibrated value, in Q16.16.
+using q16_t = int32_t;
+
+constexpr q16_t ToQ16(float value)
+{
+    return (q16_t)(value * (float)(1 << Q_FRAC) + (value < 0.0f ? -0.5f : 0.5f));
+}
+
+constexpr float ToFloat(q16_t value)
+{
+    return (float)value / (float)(1 << Q_FRAC);
+}
+
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+/**
+ * @brief   value = raw * gain + offset.
+ */
+struct LinearCalibration
+{
+    //! Value of one LSB, in Q16.16 with GAIN_FRAC more fractional bits. Limited to ±0.5 per LSB,
+    //! which is plenty for 12-bit conversions of a few volts.
+    int32_t gain   = 0;
+    q16_t   offset = 0;
+
+    static constexpr LinearCalibration FromFloat(float valuePerLsb, float offsetValue = 0.0f)
+    {
+        LinearCalibration cal;
+        cal.gain   = (int32_t)(valuePerLsb * (float)(1ULL << (Q_FRAC + GAIN_FRAC)) + 0.5f);
+        cal.offset = ToQ16(offsetValue);
+        return cal;
+    }
+
+    /**
+     * @brief   Two-point calibration, from the readings of two known values.
+     *
+     * `raw1` and `raw2` must differ.
+     */
+    static constexpr LinearCalibration FromPoints(uint16_t raw1,
+                                                  float    value1,
+                                                  uint16_t raw2,
+                                                  float    value2)
+    {
+        float valuePerLsb = (value2 - value1) / (float)((int32_t)raw2 - (int32_t)raw1);
+        return FromFloat(valuePerLsb, value1 - (valuePerLsb * (float)raw1));
+    }
+
+    //! @param  extraBits   Number of bits the reading has on top of the calibrated resolution,
+    //!                     for oversampled readings.
+    [[nodiscard]] constexpr q16_t Apply(uint16_t raw, uint8_t extraBits = 0) const
+    {
+        return (q16_t)(((int64_t)raw * gain) >> (GAIN_FRAC + extraBits)) + offset;
+    }
+};
+
+/**
+ * @brief   Calibration point: the value measured for a reading.
+ */
+struct CalibrationPoint
+{
+    uint16_t raw   = 0;
+    float    value = 0.0f;
+};
+
+/**
+ * @brief   Piecewise-linear calibration over equally spaced segments.
+ *
+ * The range of the ADC is split in @ref SEGMENTS segments of the same width, which makes finding
+ * the segment of a sample a shift instead of a search. The table is built once from calibration
+ * points at any position, the values between them being interpolated.
+ */
+class PiecewiseCalibration
+{
+public:
+    static constexpr size_t SEGMENTS = 16;
+
+    /**
+     * @brief   Builds the table from calibration points.
+     * @param   points      Sorted by increasing reading, at least two of them.
+     * @param   count       Number of points.
+     * @param   resolution  Number of bits of the samples, 12 for a plain STM32 conversion.
+     * @return  False if the points can't be used.
+     */
+    bool Build(const CalibrationPoint* points, size_t count, uint8_t resolution = 12)
+    {
+        if ((count < 2) || (resolution < 4) || (resolution > 16))
+        {
+            return false;
+        }
+        for (size_t i = 1; i < count; i++)
+        {
+            if (points[i].raw <= points[i - 1].raw)
+            {
+                return false;
+            }
+        }
+
+        m_shift = (uint8_t)(resolution - 4);
+        size_t segment = 0;
+        for (size_t i = 0; i < m_table.size(); i++)
+        {
+            // Breakpoints past the last point extrapolate the last segment.
+            int32_t raw = (int32_t)(i << m_shift);
+            while ((segment < count - 2) && (raw > points[segment + 1].raw))
+            {
+                segment++;
+            }
+
+            const CalibrationPoint& a = points[segment];
+            const CalibrationPoint& b = points[segment + 1];
+            float slope = (b.value - a.value) / (float)(b.raw - a.raw);
+            m_table[i]  = ToQ16(a.value + (slope * (float)(raw - (int32_t)a.raw)));
+        }
+        return true;
+    }
+
+    //! @param  extraBits   Number of bits the reading has on top of the table's resolution, for
+    //!                     oversampled readings.
+    [[nodiscard]] q16_t Apply(uint16_t raw, uint8_t extraBits = 0) const
+    {
+        int     shift = m_shift + extraBits;
+        size_t  i     = raw >> shift;
+        int32_t frac  = raw & ((1 << shift) - 1);
+        return m_table[i] + (q16_t)(((int64_t)(m_table[i + 1] - m_table[i]) * frac) >> shift);
+    }
+
+private:
+    //! Value at the start of each segment, plus the end of the last one.
+    std::array<q16_t, SEGMENTS + 1> m_table = {};
+    uint8_t                         m_shift = 8;
+};
+
+/**
+ * @brief   Calibration of a channel, linear or piecewise.
+ *
+ * A piecewise calibration only holds a pointer to its table, which must outlive it.
+ */
+class ChannelCalibration
+{
+public:
+    //! Defaults to the full scale of a 12-bit conversion being 3.3V.
+    ChannelCalibration() = default;
+    ChannelCalibration(const LinearCalibration& linear) : m_linear(linear) {}
+    ChannelCalibration(const PiecewiseCalibration* table) : m_table(table) {}
+
+    [[nodiscard]] bool IsLinear() const { return m_table == nullptr; }
+
+    [[nodiscard]] q16_t Apply(uint16_t raw, uint8_t extraBits = 0) const
+    {
+        return m_table == nullptr ? m_linear.Apply(raw, extraBits)
+                                  : m_table->Apply(raw, extraBits);
+    }
+
+    /**
+     * @brief   Converts `count` samples taken `stride` samples apart.
+     */
+    void Apply(const uint16_t* raw, size_t stride, q16_t* out, size_t outStride, size_t count) const
+    {
+        if (m_table != nullptr)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                out[i * outStride] = m_table->Apply(raw[i * stride]);
+            }
+            return;
+        }
+
+        // Hoisting the calibration out of the loop lets the compiler keep it in registers.
+        const int64_t gain   = m_linear.gain;
+        const q16_t   offset = m_linear.offset;
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i * outStride] = (q16_t)((raw[i * stride] * gain) >> GAIN_FRAC) + offset;
+        }
+    }
+
+private:
+    LinearCalibration           m_linear = LinearCalibration::FromFloat(3.3f / 4095.0f);
+    const PiecewiseCalibration* m_table  = nullptr;
+};
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+/**
+ * @brief   Converts every sample of a block.
+ *
+ * @param   block           The block.
+ * @param   calibrations    One calibration per channel of the block.
+ * @param   out             Receives `block.frames * block.channels` values, interleaved like the
+ *                          samples.
+ */
+inline void ConvertBlock(const Block& block, const ChannelCalibration* calibrations, q16_t* out)
+{
+    for (size_t c = 0; c < block.channels; c++)
+    {
+        calibrations[c].Apply(
+          block.samples + c, block.channels, out + c, block.channels, block.frames);
+    }
+}
+
+/**
+ * @brief   Converts every sample of a block to floats, through the fixed-point calibration.
+ */
+inline void ConvertBlock(const Block& block, const ChannelCalibration* calibrations, float* out)
+{
+    size_t count = block.frames * block.channels;
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = ToFloat(calibrations[i % block.channels].Apply(block.samples[i]));
+    }
+}
+}    // namespace CEP_ADC
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,315 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  adc
+ * @{
+ * @file        adcDecimation.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/24
+ *
+ * @brief       Oversampling and decimation of a channel's samples, for more resolution at a lower
+ *              rate.
+ *
+ * Every output sample combines 2^ratioLog2 input samples, with either a plain average (boxcar) or
+ * a CIC filter of order 2 to 4, which attenuates more of what would otherwise alias into the
+ * output. An optional FIR then shapes the output at the decimated rate.
+ *
+ * Averaging 4^n samples gains up to n bits of resolution, provided the signal carries at least
+ * one LSB of noise. The outputs are therefore kept as `inputBits + extraBits` bit values, which
+ * still fit in a 16-bit sample and can be converted by a calibration built for that resolution.
+ */
+#ifndef ADC_DECIMATION_HPP_
+#define ADC_DECIMATION_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_ADC) || defined(NILAI_TEST)
+#include "defines/inplaceFunction.hpp"
+#include "defines/span.hpp"
+#include "drivers/adcStream.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace CEP_ADC
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+static constexpr uint8_t MAX_CIC_ORDER = 4;
+static constexpr size_t  MAX_FIR_TAPS  = 32;
+//! Number of fractional bits of the FIR's taps.
+static constexpr int FIR_FRAC = 15;
+
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+struct DecimationConfig
+{
+    //! Number of input samples per output sample, as a power of two: 4 for 16 samples.
+    uint8_t ratioLog2 = 4;
+    //! 1 for a boxcar, 2 to @ref MAX_CIC_ORDER for a CIC of that order.
+    uint8_t order = 1;
+    //! Resolution of the input samples, right-aligned.
+    uint8_t inputBits = 12;
+    //! Resolution gained, at most 16 - inputBits.
+    uint8_t extraBits = 2;
+    //! Taps of the optional FIR, in Q1.15. The taps are not copied, they must outlive the filter.
+    cep::Span<const int16_t> fir;
+};
+
+/**
+ * @brief   Called from @ref AdcModule::Run with the samples a channel's decimator produced from a
+ *          block, which may be none.
+ */
+using DecimatedCallback = cep::InplaceFunction<void(size_t channel, cep::Span<const uint16_t>)>;
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+/**
+ * @brief   Sums `count` samples taken `stride` samples apart.
+ *
+ * Contiguous samples are loaded two at a time and added lane by lane in a single 32-bit word, for
+ * as many words as the lanes can hold without carrying into each other.
+ *
+ * @param   inputBits   Resolution of the samples, the bits above it must be 0.
+ */
+inline uint32_t SumSamples(const uint16_t* samples, size_t stride, size_t count, uint8_t inputBits)
+{
+    uint32_t sum = 0;
+    if (stride != 1)
+    {
+        uint32_t a = 0;
+        uint32_t b = 0;
+        uint32_t c = 0;
+        uint32_t d = 0;
+        for (; count >= 4; count -= 4)
+        {
+            a += samples[0];
+            b += samples[stride];
+            c += samples[2 * stride];
+            d += samples[3 * stride];
+            samples += 4 * stride;
+        }
+        for (; count != 0; count--)
+        {
+            a += *samples;
+            samples += stride;
+        }
+        return a + b + c + d;
+    }
+
+    if ((((uintptr_t)samples & 2) != 0) && (count != 0))
+    {
+        sum += *samples++;
+        count--;
+    }
+
+    // Each lane holds the sum of one sample out of two, it can take 2^(16 - inputBits) of them.
+    const size_t maxWords = (size_t)1 << (16 - inputBits);
+    auto         load     = [](const uint16_t* p)
+    {
+        uint32_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+    };
+    while (count >= 2)
+    {
+        size_t   words = std::min(count / 2, maxWords);
+        uint32_t lanes = 0;
+        size_t   w     = 0;
+        for (; w + 4 <= words; w += 4)
+        {
+            lanes += load(samples) + load(samples + 2) + load(samples + 4) + load(samples + 6);
+            samples += 8;
+        }
+        for (; w < words; w++)
+        {
+            lanes += load(samples);
+            samples += 2;
+        }
+        sum += (lanes & 0xFFFF) + (lanes >> 16);
+        count -= 2 * words;
+    }
+
+    if (count != 0)
+    {
+        sum += *samples;
+    }
+    return sum;
+}
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+/**
+ * @brief   Decimation pipeline of one channel.
+ *
+ * The state is kept from one call of @ref Process to the next, the stream can be fed in blocks of
+ * any size. A CIC needs `order` outputs to settle and the FIR as many outputs as it has taps,
+ * during which the outputs ramp up from 0.
+ */
+class Decimator
+{
+public:
+    /**
+     * @brief   Sets the decimator up and resets it.
+     * @return  False if the settings are out of range, the decimator is then disabled.
+     */
+    bool Configure(const DecimationConfig& config)
+    {
+        m_isEnabled = false;
+
+        // Gain of the filter, as a power of two.
+        int gainBits = config.order * config.ratioLog2;
+        if ((config.order == 0) || (config.order > MAX_CIC_ORDER) || (config.inputBits == 0) ||
+            (config.inputBits + config.extraBits > 16) || (config.extraBits > gainBits) ||
+            (config.inputBits + gainBits > 32) || (config.fir.size() > MAX_FIR_TAPS))
+        {
+            return false;
+        }
+
+        m_config    = config;
+        m_shift     = (uint8_t)(gainBits - config.extraBits);
+        m_max       = (uint16_t)((1UL << (config.inputBits + config.extraBits)) - 1);
+        m_isEnabled = true;
+        Reset();
+        return true;
+    }
+
+    void Disable() { m_isEnabled = false; }
+
+    //! Clears the state of the filters, like at the start of a new stream.
+    void Reset()
+    {
+        m_count = 0;
+        m_sum   = 0;
+        m_integrators.fill(0);
+        m_combs.fill(0);
+        m_history.fill(0);
+        m_historyPos = 0;
+        m_latest     = 0;
+    }
+
+    [[nodiscard]] bool                    IsEnabled() const { return m_isEnabled; }
+    [[nodiscard]] const DecimationConfig& GetConfig() const { return m_config; }
+    [[nodiscard]] uint32_t GetRatio() const { return (uint32_t)1 << m_config.ratioLog2; }
+    //! Last sample produced.
+    [[nodiscard]] uint16_t GetLatest() const { return m_latest; }
+
+    /**
+     * @brief   Feeds `count` samples taken `stride` samples apart.
+     * @param   out Receives the samples produced, at most `count / ratio + 1` of them.
+     * @return  The number of samples produced.
+     */
+    size_t Process(const uint16_t* samples, size_t stride, size_t count, uint16_t* out)
+    {
+        if (!m_isEnabled)
+        {
+            return 0;
+        }
+
+        const uint32_t ratio    = GetRatio();
+        size_t         produced = 0;
+        if (m_config.order == 1)
+        {
+            while (count != 0)
+            {
+                size_t take = std::min(count, (size_t)(ratio - m_count));
+                m_sum += SumSamples(samples, stride, take, m_config.inputBits);
+                samples += take * stride;
+                count -= take;
+                m_count += (uint32_t)take;
+                if (m_count == ratio)
+                {
+                    out[produced++] = Output(m_sum);
+                    m_sum           = 0;
+                    m_count         = 0;
+                }
+            }
+            return produced;
+        }
+
+        // The integrators wrap around, the combs cancel it as long as the output fits in 32 bits.
+        const size_t last = m_config.order - 1;
+        for (; count != 0; count--, samples += stride)
+        {
+            m_integrators[0] += *samples;
+            for (size_t k = 1; k <= last; k++)
+            {
+                m_integrators[k] += m_integrators[k - 1];
+            }
+
+            if (++m_count == ratio)
+            {
+                m_count    = 0;
+                uint32_t v = m_integrators[last];
+                for (size_t k = 0; k <= last; k++)
+                {
+                    uint32_t d = v - m_combs[k];
+                    m_combs[k] = v;
+                    v          = d;
+                }
+                out[produced++] = Output(v);
+            }
+        }
+        return produced;
+    }
+
+    //! Feeds a channel of a block.
+    size_t Process(const Block& block, size_t channel, uint16_t* out)
+    {
+        return Process(block.samples + channel, block.channels, block.frames, out);
+    }
+
+private:
+    uint16_t Output(uint32_t sum)
+    {
+        // Rounded to the nearest.
+        uint32_t value =
+          (uint32_t)(((uint64_t)sum + ((m_shift == 0) ? 0 : (1ULL << (m_shift - 1)))) >> m_shift);
+
+        if (!m_config.fir.empty())
+        {
+            const size_t taps       = m_config.fir.size();
+            m_historyPos            = (m_historyPos + 1) % taps;
+            m_history[m_historyPos] = (uint16_t)value;
+
+            int64_t acc = 0;
+            size_t  pos = m_historyPos;
+            for (size_t k = 0; k < taps; k++)
+            {
+                acc += (int64_t)m_config.fir[k] * m_history[pos];
+                pos = (pos == 0) ? taps - 1 : pos - 1;
+            }
+            acc   = (acc + (1 << (FIR_FRAC - 1))) >> FIR_FRAC;
+            value = acc < 0 ? 0 : (uint32_t)acc;
+        }
+
+        m_latest = (uint16_t)std::min(value, (uint32_t)m_max);
+        return m_latest;
+    }
+
+private:
+    DecimationConfig m_config;
+    bool             m_isEnabled = false;
+    uint8_t          m_shift     = 0;
+    uint16_t         m_max       = 0;
+
+    //! Number of samples fed since the last output.
+    uint32_t                            m_count       = 0;
+    uint32_t                            m_sum         = 0;
+    std::array<uint32_t, MAX_CIC_ORDER> m_integrators = {};
+    std::array<uint32_t, MAX_CIC_ORDER> m_combs       = {};
+    std::array<uint16_t, MAX_FIR_TAPS>  m_history     = {};
+    size_t                              m_historyPos  = 0;
+    uint16_t                            m_latest      = 0;
+};
+}    // namespace CEP_ADC
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
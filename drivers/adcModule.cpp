@@ -3,29 +3,75 @@
 #include <utility>
 #if defined(NILAI_USE_ADC) && defined(HAL_ADC_MODULE_ENABLED)
 #include "defines/macros.hpp"
+#include "drivers/timerClock.hpp"
 #include "services/logger.hpp"
 
-static constexpr float ConvertToVolt(uint32_t val)
-{
-    return ((static_cast<float>(val) / 4095.0f) * 3.3f);
-}
+// The HAL of the F4 and F7 doesn't include the low-level driver, which reads the sequence.
+#if defined(NILAI_USES_STM32F4xx)
+#include "stm32f4xx_ll_adc.h"
+#elif defined(NILAI_USES_STM32F7xx)
+#include "stm32f7xx_ll_adc.h"
+#endif
+
+#include <algorithm>
+#include <array>
+
+//! Maximum number of ADC modules receiving the HAL's ADC callbacks.
+static constexpr size_t MAX_MODULES = 3;
+
+static std::array<AdcModule*, MAX_MODULES> s_modules = {};
+
+#if defined(NILAI_USES_STM32F4xx) || defined(NILAI_USES_STM32F7xx)
+// A single watchdog, the HAL doesn't use its number.
+static constexpr std::array<uint32_t, CEP_ADC::WATCHDOG_COUNT> WATCHDOG_NUMBERS    = {0};
+static constexpr std::array<uint32_t, CEP_ADC::WATCHDOG_COUNT> WATCHDOG_INTERRUPTS = {ADC_IT_AWD};
+static constexpr std::array<uint32_t, CEP_ADC::WATCHDOG_COUNT> WATCHDOG_FLAGS      = {ADC_FLAG_AWD};
+#else
+static constexpr std::array<uint32_t, CEP_ADC::WATCHDOG_COUNT> WATCHDOG_NUMBERS = {
+  ADC_ANALOGWATCHDOG_1, ADC_ANALOGWATCHDOG_2, ADC_ANALOGWATCHDOG_3};
+static constexpr std::array<uint32_t, CEP_ADC::WATCHDOG_COUNT> WATCHDOG_INTERRUPTS = {
+  ADC_IT_AWD1, ADC_IT_AWD2, ADC_IT_AWD3};
+static constexpr std::array<uint32_t, CEP_ADC::WATCHDOG_COUNT> WATCHDOG_FLAGS = {
+  ADC_FLAG_AWD1, ADC_FLAG_AWD2, ADC_FLAG_AWD3};
+#endif
+
+//! Ranks of the regular sequence, the n-th channel of the module being converted at rank n + 1.
+static constexpr std::array<uint32_t, 16> RANKS = {
+  LL_ADC_REG_RANK_1,  LL_ADC_REG_RANK_2,  LL_ADC_REG_RANK_3,  LL_ADC_REG_RANK_4,
+  LL_ADC_REG_RANK_5,  LL_ADC_REG_RANK_6,  LL_ADC_REG_RANK_7,  LL_ADC_REG_RANK_8,
+  LL_ADC_REG_RANK_9,  LL_ADC_REG_RANK_10, LL_ADC_REG_RANK_11, LL_ADC_REG_RANK_12,
+  LL_ADC_REG_RANK_13, LL_ADC_REG_RANK_14, LL_ADC_REG_RANK_15, LL_ADC_REG_RANK_16};
 
 
 AdcModule::AdcModule(ADC_HandleTypeDef* adc, std::string  label) : m_adc(adc), m_label(std::move(label))
 {
     CEP_ASSERT(adc != nullptr, "[%s]: ADC handle is null!", m_label.c_str());
     m_channelCount = adc->Init.NbrOfConversion;
+    // A word per channel, enough for either width of the DMA's transfers.
     m_channelBuff  = new uint32_t[m_channelCount];
 
     CEP_ASSERT(m_channelBuff != nullptr,
                "[%s]: Unable to allocate memory for channel data buffer!",
                m_label.c_str());
 
+    m_calibrations.resize(m_channelCount);
+    m_decimators.resize(m_channelCount);
+    m_decimatedCallbacks.resize(m_channelCount);
+    m_watchdogs.Reset(GetResolution(adc));
+
+    // Register the module to receive the DMA callbacks of its stream.
+    auto it = std::find(s_modules.begin(), s_modules.end(), nullptr);
+    CEP_ASSERT(it != s_modules.end(), "Too many ADC modules!");
+    *it = this;
+
     LOG_INFO("[%s]: Initialized", m_label.c_str());
 }
 
 AdcModule::~AdcModule()
 {
+    StopStream();
+    std::replace(s_modules.begin(), s_modules.end(), this, static_cast<AdcModule*>(nullptr));
+
     delete[] m_channelBuff;
     m_channelBuff = nullptr;
 }
@@ -49,7 +95,7 @@ bool AdcModule::DoPost()
     bool isAllChannelsOk = true;
     for (size_t i = 0; i < m_channelCount; i++)
     {
-        if (m_channelBuff[i] == 0)
+        if (GetRawReading(i) == 0)
         {
             LOG_ERROR("[%s]: Error in POST: Channel %i reading 0!", m_label.c_str(), i);
             isAllChannelsOk = false;
@@ -59,7 +105,7 @@ bool AdcModule::DoPost()
             LOG_INFO("[%s]: Channel %i reading %0.3fV",
                      m_label.c_str(),
                      i,
-                     ConvertToVolt(m_channelBuff[i]));
+                     GetChannelReading(i));
         }
     }
     Stop();
@@ -71,18 +117,190 @@ bool AdcModule::DoPost()
     return isAllChannelsOk;
 }
 
+void AdcModule::Run()
+{
+    RearmWatchdogs();
+
+    CEP_ADC::Block block;
+    if (m_isStreaming && m_stream.Acquire(block))
+    {
+        Decimate(block);
+        if (m_blockCallback)
+        {
+            m_blockCallback(block);
+        }
+
+        if (!m_stream.Release())
+        {
+            LOG_WARNING("[%s]: Block %i was overwritten while being processed",
+                        m_label.c_str(),
+                        block.sequence);
+        }
+    }
+}
+
 float AdcModule::GetChannelReading(size_t channel) const
+{
+    return CEP_ADC::ToFloat(GetChannelValue(channel));
+}
+
+CEP_ADC::q16_t AdcModule::GetChannelValue(size_t channel) const
 {
     CEP_ASSERT(channel < m_channelCount,
                "[%s] Channel %i is not a valid channel!",
                m_label.c_str(),
                channel);
 
-    return ConvertToVolt(m_channelBuff[channel]);
+    if (m_isStreaming && m_decimators[channel].IsEnabled())
+    {
+        const CEP_ADC::Decimator& decimator = m_decimators[channel];
+        return m_calibrations[channel].Apply(decimator.GetLatest(),
+                                             decimator.GetConfig().extraBits);
+    }
+    return m_calibrations[channel].Apply(GetRawReading(channel));
+}
+
+uint16_t AdcModule::GetRawReading(size_t channel) const
+{
+    if (m_isStreaming)
+    {
+        const uint16_t* frame = m_stream.GetLatestFrame();
+        return frame == nullptr ? 0 : frame[channel];
+    }
+
+    if (m_isHalfWordBuff)
+    {
+        return reinterpret_cast<const uint16_t*>(m_channelBuff)[channel];
+    }
+    return (uint16_t)m_channelBuff[channel];
+}
+
+void AdcModule::SetCalibration(size_t channel, const CEP_ADC::ChannelCalibration& calibration)
+{
+    CEP_ASSERT(channel < m_channelCount,
+               "[%s] Channel %i is not a valid channel!",
+               m_label.c_str(),
+               channel);
+
+    m_calibrations[channel] = calibration;
+}
+
+bool AdcModule::SetDecimation(size_t                            channel,
+                              const CEP_ADC::DecimationConfig&  config,
+                              const CEP_ADC::DecimatedCallback& callback)
+{
+    CEP_ASSERT(channel < m_channelCount,
+               "[%s] Channel %i is not a valid channel!",
+               m_label.c_str(),
+               channel);
+
+    if (!m_decimators[channel].Configure(config))
+    {
+        LOG_ERROR("[%s]: Invalid decimation settings for channel %i", m_label.c_str(), channel);
+        m_decimatedCallbacks[channel] = nullptr;
+        return false;
+    }
+    m_decimatedCallbacks[channel] = callback;
+    return true;
+}
+
+void AdcModule::ClearDecimation(size_t channel)
+{
+    CEP_ASSERT(channel < m_channelCount,
+               "[%s] Channel %i is not a valid channel!",
+               m_label.c_str(),
+               channel);
+
+    m_decimators[channel].Disable();
+    m_decimatedCallbacks[channel] = nullptr;
+}
+
+bool AdcModule::SetWatchdog(size_t                           channel,
+                            const CEP_ADC::Window&           window,
+                            const CEP_ADC::WatchdogCallback& callback)
+{
+    CEP_ASSERT(channel < m_channelCount,
+               "[%s] Channel %i is not a valid channel!",
+               m_label.c_str(),
+               channel);
+    CEP_ASSERT(channel < RANKS.size(), "[%s] Channel %i has no rank!", m_label.c_str(), channel);
+
+    size_t watchdog = m_watchdogs.Assign(channel, window);
+    if (watchdog == CEP_ADC::NO_WATCHDOG)
+    {
+        LOG_ERROR("[%s]: No analog watchdog left for channel %i", m_label.c_str(), channel);
+        return false;
+    }
+
+    // The interrupt can't come before the callback is set, the watchdog is still disabled.
+    m_watchdogCallbacks[watchdog] = callback;
+
+    const CEP_ADC::Window& effective  = m_watchdogs.GetWindow(watchdog);
+    uint32_t               maxReading = (1UL << GetResolution(m_adc)) - 1;
+
+    ADC_AnalogWDGConfTypeDef config = {};
+    config.WatchdogNumber           = WATCHDOG_NUMBERS[watchdog];
+    config.WatchdogMode             = ADC_ANALOGWATCHDOG_SINGLE_REG;
+#if defined(NILAI_USES_STM32F4xx) || defined(NILAI_USES_STM32F7xx)
+    // Their HAL takes the channel's number rather than the low-level driver's encoding.
+    config.Channel = __LL_ADC_CHANNEL_TO_DECIMAL_NB(
+      LL_ADC_REG_GetSequencerRanks(m_adc->Instance, RANKS[channel]));
+#else
+    config.Channel = LL_ADC_REG_GetSequencerRanks(m_adc->Instance, RANKS[channel]);
+#endif
+    config.ITMode        = ENABLE;
+    config.LowThreshold  = effective.low;
+    config.HighThreshold = std::min<uint32_t>(effective.high, maxReading);
+    __HAL_ADC_CLEAR_FLAG(m_adc, WATCHDOG_FLAGS[watchdog]);
+    if (HAL_ADC_AnalogWDGConfig(m_adc, &config) != HAL_OK)
+    {
+        LOG_ERROR("[%s]: Unable to set the analog watchdog of channel %i",
+                  m_label.c_str(),
+                  channel);
+        ClearWatchdog(channel);
+        return false;
+    }
+
+    LOG_DEBUG("[%s]: Watchdog %i supervising channel %i between %i and %i",
+              m_label.c_str(),
+              watchdog + 1,
+              channel,
+              effective.low,
+              config.HighThreshold);
+    return true;
+}
+
+void AdcModule::ClearWatchdog(size_t channel)
+{
+    size_t watchdog = m_watchdogs.Find(channel);
+    if (watchdog == CEP_ADC::NO_WATCHDOG)
+    {
+        return;
+    }
+
+    ADC_AnalogWDGConfTypeDef config = {};
+    config.WatchdogNumber           = WATCHDOG_NUMBERS[watchdog];
+    config.WatchdogMode             = ADC_ANALOGWATCHDOG_NONE;
+    config.ITMode                   = DISABLE;
+    HAL_ADC_AnalogWDGConfig(m_adc, &config);
+    __HAL_ADC_DISABLE_IT(m_adc, WATCHDOG_INTERRUPTS[watchdog]);
+
+    m_watchdogs.Release(channel);
+    m_watchdogCallbacks[watchdog] = nullptr;
+}
+
+bool AdcModule::IsOutOfWindow(size_t channel) const
+{
+    size_t watchdog = m_watchdogs.Find(channel);
+    return (watchdog != CEP_ADC::NO_WATCHDOG) && m_watchdogs.IsTripped(watchdog);
 }
 
 void AdcModule::Start()
 {
+    // The DMA packs the samples two per word when it writes half-words.
+    const DMA_HandleTypeDef* dma = m_adc->DMA_Handle;
+    m_isHalfWordBuff =
+      (dma != nullptr) && (dma->Init.MemDataAlignment == DMA_MDATAALIGN_HALFWORD);
     HAL_ADC_Start_DMA(m_adc, &m_channelBuff[0], m_channelCount);
 }
 
@@ -91,4 +309,239 @@ void AdcModule::Stop()
     HAL_ADC_Stop_DMA(m_adc);
 }
 
+#if defined(HAL_TIM_MODULE_ENABLED)
+bool AdcModule::StartStream(const CEP_ADC::StreamConfig& config,
+                            const CEP_ADC::BlockCallback& callback)
+{
+    CEP_ASSERT(config.trigger != nullptr, "[%s]: Trigger timer is null!", m_label.c_str());
+    CEP_ASSERT(config.framesPerBlock != 0, "[%s]: Blocks can't be empty!", m_label.c_str());
+
+    StopStream();
+    Stop();
+
+    // The samples are packed two per word and the buffer is used as a ring.
+    const DMA_HandleTypeDef* dma = m_adc->DMA_Handle;
+    if ((dma == nullptr) || (dma->Init.Mode != DMA_CIRCULAR) ||
+        (dma->Init.MemDataAlignment != DMA_MDATAALIGN_HALFWORD))
+    {
+        LOG_ERROR("[%s]: Streaming requires a circular DMA with half-word transfers",
+                  m_label.c_str());
+        return false;
+    }
+    if ((m_adc->Init.ExternalTrigConv == ADC_SOFTWARE_START) ||
+        (m_adc->Init.ContinuousConvMode == ENABLE))
+    {
+        LOG_ERROR("[%s]: Streaming requires conversions triggered by a timer", m_label.c_str());
+        return false;
+    }
+
+    uint32_t clock = config.timerClock;
+    if (clock == 0)
+    {
+        clock = CEP_TIM::GetTimerClock(config.trigger->Instance);
+    }
+    CEP_ADC::TriggerTiming timing = CEP_ADC::ComputeTriggerTiming(clock, config.sampleRate);
+    if (timing.rate == 0)
+    {
+        LOG_ERROR("[%s]: Unable to sample at %iHz with a %iHz timer",
+                  m_label.c_str(),
+                  config.sampleRate,
+                  clock);
+        return false;
+    }
+
+    m_trigger                 = config.trigger;
+    m_trigger->Init.Prescaler = timing.prescaler;
+    m_trigger->Init.Period    = timing.period;
+    HAL_TIM_Base_DeInit(m_trigger);
+    HAL_TIM_Base_Init(m_trigger);
+
+    // Every update event starts the conversion of the sequence.
+    TIM_MasterConfigTypeDef master = {};
+    master.MasterOutputTrigger     = TIM_TRGO_UPDATE;
+    master.MasterSlaveMode         = TIM_MASTERSLAVEMODE_DISABLE;
+    HAL_TIMEx_MasterConfigSynchronization(m_trigger, &master);
+
+    m_streamBuffer.assign(2 * config.framesPerBlock * m_channelCount, 0);
+    m_stream.Reset(m_streamBuffer.data(), config.framesPerBlock, m_channelCount);
+    // A decimator produces at most one sample per frame, plus the one it had started.
+    m_decimatedBuffer.assign(config.framesPerBlock + 1, 0);
+    for (CEP_ADC::Decimator& decimator : m_decimators)
+    {
+        decimator.Reset();
+    }
+    m_blockCallback = callback;
+    m_sampleRate    = timing.rate;
+    m_isStreaming   = true;
+
+    if ((HAL_ADC_Start_DMA(m_adc,
+                           reinterpret_cast<uint32_t*>(m_streamBuffer.data()),
+                           (uint32_t)m_streamBuffer.size()) != HAL_OK) ||
+        (HAL_TIM_Base_Start(m_trigger) != HAL_OK))
+    {
+        LOG_ERROR("[%s]: Unable to start the stream", m_label.c_str());
+        StopStream();
+        return false;
+    }
+
+    LOG_DEBUG("[%s]: Streaming %i channels at %iHz (psc: %i, per: %i)",
+              m_label.c_str(),
+              m_channelCount,
+              m_sampleRate,
+              timing.prescaler,
+              timing.period);
+    return true;
+}
+#endif
+
+void AdcModule::StopStream()
+{
+    if (!m_isStreaming)
+    {
+        return;
+    }
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+    HAL_TIM_Base_Stop(m_trigger);
+#endif
+    HAL_ADC_Stop_DMA(m_adc);
+    m_isStreaming = false;
+    m_sampleRate  = 0;
+}
+
+void AdcModule::HandleHalfComplete()
+{
+    if (m_isStreaming)
+    {
+        m_stream.HandleHalfComplete();
+    }
+}
+
+void AdcModule::HandleComplete()
+{
+    if (m_isStreaming)
+    {
+        m_stream.HandleComplete();
+    }
+}
+
+void AdcModule::HandleWatchdog(size_t watchdog)
+{
+    size_t channel = m_watchdogs.Trip(watchdog);
+    if (channel == CEP_ADC::NO_CHANNEL)
+    {
+        return;
+    }
+
+    // Every conversion out of the window would interrupt again, until the channel recovers.
+    __HAL_ADC_DISABLE_IT(m_adc, WATCHDOG_INTERRUPTS[watchdog]);
+    if (m_watchdogCallbacks[watchdog])
+    {
+        m_watchdogCallbacks[watchdog](channel);
+    }
+}
+
+void AdcModule::RearmWatchdogs()
+{
+    for (size_t w = 0; w < CEP_ADC::WATCHDOG_COUNT; w++)
+    {
+        size_t channel = m_watchdogs.GetChannel(w);
+        if ((channel == CEP_ADC::NO_CHANNEL) || !m_watchdogs.IsTripped(w))
+        {
+            continue;
+        }
+
+        if (m_watchdogs.Rearm(w, GetRawReading(channel)))
+        {
+            __HAL_ADC_CLEAR_FLAG(m_adc, WATCHDOG_FLAGS[w]);
+            __HAL_ADC_ENABLE_IT(m_adc, WATCHDOG_INTERRUPTS[w]);
+        }
+    }
+}
+
+void AdcModule::Decimate(const CEP_ADC::Block& block)
+{
+    for (size_t c = 0; c < m_channelCount; c++)
+    {
+        if (!m_decimators[c].IsEnabled())
+        {
+            continue;
+        }
+
+        size_t count = m_decimators[c].Process(block, c, m_decimatedBuffer.data());
+        if (m_decimatedCallbacks[c])
+        {
+            m_decimatedCallbacks[c](c, cep::Span<const uint16_t>(m_decimatedBuffer.data(), count));
+        }
+    }
+}
+
+uint8_t AdcModule::GetResolution(const ADC_HandleTypeDef* adc)
+{
+    switch (adc->Init.Resolution)
+    {
+        case ADC_RESOLUTION_10B: return 10;
+        case ADC_RESOLUTION_8B: return 8;
+        case ADC_RESOLUTION_6B: return 6;
+        case ADC_RESOLUTION_12B:
+        default: return 12;
+    }
+}
+
+/*************************************************************************************************/
+/* HAL callbacks ------------------------------------------------------------------------------- */
+static AdcModule* FindModule(ADC_HandleTypeDef* hadc)
+{
+    for (AdcModule* module : s_modules)
+    {
+        if ((module != nullptr) && (module->GetHandle() == hadc))
+        {
+            return module;
+        }
+    }
+    return nullptr;
+}
+
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc)
+{
+    if (AdcModule* module = FindModule(hadc); module != nullptr)
+    {
+        module->HandleHalfComplete();
+    }
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
+{
+    if (AdcModule* module = FindModule(hadc); module != nullptr)
+    {
+        module->HandleComplete();
+    }
+}
+
+void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef* hadc)
+{
+    if (AdcModule* module = FindModule(hadc); module != nullptr)
+    {
+        module->HandleWatchdog(0);
+    }
+}
+
+#if !defined(NILAI_USES_STM32F4xx) && !defined(NILAI_USES_STM32F7xx)
+void HAL_ADCEx_LevelOutOfWindow2Callback(ADC_HandleTypeDef* hadc)
+{
+    if (AdcModule* module = FindModule(hadc); module != nullptr)
+    {
+        module->HandleWatchdog(1);
+    }
+}
+
+void HAL_ADCEx_LevelOutOfWindow3Callback(ADC_HandleTypeDef* hadc)
+{
+    if (AdcModule* module = FindModule(hadc); module != nullptr)
+    {
+        module->HandleWatchdog(2);
+    }
+}
+#endif
+
 #endif
@@ -21,6 +21,32 @@
 #include "test/Mocks/adc.h"
 #endif
 #include "shared/defines/module.hpp"
+#include "shared/drivers/adcCalibration.hpp"
+#include "shared/drivers/adcDecimation.hpp"
+#include "shared/drivers/adcStream.hpp"
+#include "shared/drivers/adcWatchdog.hpp"
+
+#include <array>
+#include <vector>
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+namespace CEP_ADC
+{
+struct StreamConfig
+{
+    //! Timer whose update event triggers the conversions. It must be selected as the ADC's
+    //! external trigger (TRGO) and the DMA must be in circular mode, with half-word transfers.
+    TIM_HandleTypeDef* trigger = nullptr;
+    //! Number of frames per second.
+    uint32_t sampleRate = 1000;
+    //! Number of frames in a block, the block callback is called sampleRate / framesPerBlock
+    //! times per second.
+    size_t framesPerBlock = 32;
+    //! Clock of the timer's counter in hertz, 0 to compute it from the bus of the timer.
+    uint32_t timerClock = 0;
+};
+}    // namespace CEP_ADC
+#endif
 
 class AdcModule : public cep::Module
 {
@@ -29,19 +55,156 @@ public:
     ~AdcModule() override;
 
     bool               DoPost() override;
-    void               Run() override {}
+    void               Run() override;
     [[nodiscard]] const std::string& GetLabel() const override { return m_label; }
 
     void Start();
     void Stop();
 
+    /**
+     * @brief   Gets the last reading of a channel, converted with its calibration.
+     *
+     * While streaming, all the channels come from the same frame: the last one of the last block.
+     * Decimated channels give their last decimated sample instead.
+     */
     [[nodiscard]] float GetChannelReading(size_t channel) const;
+    //! Same as @ref GetChannelReading, in fixed-point.
+    [[nodiscard]] CEP_ADC::q16_t GetChannelValue(size_t channel) const;
+
+    /*********************************************************************************************/
+    /* Calibration, see adcCalibration.hpp */
+    /**
+     * @brief   Sets how the samples of a channel are converted.
+     *
+     * Every channel defaults to the full scale of the ADC being 3.3V.
+     */
+    void SetCalibration(size_t channel, const CEP_ADC::ChannelCalibration& calibration);
+    [[nodiscard]] const CEP_ADC::ChannelCalibration& GetCalibration(size_t channel) const
+    {
+        return m_calibrations[channel];
+    }
+
+    /*********************************************************************************************/
+    /* Decimation, see adcDecimation.hpp */
+    /**
+     * @brief   Oversamples a channel of the stream, trading sample rate for resolution.
+     *
+     * The channel's calibration still applies to the decimated samples, as it takes their extra
+     * bits into account.
+     *
+     * @param   channel     The channel.
+     * @param   config      Settings of the decimation.
+     * @param   callback    Optional, called from @ref Run with the samples produced from a block.
+     * @return  False if the settings are out of range.
+     */
+    bool SetDecimation(size_t                            channel,
+                       const CEP_ADC::DecimationConfig&  config,
+                       const CEP_ADC::DecimatedCallback& callback = {});
+    void ClearDecimation(size_t channel);
+    [[nodiscard]] bool IsDecimated(size_t channel) const
+    {
+        return m_decimators[channel].IsEnabled();
+    }
+
+    /*********************************************************************************************/
+    /* Analog watchdogs, see adcWatchdog.hpp */
+    /**
+     * @brief   Has the ADC supervise a channel with one of its analog watchdogs.
+     *
+     * The ADC compares every conversion of the channel with the window, without any CPU time.
+     * `callback` is called from the ADC's interrupt as soon as a conversion falls outside of it,
+     * after which the watchdog is silenced until @ref Run sees the channel back inside.
+     *
+     * Up to three channels can be supervised. Only the first one gets a watchdog comparing every
+     * bit, see adcWatchdog.hpp.
+     *
+     * Must be called while the ADC is stopped.
+     *
+     * @param   channel     The channel.
+     * @param   window      Raw readings considered normal, bounds included.
+     * @param   callback    Called from the interrupt when the channel leaves the window.
+     * @return  False if every watchdog is in use or the ADC refused the settings.
+     */
+    bool SetWatchdog(size_t                           channel,
+                     const CEP_ADC::Window&           window,
+                     const CEP_ADC::WatchdogCallback& callback);
+    void ClearWatchdog(size_t channel);
+    //! True from the moment the channel left its window until @ref Run sees it back inside.
+    [[nodiscard]] bool IsOutOfWindow(size_t channel) const;
+
+    /**
+     * @brief   Converts every sample of a block with the calibration of its channel.
+     * @param   out Receives `block.frames * block.channels` values, interleaved like the samples.
+     */
+    void ConvertBlock(const CEP_ADC::Block& block, CEP_ADC::q16_t* out) const
+    {
+        CEP_ADC::ConvertBlock(block, m_calibrations.data(), out);
+    }
+
+    /*********************************************************************************************/
+    /* Streaming, see adcStream.hpp */
+#if defined(HAL_TIM_MODULE_ENABLED)
+    /**
+     * @brief   Starts converting every channel at a fixed rate, delivering the samples in blocks.
+     *
+     * Replaces the acquisition started by @ref Start.
+     *
+     * @param   config      Settings of the stream.
+     * @param   callback    Called from @ref Run for every block.
+     * @return  False if the peripherals aren't set up for streaming or the rate can't be reached.
+     */
+    bool StartStream(const CEP_ADC::StreamConfig& config, const CEP_ADC::BlockCallback& callback);
+#endif
+    void StopStream();
+
+    [[nodiscard]] bool     IsStreaming() const { return m_isStreaming; }
+    //! Sample rate actually obtained by the stream, in hertz.
+    [[nodiscard]] uint32_t GetSampleRate() const { return m_sampleRate; }
+    //! Number of blocks that couldn't be delivered in time since the start of the stream.
+    [[nodiscard]] uint32_t GetOverruns() const { return m_stream.GetOverruns(); }
+    [[nodiscard]] size_t   GetChannelCount() const { return m_channelCount; }
+
+    //! Called by the HAL's ADC callbacks, not meant to be called by the application.
+    void HandleHalfComplete();
+    //! Called by the HAL's ADC callbacks, not meant to be called by the application.
+    void HandleComplete();
+    //! Called by the HAL's ADC callbacks, not meant to be called by the application.
+    void HandleWatchdog(size_t watchdog);
+
+    [[nodiscard]] ADC_HandleTypeDef* GetHandle() const { return m_adc; }
 
 private:
     ADC_HandleTypeDef* m_adc          = nullptr;
     uint32_t*          m_channelBuff  = nullptr;
     size_t             m_channelCount = 0;
     std::string        m_label;
+    //! True if the DMA writes a half-word per channel into @ref m_channelBuff, a word otherwise.
+    bool m_isHalfWordBuff = false;
+
+    std::vector<CEP_ADC::ChannelCalibration> m_calibrations;
+    std::vector<CEP_ADC::Decimator>          m_decimators;
+    std::vector<CEP_ADC::DecimatedCallback>  m_decimatedCallbacks;
+    //! Samples produced by a decimator from a block.
+    std::vector<uint16_t>                    m_decimatedBuffer;
+
+    CEP_ADC::WatchdogTable                                         m_watchdogs;
+    std::array<CEP_ADC::WatchdogCallback, CEP_ADC::WATCHDOG_COUNT> m_watchdogCallbacks;
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+    TIM_HandleTypeDef* m_trigger = nullptr;
+#endif
+    std::vector<uint16_t>  m_streamBuffer;
+    CEP_ADC::PingPong      m_stream;
+    CEP_ADC::BlockCallback m_blockCallback;
+    volatile bool          m_isStreaming = false;
+    uint32_t               m_sampleRate  = 0;
+
+private:
+    [[nodiscard]] uint16_t GetRawReading(size_t channel) const;
+    void                   Decimate(const CEP_ADC::Block& block);
+    void                   RearmWatchdogs();
+
+    static uint8_t GetResolution(const ADC_HandleTypeDef* adc);
 };
 #else
 #if WARN_MISSING_STM_DRIVERS
@@ -0,0 +1,226 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  adc
+ * @{
+ * @file        adcStream.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/22
+ *
+ * @brief       Continuous, timer-triggered ADC acquisition delivered in blocks.
+ *
+ * A timer triggers the conversion of every channel of the ADC's sequence at the sample rate. The
+ * DMA stores the samples in a circular buffer split in two halves: while it fills one half, the
+ * other one is handed to the application as a @ref CEP_ADC::Block. Every block holds the same
+ * number of frames, a frame being one sample of each channel taken at the same trigger.
+ *
+ * The timer and the DMA are set up by @ref AdcModule.
+ */
+#ifndef ADC_STREAM_HPP_
+#define ADC_STREAM_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_ADC) || defined(NILAI_TEST)
+#include "defines/inplaceFunction.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace CEP_ADC
+{
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+/**
+ * @brief   Frames acquired during one half of the DMA buffer.
+ *
+ * Samples are interleaved: the sample of channel `c` in frame `f` is at `f * channels + c`.
+ * The samples point into the DMA buffer and are only valid during the block callback.
+ */
+struct Block
+{
+    const uint16_t* samples  = nullptr;
+    size_t          frames   = 0;
+    size_t          channels = 0;
+    //! Number of blocks acquired before this one since the start of the stream.
+    uint32_t sequence = 0;
+
+    [[nodiscard]] uint16_t Get(size_t frame, size_t channel) const
+    {
+        return samples[(frame * channels) + channel];
+    }
+};
+
+/**
+ * @brief   Called from @ref AdcModule::Run for every block.
+ *
+ * The DMA starts overwriting the block one half-buffer period after it was acquired, it must be
+ * processed (or copied) by then.
+ */
+using BlockCallback = cep::InplaceFunction<void(const Block&)>;
+
+/**
+ * @brief   Prescaler and period of the trigger timer.
+ */
+struct TriggerTiming
+{
+    //! Values of the PSC and ARR registers.
+    uint32_t prescaler = 0;
+    uint32_t period    = 0;
+    //! Sample rate actually obtained, in hertz. 0 if the requested rate can't be obtained.
+    uint32_t rate = 0;
+};
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+/**
+ * @brief   Computes the timer settings giving a sample rate closest to `rate`.
+ *
+ * The prescaler is kept as small as possible, which gives the period the most resolution.
+ *
+ * @param   clock       Clock of the timer's counter, in hertz.
+ * @param   rate        Sample rate, in hertz.
+ * @param   maxPeriod   Largest value of the timer's ARR register.
+ */
+constexpr TriggerTiming ComputeTriggerTiming(uint32_t clock,
+                                             uint32_t rate,
+                                             uint32_t maxPeriod = 0xFFFF)
+{
+    TriggerTiming timing;
+    if ((rate == 0) || (rate > clock))
+    {
+        return timing;
+    }
+
+    // Number of timer ticks between two triggers, rounded to the nearest.
+    uint64_t ticks     = ((uint64_t)clock + (rate / 2)) / rate;
+    uint64_t prescaler = (ticks - 1) / ((uint64_t)maxPeriod + 1);
+    if (prescaler > 0xFFFF)
+    {
+        return timing;
+    }
+
+    uint64_t period  = ((ticks + ((prescaler + 1) / 2)) / (prescaler + 1)) - 1;
+    timing.prescaler = (uint32_t)prescaler;
+    timing.period    = (uint32_t)period;
+    timing.rate      = (uint32_t)((uint64_t)clock / ((prescaler + 1) * (period + 1)));
+    return timing;
+}
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+/**
+ * @brief   Keeps track of which half of the DMA buffer the application can use.
+ *
+ * The DMA's interrupts call @ref HandleHalfComplete and @ref HandleComplete, the main loop calls
+ * @ref Acquire to get the last complete half and @ref Release once it's done with it.
+ *
+ * A half that completes before the previous one was acquired replaces it, the lost block is
+ * counted as an overrun. So is a block whose half was written again before it was released.
+ */
+class PingPong
+{
+public:
+    /**
+     * @param   buffer      DMA buffer, holding two blocks.
+     * @param   frames      Number of frames in a block.
+     * @param   channels    Number of channels in a frame.
+     */
+    void Reset(const uint16_t* buffer, size_t frames, size_t channels)
+    {
+        m_buffer    = buffer;
+        m_frames    = frames;
+        m_channels  = channels;
+        m_completed = 0;
+        m_delivered = 0;
+        m_overruns  = 0;
+    }
+
+    //! Number of samples in the whole DMA buffer.
+    [[nodiscard]] size_t GetBufferSize() const { return 2 * m_frames * m_channels; }
+
+    /*********************************************************************************************/
+    /* Interrupt side */
+    void HandleHalfComplete() { m_completed.fetch_add(1, std::memory_order_release); }
+    void HandleComplete() { m_completed.fetch_add(1, std::memory_order_release); }
+
+    /*********************************************************************************************/
+    /* Main loop side */
+    /**
+     * @brief   Gets the last complete block that hasn't been delivered yet.
+     * @return  True if there is one.
+     */
+    bool Acquire(Block& block)
+    {
+        uint32_t completed = m_completed.load(std::memory_order_acquire);
+        if (completed == m_delivered)
+        {
+            return false;
+        }
+
+        // Blocks completed in between were overwritten before we could get to them.
+        m_overruns += completed - m_delivered - 1;
+        m_delivered = completed;
+
+        // The first half completes first, the halves then alternate.
+        uint32_t sequence = completed - 1;
+        block.samples     = m_buffer + ((sequence & 1) * m_frames * m_channels);
+        block.frames      = m_frames;
+        block.channels    = m_channels;
+        block.sequence    = sequence;
+        return true;
+    }
+
+    /**
+     * @brief   Ends the use of the last acquired block.
+     * @return  False if the DMA started writing over the block before it was released.
+     */
+    bool Release()
+    {
+        // Once the other half completes, the DMA is back in the block's half.
+        if (m_completed.load(std::memory_order_acquire) != m_delivered)
+        {
+            m_overruns++;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief   Gets the last complete frame of the stream.
+     * @return  Nullptr if no block has been completed yet, `channels` samples otherwise.
+     */
+    [[nodiscard]] const uint16_t* GetLatestFrame() const
+    {
+        uint32_t completed = m_completed.load(std::memory_order_acquire);
+        if (completed == 0)
+        {
+            return nullptr;
+        }
+        size_t half = (completed - 1) & 1;
+        return m_buffer + (((half * m_frames) + m_frames - 1) * m_channels);
+    }
+
+    //! Number of blocks lost or overwritten since the start of the stream.
+    [[nodiscard]] uint32_t GetOverruns() const { return m_overruns; }
+
+private:
+    const uint16_t* m_buffer   = nullptr;
+    size_t          m_frames   = 0;
+    size_t          m_channels = 0;
+
+    //! Number of halves filled by the DMA, updated from the interrupt.
+    std::atomic<uint32_t> m_completed = 0;
+    //! Value of m_completed when the last block was acquired.
+    uint32_t m_delivered = 0;
+    uint32_t m_overruns  = 0;
+};
+}    // namespace CEP_ADC
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
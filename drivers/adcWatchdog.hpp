@@ -0,0 +1,244 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  adc
+ * @{
+ * @file        adcWatchdog.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/25
+ *
+ * @brief       Assignment of the ADC's analog watchdogs to the channels they supervise.
+ *
+ * The ADC has three analog watchdogs, each comparing the conversions of a channel with a window
+ * and raising an interrupt when one falls outside of it. The first one compares every bit of the
+ * conversion, the other two only the 8 most significant bits: their windows are widened to the
+ * nearest multiples of their precision. The ADCs of the F4 and F7 only have the first one.
+ *
+ * A watchdog that tripped is silenced until its channel is back inside the window, otherwise every
+ * conversion outside of it would raise an interrupt.
+ *
+ * The watchdogs are set up by @ref AdcModule.
+ */
+#ifndef ADC_WATCHDOG_HPP_
+#define ADC_WATCHDOG_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_ADC) || defined(NILAI_TEST)
+#include "defines/inplaceFunction.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace CEP_ADC
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+#if defined(NILAI_USES_STM32F4xx) || defined(NILAI_USES_STM32F7xx)
+static constexpr size_t WATCHDOG_COUNT = 1;
+#else
+static constexpr size_t WATCHDOG_COUNT = 3;
+#endif
+//! Returned when no watchdog or no channel matches.
+static constexpr size_t NO_WATCHDOG = SIZE_MAX;
+static constexpr size_t NO_CHANNEL  = SIZE_MAX;
+
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+/**
+ * @brief   Range of readings considered normal, bounds included.
+ */
+struct Window
+{
+    uint16_t low  = 0;
+    uint16_t high = 0xFFFF;
+
+    [[nodiscard]] constexpr bool Contains(uint16_t reading) const
+    {
+        return (reading >= low) && (reading <= high);
+    }
+
+    constexpr bool operator==(const Window& other) const
+    {
+        return (low == other.low) && (high == other.high);
+    }
+};
+
+/**
+ * @brief   Called from the ADC's interrupt when a channel's reading leaves its window.
+ */
+using WatchdogCallback = cep::InplaceFunction<void(size_t channel)>;
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+//! Number of bits a watchdog compares, for readings of `resolution` bits.
+constexpr uint8_t GetWatchdogPrecision(size_t watchdog, uint8_t resolution)
+{
+    return ((watchdog == 0) || (resolution < 8)) ? resolution : 8;
+}
+
+/**
+ * @brief   Gets the window a watchdog actually enforces.
+ *
+ * The bits the watchdog ignores are cleared in the low threshold and set in the high one.
+ */
+constexpr Window GetEffectiveWindow(const Window& window, uint8_t precision, uint8_t resolution)
+{
+    uint16_t ignored = (uint16_t)((1U << (resolution - precision)) - 1);
+    return Window {(uint16_t)(window.low & ~ignored), (uint16_t)(window.high | ignored)};
+}
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+/**
+ * @brief   Keeps track of which channel each watchdog supervises, one channel per watchdog.
+ *
+ * @ref Trip is called from the interrupt, everything else from the main loop.
+ */
+class WatchdogTable
+{
+public:
+    WatchdogTable() { Reset(m_resolution); }
+
+    /**
+     * @brief   Frees every watchdog.
+     * @param   resolution  Number of bits of the readings.
+     */
+    void Reset(uint8_t resolution)
+    {
+        m_resolution = resolution;
+        for (size_t w = 0; w < WATCHDOG_COUNT; w++)
+        {
+            m_channels[w] = NO_CHANNEL;
+            m_tripped[w]  = false;
+        }
+    }
+
+    /**
+     * @brief   Gets a watchdog for a channel.
+     *
+     * A channel keeps its watchdog when its window changes. Otherwise, the windows that would be
+     * widened by a less precise watchdog get the precise one when it's free.
+     *
+     * @return  The watchdog, or @ref NO_WATCHDOG if they are all in use.
+     */
+    size_t Assign(size_t channel, const Window& window)
+    {
+        size_t watchdog = Find(channel);
+        if (watchdog == NO_WATCHDOG)
+        {
+            watchdog = FindFree(window);
+        }
+        if (watchdog != NO_WATCHDOG)
+        {
+            m_channels[watchdog] = channel;
+            m_windows[watchdog]  = GetEffectiveWindow(
+              window, GetWatchdogPrecision(watchdog, m_resolution), m_resolution);
+            m_tripped[watchdog] = false;
+        }
+        return watchdog;
+    }
+
+    //! Frees the channel's watchdog.
+    void Release(size_t channel)
+    {
+        size_t watchdog = Find(channel);
+        if (watchdog != NO_WATCHDOG)
+        {
+            m_channels[watchdog] = NO_CHANNEL;
+            m_tripped[watchdog]  = false;
+        }
+    }
+
+    //! Watchdog supervising a channel, or @ref NO_WATCHDOG.
+    [[nodiscard]] size_t Find(size_t channel) const
+    {
+        for (size_t w = 0; w < WATCHDOG_COUNT; w++)
+        {
+            if (m_channels[w] == channel)
+            {
+                return w;
+            }
+        }
+        return NO_WATCHDOG;
+    }
+
+    //! Channel supervised by a watchdog, or @ref NO_CHANNEL.
+    [[nodiscard]] size_t        GetChannel(size_t watchdog) const { return m_channels[watchdog]; }
+    //! Window actually enforced by a watchdog.
+    [[nodiscard]] const Window& GetWindow(size_t watchdog) const { return m_windows[watchdog]; }
+
+    /*********************************************************************************************/
+    /* Interrupt side */
+    /**
+     * @brief   Records that a watchdog saw a reading outside of its window.
+     * @return  The channel it supervises, or @ref NO_CHANNEL if it isn't in use.
+     */
+    size_t Trip(size_t watchdog)
+    {
+        if (m_channels[watchdog] == NO_CHANNEL)
+        {
+            return NO_CHANNEL;
+        }
+        m_tripped[watchdog].store(true, std::memory_order_release);
+        return m_channels[watchdog];
+    }
+
+    /*********************************************************************************************/
+    /* Main loop side */
+    [[nodiscard]] bool IsTripped(size_t watchdog) const
+    {
+        return m_tripped[watchdog].load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief   Clears a tripped watchdog once its channel is back inside the window.
+     * @return  True if the watchdog must be armed again.
+     */
+    bool Rearm(size_t watchdog, uint16_t reading)
+    {
+        if (!IsTripped(watchdog) || !m_windows[watchdog].Contains(reading))
+        {
+            return false;
+        }
+        m_tripped[watchdog].store(false, std::memory_order_release);
+        return true;
+    }
+
+private:
+    size_t FindFree(const Window& window) const
+    {
+        // Only the first watchdog is precise, keep it for the windows that need it.
+        size_t fallback = NO_WATCHDOG;
+        for (size_t w = WATCHDOG_COUNT; w-- > 0;)
+        {
+            if (m_channels[w] != NO_CHANNEL)
+            {
+                continue;
+            }
+            uint8_t precision = GetWatchdogPrecision(w, m_resolution);
+            if (GetEffectiveWindow(window, precision, m_resolution) == window)
+            {
+                return w;
+            }
+            fallback = w;
+        }
+        return fallback;
+    }
+
+private:
+    uint8_t                                       m_resolution = 12;
+    std::array<size_t, WATCHDOG_COUNT>            m_channels;
+    std::array<Window, WATCHDOG_COUNT>            m_windows = {};
+    std::array<std::atomic<bool>, WATCHDOG_COUNT> m_tripped = {};
+};
+}    // namespace CEP_ADC
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
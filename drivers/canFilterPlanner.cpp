@@ -0,0 +1,514 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  can
+ * @{
+ * @file        canFilterPlanner.cpp
+ * @author      Samuel Martel
+ * @date        2021/11/08
+ *
+ * @brief       Computes the bxCAN filter banks needed to accept a set of identifiers.
+ */
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#include "drivers/canFilterPlanner.hpp"
+
+#if defined(NILAI_USE_CAN) || defined(NILAI_TEST)
+#    include <algorithm>
+#    include <bitset>
+#    include <limits>
+
+namespace CEP_CAN
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+// Layout of a filter register in 32-bit scale.
+static constexpr uint32_t STID_MASK = 0xFFE00000;    // STID[10:0] / EXID[28:18]
+static constexpr uint32_t ID29_MASK = 0xFFFFFFF8;    // EXID[28:0]
+static constexpr uint32_t IDE_BIT   = 0x00000004;
+static constexpr uint32_t RTR_BIT   = 0x00000002;
+
+using Entry = FilterPlanner::Entry;
+
+/*************************************************************************************************/
+/* Private function declarations --------------------------------------------------------------- */
+namespace
+{
+enum class Kind
+{
+    StdExact,    //!< Goes in a 16-bit list slot.
+    StdMask,     //!< Goes in a 16-bit mask slot.
+    Exact32,     //!< Goes in a 32-bit list slot.
+    Mask32,      //!< Goes in a 32-bit mask bank.
+};
+
+struct KindCount
+{
+    size_t stdExact = 0;
+    size_t stdMask  = 0;
+    size_t exact32  = 0;
+    size_t mask32   = 0;
+
+    size_t& operator[](Kind k)
+    {
+        switch (k)
+        {
+            case Kind::StdExact:
+                return stdExact;
+            case Kind::StdMask:
+                return stdMask;
+            case Kind::Exact32:
+                return exact32;
+            case Kind::Mask32:
+            default:
+                return mask32;
+        }
+    }
+};
+
+int      CountOnes(uint32_t v);
+bool     AcceptsStd(const Entry& e);
+bool     AcceptsExt(const Entry& e);
+bool     IsExact(const Entry& e);
+Kind     GetKind(const Entry& e);
+uint64_t GetSize(const Entry& e);
+Entry    Cover(const Entry& a, const Entry& b);
+bool     Contains(const Entry& outer, const Entry& inner);
+uint16_t To16Bit(uint32_t v);
+size_t   CountBanks(KindCount c);
+void     Normalize(std::vector<FilterPlanner::Range>& ranges);
+void     Decompose(const std::vector<FilterPlanner::Range>& ranges,
+                   bool                                     extended,
+                   bool                                     acceptRemote,
+                   std::vector<Entry>&                      outEntries);
+}    // namespace
+
+/*************************************************************************************************/
+/* Public method definitions ------------------------------------------------------------------- */
+void FilterPlanner::AddRange(uint32_t first, uint32_t last, bool extended)
+{
+    if (first > last)
+    {
+        std::swap(first, last);
+    }
+
+    // Identifiers that don't fit on 11 bits can only be extended.
+    if ((extended == true) || (last > STD_ID_MAX))
+    {
+        m_extRanges.push_back({std::min(first, EXT_ID_MAX), std::min(last, EXT_ID_MAX)});
+    }
+    else
+    {
+        m_stdRanges.push_back({first, last});
+    }
+}
+
+/**
+ * @brief   Computes the filter banks needed to accept the subscribed identifiers.
+ *
+ * An exact plan is always attempted first. If it needs more than `maxBanks` banks, the pair of
+ * entries that, once merged, frees the most banks while letting the fewest unwanted identifiers
+ * through is merged, until the plan fits.
+ *
+ * @param   maxBanks    Maximum number of banks that can be used.
+ * @param   firstBank   Number of the first bank to use.
+ * @return  The plan.
+ */
+FilterPlan FilterPlanner::Plan(size_t maxBanks, uint8_t firstBank) const
+{
+    FilterPlan plan;
+    plan.firstBank  = firstBank;
+    plan.bankBudget = maxBanks;
+
+    std::vector<Range> stdRanges = m_stdRanges;
+    std::vector<Range> extRanges = m_extRanges;
+    Normalize(stdRanges);
+    Normalize(extRanges);
+
+    for (const auto& r : stdRanges)
+    {
+        plan.subscribedIds += (uint64_t)(r.last - r.first) + 1;
+    }
+    for (const auto& r : extRanges)
+    {
+        plan.subscribedIds += (uint64_t)(r.last - r.first) + 1;
+    }
+
+    if (maxBanks == 0)
+    {
+        return plan;
+    }
+
+    std::vector<Entry> entries;
+    Decompose(stdRanges, false, m_acceptRemoteFrames, entries);
+    Decompose(extRanges, true, m_acceptRemoteFrames, entries);
+
+    KindCount counts;
+    for (const auto& e : entries)
+    {
+        counts[GetKind(e)]++;
+    }
+
+    while ((CountBanks(counts) > maxBanks) && (entries.size() > 1))
+    {
+        size_t  bestI     = 0;
+        size_t  bestJ     = 1;
+        size_t  bestBanks = std::numeric_limits<size_t>::max();
+        int64_t bestCost  = std::numeric_limits<int64_t>::max();
+
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            for (size_t j = i + 1; j < entries.size(); j++)
+            {
+                Entry     merged = Cover(entries[i], entries[j]);
+                KindCount c      = counts;
+                c[GetKind(entries[i])]--;
+                c[GetKind(entries[j])]--;
+                c[GetKind(merged)]++;
+
+                // Number of new identifiers let through, assuming that i and j don't overlap.
+                size_t  banks = CountBanks(c);
+                int64_t cost  = (int64_t)GetSize(merged) - (int64_t)GetSize(entries[i]) -
+                               (int64_t)GetSize(entries[j]);
+                if ((banks < bestBanks) || ((banks == bestBanks) && (cost < bestCost)))
+                {
+                    bestI     = i;
+                    bestJ     = j;
+                    bestBanks = banks;
+                    bestCost  = cost;
+                }
+            }
+        }
+
+        Entry merged = Cover(entries[bestI], entries[bestJ]);
+
+        // Drop everything the new entry already covers, including the two that were merged.
+        entries.erase(std::remove_if(entries.begin(),
+                                     entries.end(),
+                                     [&merged](const Entry& e) { return Contains(merged, e); }),
+                      entries.end());
+        entries.push_back(merged);
+
+        counts = KindCount();
+        for (const auto& e : entries)
+        {
+            counts[GetKind(e)]++;
+        }
+    }
+
+    plan.banks = PackFilterEntries(entries, firstBank);
+
+    // Count what will actually make it through the filters.
+    std::bitset<STD_ID_MAX + 1> stdAccepted;
+    for (uint32_t id = 0; id <= STD_ID_MAX; id++)
+    {
+        for (const auto& e : entries)
+        {
+            if (AcceptsStd(e) && ((((id << 21) ^ e.code) & e.care & STID_MASK) == 0))
+            {
+                stdAccepted.set(id);
+                break;
+            }
+        }
+    }
+    plan.acceptedIds = stdAccepted.count();
+
+    uint64_t extAccepted = 0;
+    for (const auto& e : entries)
+    {
+        if (AcceptsExt(e))
+        {
+            extAccepted += (uint64_t)1 << (29 - CountOnes(e.care & ID29_MASK));
+        }
+    }
+    plan.acceptedIds += std::min(extAccepted, (uint64_t)EXT_ID_MAX + 1);
+
+    return plan;
+}
+
+std::vector<PlannedBank> PackFilterEntries(const std::vector<Entry>& entries, uint8_t firstBank)
+{
+    std::vector<Entry> stdExact;
+    std::vector<Entry> stdMask;
+    std::vector<Entry> exact32;
+    std::vector<Entry> mask32;
+
+    for (const auto& e : entries)
+    {
+        switch (GetKind(e))
+        {
+            case Kind::StdExact:
+                stdExact.push_back(e);
+                break;
+            case Kind::StdMask:
+                stdMask.push_back(e);
+                break;
+            case Kind::Exact32:
+                exact32.push_back(e);
+                break;
+            case Kind::Mask32:
+                mask32.push_back(e);
+                break;
+        }
+    }
+
+    // An odd number of standard blocks leaves a free 16-bit mask slot, use it for an exact ID.
+    if (((stdMask.size() % 2) == 1) && (stdExact.empty() == false))
+    {
+        stdMask.push_back(stdExact.back());
+        stdExact.pop_back();
+    }
+    // A single leftover standard ID fits in the free slot of an odd 32-bit list.
+    if (((stdExact.size() % 4) == 1) && ((exact32.size() % 2) == 1))
+    {
+        exact32.push_back(stdExact.back());
+        stdExact.pop_back();
+    }
+
+    std::vector<PlannedBank> banks;
+    uint8_t                  bank = firstBank;
+
+    // Unused slots are filled with a copy of a used one, so that they don't accept anything else.
+    for (size_t i = 0; i < stdMask.size(); i += 2)
+    {
+        const Entry& a = stdMask[i];
+        const Entry& b = (i + 1 < stdMask.size()) ? stdMask[i + 1] : a;
+
+        PlannedBank pb;
+        pb.bank    = bank++;
+        pb.isList  = false;
+        pb.is16Bit = true;
+        pb.fr1     = ((uint32_t)To16Bit(a.care) << 16) | To16Bit(a.code);
+        pb.fr2     = ((uint32_t)To16Bit(b.care) << 16) | To16Bit(b.code);
+        banks.push_back(pb);
+    }
+
+    for (size_t i = 0; i < stdExact.size(); i += 4)
+    {
+        uint16_t ids[4];
+        for (size_t j = 0; j < 4; j++)
+        {
+            ids[j] = To16Bit(stdExact[(i + j < stdExact.size()) ? i + j : i].code);
+        }
+
+        PlannedBank pb;
+        pb.bank    = bank++;
+        pb.isList  = true;
+        pb.is16Bit = true;
+        pb.fr1     = ((uint32_t)ids[1] << 16) | ids[0];
+        pb.fr2     = ((uint32_t)ids[3] << 16) | ids[2];
+        banks.push_back(pb);
+    }
+
+    for (size_t i = 0; i < exact32.size(); i += 2)
+    {
+        PlannedBank pb;
+        pb.bank    = bank++;
+        pb.isList  = true;
+        pb.is16Bit = false;
+        pb.fr1     = exact32[i].code;
+        pb.fr2     = (i + 1 < exact32.size()) ? exact32[i + 1].code : exact32[i].code;
+        banks.push_back(pb);
+    }
+
+    for (const auto& e : mask32)
+    {
+        PlannedBank pb;
+        pb.bank    = bank++;
+        pb.isList  = false;
+        pb.is16Bit = false;
+        pb.fr1     = e.code;
+        pb.fr2     = e.care;
+        banks.push_back(pb);
+    }
+
+    return banks;
+}
+
+/*************************************************************************************************/
+/* Private function definitions ---------------------------------------------------------------- */
+namespace
+{
+int CountOnes(uint32_t v)
+{
+    int count = 0;
+    while (v != 0)
+    {
+        v &= v - 1;
+        count++;
+    }
+    return count;
+}
+
+bool AcceptsStd(const Entry& e)
+{
+    return ((e.care & IDE_BIT) == 0) || ((e.code & IDE_BIT) == 0);
+}
+
+bool AcceptsExt(const Entry& e)
+{
+    return ((e.care & IDE_BIT) == 0) || ((e.code & IDE_BIT) != 0);
+}
+
+bool IsExact(const Entry& e)
+{
+    if ((e.care & (IDE_BIT | RTR_BIT)) != (IDE_BIT | RTR_BIT))
+    {
+        return false;
+    }
+    uint32_t idMask = ((e.code & IDE_BIT) == 0) ? STID_MASK : ID29_MASK;
+    return (e.care & idMask) == idMask;
+}
+
+Kind GetKind(const Entry& e)
+{
+    bool isStd = ((e.care & IDE_BIT) != 0) && ((e.code & IDE_BIT) == 0);
+    if (isStd)
+    {
+        return IsExact(e) ? Kind::StdExact : Kind::StdMask;
+    }
+    return IsExact(e) ? Kind::Exact32 : Kind::Mask32;
+}
+
+uint64_t GetSize(const Entry& e)
+{
+    uint64_t size = 0;
+    if (AcceptsStd(e))
+    {
+        size += (uint64_t)1 << (11 - CountOnes(e.care & STID_MASK));
+    }
+    if (AcceptsExt(e))
+    {
+        size += (uint64_t)1 << (29 - CountOnes(e.care & ID29_MASK));
+    }
+    return size;
+}
+
+/**
+ * @brief   Smallest entry that accepts everything that both `a` and `b` accept.
+ */
+Entry Cover(const Entry& a, const Entry& b)
+{
+    Entry e;
+    e.care = a.care & b.care & ~(a.code ^ b.code);
+    e.code = a.code & e.care;
+    return e;
+}
+
+bool Contains(const Entry& outer, const Entry& inner)
+{
+    return ((inner.care & outer.care) == outer.care) &&
+           (((inner.code ^ outer.code) & outer.care) == 0);
+}
+
+/**
+ * @brief   Converts a standard identifier from the 32-bit to the 16-bit filter register format.
+ */
+uint16_t To16Bit(uint32_t v)
+{
+    return (uint16_t)(((v >> 21) << 5) | (((v & RTR_BIT) != 0) ? 0x0010 : 0x0000) |
+                      (((v & IDE_BIT) != 0) ? 0x0008 : 0x0000));
+}
+
+/**
+ * @brief   Number of banks needed for a set of entries.
+ *          This must follow what @ref PackFilterEntries does.
+ */
+size_t CountBanks(KindCount c)
+{
+    size_t banks = (c.stdMask + 1) / 2;
+    if (((c.stdMask % 2) == 1) && (c.stdExact > 0))
+    {
+        c.stdExact--;
+    }
+
+    size_t leftover = c.stdExact % 4;
+    banks += c.stdExact / 4;
+    banks += (c.exact32 + 1) / 2;
+    if ((leftover == 1) && ((c.exact32 % 2) == 1))
+    {
+        leftover = 0;
+    }
+    if (leftover != 0)
+    {
+        banks++;
+    }
+
+    return banks + c.mask32;
+}
+
+/**
+ * @brief   Sorts the ranges and fuses those that overlap or touch.
+ */
+void Normalize(std::vector<FilterPlanner::Range>& ranges)
+{
+    if (ranges.empty())
+    {
+        return;
+    }
+
+    std::sort(ranges.begin(),
+              ranges.end(),
+              [](const FilterPlanner::Range& a, const FilterPlanner::Range& b)
+              { return a.first < b.first; });
+
+    std::vector<FilterPlanner::Range> out;
+    out.push_back(ranges.front());
+    for (size_t i = 1; i < ranges.size(); i++)
+    {
+        if (ranges[i].first <= (uint64_t)out.back().last + 1)
+        {
+            out.back().last = std::max(out.back().last, ranges[i].last);
+        }
+        else
+        {
+            out.push_back(ranges[i]);
+        }
+    }
+
+    ranges = out;
+}
+
+/**
+ * @brief   Splits the ranges into the smallest set of aligned power-of-two blocks.
+ */
+void Decompose(const std::vector<FilterPlanner::Range>& ranges,
+               bool                                     extended,
+               bool                                     acceptRemote,
+               std::vector<Entry>&                      outEntries)
+{
+    const int      idShift = extended ? 3 : 21;
+    const uint32_t idMax   = extended ? FilterPlanner::EXT_ID_MAX : FilterPlanner::STD_ID_MAX;
+    const uint32_t flags   = IDE_BIT | (acceptRemote ? 0 : RTR_BIT);
+
+    for (const auto& r : ranges)
+    {
+        uint64_t id = r.first;
+        while (id <= r.last)
+        {
+            // Grow the block as long as it stays aligned and inside of the range.
+            int bits = 0;
+            while ((bits < 29) && ((id & (((uint64_t)1 << (bits + 1)) - 1)) == 0) &&
+                   (id + ((uint64_t)1 << (bits + 1)) - 1 <= r.last))
+            {
+                bits++;
+            }
+
+            Entry e;
+            e.care = ((idMax & ~(((uint32_t)1 << bits) - 1)) << idShift) | flags;
+            e.code = ((uint32_t)id << idShift) | (extended ? IDE_BIT : 0);
+            outEntries.push_back(e);
+
+            id += (uint64_t)1 << bits;
+        }
+    }
+}
+}    // namespace
+}    // namespace CEP_CAN
+
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
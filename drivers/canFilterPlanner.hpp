@@ -0,0 +1,151 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  can
+ * @{
+ * @file        canFilterPlanner.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/08
+ *
+ * @brief       Computes the bxCAN filter banks needed to accept a set of identifiers.
+ *
+ * The planner takes the identifiers and identifier ranges an application subscribes to and packs
+ * them into as few filter banks as possible:
+ *  - Single standard IDs go in 16-bit list banks (4 per bank).
+ *  - Aligned standard ID blocks go in 16-bit mask banks (2 per bank).
+ *  - Single extended IDs go in 32-bit list banks (2 per bank).
+ *  - Aligned extended ID blocks go in 32-bit mask banks (1 per bank).
+ *
+ * If the exact set does not fit in the banks available, the entries that cost the fewest
+ * unwanted identifiers are merged together until it does. The resulting plan reports how many
+ * identifiers the hardware will let through that were not asked for.
+ *
+ * Plans are applied by @ref CanModule::ConfigureFilters.
+ */
+#ifndef CAN_FILTER_PLANNER_HPP_
+#define CAN_FILTER_PLANNER_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_CAN) || defined(NILAI_TEST)
+#    include <cstddef>
+#    include <cstdint>
+#    include <vector>
+
+namespace CEP_CAN
+{
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+/**
+ * @brief   A filter bank computed by the @ref FilterPlanner.
+ *
+ * fr1 and fr2 hold the raw values of the bank's two filter registers, laid out as described in
+ * the bxCAN section of the reference manual.
+ */
+struct PlannedBank
+{
+    uint8_t  bank    = 0;
+    bool     isList  = false;    //!< Identifier list mode if true, identifier mask mode otherwise.
+    bool     is16Bit = false;    //!< Dual 16-bit scale if true, single 32-bit scale otherwise.
+    uint32_t fr1     = 0;
+    uint32_t fr2     = 0;
+};
+
+struct FilterPlan
+{
+    std::vector<PlannedBank> banks;
+
+    //! First bank the plan was allowed to use.
+    uint8_t firstBank = 0;
+    //! Number of banks the plan was allowed to use.
+    size_t bankBudget = 0;
+
+    //! Number of distinct identifiers that were subscribed to.
+    uint64_t subscribedIds = 0;
+    //! Number of distinct identifiers accepted by the banks.
+    //! This is an upper bound when merged extended identifier blocks overlap.
+    uint64_t acceptedIds = 0;
+
+    [[nodiscard]] bool IsExact() const { return acceptedIds == subscribedIds; }
+
+    /**
+     * @brief   Fraction of the identifiers accepted by the hardware that were not subscribed to.
+     * @return  0.0f for an exact plan, up to 1.0f.
+     */
+    [[nodiscard]] float GetFalsePositiveRate() const
+    {
+        if (acceptedIds == 0)
+        {
+            return 0.0f;
+        }
+        return (float)(acceptedIds - subscribedIds) / (float)acceptedIds;
+    }
+};
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+class FilterPlanner
+{
+public:
+    /**
+     * @param   acceptRemoteFrames  If true, remote frames for the subscribed identifiers are
+     *                              accepted along with the data frames.
+     */
+    explicit FilterPlanner(bool acceptRemoteFrames = false)
+    : m_acceptRemoteFrames(acceptRemoteFrames)
+    {
+    }
+
+    void AddId(uint32_t id, bool extended = false) { AddRange(id, id, extended); }
+    void AddRange(uint32_t first, uint32_t last, bool extended = false);
+    void Clear()
+    {
+        m_stdRanges.clear();
+        m_extRanges.clear();
+    }
+
+    [[nodiscard]] FilterPlan Plan(size_t maxBanks, uint8_t firstBank = 0) const;
+
+public:
+    /**
+     * @brief   An identifier block, expressed in the 32-bit filter register format.
+     *
+     * Bits set in `care` must match `code`, the others are don't-care.
+     */
+    struct Entry
+    {
+        uint32_t code = 0;
+        uint32_t care = 0;
+    };
+
+    struct Range
+    {
+        uint32_t first = 0;
+        uint32_t last  = 0;
+    };
+
+    static constexpr uint32_t STD_ID_MAX = 0x000007FF;
+    static constexpr uint32_t EXT_ID_MAX = 0x1FFFFFFF;
+
+private:
+    bool               m_acceptRemoteFrames = false;
+    std::vector<Range> m_stdRanges;
+    std::vector<Range> m_extRanges;
+};
+
+/**
+ * @brief   Packs a set of entries into filter banks, in the cheapest way possible.
+ * @param   entries     The entries to pack.
+ * @param   firstBank   The number of the first bank to use.
+ * @return  The packed banks.
+ */
+std::vector<PlannedBank> PackFilterEntries(const std::vector<FilterPlanner::Entry>& entries,
+                                           uint8_t                                  firstBank = 0);
+}    // namespace CEP_CAN
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,125 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  can
+ * @{
+ * @file        canFrame.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/12
+ *
+ * @brief       Compact, HAL-independent representation of a CAN frame.
+ *
+ * A @ref CEP_CAN::CompactFrame takes 16 bytes, less than half of a @ref CEP_CAN::Frame, and can
+ * be compared and copied a word at a time. It is what the RX ring, the recorder and the replay
+ * engine store; the HAL structures are only used when talking to the peripheral.
+ */
+#ifndef CAN_FRAME_HPP_
+#define CAN_FRAME_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_CAN) || defined(NILAI_TEST)
+#    include <cstddef>
+#    include <cstdint>
+
+namespace CEP_CAN
+{
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+/**
+ * @brief   A CAN frame packed in 16 bytes.
+ *
+ * Layout:
+ *  - header:   [28:0] identifier, [29] extended identifier flag, [30] remote frame flag.
+ *  - info:     [3:0] data length code, [31:4] timestamp in milliseconds (wraps every ~74 hours).
+ *  - data:     payload, byte 0 in bits [7:0]. Bytes past the DLC are always 0.
+ */
+struct CompactFrame
+{
+    uint32_t header = 0;
+    uint32_t info   = 0;
+    uint64_t data   = 0;
+
+    static constexpr uint32_t ID_MASK        = 0x1FFFFFFF;
+    static constexpr uint32_t EXTENDED_FLAG  = 0x20000000;
+    static constexpr uint32_t REMOTE_FLAG    = 0x40000000;
+    static constexpr uint32_t DLC_MASK       = 0x0000000F;
+    static constexpr uint32_t TIMESTAMP_POS  = 4;
+    static constexpr uint32_t TIMESTAMP_MASK = 0x0FFFFFFF;
+    static constexpr uint8_t  MAX_DLC        = 8;
+
+    /**
+     * @brief   Builds a frame.
+     * @param   id          Identifier of the frame. Truncated to 11 bits if not extended.
+     * @param   extended    True for a 29-bit identifier.
+     * @param   remote      True for a remote frame.
+     * @param   payload     Data of the frame, can be nullptr if len is 0.
+     * @param   len         Number of data bytes, capped at 8.
+     * @param   timestamp   Time at which the frame was received or sent, in milliseconds.
+     */
+    static CompactFrame Make(uint32_t       id,
+                             bool           extended,
+                             bool           remote,
+                             const uint8_t* payload,
+                             size_t         len,
+                             uint32_t       timestamp = 0)
+    {
+        CompactFrame frame;
+        uint8_t      dlc = (uint8_t)(len > MAX_DLC ? MAX_DLC : len);
+
+        frame.header = (id & (extended ? ID_MASK : 0x7FFU)) | (extended ? EXTENDED_FLAG : 0U) |
+                       (remote ? REMOTE_FLAG : 0U);
+        frame.SetInfo(dlc, timestamp);
+
+        if (payload != nullptr)
+        {
+            for (size_t i = 0; i < dlc; i++)
+            {
+                frame.data |= (uint64_t)payload[i] << (8 * i);
+            }
+        }
+        return frame;
+    }
+
+    [[nodiscard]] constexpr uint32_t GetId() const { return header & ID_MASK; }
+    [[nodiscard]] constexpr bool     IsExtended() const { return (header & EXTENDED_FLAG) != 0; }
+    [[nodiscard]] constexpr bool     IsRemote() const { return (header & REMOTE_FLAG) != 0; }
+    [[nodiscard]] constexpr uint8_t  GetDlc() const { return (uint8_t)(info & DLC_MASK); }
+    [[nodiscard]] constexpr uint32_t GetTimestamp() const { return info >> TIMESTAMP_POS; }
+    [[nodiscard]] constexpr uint8_t  GetByte(size_t i) const { return (uint8_t)(data >> (8 * i)); }
+
+    constexpr void SetInfo(uint8_t dlc, uint32_t timestamp)
+    {
+        info = ((timestamp & TIMESTAMP_MASK) << TIMESTAMP_POS) | (dlc & DLC_MASK);
+    }
+    constexpr void SetTimestamp(uint32_t timestamp) { SetInfo(GetDlc(), timestamp); }
+
+    //! Copies the payload into `out`, which must be able to hold 8 bytes.
+    void CopyData(uint8_t* out) const
+    {
+        for (size_t i = 0; i < MAX_DLC; i++)
+        {
+            out[i] = GetByte(i);
+        }
+    }
+
+    /**
+     * @brief   Two frames are equal if they have the same identifier, flags, DLC and payload.
+     *          The timestamp is ignored.
+     */
+    constexpr bool operator==(const CompactFrame& other) const
+    {
+        return (header == other.header) && (((info ^ other.info) & DLC_MASK) == 0) &&
+               (data == other.data);
+    }
+    constexpr bool operator!=(const CompactFrame& other) const { return !(*this == other); }
+};
+static_assert(sizeof(CompactFrame) == 16, "CompactFrame must stay 16 bytes");
+}    // namespace CEP_CAN
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -23,26 +23,20 @@ CanModule::CanModule(CAN_HandleTypeDef* handle, const std::string& label)
     : m_handle(handle), m_label(label)
 {
     CEP_ASSERT(handle != nullptr, "CAN Handle is NULL!");
-    m_framesReceived.reserve(5);
-    m_callbacks =
-        std::map<CEP_CAN::Irq, std::function<void( )>>({{CEP_CAN::Irq::TxMailboxEmpty, {}},
-                                                        {CEP_CAN::Irq::Fifo0MessagePending, {}},
-                                                        {CEP_CAN::Irq::Fifo0Full, {}},
-                                                        {CEP_CAN::Irq::Fifo0Overrun, {}},
-                                                        {CEP_CAN::Irq::Fifo1MessagePending, {}},
-                                                        {CEP_CAN::Irq::Fifo1Full, {}},
-                                                        {CEP_CAN::Irq::Fifo1Overrun, {}},
-                                                        {CEP_CAN::Irq::Wakeup, {}},
-                                                        {CEP_CAN::Irq::SleepAck, {}},
-                                                        {CEP_CAN::Irq::ErrorWarning, {}},
-                                                        {CEP_CAN::Irq::ErrorPassive, {}},
-                                                        {CEP_CAN::Irq::BusOffError, {}},
-                                                        {CEP_CAN::Irq::LastErrorCode, {}},
-                                                        {CEP_CAN::Irq::ErrorStatus, {}}});
+
+    // Enable the DWT cycle counter, used to measure the time spent in HandleIrq.
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#    if defined(__CORE_CM7_H_GENERIC)
+    // The Cortex-M7's DWT ignores writes until it is unlocked.
+    DWT->LAR = 0xC5ACCE55;
+#    endif
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
     HAL_CAN_Start(m_handle);
+    m_bitrate         = ComputeBitrate( );
+    m_lastStatsUpdate = HAL_GetTick( );
 
-    LOG_INFO("[%s]: Initialized", m_label.c_str( ));
+    LOG_INFO("[%s]: Initialized, %i bps", m_label.c_str( ), (int)m_bitrate);
 }
 
 CanModule::~CanModule( ) { HAL_CAN_Stop(m_handle); }
@@ -57,11 +51,43 @@ bool CanModule::DoPost( )
     return true;
 }
 
-void CanModule::Run( ) {}
+void CanModule::Run( )
+{
+    uint32_t now = HAL_GetTick( );
+    if (now - m_lastStatsUpdate >= STATS_PERIOD)
+    {
+        // The counters are 64-bit and incremented by the interrupt, their reads could tear.
+        uint32_t primask = __get_PRIMASK( );
+        __disable_irq( );
+        m_stats.UpdateRates(now - m_lastStatsUpdate, m_bitrate);
+        __set_PRIMASK(primask);
+        m_lastStatsUpdate = now;
+    }
+}
+
+CEP_CAN::Statistics CanModule::GetStatistics( ) const
+{
+    uint32_t primask = __get_PRIMASK( );
+    __disable_irq( );
+    CEP_CAN::Statistics stats = m_stats;
+    __set_PRIMASK(primask);
+    return stats;
+}
+
+void CanModule::ResetStatistics( )
+{
+    uint32_t primask = __get_PRIMASK( );
+    __disable_irq( );
+    m_stats = {};
+    __set_PRIMASK(primask);
+}
 
 void CanModule::ConfigureFilter(const CEP_CAN::FilterConfiguration& config)
 {
-    uint64_t hash = ((uint64_t)config.filterId.fullId << 32) | config.maskId.fullId;
+    CEP_ASSERT(config.bank < CEP_CAN::FILTER_BANK_COUNT,
+               "In %s::ConfigureFilter: Invalid filter bank %i!",
+               m_label.c_str( ),
+               config.bank);
 
     CAN_FilterTypeDef filter = AssertAndConvertFilterStruct(config);
 
@@ -70,36 +96,128 @@ void CanModule::ConfigureFilter(const CEP_CAN::FilterConfiguration& config)
         CEP_ASSERT(false, "In %s::ConfigureFilter: Unable to configure filter!", m_label.c_str( ));
     }
 
-    m_filters[hash] = config;
+    m_filters[config.bank] = config;
 }
 
-CEP_CAN::Frame CanModule::ReceiveFrame( )
-{
-    CEP_CAN::Frame frame = m_framesReceived.back( );
-    m_framesReceived.pop_back( );
-    return frame;
-}
-CEP_CAN::Status
-    CanModule::TransmitFrame(uint32_t addr, const std::vector<uint8_t>& data, bool forceExtended)
+/**
+ * @brief   Programs the filter banks computed by a @ref CEP_CAN::FilterPlanner.
+ *
+ * The banks of the plan's budget that the plan doesn't use are disabled.
+ *
+ * @param   plan    The plan to apply.
+ * @param   fifo    The FIFO that the accepted frames go to.
+ */
+void CanModule::ConfigureFilters(const CEP_CAN::FilterPlan& plan, CEP_CAN::FilterFifoAssignation fifo)
 {
-    CAN_TxHeaderTypeDef head = {0, 0, 0, 0, 0, (FunctionalState)0};
-    head.StdId               = addr & 0x000007FF;
-    head.ExtId               = addr & 0x1FFFFFFF;
-    // If address is higher than 0x7FF, use extended ID.
-    if ((addr > 0x7FF) || forceExtended)
+    CEP_ASSERT(plan.banks.size( ) <= plan.bankBudget,
+               "In %s::ConfigureFilters: Plan uses more banks than it is allowed to!",
+               m_label.c_str( ));
+
+    for (const auto& bank : plan.banks)
     {
-        head.IDE = CAN_ID_EXT;
+        CEP_CAN::FilterConfiguration config;
+        config.fifo  = fifo;
+        config.bank  = bank.bank;
+        config.mode  = bank.isList ? CEP_CAN::FilterMode::IdList : CEP_CAN::FilterMode::IdMask;
+        config.scale = bank.is16Bit ? CEP_CAN::FilterScale::Scale16bit
+                                    : CEP_CAN::FilterScale::Scale32bit;
+
+        if (bank.is16Bit)
+        {
+            // HAL packs FR1 as [MaskIdLow:IdLow] and FR2 as [MaskIdHigh:IdHigh] in 16-bit scale.
+            config.filterId.idLow    = (uint16_t)(bank.fr1 & 0x0000FFFF);
+            config.maskId.maskIdLow  = (uint16_t)(bank.fr1 >> 16);
+            config.filterId.idHigh   = (uint16_t)(bank.fr2 & 0x0000FFFF);
+            config.maskId.maskIdHigh = (uint16_t)(bank.fr2 >> 16);
+        }
+        else
+        {
+            config.filterId.idLow    = (uint16_t)(bank.fr1 & 0x0000FFFF);
+            config.filterId.idHigh   = (uint16_t)(bank.fr1 >> 16);
+            config.maskId.maskIdLow  = (uint16_t)(bank.fr2 & 0x0000FFFF);
+            config.maskId.maskIdHigh = (uint16_t)(bank.fr2 >> 16);
+        }
+
+        ConfigureFilter(config);
+    }
+
+    size_t lastBank = std::min((size_t)plan.firstBank + plan.bankBudget, CEP_CAN::FILTER_BANK_COUNT);
+    for (size_t bank = plan.firstBank + plan.banks.size( ); bank < lastBank; bank++)
+    {
+        CEP_CAN::FilterConfiguration config;
+        config.bank     = (uint8_t)bank;
+        config.activate = CEP_CAN::FilterEnable::Disable;
+        ConfigureFilter(config);
+    }
+
+    if (plan.IsExact( ))
+    {
+        LOG_INFO("[%s]: %i filter banks configured", m_label.c_str( ), (int)plan.banks.size( ));
     }
     else
     {
-        head.IDE = CAN_ID_STD;
+        LOG_WARNING("[%s]: %i filter banks configured, %0.2f%% of accepted IDs are unwanted",
+                    m_label.c_str( ),
+                    (int)plan.banks.size( ),
+                    plan.GetFalsePositiveRate( ) * 100.0f);
     }
+}
+
+/**
+ * @brief   Gets the oldest frame that hasn't been read yet.
+ * @return  The frame, or an empty frame if none are available.
+ */
+CEP_CAN::Frame CanModule::ReceiveFrame( )
+{
+    CEP_CAN::CompactFrame frame;
+    ReceiveFrame(frame);
+    return CEP_CAN::ToFrame(frame);
+}
 
+/**
+ * @brief   Gets the oldest frame that hasn't been read yet, without converting it.
+ * @param   frame   Where to put the frame.
+ * @return  True if a frame was available, false otherwise.
+ */
+bool CanModule::ReceiveFrame(CEP_CAN::CompactFrame& frame)
+{
+    if (!m_rxFrames.Pop(frame))
+    {
+        m_status |= CEP_CAN::Status::NO_PACKET_RECEIVED;
+        return false;
+    }
+    return true;
+}
+
+CEP_CAN::Status
+    CanModule::TransmitFrame(uint32_t addr, const std::vector<uint8_t>& data, bool forceExtended)
+{
+    return TransmitFrame(addr, data.data( ), data.size( ), forceExtended);
+}
+
+CEP_CAN::Status
+    CanModule::TransmitFrame(uint32_t addr, const uint8_t* data, size_t len, bool forceExtended)
+{
+    // If address is higher than 0x7FF, use extended ID.
+    bool extended = (addr > 0x7FF) || forceExtended;
     // If we have data, this is a data frame. Else it's a remote frame.
-    head.RTR =
-        data.empty( ) ? (uint32_t)CEP_CAN::FrameType::Remote : (uint32_t)CEP_CAN::FrameType::Data;
-    // Cap amount of data at 8 bytes.
-    head.DLC = std::min(data.size( ), (size_t)8);
+    bool remote = (data == nullptr) || (len == 0);
+
+    return TransmitFrame(CEP_CAN::CompactFrame::Make(addr, extended, remote, data, len));
+}
+
+CEP_CAN::Status CanModule::TransmitFrame(const CEP_CAN::CompactFrame& frame)
+{
+    CAN_TxHeaderTypeDef head = {0, 0, 0, 0, 0, (FunctionalState)0};
+    head.StdId               = frame.GetId( ) & 0x000007FF;
+    head.ExtId               = frame.GetId( );
+    head.IDE                 = frame.IsExtended( ) ? CAN_ID_EXT : CAN_ID_STD;
+    head.RTR = frame.IsRemote( ) ? (uint32_t)CEP_CAN::FrameType::Remote
+                                 : (uint32_t)CEP_CAN::FrameType::Data;
+    head.DLC = frame.GetDlc( );
+
+    std::array<uint8_t, 8> data = {};
+    frame.CopyData(data.data( ));
 
     if (WaitForFreeMailbox( ) == false)
     {
@@ -109,40 +227,41 @@ CEP_CAN::Status
 
     uint32_t buffNum = 0;
 
+    // A short frame can be sent, and its interrupt handled, before the mailbox is stamped.
+    // The statistics are also updated by the interrupt.
+    uint32_t primask = __get_PRIMASK( );
+    __disable_irq( );
     // Add frame to the mailbox.
-    // Using const_cast here because data.data() is a const uint8_t* and not a uint8_t*.
-    if (HAL_CAN_AddTxMessage(m_handle, &head, const_cast<uint8_t*>(data.data( )), &buffNum) !=
-        HAL_OK)
+    HAL_StatusTypeDef status = HAL_CAN_AddTxMessage(m_handle, &head, data.data( ), &buffNum);
+    if (status == HAL_OK)
+    {
+        // buffNum is CAN_TX_MAILBOX0, 1 or 2, one bit per mailbox.
+        m_txQueuedAt[__builtin_ctz(buffNum)] = DWT->CYCCNT;
+        m_stats.CountTx(frame.IsExtended( ), frame.GetDlc( ));
+    }
+    __set_PRIMASK(primask);
+
+    if (status != HAL_OK)
     {
         LOG_ERROR("In %s::TransmitFrame: Unable to add frame to mailbox", m_label.c_str( ));
         return CEP_CAN::Status::TX_ERROR;
     }
 
-    return CEP_CAN::Status::ERROR_NONE;
-}
-
-CEP_CAN::Status
-    CanModule::TransmitFrame(uint32_t addr, const uint8_t* data, size_t len, bool forceExtended)
-{
-    std::vector<uint8_t> dataV;
-
-    if (data != nullptr && len > 0)
+    if (m_frameObserver)
     {
-        dataV.reserve(len);
-        for (size_t i = 0; i < len; i++)
-        {
-            dataV.emplace_back(data[i]);
-        }
+        CEP_CAN::CompactFrame sent = frame;
+        sent.SetTimestamp(HAL_GetTick( ));
+        m_frameObserver(sent, true);
     }
 
-    return TransmitFrame(addr, dataV, forceExtended);
+    return CEP_CAN::Status::ERROR_NONE;
 }
 
-void CanModule::SetCallback(CEP_CAN::Irq irq, const std::function<void( )>& callback)
+void CanModule::SetCallback(CEP_CAN::Irq irq, const CEP_CAN::IrqCallback& callback)
 {
-    m_callbacks[irq] = callback;
+    m_callbacks[CEP_CAN::IrqToIndex(irq)] = callback;
 }
-void CanModule::ClearCallback(CEP_CAN::Irq irq) { m_callbacks[irq] = std::function<void( )>( ); }
+void CanModule::ClearCallback(CEP_CAN::Irq irq) { m_callbacks[CEP_CAN::IrqToIndex(irq)] = nullptr; }
 
 void CanModule::EnableInterrupt(CEP_CAN::Irq irq) { __HAL_CAN_ENABLE_IT(m_handle, (uint32_t)irq); }
 void CanModule::DisableInterrupt(CEP_CAN::Irq irq)
@@ -152,6 +271,8 @@ void CanModule::DisableInterrupt(CEP_CAN::Irq irq)
 
 void CanModule::HandleIrq( )
 {
+    uint32_t start = DWT->CYCCNT;
+
     // CAN Interrupt Register.
     uint32_t ier = m_handle->Instance->IER;
 
@@ -160,38 +281,157 @@ void CanModule::HandleIrq( )
     HandleTxMailbox2Irq(ier);
     HandleRxFifo0Irq(ier);
     HandleRxFifo1Irq(ier);
+    if (m_drainRxFifos &&
+        ((ier & (CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO0_FULL | CAN_IT_RX_FIFO1_MSG_PENDING |
+                 CAN_IT_RX_FIFO1_FULL)) != 0))
+    {
+        DrainRxFifos( );
+    }
     HandleSleepIrq(ier);
     HandleWakeupIrq(ier);
     HandleErrorIrq(ier);
+
+    m_irqLatency.Add(DWT->CYCCNT - start);
 }
 
 void CanModule::HandleFrameReception(CEP_CAN::RxFifo fifo)
 {
-    CEP_CAN::Frame frame = CEP_CAN::Frame( );
-    HAL_CAN_GetRxMessage(m_handle, (uint32_t)fifo, &frame.frame, frame.data.data( ));
-    frame.timestamp = HAL_GetTick( );
-
-    m_framesReceived.push_back(frame);
+    size_t queued = 0;
+    ReadFrameIntoRing(fifo, queued);
+    m_rxFrames.Commit(queued);
 
     switch (fifo)
     {
         case CEP_CAN::RxFifo::Fifo0:
-            if (m_callbacks[CEP_CAN::Irq::Fifo0MessagePending])
-            {
-                m_callbacks[CEP_CAN::Irq::Fifo0MessagePending]( );
-            }
+            InvokeCallback(CEP_CAN::Irq::Fifo0MessagePending);
             break;
         case CEP_CAN::RxFifo::Fifo1:
-            if (m_callbacks[CEP_CAN::Irq::Fifo1MessagePending])
-            {
-                m_callbacks[CEP_CAN::Irq::Fifo1MessagePending]( );
-            }
+            InvokeCallback(CEP_CAN::Irq::Fifo1MessagePending);
             break;
         default:
             CEP_ASSERT(false, "In %s::HandleFrameReception, invalid FIFO!", m_label.c_str( ));
     }
 }
 
+/**
+ * @brief   Reads the oldest frame of a FIFO into the RX ring, without making it available yet.
+ *          The frame is released from the FIFO even if there is no room left for it.
+ * @param   fifo    The FIFO to read from.
+ * @param   queued  Number of frames written in the ring but not yet committed.
+ *                  Incremented if the frame is written.
+ */
+void CanModule::ReadFrameIntoRing(CEP_CAN::RxFifo fifo, size_t& queued)
+{
+    if (queued < m_rxFrames.Free( ))
+    {
+        // Read the mailbox straight into the compact representation.
+        const CAN_FIFOMailBox_TypeDef& mailbox = m_handle->Instance->sFIFOMailBox[(uint32_t)fifo];
+        uint32_t                       rir     = mailbox.RIR;
+
+        CEP_CAN::CompactFrame& frame = m_rxFrames.Slot(queued);
+        if ((rir & CAN_RI0R_IDE) != 0)
+        {
+            frame.header = ((rir >> CAN_RI0R_EXID_Pos) & CEP_CAN::CompactFrame::ID_MASK) |
+                           CEP_CAN::CompactFrame::EXTENDED_FLAG;
+        }
+        else
+        {
+            frame.header = (rir >> CAN_RI0R_STID_Pos) & 0x7FF;
+        }
+        if ((rir & CAN_RI0R_RTR) != 0)
+        {
+            frame.header |= CEP_CAN::CompactFrame::REMOTE_FLAG;
+        }
+
+        uint8_t dlc = (uint8_t)((mailbox.RDTR & CAN_RDT0R_DLC) >> CAN_RDT0R_DLC_Pos);
+        dlc         = std::min(dlc, CEP_CAN::CompactFrame::MAX_DLC);
+        frame.SetInfo(dlc, HAL_GetTick( ));
+        frame.data = ((uint64_t)mailbox.RDHR << 32) | mailbox.RDLR;
+        // Keep the bytes past the DLC cleared, frames are compared a word at a time.
+        if (dlc < CEP_CAN::CompactFrame::MAX_DLC)
+        {
+            frame.data &= (1ULL << (8 * dlc)) - 1;
+        }
+        queued++;
+
+        m_stats.CountRx(frame.IsExtended( ), dlc);
+        if (m_frameObserver)
+        {
+            m_frameObserver(frame, false);
+        }
+    }
+    else
+    {
+        m_status |= CEP_CAN::Status::ERROR_DROPPED_PKT;
+        m_stats.droppedFrames++;
+    }
+
+    // Release the mailbox.
+    if (fifo == CEP_CAN::RxFifo::Fifo0)
+    {
+        SET_BIT(m_handle->Instance->RF0R, CAN_RF0R_RFOM0);
+    }
+    else
+    {
+        SET_BIT(m_handle->Instance->RF1R, CAN_RF1R_RFOM1);
+    }
+}
+
+/**
+ * @brief   Reads every frame pending in both RX FIFOs and makes them available all at once.
+ *
+ * The message counters are re-read after each frame, so frames that arrive while draining are
+ * picked up in the same interrupt.
+ */
+void CanModule::DrainRxFifos( )
+{
+    size_t queued     = 0;
+    bool   gotFifo0   = false;
+    bool   gotFifo1   = false;
+    bool   hasPending = true;
+
+    while (hasPending)
+    {
+        hasPending = false;
+        if ((m_handle->Instance->RF0R & CAN_RF0R_FMP0) != 0)
+        {
+            ReadFrameIntoRing(CEP_CAN::RxFifo::Fifo0, queued);
+            gotFifo0   = true;
+            hasPending = true;
+        }
+        if ((m_handle->Instance->RF1R & CAN_RF1R_FMP1) != 0)
+        {
+            ReadFrameIntoRing(CEP_CAN::RxFifo::Fifo1, queued);
+            gotFifo1   = true;
+            hasPending = true;
+        }
+    }
+
+    m_rxFrames.Commit(queued);
+
+    if (gotFifo0)
+    {
+        InvokeCallback(CEP_CAN::Irq::Fifo0MessagePending);
+    }
+    if (gotFifo1)
+    {
+        InvokeCallback(CEP_CAN::Irq::Fifo1MessagePending);
+    }
+}
+
+/**
+ * @brief   Records the latency of a successful transmission and calls the TX callback.
+ * @param   mailbox The mailbox that completed, 0 to 2.
+ */
+void CanModule::HandleTxComplete(size_t mailbox)
+{
+    uint32_t cycles = DWT->CYCCNT - m_txQueuedAt[mailbox];
+    m_stats.txLatency.Add(cycles / (SystemCoreClock / 1000000));
+
+    // If a callback is set, call it.
+    InvokeCallback(CEP_CAN::Irq::TxMailboxEmpty);
+}
+
 void CanModule::HandleTxMailbox0Irq(uint32_t ier)
 {
     // If Tx interrupts are enabled:
@@ -208,11 +448,7 @@ void CanModule::HandleTxMailbox0Irq(uint32_t ier)
             // Check Mailbox 0 Transmission complete.
             if ((tsrFlags & CAN_TSR_TXOK0) != 0)
             {
-                // If a callback is set, call it.
-                if (m_callbacks[CEP_CAN::Irq::TxMailboxEmpty])
-                {
-                    m_callbacks[CEP_CAN::Irq::TxMailboxEmpty]( );
-                }
+                HandleTxComplete(0);
             }
 
             else
@@ -221,12 +457,14 @@ void CanModule::HandleTxMailbox0Irq(uint32_t ier)
                 if ((tsrFlags & CAN_TSR_ALST0) != 0)
                 {
                     m_status |= CEP_CAN::Status::ERROR_TX_ALST0;
+                    m_stats.arbitrationLost[0]++;
                 }
 
                 // Check Transmission Error flag.
                 else if ((tsrFlags & CAN_TSR_TERR0) != 0)
                 {
                     m_status |= CEP_CAN::Status::ERROR_TX_TERR0;
+                    m_stats.transmitErrors[0]++;
                 }
                 else
                 {
@@ -260,11 +498,7 @@ void CanModule::HandleTxMailbox1Irq(uint32_t ier)
             // Check Mailbox 0 Transmission complete.
             if ((tsrFlags & CAN_TSR_TXOK1) != 0)
             {
-                // If a callback is set, call it.
-                if (m_callbacks[CEP_CAN::Irq::TxMailboxEmpty])
-                {
-                    m_callbacks[CEP_CAN::Irq::TxMailboxEmpty]( );
-                }
+                HandleTxComplete(1);
             }
 
             else
@@ -273,12 +507,14 @@ void CanModule::HandleTxMailbox1Irq(uint32_t ier)
                 if ((tsrFlags & CAN_TSR_ALST1) != 0)
                 {
                     m_status |= CEP_CAN::Status::ERROR_TX_ALST1;
+                    m_stats.arbitrationLost[1]++;
                 }
 
                 // Check Transmission Error flag.
                 else if ((tsrFlags & CAN_TSR_TERR1) != 0)
                 {
                     m_status |= CEP_CAN::Status::ERROR_TX_TERR1;
+                    m_stats.transmitErrors[1]++;
                 }
                 else
                 {
@@ -312,11 +548,7 @@ void CanModule::HandleTxMailbox2Irq(uint32_t ier)
             // Check Mailbox 0 Transmission complete.
             if ((tsrFlags & CAN_TSR_TXOK2) != 0)
             {
-                // If a callback is set, call it.
-                if (m_callbacks[CEP_CAN::Irq::TxMailboxEmpty])
-                {
-                    m_callbacks[CEP_CAN::Irq::TxMailboxEmpty]( );
-                }
+                HandleTxComplete(2);
             }
             else
             {
@@ -324,12 +556,14 @@ void CanModule::HandleTxMailbox2Irq(uint32_t ier)
                 if ((tsrFlags & CAN_TSR_ALST2) != 0)
                 {
                     m_status |= CEP_CAN::Status::ERROR_TX_ALST2;
+                    m_stats.arbitrationLost[2]++;
                 }
 
                 // Check Transmission Error flag.
                 else if ((tsrFlags & CAN_TSR_TERR2) != 0)
                 {
                     m_status |= CEP_CAN::Status::ERROR_TX_TERR2;
+                    m_stats.transmitErrors[2]++;
                 }
                 else
                 {
@@ -358,6 +592,7 @@ void CanModule::HandleRxFifo0Irq(uint32_t ier)
         {
             // Set CAN error code.
             m_status |= CEP_CAN::Status::ERROR_RX_FOV0;
+            m_stats.fifoOverruns[0]++;
 
             // Clear flag.
             __HAL_CAN_CLEAR_FLAG(m_handle, CAN_FLAG_FOV0);
@@ -374,7 +609,7 @@ void CanModule::HandleRxFifo0Irq(uint32_t ier)
             __HAL_CAN_CLEAR_FLAG(m_handle, CAN_FLAG_FF0);
 
             // While there's still unread frames in the FIFO:
-            while ((rf0r & CAN_RF0R_FMP0) != 0)
+            while (!m_drainRxFifos && ((m_handle->Instance->RF0R & CAN_RF0R_FMP0) != 0))
             {
                 // Read them.
                 HandleFrameReception(CEP_CAN::RxFifo::Fifo0);
@@ -386,7 +621,7 @@ void CanModule::HandleRxFifo0Irq(uint32_t ier)
     if ((ier & CAN_IT_RX_FIFO0_MSG_PENDING) != 0)
     {
         // Check if message is still pending.
-        if ((m_handle->Instance->RF0R & CAN_RF0R_FMP0) != 0)
+        if (!m_drainRxFifos && ((m_handle->Instance->RF0R & CAN_RF0R_FMP0) != 0))
         {
             HandleFrameReception(CEP_CAN::RxFifo::Fifo0);
         }
@@ -404,6 +639,7 @@ void CanModule::HandleRxFifo1Irq(uint32_t ier)
         {
             // Set CAN error code.
             m_status |= CEP_CAN::Status::ERROR_RX_FOV1;
+            m_stats.fifoOverruns[1]++;
 
             // Clear flag.
             __HAL_CAN_CLEAR_FLAG(m_handle, CAN_FLAG_FOV1);
@@ -420,7 +656,7 @@ void CanModule::HandleRxFifo1Irq(uint32_t ier)
             __HAL_CAN_CLEAR_FLAG(m_handle, CAN_FLAG_FF1);
 
             // While there's still unread frames in the FIFO:
-            while ((rf1r & CAN_RF1R_FMP1) != 0)
+            while (!m_drainRxFifos && ((m_handle->Instance->RF1R & CAN_RF1R_FMP1) != 0))
             {
                 // Read them.
                 HandleFrameReception(CEP_CAN::RxFifo::Fifo1);
@@ -432,7 +668,7 @@ void CanModule::HandleRxFifo1Irq(uint32_t ier)
     if ((ier & CAN_IT_RX_FIFO1_MSG_PENDING) != 0)
     {
         // Check if message is still pending.
-        if ((m_handle->Instance->RF1R & CAN_RF1R_FMP1) != 0)
+        if (!m_drainRxFifos && ((m_handle->Instance->RF1R & CAN_RF1R_FMP1) != 0))
         {
             HandleFrameReception(CEP_CAN::RxFifo::Fifo1);
         }
@@ -451,10 +687,7 @@ void CanModule::HandleSleepIrq(uint32_t ier)
             __HAL_CAN_CLEAR_FLAG(m_handle, CAN_FLAG_SLAKI);
 
             // Call the callback, if there's one.
-            if (m_callbacks[CEP_CAN::Irq::SleepAck])
-            {
-                m_callbacks[CEP_CAN::Irq::SleepAck]( );
-            }
+            InvokeCallback(CEP_CAN::Irq::SleepAck);
         }
     }
 }
@@ -471,10 +704,7 @@ void CanModule::HandleWakeupIrq(uint32_t ier)
             __HAL_CAN_CLEAR_FLAG(m_handle, CAN_FLAG_WKU);
 
             // If there's one, call the callback.
-            if (m_callbacks[CEP_CAN::Irq::Wakeup])
-            {
-                m_callbacks[CEP_CAN::Irq::Wakeup]( );
-            }
+            InvokeCallback(CEP_CAN::Irq::Wakeup);
         }
     }
 }
@@ -493,41 +723,36 @@ void CanModule::HandleErrorIrq(uint32_t ier)
             {
                 // Set status code.
                 m_status |= CEP_CAN::Status::ERROR_EWG;
+                m_stats.errorWarnings++;
 
                 // No need to clear the flag since it is read only.
 
-                if (m_callbacks[CEP_CAN::Irq::ErrorWarning])
-                {
-                    m_callbacks[CEP_CAN::Irq::ErrorWarning];
-                }
+                InvokeCallback(CEP_CAN::Irq::ErrorWarning);
             }
             // Check error passive flag.
             if (((ier & CAN_IT_ERROR_PASSIVE) != 0) && ((esr & CAN_ESR_EPVF) != 0))
             {
                 // Set status code.
                 m_status |= CEP_CAN::Status::ERROR_EPV;
+                m_stats.errorPassives++;
 
                 // No need to clear the flag since it is read only.
-                if (m_callbacks[CEP_CAN::Irq::ErrorPassive])
-                {
-                    m_callbacks[CEP_CAN::Irq::ErrorPassive];
-                }
+                InvokeCallback(CEP_CAN::Irq::ErrorPassive);
             }
             // Check bus-off flag.
             if (((ier & CAN_IT_BUSOFF) != 0) && ((esr & CAN_ESR_BOFF) != 0))
             {
                 // Set status code.
                 m_status |= CEP_CAN::Status::ERROR_BOF;
+                m_stats.busOffs++;
 
                 // No need to clear the flag since it is read only.
-                if (m_callbacks[CEP_CAN::Irq::BusOffError])
-                {
-                    m_callbacks[CEP_CAN::Irq::BusOffError]( );
-                }
+                InvokeCallback(CEP_CAN::Irq::BusOffError);
             }
             // Check last error code flag.
             if (((ier & CAN_IT_LAST_ERROR_CODE) != 0) && ((esr & CAN_ESR_LEC) != 0))
             {
+                m_stats.protocolErrors++;
                 switch (esr & CAN_ESR_LEC)
                 {
                     case CAN_ESR_LEC_0:
@@ -561,10 +786,7 @@ void CanModule::HandleErrorIrq(uint32_t ier)
                 // Clear Last Error code Flag.
                 CLEAR_BIT(m_handle->Instance->ESR, CAN_ESR_LEC);
 
-                if (m_callbacks[CEP_CAN::Irq::LastErrorCode])
-                {
-                    m_callbacks[CEP_CAN::Irq::LastErrorCode]( );
-                }
+                InvokeCallback(CEP_CAN::Irq::LastErrorCode);
             }
         }
 
@@ -599,6 +821,21 @@ CAN_FilterTypeDef
     return filter;
 }
 
+/**
+ * @brief   Computes the bitrate of the bus from the bit timing register.
+ * @return  The bitrate, in bits per second.
+ */
+uint32_t CanModule::ComputeBitrate( ) const
+{
+    uint32_t btr       = m_handle->Instance->BTR;
+    uint32_t prescaler = ((btr & CAN_BTR_BRP) >> CAN_BTR_BRP_Pos) + 1;
+    // Sync segment + bit segment 1 + bit segment 2, in time quanta.
+    uint32_t quanta = 1 + (((btr & CAN_BTR_TS1) >> CAN_BTR_TS1_Pos) + 1) +
+                      (((btr & CAN_BTR_TS2) >> CAN_BTR_TS2_Pos) + 1);
+
+    return HAL_RCC_GetPCLK1Freq( ) / (prescaler * quanta);
+}
+
 bool CanModule::WaitForFreeMailbox( )
 {
     uint32_t timeout = HAL_GetTick( ) + CanModule::TIMEOUT;
@@ -21,19 +21,32 @@
 #        include NILAI_HAL_HEADER
 #        if defined(HAL_CAN_MODULE_ENABLED)
 #            include "defines/macros.hpp"
+#            include "defines/inplaceFunction.hpp"
 #            include "defines/misc.hpp"
 #            include "defines/module.hpp"
+#            include "defines/ringBuffer.hpp"
+#            include "drivers/canFilterPlanner.hpp"
+#            include "drivers/canFrame.hpp"
+#            include "drivers/canStatistics.hpp"
 
 #            include <array>
 #            include <cstdint>
 #            include <functional>
-#            include <map>
 #            include <vector>
 
 /*************************************************************************************************/
 /* Defines
  * -------------------------------------------------------------------------------------
  */
+namespace CEP_CAN
+{
+//! Number of filter banks of the bxCAN peripheral. Dual CAN parts share theirs between both.
+#            if defined(NILAI_USES_STM32F4xx) || defined(NILAI_USES_STM32F7xx)
+static constexpr size_t FILTER_BANK_COUNT = 28;
+#            else
+static constexpr size_t FILTER_BANK_COUNT = 14;
+#            endif
+}    // namespace CEP_CAN
 
 /*************************************************************************************************/
 /* Enumerated Types
@@ -280,6 +293,62 @@ enum class Irq
     ErrorStatus         = CAN_IT_ERROR,
 };
 
+//! Number of bits in the CAN_IER register, each interrupt source is one bit.
+static constexpr size_t IRQ_COUNT = 18;
+
+/**
+ * @brief   Converts an interrupt source into its bit position in the CAN_IER register.
+ */
+constexpr size_t IrqToIndex(Irq irq)
+{
+    return (size_t)__builtin_ctz((uint32_t)irq);
+}
+
+/**
+ * @brief   Interrupt callbacks are stored in place, registering or calling one never allocates.
+ *
+ * Unlike the std::function this used to be, the callable must fit in
+ * @ref cep::INPLACE_FUNCTION_DEFAULT_CAPACITY bytes, enough for a lambda capturing 4 pointers or
+ * references. A bigger capture fails to compile: capture a pointer to the state instead.
+ */
+using IrqCallback = cep::InplaceFunction<void( )>;
+
+/**
+ * @brief   Called for every frame received or transmitted, used to record the traffic.
+ *
+ * Received frames are reported from the interrupt handler.
+ */
+using FrameObserver = cep::InplaceFunction<void(const CompactFrame& frame, bool tx)>;
+
+/**
+ * @brief   Time spent in @ref CanModule::HandleIrq, from entry to exit.
+ *
+ * All values are in CPU cycles, as counted by the DWT cycle counter.
+ * Divide by SystemCoreClock to get seconds.
+ */
+struct IrqLatency
+{
+    uint32_t last  = 0;
+    uint32_t min   = UINT32_MAX;
+    uint32_t max   = 0;
+    uint32_t count = 0;
+    uint64_t total = 0;
+
+    [[nodiscard]] float GetAverage( ) const
+    {
+        return count == 0 ? 0.0f : (float)((double)total / (double)count);
+    }
+
+    void Add(uint32_t cycles)
+    {
+        last = cycles;
+        min  = std::min(min, cycles);
+        max  = std::max(max, cycles);
+        count++;
+        total += cycles;
+    }
+};
+
 struct Frame
 {
     CAN_RxHeaderTypeDef    frame;
@@ -310,11 +379,45 @@ struct Frame
 
     bool operator!=(const Frame& other) { return !(*this == other); }
 };
+
+/**
+ * @brief   Converts a frame from the compact representation to the HAL one.
+ */
+inline Frame ToFrame(const CompactFrame& compact)
+{
+    Frame frame     = Frame( );
+    frame.frame.IDE = compact.IsExtended( ) ? CAN_ID_EXT : CAN_ID_STD;
+    frame.frame.RTR = compact.IsRemote( ) ? CAN_RTR_REMOTE : CAN_RTR_DATA;
+    frame.frame.DLC = compact.GetDlc( );
+    // Only the field matching the frame's format is meaningful, the other one is left at 0.
+    frame.frame.StdId = compact.IsExtended( ) ? 0 : compact.GetId( );
+    frame.frame.ExtId = compact.IsExtended( ) ? compact.GetId( ) : 0;
+    frame.timestamp   = compact.GetTimestamp( );
+    compact.CopyData(frame.data.data( ));
+    return frame;
+}
+
+/**
+ * @brief   Converts a frame from the HAL representation to the compact one.
+ */
+inline CompactFrame ToCompactFrame(const Frame& frame)
+{
+    bool extended = frame.frame.IDE == CAN_ID_EXT;
+    return CompactFrame::Make(extended ? frame.frame.ExtId : frame.frame.StdId,
+                              extended,
+                              frame.frame.RTR == CAN_RTR_REMOTE,
+                              frame.data.data( ),
+                              frame.frame.DLC,
+                              frame.timestamp);
+}
 }    // Namespace CEP_CAN
 
 class CanModule : public cep::Module
 {
 public:
+    //! Number of received frames that can be held until they are read. Must be a power of two.
+    static constexpr size_t RX_RING_SIZE = 32;
+
     CanModule(CAN_HandleTypeDef* handle, const std::string& label);
     virtual ~CanModule( ) override;
 
@@ -323,9 +426,13 @@ public:
     virtual const std::string& GetLabel( ) const override { return m_label; }
 
     void ConfigureFilter(const CEP_CAN::FilterConfiguration& config);
+    void ConfigureFilters(const CEP_CAN::FilterPlan&     plan,
+                          CEP_CAN::FilterFifoAssignation fifo = CEP_CAN::FilterFifoAssignation::Fifo0);
 
-    size_t          GetNumberOfAvailableFrames( ) const { return m_framesReceived.size( ); }
+    size_t          GetNumberOfAvailableFrames( ) const { return m_rxFrames.Size( ); }
     CEP_CAN::Frame  ReceiveFrame( );
+    bool            ReceiveFrame(CEP_CAN::CompactFrame& frame);
+    CEP_CAN::Status TransmitFrame(const CEP_CAN::CompactFrame& frame);
     CEP_CAN::Status TransmitFrame(uint32_t                    addr,
                                   const std::vector<uint8_t>& data = std::vector<uint8_t>( ),
                                   bool                        forceExtended = false);
@@ -334,9 +441,12 @@ public:
                                   size_t         len           = 0,
                                   bool           forceExtended = false);
 
-    void SetCallback(CEP_CAN::Irq irq, const std::function<void( )>& callback);
+    void SetCallback(CEP_CAN::Irq irq, const CEP_CAN::IrqCallback& callback);
     void ClearCallback(CEP_CAN::Irq irq);
 
+    void SetFrameObserver(const CEP_CAN::FrameObserver& observer) { m_frameObserver = observer; }
+    void ClearFrameObserver( ) { m_frameObserver = nullptr; }
+
     void EnableInterrupt(CEP_CAN::Irq irq);
     void EnableInterrupts(const std::vector<CEP_CAN::Irq>& irqs)
     {
@@ -356,10 +466,44 @@ public:
 
     void HandleIrq( );
 
+    /**
+     * @brief   When enabled, every frame pending in both RX FIFOs is read in a single interrupt,
+     *          instead of one frame per interrupt.
+     *
+     * The frames are made available all at once, and the Fifo0MessagePending and
+     * Fifo1MessagePending callbacks are called once per interrupt instead of once per frame.
+     */
+    void SetRxDrainMode(bool enable) { m_drainRxFifos = enable; }
+    [[nodiscard]] bool GetRxDrainMode( ) const { return m_drainRxFifos; }
+
+    [[nodiscard]] const CEP_CAN::IrqLatency& GetIrqLatency( ) const { return m_irqLatency; }
+    void                                     ResetIrqLatency( ) { m_irqLatency = {}; }
+
+    [[nodiscard]] CEP_CAN::Status     GetStatus( ) const { return m_status; }
+    void                              ClearStatus( ) { m_status = CEP_CAN::Status::ERROR_NONE; }
+    //! Copy of the statistics, taken with the interrupts masked since the CAN interrupt updates
+    //! them.
+    [[nodiscard]] CEP_CAN::Statistics GetStatistics( ) const;
+    void                              ResetStatistics( );
+    //! Bitrate of the bus, computed from the bit timing register.
+    [[nodiscard]] uint32_t GetBitrate( ) const { return m_bitrate; }
+
 private:
     CAN_FilterTypeDef AssertAndConvertFilterStruct(const CEP_CAN::FilterConfiguration& config);
     bool              WaitForFreeMailbox( );
+    void              InvokeCallback(CEP_CAN::Irq irq) const
+    {
+        const CEP_CAN::IrqCallback& callback = m_callbacks[CEP_CAN::IrqToIndex(irq)];
+        if (callback)
+        {
+            callback( );
+        }
+    }
     void              HandleFrameReception(CEP_CAN::RxFifo fifo);
+    void              ReadFrameIntoRing(CEP_CAN::RxFifo fifo, size_t& queued);
+    void              DrainRxFifos( );
+    void              HandleTxComplete(size_t mailbox);
+    uint32_t          ComputeBitrate( ) const;
     void              HandleTxMailbox0Irq(uint32_t ier);
     void              HandleTxMailbox1Irq(uint32_t ier);
     void              HandleTxMailbox2Irq(uint32_t ier);
@@ -374,11 +518,22 @@ private:
     std::string        m_label  = "";
     CEP_CAN::Status    m_status = CEP_CAN::Status::ERROR_NONE;
 
-    std::vector<CEP_CAN::Frame>                      m_framesReceived;
-    std::map<CEP_CAN::Irq, std::function<void( )>>   m_callbacks;
-    std::map<uint64_t, CEP_CAN::FilterConfiguration> m_filters;
+    cep::RingBuffer<CEP_CAN::CompactFrame, RX_RING_SIZE>                 m_rxFrames;
+    bool                                                                 m_drainRxFifos = false;
+    std::array<CEP_CAN::IrqCallback, CEP_CAN::IRQ_COUNT>                 m_callbacks;
+    CEP_CAN::FrameObserver                                               m_frameObserver;
+    CEP_CAN::IrqLatency                                                  m_irqLatency;
+
+    CEP_CAN::Statistics m_stats;
+    uint32_t            m_bitrate         = 0;
+    uint32_t            m_lastStatsUpdate = 0;
+    //! DWT cycle count at which each mailbox was filled, to measure the TX latency.
+    std::array<uint32_t, CEP_CAN::Statistics::MAILBOX_COUNT> m_txQueuedAt = {};
+    std::array<CEP_CAN::FilterConfiguration, CEP_CAN::FILTER_BANK_COUNT> m_filters;
 
     static constexpr uint32_t TIMEOUT = 15;
+    //! Period at which the frame rates and bus load are updated, in milliseconds.
+    static constexpr uint32_t STATS_PERIOD = 1000;
 };
 #        else
 #            if WARN_MISSING_STM_DRIVERS
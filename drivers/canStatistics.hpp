@@ -0,0 +1,212 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  can
+ * @{
+ * @file        canStatistics.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/11
+ *
+ * @brief       Traffic, error and latency counters of a CAN bus.
+ *
+ * The counters are updated by @ref CanModule from its interrupt handler, the rates and the bus
+ * load are updated periodically from @ref CanModule::Run.
+ */
+#ifndef CAN_STATISTICS_HPP_
+#define CAN_STATISTICS_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_CAN) || defined(NILAI_TEST)
+#    include <array>
+#    include <cstddef>
+#    include <cstdint>
+
+namespace CEP_CAN
+{
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+/**
+ * @brief   Estimates the number of bits a data frame takes on the bus.
+ *
+ * Includes the interframe space and the worst case amount of stuff bits, which makes it an upper
+ * bound suitable for budgeting bus load.
+ *
+ * @param   extended    True for a 29-bit identifier, false for an 11-bit one.
+ * @param   dlc         Number of data bytes, 0 to 8.
+ * @return  The number of bits.
+ */
+constexpr uint32_t EstimateFrameBits(bool extended, uint8_t dlc)
+{
+    uint32_t dataBits = 8 * (uint32_t)(dlc > 8 ? 8 : dlc);
+    // SOF up to the end of the CRC, the only part subject to bit stuffing.
+    uint32_t stuffed = (extended ? 54 : 34) + dataBits;
+    // CRC delimiter, ACK slot and delimiter, EOF and interframe space.
+    uint32_t fixed = 1 + 2 + 7 + 3;
+
+    return stuffed + ((stuffed - 1) / 4) + fixed;
+}
+
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+/**
+ * @brief   Histogram with power-of-two bins, in microseconds.
+ *
+ * Bin 0 holds values under 2us, bin n holds values in [2^n, 2^(n+1)) us and the last bin holds
+ * everything above.
+ */
+struct LatencyHistogram
+{
+    static constexpr size_t BIN_COUNT = 16;
+
+    std::array<uint32_t, BIN_COUNT> bins  = {};
+    uint32_t                        count = 0;
+    uint32_t                        min   = UINT32_MAX;
+    uint32_t                        max   = 0;
+    uint64_t                        total = 0;
+
+    static constexpr size_t GetBin(uint32_t us)
+    {
+        size_t bin = 0;
+        while ((us >>= 1) != 0 && bin < (BIN_COUNT - 1))
+        {
+            bin++;
+        }
+        return bin;
+    }
+
+    //! Smallest value that doesn't fit in `bin`.
+    static constexpr uint32_t GetBinUpperBound(size_t bin)
+    {
+        return bin >= (BIN_COUNT - 1) ? UINT32_MAX : (2U << bin);
+    }
+
+    void Add(uint32_t us)
+    {
+        bins[GetBin(us)]++;
+        count++;
+        total += us;
+        min = us < min ? us : min;
+        max = us > max ? us : max;
+    }
+
+    [[nodiscard]] float GetAverage() const
+    {
+        return count == 0 ? 0.0f : (float)((double)total / (double)count);
+    }
+
+    /**
+     * @brief   Gets an upper bound of a percentile of the values.
+     * @param   percentile  The percentile, between 0.0f and 1.0f.
+     * @return  The upper bound of the bin holding that percentile, 0 if the histogram is empty.
+     */
+    [[nodiscard]] uint32_t GetPercentile(float percentile) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        uint64_t target = (uint64_t)((double)percentile * (double)count + 0.5);
+        uint64_t seen   = 0;
+        for (size_t i = 0; i < BIN_COUNT; i++)
+        {
+            seen += bins[i];
+            if (seen >= target && seen != 0)
+            {
+                return GetBinUpperBound(i) < max ? GetBinUpperBound(i) : max;
+            }
+        }
+        return max;
+    }
+};
+
+struct Statistics
+{
+    static constexpr size_t MAILBOX_COUNT = 3;
+    static constexpr size_t FIFO_COUNT    = 2;
+
+    //! Number of frames received since the statistics were reset.
+    uint32_t rxFrames = 0;
+    //! Number of frames queued for transmission since the statistics were reset.
+    uint32_t txFrames = 0;
+    //! Estimated number of bits used by the received frames, see @ref EstimateFrameBits.
+    uint64_t rxBits = 0;
+    //! Estimated number of bits used by the transmitted frames, see @ref EstimateFrameBits.
+    uint64_t txBits = 0;
+
+    //! Rates measured over the last update period.
+    float rxFramesPerSecond = 0.0f;
+    float txFramesPerSecond = 0.0f;
+    //! Fraction of the bus' bandwidth used by our traffic, 0.0f to 1.0f.
+    float busLoad = 0.0f;
+
+    std::array<uint32_t, MAILBOX_COUNT> arbitrationLost = {};
+    std::array<uint32_t, MAILBOX_COUNT> transmitErrors  = {};
+    std::array<uint32_t, FIFO_COUNT>    fifoOverruns    = {};
+    //! Frames released from a FIFO because there was no room left to keep them.
+    uint32_t droppedFrames = 0;
+
+    uint32_t errorWarnings  = 0;
+    uint32_t errorPassives  = 0;
+    uint32_t busOffs        = 0;
+    uint32_t protocolErrors = 0;
+
+    //! Time from a frame being put in a mailbox to its transmission being acknowledged.
+    //! Only measured when the TxMailboxEmpty interrupt is enabled.
+    LatencyHistogram txLatency;
+
+    void CountRx(bool extended, uint8_t dlc)
+    {
+        rxFrames++;
+        rxBits += EstimateFrameBits(extended, dlc);
+    }
+
+    void CountTx(bool extended, uint8_t dlc)
+    {
+        txFrames++;
+        txBits += EstimateFrameBits(extended, dlc);
+    }
+
+    /**
+     * @brief   Updates the rates and bus load with the traffic since the last update.
+     * @param   elapsedMs   Time since the last update.
+     * @param   bitrate     Bitrate of the bus, in bits per second.
+     */
+    void UpdateRates(uint32_t elapsedMs, uint32_t bitrate)
+    {
+        if (elapsedMs == 0)
+        {
+            return;
+        }
+
+        float seconds     = (float)elapsedMs / 1000.0f;
+        rxFramesPerSecond = (float)(rxFrames - m_lastRxFrames) / seconds;
+        txFramesPerSecond = (float)(txFrames - m_lastTxFrames) / seconds;
+
+        if (bitrate != 0)
+        {
+            uint64_t bits = (rxBits - m_lastRxBits) + (txBits - m_lastTxBits);
+            busLoad       = (float)bits / ((float)bitrate * seconds);
+        }
+
+        m_lastRxFrames = rxFrames;
+        m_lastTxFrames = txFrames;
+        m_lastRxBits   = rxBits;
+        m_lastTxBits   = txBits;
+    }
+
+private:
+    uint32_t m_lastRxFrames = 0;
+    uint32_t m_lastTxFrames = 0;
+    uint64_t m_lastRxBits   = 0;
+    uint64_t m_lastTxBits   = 0;
+};
+}    // namespace CEP_CAN
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
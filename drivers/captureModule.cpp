@@ -0,0 +1,227 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  capture
+ * @{
+ * @file        captureModule.cpp
+ * @author      Samuel Martel
+ * @date        2021/11/28
+ */
+#include "captureModule.hpp"
+#if defined(NILAI_USE_CAPTURE) && defined(HAL_TIM_MODULE_ENABLED)
+#include "defines/macros.hpp"
+#include "drivers/timerClock.hpp"
+#include "services/logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+//! Maximum number of capture modules receiving the HAL's TIM callbacks.
+static constexpr size_t MAX_MODULES = 4;
+
+static std::array<CaptureModule*, MAX_MODULES> s_modules = {};
+
+static constexpr std::array<uint32_t, 4> HAL_CHANNELS = {
+  TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4};
+static constexpr std::array<HAL_TIM_ActiveChannel, 4> ACTIVE_CHANNELS = {
+  HAL_TIM_ACTIVE_CHANNEL_1,
+  HAL_TIM_ACTIVE_CHANNEL_2,
+  HAL_TIM_ACTIVE_CHANNEL_3,
+  HAL_TIM_ACTIVE_CHANNEL_4};
+static constexpr std::array<uint32_t, 4> DMA_IDS = {
+  TIM_DMA_ID_CC1, TIM_DMA_ID_CC2, TIM_DMA_ID_CC3, TIM_DMA_ID_CC4};
+
+CaptureModule::CaptureModule(TIM_HandleTypeDef* timer, uint32_t channel, std::string label)
+: m_timer(timer),
+  m_riseIndex(channel >> 2),
+  m_fallIndex((channel >> 2) ^ 1),
+  m_label(std::move(label))
+{
+    CEP_ASSERT(timer != nullptr, "[%s]: TIM handle is null!", m_label.c_str());
+    CEP_ASSERT(m_riseIndex < HAL_CHANNELS.size(), "[%s]: Invalid channel!", m_label.c_str());
+
+    auto it = std::find(s_modules.begin(), s_modules.end(), nullptr);
+    CEP_ASSERT(it != s_modules.end(), "Too many capture modules!");
+    *it = this;
+
+    LOG_INFO("[%s]: Initialized", m_label.c_str());
+}
+
+CaptureModule::~CaptureModule()
+{
+    Stop();
+    std::replace(s_modules.begin(), s_modules.end(), this, static_cast<CaptureModule*>(nullptr));
+}
+
+/**
+ * If the initialization passed, the POST passes.
+ */
+bool CaptureModule::DoPost()
+{
+    LOG_INFO("[%s]: POST OK", m_label.c_str());
+    return true;
+}
+
+void CaptureModule::Run()
+{
+    if (!m_isRunning)
+    {
+        return;
+    }
+
+    uint32_t overruns = GetOverruns();
+    m_rises.Update([this]() { return GetPosition(m_riseIndex, m_riseBuffer.size()); });
+    m_falls.Update([this]() { return GetPosition(m_fallIndex, m_fallBuffer.size()); });
+    if (GetOverruns() != overruns)
+    {
+        // The edges that are left might not alternate anymore.
+        m_decoder.Resync();
+    }
+
+    m_decoder.Process(m_rises,
+                      m_falls,
+                      [this](const CAPTURE::Measurement& measurement)
+                      {
+                          m_last = measurement;
+                          if (m_windows.Add(measurement) && m_callback)
+                          {
+                              m_callback(m_windows.GetLatest());
+                          }
+                      });
+}
+
+bool CaptureModule::Start(const CAPTURE::CaptureConfig&      config,
+                          const CAPTURE::StatisticsCallback& callback)
+{
+    CEP_ASSERT(config.window != 0, "[%s]: Windows can't be empty!", m_label.c_str());
+    CEP_ASSERT((config.bufferSize != 0) && (config.bufferSize <= 0xFFFF),
+               "[%s]: Invalid buffer size!",
+               m_label.c_str());
+
+    Stop();
+
+    // The timestamps are words, the buffers are used as rings.
+    for (size_t index : {m_riseIndex, m_fallIndex})
+    {
+        const DMA_HandleTypeDef* dma = m_timer->hdma[DMA_IDS[index]];
+        if ((dma == nullptr) || (dma->Init.Mode != DMA_CIRCULAR) ||
+            (dma->Init.MemDataAlignment != DMA_MDATAALIGN_WORD))
+        {
+            LOG_ERROR("[%s]: Capturing CH%i requires a circular DMA reading words",
+                      m_label.c_str(),
+                      index + 1);
+            return false;
+        }
+    }
+
+    // The counter runs over its whole range, a period being the difference of two timestamps.
+    uint32_t counterMax = IS_TIM_32B_COUNTER_INSTANCE(m_timer->Instance) ? 0xFFFFFFFF : 0xFFFF;
+    m_timer->Init.Prescaler   = config.prescaler;
+    m_timer->Init.Period      = counterMax;
+    m_timer->Init.CounterMode = TIM_COUNTERMODE_UP;
+    HAL_TIM_IC_DeInit(m_timer);
+    HAL_TIM_IC_Init(m_timer);
+
+    TIM_IC_InitTypeDef ic = {};
+    ic.ICPolarity         = TIM_ICPOLARITY_RISING;
+    ic.ICSelection        = TIM_ICSELECTION_DIRECTTI;
+    ic.ICPrescaler        = TIM_ICPSC_DIV1;
+    ic.ICFilter           = config.filter;
+    HAL_TIM_IC_ConfigChannel(m_timer, &ic, HAL_CHANNELS[m_riseIndex]);
+    // The other channel of the pair captures the same input.
+    ic.ICPolarity  = TIM_ICPOLARITY_FALLING;
+    ic.ICSelection = TIM_ICSELECTION_INDIRECTTI;
+    HAL_TIM_IC_ConfigChannel(m_timer, &ic, HAL_CHANNELS[m_fallIndex]);
+
+    uint32_t clock = CEP_TIM::GetTimerClock(m_timer->Instance) / (config.prescaler + 1);
+    m_riseBuffer.assign(config.bufferSize, 0);
+    m_fallBuffer.assign(config.bufferSize, 0);
+    m_rises.Reset(m_riseBuffer.data(), m_riseBuffer.size());
+    m_falls.Reset(m_fallBuffer.data(), m_fallBuffer.size());
+    m_decoder.Reset(counterMax);
+    m_windows.Reset(config.window, clock);
+    m_last      = {};
+    m_callback  = callback;
+    m_isRunning = true;
+
+    if ((HAL_TIM_IC_Start_DMA(m_timer,
+                              HAL_CHANNELS[m_fallIndex],
+                              m_fallBuffer.data(),
+                              (uint16_t)m_fallBuffer.size()) != HAL_OK) ||
+        (HAL_TIM_IC_Start_DMA(m_timer,
+                              HAL_CHANNELS[m_riseIndex],
+                              m_riseBuffer.data(),
+                              (uint16_t)m_riseBuffer.size()) != HAL_OK))
+    {
+        LOG_ERROR("[%s]: Unable to start the capture", m_label.c_str());
+        Stop();
+        return false;
+    }
+
+    LOG_DEBUG("[%s]: Capturing CH%i at %iHz, windows of %i periods",
+              m_label.c_str(),
+              m_riseIndex + 1,
+              clock,
+              config.window);
+    return true;
+}
+
+void CaptureModule::Stop()
+{
+    if (m_isRunning)
+    {
+        HAL_TIM_IC_Stop_DMA(m_timer, HAL_CHANNELS[m_riseIndex]);
+        HAL_TIM_IC_Stop_DMA(m_timer, HAL_CHANNELS[m_fallIndex]);
+        m_isRunning = false;
+    }
+}
+
+void CaptureModule::HandleComplete(HAL_TIM_ActiveChannel channel)
+{
+    if (channel == ACTIVE_CHANNELS[m_riseIndex])
+    {
+        m_rises.HandleComplete();
+    }
+    else if (channel == ACTIVE_CHANNELS[m_fallIndex])
+    {
+        m_falls.HandleComplete();
+    }
+}
+
+size_t CaptureModule::GetPosition(size_t index, size_t size) const
+{
+    return size - __HAL_DMA_GET_COUNTER(m_timer->hdma[DMA_IDS[index]]);
+}
+
+/*************************************************************************************************/
+/* HAL callbacks ------------------------------------------------------------------------------- */
+static CaptureModule* FindModule(TIM_HandleTypeDef* htim)
+{
+    for (CaptureModule* module : s_modules)
+    {
+        if ((module != nullptr) && (module->GetHandle() == htim))
+        {
+            return module;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * In circular mode, the DMA calls it every time it fills a buffer.
+ */
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef* htim)
+{
+    if (CaptureModule* module = FindModule(htim); module != nullptr)
+    {
+        module->HandleComplete(htim->Channel);
+    }
+}
+
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,130 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  capture
+ * @{
+ * @file        captureModule.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/28
+ *
+ * @brief       Measures the frequency, period and duty cycle of a signal with a timer's input
+ *              capture.
+ *
+ * The edges are timestamped by the timer and moved by the DMA, the CPU only merges them and
+ * accumulates the statistics from @ref CaptureModule::Run, a buffer at a time.
+ */
+#ifndef CAPTURE_MODULE_HPP_
+#define CAPTURE_MODULE_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_CAPTURE)
+#include "defines/internalConfig.h"
+#include NILAI_HAL_HEADER
+#if defined(HAL_TIM_MODULE_ENABLED)
+#include "defines/module.hpp"
+#include "drivers/inputCapture.hpp"
+
+#include <string>
+#include <vector>
+
+namespace CAPTURE
+{
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+struct CaptureConfig
+{
+    //! Number of periods per window of statistics.
+    uint32_t window = 100;
+    //! Number of edges of each polarity the DMA buffers hold. @ref CaptureModule::Run must be
+    //! called before that many periods elapse, or the oldest edges are lost.
+    size_t bufferSize = 64;
+    //! Value of the timer's PSC register, for periods longer than the counter's range.
+    uint32_t prescaler = 0;
+    //! Value of the input's digital filter, 0 to 15.
+    uint32_t filter = 0;
+};
+}    // namespace CAPTURE
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+class CaptureModule : public cep::Module
+{
+public:
+    /**
+     * @param   timer   The timer, which must have a DMA in circular mode reading words for both
+     *                  channels of the pair. Its counter runs freely.
+     * @param   channel Channel of the input, from TIM_CHANNEL_1 to TIM_CHANNEL_4. It captures the
+     *                  rising edges, the other channel of its pair (CH1 and CH2, CH3 and CH4)
+     *                  captures the falling edges of the same input.
+     */
+    CaptureModule(TIM_HandleTypeDef* timer, uint32_t channel, std::string label);
+    ~CaptureModule() override;
+
+    virtual bool               DoPost() override;
+    virtual void               Run() override;
+    virtual const std::string& GetLabel() const override { return m_label; }
+
+    /**
+     * @brief   Starts capturing the edges.
+     * @param   callback    Called from @ref Run with the statistics of every window.
+     * @return  False if the timer isn't set up for it.
+     */
+    bool Start(const CAPTURE::CaptureConfig&      config,
+               const CAPTURE::StatisticsCallback& callback = {});
+    void Stop();
+    [[nodiscard]] bool IsRunning() const { return m_isRunning; }
+
+    //! Statistics of the last complete window.
+    [[nodiscard]] const CAPTURE::Statistics& GetStatistics() const
+    {
+        return m_windows.GetLatest();
+    }
+    //! Last period measured, in ticks of the timer's counter.
+    [[nodiscard]] const CAPTURE::Measurement& GetLastMeasurement() const { return m_last; }
+
+    //! Number of edges lost because @ref Run wasn't called often enough.
+    [[nodiscard]] uint32_t GetOverruns() const
+    {
+        return m_rises.GetOverruns() + m_falls.GetOverruns();
+    }
+    //! Number of periods that couldn't be measured.
+    [[nodiscard]] uint32_t GetMissed() const { return m_decoder.GetMissed(); }
+
+    //! Called by the HAL's TIM callbacks, not meant to be called by the application.
+    void HandleComplete(HAL_TIM_ActiveChannel channel);
+
+    [[nodiscard]] TIM_HandleTypeDef* GetHandle() const { return m_timer; }
+
+private:
+    TIM_HandleTypeDef* m_timer = nullptr;
+    //! Index of the channels capturing each edge, from 0 to 3.
+    size_t      m_riseIndex = 0;
+    size_t      m_fallIndex = 1;
+    std::string m_label     = "";
+    bool        m_isRunning = false;
+
+    std::vector<uint32_t>       m_riseBuffer;
+    std::vector<uint32_t>       m_fallBuffer;
+    CAPTURE::EdgeRing           m_rises;
+    CAPTURE::EdgeRing           m_falls;
+    CAPTURE::EdgeDecoder        m_decoder;
+    CAPTURE::WindowStatistics   m_windows;
+    CAPTURE::Measurement        m_last;
+    CAPTURE::StatisticsCallback m_callback;
+
+private:
+    [[nodiscard]] size_t GetPosition(size_t index, size_t size) const;
+};
+
+#else
+#if WARN_MISSING_STM_DRIVERS
+#warning NilaiTFO Capture Module enabled, but HAL_TIM_MODULE_ENABLED is not defined!
+#endif
+#endif
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,109 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  i2c
+ * @{
+ * @file        i2cInventory.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/19
+ *
+ * @brief       List of the devices that answered a scan of an I2C bus.
+ *
+ * Addresses are left-aligned, like everywhere else in the I2C module: a device whose 7-bit
+ * address is 0x20 is at 0x40.
+ *
+ * Scans are started with @ref I2cModule::StartScan.
+ */
+#ifndef I2C_INVENTORY_HPP_
+#define I2C_INVENTORY_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_I2C) || defined(NILAI_TEST)
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+namespace CEP_I2C
+{
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+class Inventory
+{
+public:
+    //! First and last addresses that aren't reserved by the I2C specification.
+    static constexpr uint8_t FIRST_ADDRESS = 0x08 << 1;
+    static constexpr uint8_t LAST_ADDRESS  = 0x77 << 1;
+    //! Returned by @ref Find when no device matches.
+    static constexpr uint8_t NO_DEVICE = 0x00;
+
+    void Clear()
+    {
+        m_devices.reset();
+        m_isComplete = false;
+        m_duration   = 0;
+    }
+
+    void Add(uint8_t address) { m_devices.set(address >> 1); }
+
+    //! Called once every address has been probed.
+    void Complete(uint32_t durationMs)
+    {
+        m_isComplete = true;
+        m_duration   = durationMs;
+    }
+
+    //! True once a scan went through the whole bus, the inventory is empty before that.
+    [[nodiscard]] bool     IsComplete() const { return m_isComplete; }
+    //! Time the last scan took, in milliseconds.
+    [[nodiscard]] uint32_t GetDuration() const { return m_duration; }
+
+    [[nodiscard]] bool   Contains(uint8_t address) const { return m_devices.test(address >> 1); }
+    [[nodiscard]] size_t Count() const { return m_devices.count(); }
+
+    /**
+     * @brief   Finds a device in a range of addresses, like the ones a device's address pins can
+     *          select.
+     * @param   first   First address of the range.
+     * @param   last    Last address of the range, included.
+     * @param   index   0 for the first device of the range, 1 for the second one, etc.
+     * @return  The address of the device, or @ref NO_DEVICE.
+     */
+    [[nodiscard]] uint8_t Find(uint8_t first, uint8_t last, size_t index = 0) const
+    {
+        for (size_t a = first >> 1; a <= (size_t)(last >> 1); a++)
+        {
+            if (m_devices.test(a) && (index-- == 0))
+            {
+                return (uint8_t)(a << 1);
+            }
+        }
+        return NO_DEVICE;
+    }
+
+    //! Calls `f(address)` for every device, in increasing order of address.
+    template<typename F>
+    void ForEach(F&& f) const
+    {
+        for (size_t a = 0; a < m_devices.size(); a++)
+        {
+            if (m_devices.test(a))
+            {
+                f((uint8_t)(a << 1));
+            }
+        }
+    }
+
+private:
+    std::bitset<128> m_devices;
+    bool             m_isComplete = false;
+    uint32_t         m_duration   = 0;
+};
+}    // namespace CEP_I2C
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,188 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  i2c
+ * @{
+ * @file        i2cMemory.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/19
+ *
+ * @brief       Bulk reads and writes of I2C EEPROMs and other paged memories.
+ *
+ * Transfers of any length are split so that no write crosses a page of the device and no access
+ * crosses a block, the part of the memory reachable with the memory address alone. The block is
+ * selected by the low bits of the device address, like on the 24C16 or the 24M01.
+ *
+ * A memory doesn't acknowledge its address while it writes a page. Instead of waiting for the
+ * worst case write time after each page, the next access is simply retried until the memory
+ * acknowledges it: the wait ends as soon as the write cycle does, and the last page's write cycle
+ * overlaps with whatever the application does next.
+ *
+ * The transfers are built on primitives provided by a port, which must be a type with:
+ *  - `MemoryAccess Write(uint8_t device, uint16_t address, const uint8_t* data, size_t len)`
+ *  - `MemoryAccess Read(uint8_t device, uint16_t address, uint8_t* data, size_t len)`
+ *  - `uint32_t GetTick()`: current time, in milliseconds.
+ *
+ * @ref I2cModule provides a port over the HAL, the tests use a mocked one.
+ */
+#ifndef I2C_MEMORY_HPP_
+#define I2C_MEMORY_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_I2C) || defined(NILAI_TEST)
+#include "defines/span.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CEP_I2C
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+//! Largest number of bytes the HAL can transfer at once.
+static constexpr size_t MAX_TRANSFER_SIZE = 0xFFFF;
+
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+//! Result of a primitive of a memory port.
+enum class MemoryAccess
+{
+    Done,
+    //! The device didn't acknowledge its address, it is most likely busy writing.
+    Busy,
+    Failed,
+};
+
+struct MemoryLayout
+{
+    //! Size of a write page, in bytes. A power of two.
+    size_t pageSize = 1;
+    //! Size of the memory address, 1 or 2 bytes. The bits above it select the block through the
+    //! device address.
+    uint8_t addressSize = 2;
+    //! Longest time the device can take to write a page, in milliseconds.
+    uint32_t writeCycleTime = 5;
+};
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+/**
+ * @brief   Gets the number of bytes that can be accessed at `address` without crossing a
+ *          multiple of `boundary`.
+ * @return  The smallest of that number and `len`.
+ */
+constexpr size_t GetChunkSize(uint32_t address, size_t len, size_t boundary)
+{
+    size_t room = boundary - (address % boundary);
+    return len < room ? len : room;
+}
+
+/**
+ * @brief   Gets the device address to use to access `address`, whose bits above the memory
+ *          address select the block.
+ * @param   device  Address of the device, left-aligned.
+ */
+constexpr uint8_t GetBlockAddress(uint8_t device, uint32_t address, uint8_t addressSize)
+{
+    return (uint8_t)(device | ((address >> (8 * addressSize)) << 1));
+}
+
+//! Number of bytes reachable without changing the device address.
+constexpr size_t GetBlockSize(uint8_t addressSize)
+{
+    return (size_t)1 << (8 * addressSize);
+}
+
+/**
+ * @brief   Retries an access for as long as the device is busy, up to `timeout` milliseconds.
+ */
+template<typename Port, typename Access>
+MemoryAccess RetryWhileBusy(Port& port, uint32_t timeout, Access&& access)
+{
+    uint32_t     start  = port.GetTick();
+    MemoryAccess result = access();
+    while ((result == MemoryAccess::Busy) && ((uint32_t)(port.GetTick() - start) <= timeout))
+    {
+        result = access();
+    }
+    return result;
+}
+
+/**
+ * @brief   Writes `data` at `address`, one page at a time.
+ *
+ * Returns as soon as the last page has been sent, without waiting for its write cycle to end.
+ *
+ * @param   device  Address of the device, left-aligned.
+ * @return  False if a page couldn't be written.
+ */
+template<typename Port>
+bool WriteMemory(Port&                    port,
+                 uint8_t                  device,
+                 const MemoryLayout&      layout,
+                 uint32_t                 address,
+                 cep::Span<const uint8_t> data)
+{
+    size_t done = 0;
+    while (done < data.size())
+    {
+        uint32_t at  = address + (uint32_t)done;
+        size_t   len = GetChunkSize(at, data.size() - done, layout.pageSize);
+        uint8_t  dev = GetBlockAddress(device, at, layout.addressSize);
+
+        MemoryAccess result = RetryWhileBusy(
+          port,
+          layout.writeCycleTime,
+          [&]() { return port.Write(dev, (uint16_t)at, data.data() + done, len); });
+        if (result != MemoryAccess::Done)
+        {
+            return false;
+        }
+        done += len;
+    }
+
+    return true;
+}
+
+/**
+ * @brief   Fills `data` with the content of the memory starting at `address`.
+ *
+ * Waits for a write cycle in progress to end.
+ *
+ * @param   device  Address of the device, left-aligned.
+ * @return  False if the memory couldn't be read.
+ */
+template<typename Port>
+bool ReadMemory(
+  Port& port, uint8_t device, const MemoryLayout& layout, uint32_t address, cep::Span<uint8_t> data)
+{
+    size_t done = 0;
+    while (done < data.size())
+    {
+        uint32_t at  = address + (uint32_t)done;
+        size_t   len = GetChunkSize(at, data.size() - done, GetBlockSize(layout.addressSize));
+        len          = len < MAX_TRANSFER_SIZE ? len : MAX_TRANSFER_SIZE;
+        uint8_t dev  = GetBlockAddress(device, at, layout.addressSize);
+
+        MemoryAccess result =
+          RetryWhileBusy(port,
+                         layout.writeCycleTime,
+                         [&]() { return port.Read(dev, (uint16_t)at, data.data() + done, len); });
+        if (result != MemoryAccess::Done)
+        {
+            return false;
+        }
+        done += len;
+    }
+
+    return true;
+}
+}    // namespace CEP_I2C
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
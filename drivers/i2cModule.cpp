@@ -17,38 +17,94 @@
  */
 #include "drivers/i2cModule.hpp"
 
-#include <utility>
 #if defined(NILAI_USE_I2C) && defined(HAL_I2C_MODULE_ENABLED)
 #include "services/logger.hpp"
 
+#include <algorithm>
+#include <array>
+#include <utility>
+
+/*************************************************************************************************/
+/* Defines
+ * -------------------------------------------------------------------------------------
+ */
+//! Maximum number of I2C modules receiving the HAL's I2C callbacks.
+static constexpr size_t MAX_MODULES = 4;
+
+/*************************************************************************************************/
+/* Private variables
+ * ------------------------------------------------------------------------------ */
+static std::array<I2cModule*, MAX_MODULES> s_modules = {};
+
+/*************************************************************************************************/
+/* Public function definitions
+ * --------------------------------------------------------------- */
 I2cModule::I2cModule(I2C_HandleTypeDef* handle, std::string  label)
 : m_handle(handle), m_label(std::move(label))
 {
     CEP_ASSERT(handle != nullptr, "In I2cModule: handle is NULL!");
+
+    // Register the module to receive the completion callbacks of its asynchronous transactions.
+    auto it = std::find(s_modules.begin(), s_modules.end(), nullptr);
+    CEP_ASSERT(it != s_modules.end(), "Too many I2C modules!");
+    *it = this;
+
     LOG_INFO("[%s]: Initialized", m_label.c_str());
 }
 
+I2cModule::~I2cModule()
+{
+    std::replace(s_modules.begin(), s_modules.end(), this, static_cast<I2cModule*>(nullptr));
+}
+
 /**
  * If the initialization passed, the POST passes.
+ * The bus is scanned in the background, what was found is reported by Run. The devices are checked
+ * by their own POST.
  * @return
  */
 bool I2cModule::DoPost()
 {
+    if (!m_isScanning && !StartScan())
+    {
+        LOG_ERROR("[%s]: Unable to start the bus scan", m_label.c_str());
+    }
+
     LOG_INFO("[%s]: POST OK", m_label.c_str());
     return true;
 }
 
 void I2cModule::Run()
 {
+    // Report the last scan once it is over.
+    if (m_scanReported || m_isScanning)
+    {
+        return;
+    }
+    m_scanReported = true;
+
+    if (m_scanErrors != CEP_I2C::Status::Ok)
+    {
+        LOG_ERROR("[%s]: Errors during the bus scan: 0x%08X",
+                  m_label.c_str(),
+                  (uint32_t)m_scanErrors);
+    }
+    if (!m_inventory.IsComplete())
+    {
+        return;
+    }
+
+    LOG_INFO("[%s]: %i devices found in %ims",
+             m_label.c_str(),
+             m_inventory.Count(),
+             m_inventory.GetDuration());
+    m_inventory.ForEach([this](uint8_t address)
+                        { LOG_DEBUG("[%s]: Device at 0x%02X", m_label.c_str(), address); });
 }
 
 void I2cModule::TransmitFrame(uint8_t addr, const uint8_t* data, size_t len)
 {
-    if (HAL_I2C_Master_Transmit(m_handle,
-                                addr,
-                                const_cast<uint8_t*>(data),
-                                (uint16_t)len,
-                                I2cModule::TIMEOUT) != HAL_OK)
+    if (Transmit(addr, {data, len}) != CEP_I2C::Status::Ok)
     {
         LOG_ERROR("[%s]: In TransmitFrame, unable to transmit frame", m_label.c_str());
     }
@@ -59,13 +115,7 @@ void I2cModule::TransmitFrameToRegister(uint8_t        addr,
                                         const uint8_t* data,
                                         size_t         len)
 {
-    if (HAL_I2C_Mem_Write(m_handle,
-                          addr,
-                          regAddr,
-                          sizeof(regAddr),
-                          const_cast<uint8_t*>(data),
-                          (uint16_t)len,
-                          I2cModule::TIMEOUT) != HAL_OK)
+    if (TransmitToRegister(addr, regAddr, {data, len}) != CEP_I2C::Status::Ok)
     {
         LOG_ERROR("[%s]: In TransmitFrameToRegister, unable to transmit frame", m_label.c_str());
     }
@@ -79,11 +129,7 @@ CEP_I2C::Frame I2cModule::ReceiveFrame(uint8_t addr, size_t len)
     // Allocate memory for the data.
     frame.data.resize(len);
 
-    if (HAL_I2C_Master_Receive(m_handle,
-                               addr,
-                               frame.data.data(),
-                               (uint16_t)frame.data.size(),
-                               I2cModule::TIMEOUT) != HAL_OK)
+    if (Receive(addr, frame.data) != CEP_I2C::Status::Ok)
     {
         LOG_ERROR("[%s]: In ReceiveFrame, unable to receive frame", m_label.c_str());
     }
@@ -99,19 +145,440 @@ CEP_I2C::Frame I2cModule::ReceiveFrameFromRegister(uint8_t addr, uint8_t regAddr
     frame.registerAddress = regAddr;
     frame.data.resize(len);
 
-    if (HAL_I2C_Mem_Read(m_handle,
-                         frame.deviceAddress,
-                         frame.registerAddress,
-                         sizeof(frame.registerAddress),
-                         frame.data.data(),
-                         (uint16_t)frame.data.size(),
-                         I2cModule::TIMEOUT) != HAL_OK)
+    if (ReceiveFromRegister(addr, regAddr, frame.data) != CEP_I2C::Status::Ok)
     {
         LOG_ERROR("[%s]: In ReceiveFrameFromRegister, unable to receive frame", m_label.c_str());
     }
 
     return frame;
 }
+
+CEP_I2C::Status I2cModule::Transmit(uint8_t addr, cep::Span<const uint8_t> data)
+{
+    if (!WaitUntilIdle())
+    {
+        return CEP_I2C::Status::TimeoutError;
+    }
+
+    return ToStatus(HAL_I2C_Master_Transmit(m_handle,
+                                            addr,
+                                            const_cast<uint8_t*>(data.data()),
+                                            (uint16_t)data.size(),
+                                            I2cModule::TIMEOUT));
+}
+
+CEP_I2C::Status I2cModule::TransmitToRegister(uint8_t                  addr,
+                                              uint16_t                 regAddr,
+                                              cep::Span<const uint8_t> data,
+                                              uint8_t                  regSize)
+{
+    if (!WaitUntilIdle())
+    {
+        return CEP_I2C::Status::TimeoutError;
+    }
+
+    return ToStatus(HAL_I2C_Mem_Write(m_handle,
+                                      addr,
+                                      regAddr,
+                                      ToMemAddSize(regSize),
+                                      const_cast<uint8_t*>(data.data()),
+                                      (uint16_t)data.size(),
+                                      I2cModule::TIMEOUT));
+}
+
+CEP_I2C::Status I2cModule::Receive(uint8_t addr, cep::Span<uint8_t> data)
+{
+    if (!WaitUntilIdle())
+    {
+        return CEP_I2C::Status::TimeoutError;
+    }
+
+    return ToStatus(HAL_I2C_Master_Receive(
+      m_handle, addr, data.data(), (uint16_t)data.size(), I2cModule::TIMEOUT));
+}
+
+CEP_I2C::Status I2cModule::ReceiveFromRegister(uint8_t            addr,
+                                               uint16_t           regAddr,
+                                               cep::Span<uint8_t> data,
+                                               uint8_t            regSize)
+{
+    if (!WaitUntilIdle())
+    {
+        return CEP_I2C::Status::TimeoutError;
+    }
+
+    return ToStatus(HAL_I2C_Mem_Read(m_handle,
+                                     addr,
+                                     regAddr,
+                                     ToMemAddSize(regSize),
+                                     data.data(),
+                                     (uint16_t)data.size(),
+                                     I2cModule::TIMEOUT));
+}
+
+CEP_I2C::Status I2cModule::WriteMemory(uint8_t                      addr,
+                                       const CEP_I2C::MemoryLayout& layout,
+                                       uint32_t                     memAddr,
+                                       cep::Span<const uint8_t>     data)
+{
+    if (!WaitUntilIdle())
+    {
+        return CEP_I2C::Status::TimeoutError;
+    }
+
+    MemoryPort port = {m_handle, ToMemAddSize(layout.addressSize)};
+    if (!CEP_I2C::WriteMemory(port, addr, layout, memAddr, data))
+    {
+        return port.status == CEP_I2C::Status::Ok ? CEP_I2C::Status::TimeoutError : port.status;
+    }
+    return CEP_I2C::Status::Ok;
+}
+
+CEP_I2C::Status I2cModule::ReadMemory(uint8_t                      addr,
+                                      const CEP_I2C::MemoryLayout& layout,
+                                      uint32_t                     memAddr,
+                                      cep::Span<uint8_t>           data)
+{
+    if (!WaitUntilIdle())
+    {
+        return CEP_I2C::Status::TimeoutError;
+    }
+
+    MemoryPort port = {m_handle, ToMemAddSize(layout.addressSize)};
+    if (!CEP_I2C::ReadMemory(port, addr, layout, memAddr, data))
+    {
+        return port.status == CEP_I2C::Status::Ok ? CEP_I2C::Status::TimeoutError : port.status;
+    }
+    return CEP_I2C::Status::Ok;
+}
+
+bool I2cModule::StartScan()
+{
+    if (m_isScanning)
+    {
+        return false;
+    }
+
+    m_inventory.Clear();
+    m_scanErrors  = CEP_I2C::Status::Ok;
+    m_scanAddress = CEP_I2C::Inventory::FIRST_ADDRESS;
+    m_scanStart    = HAL_GetTick();
+    m_scanReported = false;
+    m_isScanning   = true;
+
+    return ProbeNextAddress();
+}
+
+bool I2cModule::Scan()
+{
+    if (!m_isScanning && !StartScan())
+    {
+        return false;
+    }
+
+    uint32_t timeoutTime = HAL_GetTick() + I2cModule::SCAN_TIMEOUT;
+    while (m_isScanning && (HAL_GetTick() <= timeoutTime))
+    {
+    }
+
+    return m_inventory.IsComplete();
+}
+
+bool I2cModule::QueueTransaction(const CEP_I2C::Transaction& transaction)
+{
+    CEP_ASSERT((transaction.txLen != 0) || (transaction.rxLen != 0),
+               "No data in I2cModule::QueueTransaction");
+    CEP_ASSERT((transaction.regSize == 0) || (transaction.txLen == 0) || (transaction.rxLen == 0),
+               "Register write-then-read in I2cModule::QueueTransaction");
+    CEP_ASSERT(transaction.regSize <= 2, "Invalid register size in I2cModule::QueueTransaction");
+
+    // The queue is shared between the application and the completion interrupt.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    bool queued = m_queue.Push(transaction);
+    // If it is the only transaction in the queue, nothing is on the bus: start it now.
+    if (queued && (m_queue.Size() == 1))
+    {
+        StartNextTransaction();
+    }
+
+    __set_PRIMASK(primask);
+    return queued;
+}
+
+void I2cModule::HandleTransferComplete()
+{
+    if (m_queue.Empty())
+    {
+        return;
+    }
+
+    const CEP_I2C::Transaction& current = m_queue.Front();
+    bool isWriteRead = (current.regSize == 0) && (current.txLen != 0) && (current.rxLen != 0);
+    if (isWriteRead && !m_isReadPhase)
+    {
+        // The write phase is done, read after a repeated start.
+        m_isReadPhase = true;
+        if (HAL_I2C_Master_Seq_Receive_IT(
+              m_handle, current.address, current.rxData, (uint16_t)current.rxLen, I2C_LAST_FRAME) !=
+            HAL_OK)
+        {
+            HandleTransferError();
+        }
+        return;
+    }
+
+    EndTransaction(CEP_I2C::Status::Ok);
+}
+
+void I2cModule::HandleTransferError()
+{
+    auto status = (CEP_I2C::Status)m_handle->ErrorCode;
+    EndTransaction(status == CEP_I2C::Status::Ok ? CEP_I2C::Status::WrongStart : status);
+}
+
+/*************************************************************************************************/
+/* Private functions definitions
+ * --------------------------------------------------------------- */
+bool I2cModule::WaitUntilIdle()
+{
+    uint32_t timeoutTime = HAL_GetTick() + I2cModule::TIMEOUT;
+
+    while (HAL_GetTick() <= timeoutTime)
+    {
+        if ((m_handle->State == HAL_I2C_STATE_READY) && m_queue.Empty())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+CEP_I2C::Status I2cModule::ToStatus(HAL_StatusTypeDef status) const
+{
+    if (status == HAL_OK)
+    {
+        return CEP_I2C::Status::Ok;
+    }
+
+    // A timeout or a busy peripheral doesn't always leave an error code.
+    auto code = (CEP_I2C::Status)m_handle->ErrorCode;
+    return code == CEP_I2C::Status::Ok ? CEP_I2C::Status::TimeoutError : code;
+}
+
+uint16_t I2cModule::ToMemAddSize(uint8_t regSize)
+{
+    CEP_ASSERT((regSize == 1) || (regSize == 2), "Invalid register size in I2cModule");
+    return regSize == 2 ? I2C_MEMADD_SIZE_16BIT : I2C_MEMADD_SIZE_8BIT;
+}
+
+/**
+ * Starts the transaction at the front of the queue.
+ * The transactions that can't be started are ended right away, until one starts or the queue is
+ * empty. This is a loop rather than going through EndTransaction, their callbacks can queue more
+ * transactions (a scan queues the next probe) and a stuck bus would otherwise recurse for each one.
+ * Must be called with the interrupts disabled or from the I2C interrupt.
+ */
+void I2cModule::StartNextTransaction()
+{
+    // Called again by the callbacks below, what they queue is taken care of by this loop.
+    if (m_isStarting)
+    {
+        return;
+    }
+    m_isStarting = true;
+
+    while (!m_queue.Empty())
+    {
+        HAL_StatusTypeDef s = StartTransaction(m_queue.Front());
+        if (s == HAL_OK)
+        {
+            break;
+        }
+
+        // Most likely a blocking transfer is using the bus, report it and move on.
+        // A refused start doesn't always leave an error code, it must still be reported as one.
+        auto code = (CEP_I2C::Status)m_handle->ErrorCode;
+        CEP_I2C::Transaction failed;
+        m_queue.Pop(failed);
+        if (failed.callback)
+        {
+            failed.callback(((s == HAL_BUSY) || (code == CEP_I2C::Status::Ok))
+                              ? CEP_I2C::Status::WrongStart
+                              : code);
+        }
+    }
+
+    m_isStarting = false;
+}
+
+HAL_StatusTypeDef I2cModule::StartTransaction(const CEP_I2C::Transaction& next)
+{
+    auto*             tx       = const_cast<uint8_t*>(next.txData);
+    auto              txLen    = (uint16_t)next.txLen;
+    uint8_t*          rx       = next.rxData;
+    auto              rxLen    = (uint16_t)next.rxLen;
+    bool              useTxDma = m_handle->hdmatx != nullptr;
+    bool              useRxDma = m_handle->hdmarx != nullptr;
+    HAL_StatusTypeDef s        = HAL_ERROR;
+
+    m_isReadPhase = false;
+    if (next.regSize != 0)
+    {
+        uint16_t regSize = ToMemAddSize(next.regSize);
+        if (txLen != 0)
+        {
+            s = useTxDma ? HAL_I2C_Mem_Write_DMA(m_handle, next.address, next.reg, regSize, tx, txLen)
+                         : HAL_I2C_Mem_Write_IT(m_handle, next.address, next.reg, regSize, tx, txLen);
+        }
+        else
+        {
+            s = useRxDma ? HAL_I2C_Mem_Read_DMA(m_handle, next.address, next.reg, regSize, rx, rxLen)
+                         : HAL_I2C_Mem_Read_IT(m_handle, next.address, next.reg, regSize, rx, rxLen);
+        }
+    }
+    else if ((txLen != 0) && (rxLen != 0))
+    {
+        // No stop condition after the write, the read starts with a repeated start.
+        s = HAL_I2C_Master_Seq_Transmit_IT(m_handle, next.address, tx, txLen, I2C_FIRST_FRAME);
+    }
+    else if (txLen != 0)
+    {
+        s = useTxDma ? HAL_I2C_Master_Transmit_DMA(m_handle, next.address, tx, txLen)
+                     : HAL_I2C_Master_Transmit_IT(m_handle, next.address, tx, txLen);
+    }
+    else
+    {
+        s = useRxDma ? HAL_I2C_Master_Receive_DMA(m_handle, next.address, rx, rxLen)
+                     : HAL_I2C_Master_Receive_IT(m_handle, next.address, rx, rxLen);
+    }
+
+    return s;
+}
+
+/**
+ * Ends the transaction at the front of the queue, starts the next one and calls the callback.
+ * The next transaction is started first to keep the bus busy while the callback runs.
+ */
+void I2cModule::EndTransaction(CEP_I2C::Status status)
+{
+    if (m_queue.Empty())
+    {
+        return;
+    }
+
+    CEP_I2C::Transaction done;
+    m_queue.Pop(done);
+
+    StartNextTransaction();
+
+    if (done.callback)
+    {
+        done.callback(status);
+    }
+}
+
+/**
+ * Queues the probe of the next address of the scan.
+ * Called from the I2C interrupt once the scan has started.
+ */
+bool I2cModule::ProbeNextAddress()
+{
+    CEP_I2C::Transaction probe;
+    probe.address  = m_scanAddress;
+    probe.rxData   = &m_probeByte;
+    probe.rxLen    = 1;
+    probe.callback = [this](CEP_I2C::Status status) { HandleProbe(status); };
+
+    if (!QueueTransaction(probe))
+    {
+        m_scanErrors = (CEP_I2C::Status)((uint32_t)m_scanErrors |
+                                         (uint32_t)CEP_I2C::Status::WrongStart);
+        m_isScanning = false;
+        return false;
+    }
+    return true;
+}
+
+void I2cModule::HandleProbe(CEP_I2C::Status status)
+{
+    if (status == CEP_I2C::Status::Ok)
+    {
+        m_inventory.Add(m_scanAddress);
+    }
+    else if (status != CEP_I2C::Status::AckFailure)
+    {
+        // Nobody acknowledging the address is expected, anything else is a problem with the bus.
+        m_scanErrors = (CEP_I2C::Status)((uint32_t)m_scanErrors | (uint32_t)status);
+    }
+
+    if (m_scanAddress >= CEP_I2C::Inventory::LAST_ADDRESS)
+    {
+        m_inventory.Complete(HAL_GetTick() - m_scanStart);
+        m_isScanning = false;
+        return;
+    }
+
+    m_scanAddress += 2;
+    ProbeNextAddress();
+}
+
+/*************************************************************************************************/
+/* HAL callbacks
+ * ------------------------------------------------------------------------------------ */
+static I2cModule* FindModule(I2C_HandleTypeDef* hi2c)
+{
+    for (I2cModule* module : s_modules)
+    {
+        if ((module != nullptr) && (module->GetHandle() == hi2c))
+        {
+            return module;
+        }
+    }
+    return nullptr;
+}
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    if (I2cModule* module = FindModule(hi2c); module != nullptr)
+    {
+        module->HandleTransferComplete();
+    }
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    if (I2cModule* module = FindModule(hi2c); module != nullptr)
+    {
+        module->HandleTransferComplete();
+    }
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    if (I2cModule* module = FindModule(hi2c); module != nullptr)
+    {
+        module->HandleTransferComplete();
+    }
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    if (I2cModule* module = FindModule(hi2c); module != nullptr)
+    {
+        module->HandleTransferComplete();
+    }
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c)
+{
+    if (I2cModule* module = FindModule(hi2c); module != nullptr)
+    {
+        module->HandleTransferError();
+    }
+}
 #endif
 /**
  * @}
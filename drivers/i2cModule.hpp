@@ -21,9 +21,15 @@
 #include "defines/internalConfig.h"
 #include NILAI_HAL_HEADER
 #if defined(HAL_I2C_MODULE_ENABLED)
+#include "defines/bitManipulations.hpp"
+#include "defines/inplaceFunction.hpp"
 #include "defines/macros.hpp"
 #include "defines/misc.hpp"
 #include "defines/module.hpp"
+#include "defines/ringBuffer.hpp"
+#include "defines/span.hpp"
+#include "drivers/i2cInventory.hpp"
+#include "drivers/i2cMemory.hpp"
 
 #include <string>
 #include <utility>
@@ -91,13 +97,47 @@ struct Frame
     {
     }
 };
+
+/**
+ * @brief   Called from the I2C interrupt when an asynchronous transaction ends.
+ * @param   status  Status::Ok if the transaction succeeded, the errors that occurred otherwise.
+ */
+using TransactionCallback = cep::InplaceFunction<void(Status)>;
+
+/**
+ * @brief   A transfer queued with @ref I2cModule::QueueTransaction.
+ *
+ * Depending on the buffers given, it is:
+ *  - A write: `txData` is sent, after the register address if `regSize` isn't 0.
+ *  - A read: `rxLen` bytes are read, from the register if `regSize` isn't 0.
+ *  - A write-then-read: `txData` is sent, then `rxLen` bytes are read after a repeated start.
+ *    `regSize` must be 0, reading from a register is done with a read.
+ *
+ * The buffers are not copied, they must stay valid until the callback has been called.
+ */
+struct Transaction
+{
+    //! Address of the device, left-aligned like for the blocking methods.
+    uint8_t address = 0;
+    //! Register to write to or read from.
+    uint16_t reg = 0;
+    //! Size of the register's address, in bytes: 0 if there is no register, 1 or 2.
+    uint8_t regSize = 0;
+
+    const uint8_t* txData = nullptr;
+    size_t         txLen  = 0;
+    uint8_t*       rxData = nullptr;
+    size_t         rxLen  = 0;
+
+    TransactionCallback callback = {};
+};
 }    // namespace CEP_I2C
 
 class I2cModule : public cep::Module
 {
 public:
     I2cModule(I2C_HandleTypeDef* handle, std::string label);
-    ~I2cModule() override = default;
+    ~I2cModule() override;
 
     bool                             DoPost() override;
     void                             Run() override;
@@ -127,11 +167,184 @@ public:
     CEP_I2C::Frame ReceiveFrame(uint8_t addr, size_t len);
     CEP_I2C::Frame ReceiveFrameFromRegister(uint8_t addr, uint8_t regAddr, size_t len);
 
+    /*********************************************************************************************/
+    /* Allocation-free transfers */
+    /* `regSize` is the size of the register's address in bytes, 1 or 2. */
+    CEP_I2C::Status Transmit(uint8_t addr, cep::Span<const uint8_t> data);
+    CEP_I2C::Status TransmitToRegister(uint8_t                  addr,
+                                       uint16_t                 regAddr,
+                                       cep::Span<const uint8_t> data,
+                                       uint8_t                  regSize = 1);
+    //! Fills `data` entirely.
+    CEP_I2C::Status Receive(uint8_t addr, cep::Span<uint8_t> data);
+    //! Fills `data` entirely.
+    CEP_I2C::Status ReceiveFromRegister(uint8_t            addr,
+                                        uint16_t           regAddr,
+                                        cep::Span<uint8_t> data,
+                                        uint8_t            regSize = 1);
+
+    /**
+     * @brief   Reads an integer stored in `sizeof(T)` consecutive registers.
+     * @tparam  T   Type of the value.
+     * @tparam  E   Order of the bytes in the device, most devices use big endian.
+     * @param   value   Left untouched if the read fails.
+     */
+    template<typename T, cep::Endianness E = cep::Endianness::Big>
+    CEP_I2C::Status ReadRegister(uint8_t addr, uint16_t regAddr, T& value, uint8_t regSize = 1)
+    {
+        uint8_t         bytes[sizeof(T)] = {};
+        CEP_I2C::Status status           = ReceiveFromRegister(addr, regAddr, bytes, regSize);
+        if (status == CEP_I2C::Status::Ok)
+        {
+            value = cep::fromBytes<E, T>(&bytes[0]);
+        }
+        return status;
+    }
+
+    /**
+     * @brief   Writes an integer in `sizeof(T)` consecutive registers.
+     * @tparam  T   Type of the value.
+     * @tparam  E   Order of the bytes in the device, most devices use big endian.
+     */
+    template<typename T, cep::Endianness E = cep::Endianness::Big>
+    CEP_I2C::Status WriteRegister(uint8_t addr, uint16_t regAddr, T value, uint8_t regSize = 1)
+    {
+        uint8_t bytes[sizeof(T)] = {};
+        cep::toBytes<E>(value, &bytes[0]);
+        return TransmitToRegister(addr, regAddr, bytes, regSize);
+    }
+
+    /*********************************************************************************************/
+    /* Paged memories */
+    /**
+     * @brief   Writes `data` in an EEPROM, one page at a time. See i2cMemory.hpp.
+     *
+     * Returns without waiting for the write cycle of the last page, the next access to the memory
+     * waits for it.
+     */
+    CEP_I2C::Status WriteMemory(uint8_t                      addr,
+                                const CEP_I2C::MemoryLayout& layout,
+                                uint32_t                     memAddr,
+                                cep::Span<const uint8_t>     data);
+    //! Fills `data` with the content of an EEPROM. See i2cMemory.hpp.
+    CEP_I2C::Status ReadMemory(uint8_t                      addr,
+                               const CEP_I2C::MemoryLayout& layout,
+                               uint32_t                     memAddr,
+                               cep::Span<uint8_t>           data);
+
+    /**
+     * @brief   Queues a transfer that runs in the background, using DMA when the handle has DMA
+     *          channels linked to it and interrupts otherwise.
+     *
+     * Transactions are started one after the other from the completion interrupt, the main loop
+     * is never blocked. The blocking methods wait for the queue to be empty before using the bus.
+     *
+     * Can be called from an interrupt, including from a transaction's callback.
+     *
+     * @param   transaction The transaction, see @ref CEP_I2C::Transaction.
+     * @return  True if the transaction was queued, false if the queue is full.
+     */
+    bool QueueTransaction(const CEP_I2C::Transaction& transaction);
+
+    /*********************************************************************************************/
+    /* Bus scan */
+    /**
+     * @brief   Probes every address of the bus in the background, building the inventory.
+     *
+     * Each address is probed by reading a single byte, which any device can answer without side
+     * effects. The probes go through the transaction queue one after the other, the whole bus
+     * takes about 3ms at 400kHz.
+     *
+     * @return  False if a scan is already running or the probe couldn't be queued.
+     */
+    bool StartScan();
+    //! Scans the bus, or joins the scan in progress, and waits for the scan to end.
+    //! @return False if the scan couldn't be started or didn't end in time.
+    bool Scan();
+    [[nodiscard]] bool IsScanning() const { return m_isScanning; }
+    //! Valid once @ref CEP_I2C::Inventory::IsComplete is true.
+    [[nodiscard]] const CEP_I2C::Inventory& GetInventory() const { return m_inventory; }
+    //! Errors other than absent devices that happened during the last scan.
+    [[nodiscard]] CEP_I2C::Status GetScanErrors() const { return m_scanErrors; }
+
+    [[nodiscard]] size_t GetPendingTransactions() const { return m_queue.Size(); }
+    [[nodiscard]] bool   IsIdle() const { return m_queue.Empty(); }
+
+    //! Called by the HAL's I2C callbacks, not meant to be called by the application.
+    void HandleTransferComplete();
+    //! Called by the HAL's I2C callbacks, not meant to be called by the application.
+    void HandleTransferError();
+
+    [[nodiscard]] I2C_HandleTypeDef* GetHandle() const { return m_handle; }
+
+    static constexpr size_t QUEUE_SIZE = 16;
+
 protected:
+    //! Port of the transfers of i2cMemory.hpp, over the HAL's blocking functions.
+    struct MemoryPort
+    {
+        I2C_HandleTypeDef* handle;
+        uint16_t           memAddSize;
+        //! Errors of the last failed access.
+        CEP_I2C::Status status = CEP_I2C::Status::Ok;
+
+        CEP_I2C::MemoryAccess Write(uint8_t device, uint16_t address, const uint8_t* data, size_t len)
+        {
+            return ToAccess(HAL_I2C_Mem_Write(
+              handle, device, address, memAddSize, const_cast<uint8_t*>(data), (uint16_t)len, TIMEOUT));
+        }
+        CEP_I2C::MemoryAccess Read(uint8_t device, uint16_t address, uint8_t* data, size_t len)
+        {
+            return ToAccess(HAL_I2C_Mem_Read(
+              handle, device, address, memAddSize, data, (uint16_t)len, TIMEOUT));
+        }
+        static uint32_t GetTick() { return HAL_GetTick(); }
+
+        CEP_I2C::MemoryAccess ToAccess(HAL_StatusTypeDef s)
+        {
+            if (s == HAL_OK)
+            {
+                return CEP_I2C::MemoryAccess::Done;
+            }
+            status = (CEP_I2C::Status)handle->ErrorCode;
+            return status == CEP_I2C::Status::AckFailure ? CEP_I2C::MemoryAccess::Busy
+                                                         : CEP_I2C::MemoryAccess::Failed;
+        }
+    };
+
     I2C_HandleTypeDef* m_handle = nullptr;
     std::string        m_label;
 
+    //! The transaction at the front is the one on the bus.
+    cep::RingBuffer<CEP_I2C::Transaction, QUEUE_SIZE> m_queue;
+    //! True once the write phase of a write-then-read is done.
+    bool m_isReadPhase = false;
+    //! True while @ref StartNextTransaction goes through the queue.
+    bool m_isStarting = false;
+
+    CEP_I2C::Inventory m_inventory;
+    volatile bool      m_isScanning  = false;
+    uint8_t            m_scanAddress = 0;
+    uint32_t           m_scanStart   = 0;
+    CEP_I2C::Status    m_scanErrors  = CEP_I2C::Status::Ok;
+    //! Set once @ref Run has logged the result of the last scan.
+    bool m_scanReported = true;
+    //! Byte read by the probes, discarded.
+    uint8_t m_probeByte = 0;
+
     static constexpr uint16_t TIMEOUT = 200;
+    //! Longest time @ref Scan waits for, enough for the whole bus at 100kHz.
+    static constexpr uint16_t SCAN_TIMEOUT = 100;
+
+protected:
+    bool              WaitUntilIdle();
+    CEP_I2C::Status   ToStatus(HAL_StatusTypeDef status) const;
+    static uint16_t   ToMemAddSize(uint8_t regSize);
+    void              StartNextTransaction();
+    HAL_StatusTypeDef StartTransaction(const CEP_I2C::Transaction& next);
+    void              EndTransaction(CEP_I2C::Status status);
+    bool              ProbeNextAddress();
+    void              HandleProbe(CEP_I2C::Status status);
 };
 #else
 #if WARN_MISSING_STM_DRIVERS
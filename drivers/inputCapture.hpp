@@ -0,0 +1,392 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  capture
+ * @{
+ * @file        inputCapture.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/28
+ *
+ * @brief       Frequency, period and duty cycle of a signal, from the timestamps of its edges.
+ *
+ * A timer captures the value of its counter on every rising edge in one channel and on every
+ * falling edge in the other channel of the pair, and the DMA stores them in two circular buffers.
+ * The edges of both buffers are merged back in order, every rising edge closing a period whose
+ * length and high time are then accumulated into statistics over a window of periods.
+ *
+ * The counter runs freely, every difference is taken modulo its range: a period can't last longer
+ * than the counter takes to wrap around.
+ */
+#ifndef INPUT_CAPTURE_HPP_
+#define INPUT_CAPTURE_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_CAPTURE) || defined(NILAI_TEST)
+#include "defines/inplaceFunction.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace CAPTURE
+{
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+//! One period of the signal, in ticks of the timer's counter.
+struct Measurement
+{
+    uint32_t period = 0;
+    //! Time spent high, from the rising edge starting the period.
+    uint32_t high = 0;
+};
+
+/**
+ * @brief   Statistics of the periods of a window.
+ */
+struct Statistics
+{
+    //! Number of periods measured.
+    uint32_t count = 0;
+    //! Clock of the timer's counter in hertz, the periods being in ticks of it.
+    uint32_t clock = 0;
+
+    uint32_t minPeriod  = 0;
+    uint32_t maxPeriod  = 0;
+    float    meanPeriod = 0.0f;
+    //! Standard deviation of the periods, in ticks.
+    float jitter = 0.0f;
+
+    //! Duty cycles, in percent. The mean is the time spent high over the whole window.
+    float minDuty  = 0.0f;
+    float maxDuty  = 0.0f;
+    float meanDuty = 0.0f;
+
+    //! Mean frequency over the window, in hertz.
+    [[nodiscard]] float GetFrequency() const
+    {
+        return meanPeriod == 0.0f ? 0.0f : (float)clock / meanPeriod;
+    }
+    //! Converts a number of ticks, like @ref meanPeriod or @ref jitter, to microseconds.
+    [[nodiscard]] float ToMicroseconds(float ticks) const
+    {
+        return clock == 0 ? 0.0f : (ticks * 1000000.0f) / (float)clock;
+    }
+};
+
+/**
+ * @brief   Called from @ref CaptureModule::Run every time a window is complete.
+ */
+using StatisticsCallback = cep::InplaceFunction<void(const Statistics&)>;
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+/**
+ * @brief   Reads the timestamps a DMA writes into a circular buffer.
+ *
+ * The DMA's transfer complete interrupt calls @ref HandleComplete, which tells apart a buffer
+ * that just wrapped around from one that hasn't been written to. Timestamps that were written
+ * over before being read are counted as overruns.
+ */
+class EdgeRing
+{
+public:
+    void Reset(const uint32_t* buffer, size_t size)
+    {
+        m_buffer   = buffer;
+        m_size     = size;
+        m_laps     = 0;
+        m_written  = 0;
+        m_read     = 0;
+        m_overruns = 0;
+    }
+
+    /*********************************************************************************************/
+    /* Interrupt side */
+    void HandleComplete() { m_laps.fetch_add(1, std::memory_order_release); }
+
+    /*********************************************************************************************/
+    /* Main loop side */
+    /**
+     * @brief   Takes the timestamps written so far into account.
+     * @param   getPosition Returns the index the DMA writes to next, which is the size of the
+     *                      buffer minus the DMA's counter.
+     */
+    template<typename GetPosition>
+    void Update(GetPosition&& getPosition)
+    {
+        // The position must be read after the number of laps it belongs to.
+        uint32_t laps     = 0;
+        size_t   position = 0;
+        do
+        {
+            laps     = m_laps.load(std::memory_order_acquire);
+            position = getPosition();
+        } while (laps != m_laps.load(std::memory_order_acquire));
+
+        uint64_t written = ((uint64_t)laps * m_size) + position;
+        // The DMA wrapped around, but its interrupt hasn't been handled yet.
+        if (written < m_written)
+        {
+            written += m_size;
+        }
+        m_written = written;
+
+        if (m_written - m_read > m_size)
+        {
+            m_overruns += (uint32_t)(m_written - m_read - m_size);
+            m_read = m_written - m_size;
+        }
+    }
+
+    [[nodiscard]] bool     IsEmpty() const { return m_read == m_written; }
+    [[nodiscard]] uint32_t Peek() const { return m_buffer[m_read % m_size]; }
+    void                   Pop() { m_read++; }
+
+    //! Number of timestamps lost since the reset.
+    [[nodiscard]] uint32_t GetOverruns() const { return m_overruns; }
+
+private:
+    const uint32_t* m_buffer = nullptr;
+    size_t          m_size   = 0;
+
+    //! Number of times the DMA filled the buffer, updated from the interrupt.
+    std::atomic<uint32_t> m_laps = 0;
+    //! Number of timestamps written and read since the reset.
+    uint64_t m_written  = 0;
+    uint64_t m_read     = 0;
+    uint32_t m_overruns = 0;
+};
+
+/**
+ * @brief   Merges the rising and falling edges back in order and measures the periods.
+ *
+ * An edge is only consumed once the next edge of the other polarity is known, to be sure which
+ * one came first. A period without a falling edge, which means an edge was lost, isn't measured.
+ */
+class EdgeDecoder
+{
+public:
+    //! @param  counterMax  Largest value of the timer's counter, 0xFFFF or 0xFFFFFFFF.
+    void Reset(uint32_t counterMax)
+    {
+        m_max    = counterMax;
+        m_missed = 0;
+        Resync();
+    }
+
+    //! Forgets the previous edges, after some of them were lost.
+    void Resync()
+    {
+        m_hasLast = false;
+        m_hasRise = false;
+        m_hasFall = false;
+    }
+
+    /**
+     * @brief   Consumes the edges of both rings, as long as both have some.
+     * @param   out Receives every period closed by a rising edge.
+     * @return  The number of periods measured.
+     */
+    template<typename Output>
+    size_t Process(EdgeRing& rises, EdgeRing& falls, Output&& out)
+    {
+        size_t measured = 0;
+        while (!rises.IsEmpty() && !falls.IsEmpty())
+        {
+            uint32_t rise = rises.Peek();
+            uint32_t fall = falls.Peek();
+            // The edge closest to the last one comes first. Without a last one, the two edges
+            // are assumed to be less than half the counter's range apart.
+            bool riseFirst = m_hasLast
+                               ? Elapsed(m_last, rise) <= Elapsed(m_last, fall)
+                               : Elapsed(rise, fall) <= (m_max / 2);
+            if (riseFirst)
+            {
+                rises.Pop();
+                if (HandleRise(rise, out))
+                {
+                    measured++;
+                }
+            }
+            else
+            {
+                falls.Pop();
+                HandleFall(fall);
+            }
+        }
+        return measured;
+    }
+
+    //! Number of periods that couldn't be measured.
+    [[nodiscard]] uint32_t GetMissed() const { return m_missed; }
+
+private:
+    [[nodiscard]] uint32_t Elapsed(uint32_t from, uint32_t to) const
+    {
+        return (to - from) & m_max;
+    }
+
+    template<typename Output>
+    bool HandleRise(uint32_t rise, Output&& out)
+    {
+        bool measured = false;
+        if (m_hasRise && m_hasFall)
+        {
+            out(Measurement{Elapsed(m_rise, rise), Elapsed(m_rise, m_fall)});
+            measured = true;
+        }
+        else if (m_hasRise)
+        {
+            m_missed++;
+        }
+
+        m_rise    = rise;
+        m_hasRise = true;
+        m_hasFall = false;
+        m_last    = rise;
+        m_hasLast = true;
+        return measured;
+    }
+
+    void HandleFall(uint32_t fall)
+    {
+        // A falling edge before the first rising edge doesn't belong to any period.
+        m_fall    = fall;
+        m_hasFall = m_hasRise;
+        m_last    = fall;
+        m_hasLast = true;
+    }
+
+private:
+    uint32_t m_max     = 0xFFFF;
+    uint32_t m_last    = 0;
+    uint32_t m_rise    = 0;
+    uint32_t m_fall    = 0;
+    bool     m_hasLast = false;
+    bool     m_hasRise = false;
+    bool     m_hasFall = false;
+    uint32_t m_missed  = 0;
+};
+
+/**
+ * @brief   Accumulates the measurements of a window of periods.
+ *
+ * Everything is accumulated in integers, the statistics are only computed in floating point once
+ * per window.
+ */
+class WindowStatistics
+{
+public:
+    /**
+     * @param   window  Number of periods per window.
+     * @param   clock   Clock of the timer's counter, in hertz.
+     */
+    void Reset(uint32_t window, uint32_t clock)
+    {
+        m_window = window;
+        m_clock  = clock;
+        m_latest = {};
+        Restart();
+    }
+
+    /**
+     * @brief   Adds a period to the current window.
+     * @return  True if it completed the window, @ref GetLatest then holds its statistics.
+     */
+    bool Add(const Measurement& m)
+    {
+        if (m_count == 0)
+        {
+            m_first   = m.period;
+            m_min     = m.period;
+            m_max     = m.period;
+            m_minDuty = m;
+            m_maxDuty = m;
+        }
+        m_count++;
+        m_min = m.period < m_min ? m.period : m_min;
+        m_max = m.period > m_max ? m.period : m_max;
+        m_sumPeriods += m.period;
+        m_sumHigh += m.high;
+
+        // Deviations from the first period keep the squares small for a steady signal.
+        int64_t delta = (int64_t)m.period - (int64_t)m_first;
+        m_sumDeltas += delta;
+        m_sumSquares += (uint64_t)(delta * delta);
+
+        // high / period compared without dividing.
+        if ((uint64_t)m.high * m_minDuty.period < (uint64_t)m_minDuty.high * m.period)
+        {
+            m_minDuty = m;
+        }
+        if ((uint64_t)m.high * m_maxDuty.period > (uint64_t)m_maxDuty.high * m.period)
+        {
+            m_maxDuty = m;
+        }
+
+        if (m_count < m_window)
+        {
+            return false;
+        }
+
+        const double count    = (double)m_count;
+        const double mean     = (double)m_sumDeltas / count;
+        double       variance = ((double)m_sumSquares / count) - (mean * mean);
+
+        m_latest.count      = m_count;
+        m_latest.clock      = m_clock;
+        m_latest.minPeriod  = m_min;
+        m_latest.maxPeriod  = m_max;
+        m_latest.meanPeriod = (float)((double)m_sumPeriods / count);
+        m_latest.jitter     = variance > 0.0 ? (float)std::sqrt(variance) : 0.0f;
+        m_latest.minDuty    = GetDuty(m_minDuty.high, m_minDuty.period);
+        m_latest.maxDuty    = GetDuty(m_maxDuty.high, m_maxDuty.period);
+        m_latest.meanDuty   = GetDuty(m_sumHigh, m_sumPeriods);
+        Restart();
+        return true;
+    }
+
+    //! Statistics of the last complete window.
+    [[nodiscard]] const Statistics& GetLatest() const { return m_latest; }
+
+private:
+    void Restart()
+    {
+        m_count      = 0;
+        m_sumPeriods = 0;
+        m_sumHigh    = 0;
+        m_sumDeltas  = 0;
+        m_sumSquares = 0;
+    }
+
+    static float GetDuty(uint64_t high, uint64_t period)
+    {
+        return period == 0 ? 0.0f : (float)((double)high * 100.0 / (double)period);
+    }
+
+private:
+    uint32_t   m_window = 1;
+    uint32_t   m_clock  = 0;
+    Statistics m_latest;
+
+    uint32_t    m_count      = 0;
+    uint32_t    m_first      = 0;
+    uint32_t    m_min        = 0;
+    uint32_t    m_max        = 0;
+    uint64_t    m_sumPeriods = 0;
+    uint64_t    m_sumHigh    = 0;
+    int64_t     m_sumDeltas  = 0;
+    uint64_t    m_sumSquares = 0;
+    Measurement m_minDuty;
+    Measurement m_maxDuty;
+};
+}    // namespace CAPTURE
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
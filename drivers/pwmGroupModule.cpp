@@ -0,0 +1,267 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  pwm
+ * @{
+ * @file        pwmGroupModule.cpp
+ * @author      Samuel Martel
+ * @date        2021/11/27
+ */
+#include "pwmGroupModule.hpp"
+#if defined(NILAI_USE_PWM) && defined(HAL_TIM_MODULE_ENABLED)
+#include "drivers/timerClock.hpp"
+#include "services/logger.hpp"
+
+#include <array>
+
+static constexpr std::array<uint32_t, 4> HAL_CHANNELS = {
+  TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4};
+
+PwmGroupModule::PwmGroupModule(TIM_HandleTypeDef*                   timer,
+                               const std::vector<PWM::GroupOutput>& outputs,
+                               const std::string&                   label)
+: m_timer(timer), m_label(label)
+{
+    CEP_ASSERT(timer != nullptr, "[%s]: TIM Handle is NULL!", label.c_str());
+
+    // Changes of the period and of the compare values wait for the end of the current period.
+    m_timer->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    m_timer->Instance->CR1 |= TIM_CR1_ARPE;
+
+    uint32_t used = 0;
+    for (PWM::GroupOutput config : outputs)
+    {
+#if !defined(TIM_OCMODE_COMBINED_PWM1)
+        // Without the combined PWM modes, the pulse can only start with the period.
+        if (config.isPhaseShifted)
+        {
+            LOG_ERROR("[%s]: CH%i can't be phase-shifted on this timer",
+                      label.c_str(),
+                      (int)config.channel + 1);
+            config.isPhaseShifted = false;
+            m_hasRejectedOutputs  = true;
+        }
+#endif
+        size_t   index    = (size_t)config.channel;
+        size_t   count    = config.isPhaseShifted ? 2 : 1;
+        uint32_t channels = ((1UL << count) - 1) << index;
+        CEP_ASSERT(!config.isPhaseShifted || ((index % 2) == 0),
+                   "[%s]: Only CH1 and CH3 can be phase-shifted",
+                   label.c_str());
+        CEP_ASSERT((used & channels) == 0, "[%s]: CH%i is used twice", label.c_str(), index + 1);
+#if defined(NILAI_USES_STM32F4xx)
+        // Only CH1 to CH3 of the advanced timers have one, their HAL doesn't check the channel.
+        [[maybe_unused]] bool hasComplementary =
+          IS_TIM_CCXN_INSTANCE(m_timer->Instance) && (index < 3);
+#else
+        [[maybe_unused]] bool hasComplementary =
+          IS_TIM_CCXN_INSTANCE(m_timer->Instance, HAL_CHANNELS[index]);
+#endif
+        CEP_ASSERT(!config.hasComplementary || hasComplementary,
+                   "[%s]: CH%i doesn't have a complementary output",
+                   label.c_str(),
+                   index + 1);
+        used |= channels;
+
+        Output output;
+        output.config  = config;
+        output.channel = HAL_CHANNELS[index];
+        m_outputs.push_back(output);
+
+        // Inactive until the first update, with the compare values preloaded.
+        TIM_OC_InitTypeDef oc = {};
+        oc.OCMode             = TIM_OCMODE_PWM1;
+        oc.Pulse              = 0;
+        oc.OCPolarity         = TIM_OCPOLARITY_HIGH;
+        oc.OCNPolarity        = TIM_OCNPOLARITY_HIGH;
+        oc.OCFastMode         = TIM_OCFAST_DISABLE;
+        oc.OCIdleState        = TIM_OCIDLESTATE_RESET;
+        oc.OCNIdleState       = TIM_OCNIDLESTATE_RESET;
+        for (size_t c = index; c < index + count; c++)
+        {
+            HAL_TIM_PWM_ConfigChannel(m_timer, &oc, HAL_CHANNELS[c]);
+        }
+    }
+
+    LOG_INFO("[%s]: Initialized", m_label.c_str());
+}
+
+/**
+ * If the initialization passed, the POST passes.
+ */
+bool PwmGroupModule::DoPost()
+{
+    if (m_hasRejectedOutputs)
+    {
+        LOG_ERROR("[%s]: POST error, phase-shifted outputs aren't supported", m_label.c_str());
+        return false;
+    }
+
+    LOG_INFO("[%s]: POST OK", m_label.c_str());
+    return true;
+}
+
+void PwmGroupModule::Run()
+{
+}
+
+void PwmGroupModule::Enable()
+{
+    LOG_DEBUG("[%s]: Starting PWM generation", m_label.c_str());
+    // The outputs share the counter, starting them one after the other doesn't shift them.
+    for (const Output& output : m_outputs)
+    {
+        HAL_TIM_PWM_Start(m_timer, output.channel);
+        if (output.config.hasComplementary)
+        {
+            HAL_TIMEx_PWMN_Start(m_timer, output.channel);
+        }
+    }
+    m_isActive = true;
+}
+
+void PwmGroupModule::Disable()
+{
+    LOG_DEBUG("[%s]: Stopping PWM generation", m_label.c_str());
+    for (const Output& output : m_outputs)
+    {
+        if (output.config.hasComplementary)
+        {
+            HAL_TIMEx_PWMN_Stop(m_timer, output.channel);
+        }
+        HAL_TIM_PWM_Stop(m_timer, output.channel);
+    }
+    m_isActive = false;
+}
+
+bool PwmGroupModule::SetFrequency(uint64_t hz)
+{
+    uint32_t    clk       = CEP_TIM::GetTimerClock(m_timer->Instance);
+    uint32_t    maxPeriod = IS_TIM_32B_COUNTER_INSTANCE(m_timer->Instance) ? 0xFFFFFFFF : 0xFFFF;
+    PWM::Timing timing    = m_timings.Solve(clk, hz, m_fitMode, maxPeriod);
+    if (timing.frequency == 0)
+    {
+        LOG_ERROR("[%s]: Unable to generate %dHz", m_label.c_str(), (uint32_t)hz);
+        return false;
+    }
+
+    m_activeFreq            = hz;
+    m_timer->Init.Prescaler = timing.prescaler;
+    m_timer->Init.Period    = timing.period;
+
+    // Without update events, every register is loaded at the same one.
+    m_timer->Instance->CR1 |= TIM_CR1_UDIS;
+    __HAL_TIM_SET_PRESCALER(m_timer, timing.prescaler);
+    __HAL_TIM_SET_AUTORELOAD(m_timer, timing.period);
+    WriteOutputs();
+    m_timer->Instance->CR1 &= ~TIM_CR1_UDIS;
+    LoadIfStopped();
+
+    LOG_DEBUG("[%s]: Setting frequency to %dHz (psc: 0x%08X, per: 0x%08X, clk: %dHz)",
+              m_label.c_str(),
+              timing.frequency,
+              timing.prescaler,
+              timing.period,
+              clk);
+    return true;
+}
+
+void PwmGroupModule::SetDutyCycle(size_t output, uint32_t percent)
+{
+    CEP_ASSERT(output < m_outputs.size(), "[%s]: Invalid output %i", m_label.c_str(), output);
+    m_outputs[output].dutyCycle = (percent < 100) ? percent : 100;
+}
+
+void PwmGroupModule::SetPhase(size_t output, uint32_t degrees)
+{
+    CEP_ASSERT(output < m_outputs.size(), "[%s]: Invalid output %i", m_label.c_str(), output);
+    CEP_ASSERT(m_outputs[output].config.isPhaseShifted,
+               "[%s]: Output %i isn't phase-shifted",
+               m_label.c_str(),
+               output);
+    m_outputs[output].phase = degrees % 360;
+}
+
+void PwmGroupModule::Update()
+{
+    m_timer->Instance->CR1 |= TIM_CR1_UDIS;
+    WriteOutputs();
+    m_timer->Instance->CR1 &= ~TIM_CR1_UDIS;
+    LoadIfStopped();
+}
+
+bool PwmGroupModule::SetDeadTime(uint32_t ns)
+{
+    if (!IS_TIM_BREAK_INSTANCE(m_timer->Instance))
+    {
+        LOG_ERROR("[%s]: The timer doesn't have complementary outputs", m_label.c_str());
+        return false;
+    }
+
+    // Only the dead time is changed, the break inputs are left as configured.
+    uint32_t clock = GetDeadTimeClock();
+    uint8_t  dtg   = PWM::EncodeDeadTime(clock, ns);
+    m_timer->Instance->BDTR = (m_timer->Instance->BDTR & ~TIM_BDTR_DTG) | dtg;
+    m_deadTime = (uint32_t)(((uint64_t)PWM::DecodeDeadTime(dtg) * 1000000000) / clock);
+
+    LOG_DEBUG("[%s]: Setting dead time to %dns (DTG: 0x%02X)", m_label.c_str(), m_deadTime, dtg);
+    return true;
+}
+
+void PwmGroupModule::WriteOutputs()
+{
+    const uint32_t period = __HAL_TIM_GET_AUTORELOAD(m_timer);
+    for (const Output& output : m_outputs)
+    {
+        uint32_t width = PWM::DutyToCompare(period, output.dutyCycle);
+#if defined(TIM_OCMODE_COMBINED_PWM1)
+        if (output.config.isPhaseShifted)
+        {
+            size_t     index = (size_t)output.config.channel;
+            PWM::Pulse pulse =
+              PWM::PlacePulse(period, PWM::PhaseToTicks(period, output.phase), width);
+            SetMode(index, pulse.wraps ? TIM_OCMODE_COMBINED_PWM1 : TIM_OCMODE_COMBINED_PWM2);
+            SetMode(index + 1, pulse.wraps ? TIM_OCMODE_PWM2 : TIM_OCMODE_PWM1);
+            __HAL_TIM_SET_COMPARE(m_timer, output.channel, pulse.first);
+            __HAL_TIM_SET_COMPARE(m_timer, HAL_CHANNELS[index + 1], pulse.second);
+            continue;
+        }
+#endif
+        __HAL_TIM_SET_COMPARE(m_timer, output.channel, width);
+    }
+}
+
+void PwmGroupModule::SetMode(size_t index, uint32_t mode)
+{
+    // CH1 and CH2 are in CCMR1, CH3 and CH4 in CCMR2, the second channel of each 8 bits higher.
+    __IO uint32_t& ccmr  = index < 2 ? m_timer->Instance->CCMR1 : m_timer->Instance->CCMR2;
+    uint32_t       shift = (index % 2) * 8;
+    ccmr                 = (ccmr & ~(TIM_CCMR1_OC1M << shift)) | (mode << shift);
+}
+
+void PwmGroupModule::LoadIfStopped()
+{
+    // A running timer loads the new values at the next update event, a stopped one never would.
+    if ((m_timer->Instance->CR1 & TIM_CR1_CEN) == 0)
+    {
+        HAL_TIM_GenerateEvent(m_timer, TIM_EVENTSOURCE_UPDATE);
+    }
+}
+
+uint32_t PwmGroupModule::GetDeadTimeClock() const
+{
+    uint32_t clock = CEP_TIM::GetTimerClock(m_timer->Instance);
+    switch (m_timer->Init.ClockDivision)
+    {
+        case TIM_CLOCKDIVISION_DIV2: return clock / 2;
+        case TIM_CLOCKDIVISION_DIV4: return clock / 4;
+        default: return clock;
+    }
+}
+
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,156 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  pwm
+ * @{
+ * @file        pwmGroupModule.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/27
+ *
+ * @brief       Channels of a timer driven together, at the same frequency.
+ *
+ * The group owns the timer: the frequency is set once for every output, and the duty cycles and
+ * phases are staged and then applied together by @ref PwmGroupModule::Update, taking effect at
+ * the same update event.
+ *
+ * An output with a phase offset takes a pair of channels, CH1 and CH2 or CH3 and CH4, in one of
+ * the timer's combined PWM modes. Only the first channel of the pair drives a pin. Outputs can
+ * also drive their complementary pin, with a dead time between the two, on advanced timers.
+ */
+#ifndef PWM_GROUP_MODULE_HPP_
+#define PWM_GROUP_MODULE_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_PWM)
+#include "defines/internalConfig.h"
+#include NILAI_HAL_HEADER
+#if defined(HAL_TIM_MODULE_ENABLED)
+#include "defines/module.hpp"
+#include "drivers/pwmModule.h"
+#include "drivers/pwmTiming.hpp"
+
+#include <string>
+#include <vector>
+
+namespace PWM
+{
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+struct GroupOutput
+{
+    PWM::Channels channel = PWM::Channels::CH1;
+    //! The pulse can start anywhere in the period. Only CH1 and CH3 can be phase-shifted, they
+    //! then also take CH2 or CH4. Needs the combined PWM modes, which the timers of the F4 don't
+    //! have: the output is then generated without its offset and the POST fails.
+    bool isPhaseShifted = false;
+    //! The complementary pin is driven as well, inverted and with the group's dead time.
+    bool hasComplementary = false;
+};
+}    // namespace PWM
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+class PwmGroupModule : public cep::Module
+{
+public:
+    /**
+     * @param   timer   The timer, initialized for PWM generation. It's not shared with anything
+     *                  else, not even a @ref PwmModule.
+     * @param   outputs Outputs of the group, indexed in that order by the other functions.
+     */
+    PwmGroupModule(TIM_HandleTypeDef*                   timer,
+                   const std::vector<PWM::GroupOutput>& outputs,
+                   const std::string&                   label);
+
+    virtual bool               DoPost() override;
+    virtual void               Run() override;
+    virtual const std::string& GetLabel() const override { return m_label; }
+
+    //! Starts every output, and their complementary pins.
+    void Enable();
+    void Disable();
+    bool IsEnabled() const { return m_isActive; }
+
+    /**
+     * @brief   Changes the frequency of every output, keeping their duty cycles and phases.
+     *
+     * The staged duty cycles and phases are applied along with it.
+     *
+     * @return  False if the frequency can't be generated, the timer is then left untouched.
+     */
+    bool     SetFrequency(uint64_t hz);
+    uint64_t GetFrequency() const { return m_activeFreq; }
+    //! How @ref SetFrequency picks the timer's settings, PWM::FitMode::Nearest by default.
+    void     SetFitMode(PWM::FitMode mode) { m_fitMode = mode; }
+
+    //! Stages the duty cycle of an output, applied by @ref Update.
+    void     SetDutyCycle(size_t output, uint32_t percent);
+    uint32_t GetDutyCycle(size_t output) const { return m_outputs[output].dutyCycle; }
+    /**
+     * @brief   Stages the delay between the start of the period and the start of an output's
+     *          pulse, applied by @ref Update. Only for phase-shifted outputs.
+     */
+    void     SetPhase(size_t output, uint32_t degrees);
+    uint32_t GetPhase(size_t output) const { return m_outputs[output].phase; }
+
+    /**
+     * @brief   Applies every staged duty cycle and phase.
+     *
+     * The compare values all take effect at the next update event. The combined PWM mode of a
+     * phase-shifted output isn't preloaded though, when its pulse starts or stops wrapping around
+     * the end of the period, that output can be off for the rest of the current period.
+     */
+    void Update();
+
+    /**
+     * @brief   Sets the delay between an output going inactive and its complementary pin going
+     *          active, and vice versa.
+     *
+     * The dead time is rounded up to what the timer can generate, at most 1008 ticks of its dead
+     * time clock.
+     *
+     * @return  False if the timer doesn't have complementary outputs.
+     */
+    bool     SetDeadTime(uint32_t ns);
+    //! Dead time actually generated, in nanoseconds.
+    uint32_t GetDeadTime() const { return m_deadTime; }
+
+private:
+    struct Output
+    {
+        PWM::GroupOutput config;
+        //! The channel, as the HAL knows it.
+        uint32_t channel   = 0;
+        uint32_t dutyCycle = 0;
+        uint32_t phase     = 0;
+    };
+
+    TIM_HandleTypeDef*  m_timer = nullptr;
+    std::vector<Output> m_outputs;
+    std::string         m_label = "";
+
+    uint64_t m_activeFreq = 0;
+    uint32_t m_deadTime   = 0;
+    bool     m_isActive   = false;
+    //! Set when outputs asked for something the timer can't do, fails the POST.
+    bool m_hasRejectedOutputs = false;
+
+    PWM::FitMode        m_fitMode = PWM::FitMode::Nearest;
+    PWM::TimingCache<4> m_timings;
+
+private:
+    void WriteOutputs();
+    void SetMode(size_t index, uint32_t mode);
+    void LoadIfStopped();
+
+    uint32_t GetDeadTimeClock() const;
+};
+
+#endif
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
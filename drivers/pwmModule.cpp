@@ -11,11 +11,21 @@
 
 #include "pwmModule.h"
 #if defined(NILAI_USE_PWM) && defined(HAL_TIM_MODULE_ENABLED)
+#include "drivers/timerClock.hpp"
 #include "services/logger.hpp"
 
+#include <array>
+
+static constexpr std::array<uint32_t, 4> HAL_CHANNELS = {
+  TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4};
+//! Burst base of each channel's compare register.
+static constexpr std::array<uint32_t, 4> COMPARE_BASES = {
+  TIM_DMABASE_CCR1, TIM_DMABASE_CCR2, TIM_DMABASE_CCR3, TIM_DMABASE_CCR4};
+
 PwmModule::PwmModule(TIM_HandleTypeDef* timer, PWM::Channels channel, const std::string& label)
 : m_timer(timer),
-  m_channel((uint32_t)channel),
+  m_id(channel),
+  m_channel(HAL_CHANNELS[(size_t)channel]),
   m_label(label),
   m_activeFreq(0),
   m_activeDutyCycle(0),
@@ -23,6 +33,11 @@ PwmModule::PwmModule(TIM_HandleTypeDef* timer, PWM::Channels channel, const std:
 {
     CEP_ASSERT(timer != nullptr, "[PWM]: TIM Handle is NULL!");
 
+    // Changes of the period and of the compare value wait for the end of the current period.
+    m_timer->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    m_timer->Instance->CR1 |= TIM_CR1_ARPE;
+    __HAL_TIM_ENABLE_OCxPRELOAD(m_timer, m_channel);
+
     LOG_INFO("[PWM]: Initialized");
 }
 
@@ -61,83 +76,111 @@ void PwmModule::SetFrequency(uint64_t hz)
         return;
     }
 
-    uint32_t clk = HAL_RCC_GetPCLK1Freq();
-
-    // If the PWM is currently active:
-    if (m_isActive)
+    uint32_t    clk       = CEP_TIM::GetTimerClock(m_timer->Instance);
+    uint32_t    maxPeriod = IS_TIM_32B_COUNTER_INSTANCE(m_timer->Instance) ? 0xFFFFFFFF : 0xFFFF;
+    PWM::Timing timing    = m_timings.Solve(clk, hz, m_fitMode, maxPeriod);
+    if (timing.frequency == 0)
     {
-        // Stop it.
-        HAL_TIM_PWM_Stop(m_timer, m_channel);
+        // No valid prescaler/period combo, the PWM is left untouched.
+        CEP_ASSERT(false, "Invalid frequency requested!");
+        return;
     }
 
-    TIM_Base_InitTypeDef init = m_timer->Init;
-    init.Prescaler            = 0;
+    m_activeFreq            = hz;
+    m_timer->Init.Prescaler = timing.prescaler;
+    m_timer->Init.Period    = timing.period;
+
+    // Without update events, the timer can't load the new prescaler before the new period.
+    m_timer->Instance->CR1 |= TIM_CR1_UDIS;
+    __HAL_TIM_SET_PRESCALER(m_timer, timing.prescaler);
+    __HAL_TIM_SET_AUTORELOAD(m_timer, timing.period);
+    // Recompute duty cycle since we changed the frequency.
+    __HAL_TIM_SET_COMPARE(
+      m_timer, m_channel, PWM::DutyToCompare(timing.period, m_activeDutyCycle));
+    m_timer->Instance->CR1 &= ~TIM_CR1_UDIS;
+    LoadIfStopped();
+
+    LOG_DEBUG("[PWM]: Setting frequency to %dHz (psc: 0x%08X, per: 0x%08X, clk: %dHz)",
+              timing.frequency,
+              timing.prescaler,
+              timing.period,
+              clk);
+}
+
+void PwmModule::SetDutyCycle(uint32_t percent)
+{
+    // Clip percent to 100, we can't have more than a 100% duty cycle.
+    m_activeDutyCycle = (percent < 100) ? percent : 100;
+    SetCompare(PWM::DutyToCompare(GetPeriod(), m_activeDutyCycle));
 
-    uint64_t regVal = 0;
+    LOG_DEBUG("[PWM]: Setting duty cycle to %d%% (CCR: 0x%08X)", m_activeDutyCycle, GetCompare());
+}
 
-    // Try to find a valid prescaler/period combo for desired freq.
-    while (init.Prescaler < 0xFFFF)
-    {
-        regVal = ((clk / (hz * (init.Prescaler + 1))) - 1) * 2;
-
-        // If regVal <= 0xFFFF, good value.
-        if (regVal <= 0xFFFF)
-        {
-            m_activeFreq  = hz;
-            init.Period   = (uint32_t)regVal;
-            m_timer->Init = init;
-            HAL_TIM_Base_DeInit(m_timer);
-            HAL_TIM_Base_Init(m_timer);
-            LOG_DEBUG("[PWM]: Setting frequency to %d%Hz (psc: 0x%08X, per: 0x%08X, clk: %dHz)",
-                      hz,
-                      m_timer->Init.Prescaler,
-                      regVal,
-                      clk);
-
-            // Recompute duty cycle since we changed the frequency.
-            SetDutyCycle(m_activeDutyCycle);
-
-            if (m_isActive)
-            {
-                // Restart PWM if it was active.
-                HAL_TIM_PWM_Start(m_timer, m_channel);
-            }
-            return;
-        }
-        else
-        {
-            // regVal is not valid, try another prescaler value.
-            init.Prescaler++;
-        }
-    }
+void PwmModule::SetPeriod(uint32_t period)
+{
+    m_timer->Init.Period = period;
+    __HAL_TIM_SET_AUTORELOAD(m_timer, period);
+    LoadIfStopped();
 
-    // If we get here, no valid prescaler/period combo found.
-    // We don't restart the PWM if it was active.
-    CEP_ASSERT(false, "Invalid frequency requested!");
+    uint64_t ticks = ((uint64_t)m_timer->Instance->PSC + 1) * ((uint64_t)period + 1);
+    m_activeFreq   = CEP_TIM::GetTimerClock(m_timer->Instance) / ticks;
 }
 
-void PwmModule::SetDutyCycle(uint32_t percent)
+void PwmModule::SetCompare(uint32_t compare)
 {
-    // TODO: Fix this function so that we can set the duty cycle.
-    // Clip percent to 100, we can't have more than a 100% duty cycle.
-    //    percent           = (percent < 100) ? percent : 100;
-    //    float requestedDC = (float)percent / 100.0f;
+    __HAL_TIM_SET_COMPARE(m_timer, m_channel, compare);
+    LoadIfStopped();
+}
+
+bool PwmModule::PlayWaveform(cep::Span<const uint32_t> table, PWM::WaveformTarget target)
+{
+    CEP_ASSERT(!table.empty(), "[%s]: The waveform is empty!", m_label.c_str());
+
+    StopWaveform();
 
-    // If the PWM is currently active, disable it.
-    if (m_isActive)
+    const DMA_HandleTypeDef* dma = m_timer->hdma[TIM_DMA_ID_UPDATE];
+    if ((dma == nullptr) || (dma->Init.MemDataAlignment != DMA_MDATAALIGN_WORD))
     {
-        HAL_TIM_PWM_Stop(m_timer, m_channel);
+        LOG_ERROR("[%s]: Waveforms require the update DMA of the timer, reading words",
+                  m_label.c_str());
+        return false;
     }
 
-    m_activeDutyCycle = percent;
-    m_timer->Instance->CCR1 =
-      m_timer->Instance->ARR / 2;    //(uint32_t)((float)m_activeFreq * requestedDC);
+    uint32_t base =
+      target == PWM::WaveformTarget::Period ? TIM_DMABASE_ARR : COMPARE_BASES[(size_t)m_id];
+    // The HAL only reads the table, it just doesn't say so.
+    if (HAL_TIM_DMABurst_MultiWriteStart(m_timer,
+                                         base,
+                                         TIM_DMA_UPDATE,
+                                         const_cast<uint32_t*>(table.data()),
+                                         TIM_DMABURSTLENGTH_1TRANSFER,
+                                         (uint32_t)table.size()) != HAL_OK)
+    {
+        LOG_ERROR("[%s]: Unable to start the waveform", m_label.c_str());
+        return false;
+    }
 
-    LOG_DEBUG("[PWM]: Setting duty cycle to %d%% (CCR1: 0x%08X)", percent, m_timer->Instance->CCR1);
-    // If the PWM was active, re-enable it.
-    if (m_isActive)
+    m_isPlaying = true;
+    LOG_DEBUG("[%s]: Playing a waveform of %i values", m_label.c_str(), table.size());
+    return true;
+}
+
+void PwmModule::StopWaveform()
+{
+    if (m_isPlaying)
+    {
+        HAL_TIM_DMABurst_WriteStop(m_timer, TIM_DMA_UPDATE);
+        m_isPlaying = false;
+    }
+}
+
+void PwmModule::LoadIfStopped()
+{
+    // A running timer loads the new values at the next update event. A stopped one never would,
+    // generating the event also restarts its count, which doesn't matter when it's stopped.
+    if ((m_timer->Instance->CR1 & TIM_CR1_CEN) == 0)
     {
-        HAL_TIM_PWM_Start(m_timer, m_channel);
+        HAL_TIM_GenerateEvent(m_timer, TIM_EVENTSOURCE_UPDATE);
     }
 }
 
@@ -21,6 +21,8 @@
 #include "defines/macros.hpp"
 #include "defines/misc.hpp"
 #include "defines/module.hpp"
+#include "defines/span.hpp"
+#include "drivers/pwmTiming.hpp"
 
 #include <string>
 #include <vector>
@@ -49,20 +51,63 @@ public:
     void Disable();
     bool IsEnabled() const { return m_isActive; }
 
+    /**
+     * @brief   Changes the frequency of the timer, and therefore of all its channels.
+     *
+     * Like every other setting, the new frequency takes effect at the end of the current period:
+     * the output is never stopped or cut short. The settings of the last few frequencies are
+     * remembered, switching between them is cheap.
+     */
     void     SetFrequency(uint64_t hz);
     uint64_t GetFrequency() const { return m_activeFreq; }
+    //! How @ref SetFrequency picks the timer's settings, PWM::FitMode::Nearest by default.
+    void     SetFitMode(PWM::FitMode mode) { m_fitMode = mode; }
 
     void     SetDutyCycle(uint32_t percent);
     uint32_t GetDutyCycle() const { return m_activeDutyCycle; }
 
+    /**
+     * @brief   Sets the timer's ARR register, the period being `period + 1` ticks.
+     *
+     * The compare value isn't scaled, see @ref SetFrequency to keep the duty cycle.
+     */
+    void     SetPeriod(uint32_t period);
+    uint32_t GetPeriod() const { return __HAL_TIM_GET_AUTORELOAD(m_timer); }
+    //! Sets the channel's compare value, the output being active for `compare` ticks per period.
+    void     SetCompare(uint32_t compare);
+    uint32_t GetCompare() const { return __HAL_TIM_GET_COMPARE(m_timer, m_channel); }
+
+    /**
+     * @brief   Streams a table of compare values or periods into the timer, one per period.
+     *
+     * At every update event, the timer's update DMA writes the next value of the table, which
+     * takes effect at the following one. The CPU isn't involved until the table is done: once in
+     * normal mode, never in circular mode.
+     *
+     * The table isn't copied, it must outlive the playback. The DMA must read words from memory.
+     *
+     * @return  False if the timer's update DMA isn't set up for it.
+     */
+    bool PlayWaveform(cep::Span<const uint32_t> table, PWM::WaveformTarget target);
+    void StopWaveform();
+
 private:
     TIM_HandleTypeDef* m_timer   = nullptr;
+    PWM::Channels      m_id      = PWM::Channels::CH1;
+    //! The channel, as the HAL knows it.
     uint32_t           m_channel = 0;
     std::string        m_label   = "";
 
     uint64_t m_activeFreq      = 0;
     uint32_t m_activeDutyCycle = 0;
     bool     m_isActive        = false;
+    bool     m_isPlaying       = false;
+
+    PWM::FitMode        m_fitMode = PWM::FitMode::Nearest;
+    PWM::TimingCache<4> m_timings;
+
+private:
+    void LoadIfStopped();
 };
 
 #else
@@ -0,0 +1,323 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  pwm
+ * @{
+ * @file        pwmTiming.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/26
+ *
+ * @brief       Prescaler and period of a timer generating a given frequency, and placement of
+ *              the pulses within a period.
+ *
+ * A timer counting at `clock` overflows at `clock / ((PSC + 1) * (ARR + 1))`. The settings are
+ * computed directly from the requested frequency rather than by trying every prescaler, and the
+ * last few results are remembered for applications that keep switching between frequencies.
+ *
+ * A pulse that doesn't start with the period, for phase-shifted outputs, takes a pair of channels
+ * in one of the timer's combined PWM modes: the output is the AND or the OR of both channels.
+ *
+ * The timer is configured by @ref PwmModule.
+ */
+#ifndef PWM_TIMING_HPP_
+#define PWM_TIMING_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_PWM) || defined(NILAI_TEST)
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace PWM
+{
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+enum class FitMode
+{
+    //! The frequency closest to the one requested, with the smallest prescaler. The period is
+    //! then as long as possible, which gives the duty cycle the finest steps and the least jitter.
+    Nearest,
+    //! Exactly the frequency requested, with the smallest prescaler that allows it, or nothing.
+    Exact,
+};
+
+//! Register a waveform is written to.
+enum class WaveformTarget
+{
+    //! The compare value of the channel, modulating the duty cycle.
+    Compare,
+    //! The period of the timer, modulating the frequency.
+    Period,
+};
+
+/**
+ * @brief   Compare values of a channel pair generating a pulse anywhere in the period.
+ *
+ * When the pulse doesn't wrap around the end of the period, the output is active while
+ * `first <= CNT < second`: the first channel is in combined PWM mode 2, the second one in PWM
+ * mode 1. When it does, the output is active while `CNT < first || CNT >= second`: the first
+ * channel is in combined PWM mode 1, the second one in PWM mode 2.
+ */
+struct Pulse
+{
+    bool     wraps  = false;
+    uint32_t first  = 0;
+    uint32_t second = 0;
+};
+
+struct Timing
+{
+    //! Values of the PSC and ARR registers.
+    uint32_t prescaler = 0;
+    uint32_t period    = 0;
+    //! Frequency actually obtained, rounded to the nearest hertz. 0 if the request can't be met.
+    uint32_t frequency = 0;
+};
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+/**
+ * @brief   Computes the timer settings generating `hz`.
+ *
+ * @ref FitMode::Nearest is a handful of divisions. @ref FitMode::Exact has to look for a divisor
+ * of `clock / hz`, starting from the smallest prescaler that fits: most frequencies are found
+ * right away, but one that can't be reached exactly may take a few thousand tries to rule out.
+ *
+ * @param   clock           Clock of the timer's counter, in hertz.
+ * @param   hz              Frequency to generate.
+ * @param   mode            How to pick the settings.
+ * @param   maxPeriod       Largest value of the timer's ARR register.
+ * @param   maxPrescaler    Largest value of the timer's PSC register.
+ */
+constexpr Timing SolveTiming(uint32_t clock,
+                             uint64_t hz,
+                             FitMode  mode         = FitMode::Nearest,
+                             uint32_t maxPeriod    = 0xFFFF,
+                             uint32_t maxPrescaler = 0xFFFF)
+{
+    Timing timing;
+    if ((hz == 0) || (hz > clock))
+    {
+        return timing;
+    }
+
+    const uint64_t maxCount = (uint64_t)maxPeriod + 1;
+    uint64_t       ticks    = 0;
+    uint64_t       divider  = 0;
+    if (mode == FitMode::Exact)
+    {
+        if ((clock % hz) != 0)
+        {
+            return timing;
+        }
+
+        ticks = clock / hz;
+        // Smallest prescaler for which the period fits, then the first one that divides evenly.
+        divider = (ticks + maxCount - 1) / maxCount;
+        while ((divider <= (uint64_t)maxPrescaler + 1) && ((ticks % divider) != 0))
+        {
+            divider++;
+        }
+    }
+    else
+    {
+        // Number of timer ticks per period, rounded to the nearest.
+        ticks   = ((uint64_t)clock + (hz / 2)) / hz;
+        divider = ((ticks - 1) / maxCount) + 1;
+    }
+
+    if (divider > (uint64_t)maxPrescaler + 1)
+    {
+        return timing;
+    }
+
+    uint64_t count   = (ticks + (divider / 2)) / divider;
+    timing.prescaler = (uint32_t)(divider - 1);
+    timing.period    = (uint32_t)(count - 1);
+    timing.frequency = (uint32_t)(((uint64_t)clock + ((divider * count) / 2)) / (divider * count));
+    return timing;
+}
+
+/**
+ * @brief   Gets the compare value giving a duty cycle of `percent` with a period of `period`.
+ *
+ * 100% is one past the period, which keeps the output active for the whole period.
+ */
+constexpr uint32_t DutyToCompare(uint32_t period, uint32_t percent)
+{
+    percent          = percent < 100 ? percent : 100;
+    uint64_t compare = ((((uint64_t)period + 1) * percent) + 50) / 100;
+    // A 32-bit timer whose period is 0xFFFFFFFF can't be active for its whole period.
+    return compare > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)compare;
+}
+
+/**
+ * @brief   Places a pulse in a period of `period + 1` ticks.
+ * @param   period  Value of the ARR register.
+ * @param   start   Tick at which the pulse starts, modulo the period.
+ * @param   width   Number of ticks the pulse lasts, at most `period + 1`.
+ */
+constexpr Pulse PlacePulse(uint32_t period, uint32_t start, uint32_t width)
+{
+    const uint64_t ticks = (uint64_t)period + 1;
+    Pulse          pulse;
+    if (width >= ticks)
+    {
+        // Always active, the second channel being active from the first tick.
+        pulse.wraps = true;
+        return pulse;
+    }
+
+    start        = (uint32_t)(start % ticks);
+    uint64_t end = (uint64_t)start + width;
+    // A pulse ending with the period wraps to 0, a compare value of `period + 1` wouldn't fit in
+    // a 32-bit timer.
+    if (end < ticks)
+    {
+        pulse.first  = start;
+        pulse.second = (uint32_t)end;
+    }
+    else
+    {
+        pulse.wraps  = true;
+        pulse.first  = (uint32_t)(end - ticks);
+        pulse.second = start;
+    }
+    return pulse;
+}
+
+//! Gets the tick at which a phase of `degrees` starts, in a period of `period + 1` ticks.
+constexpr uint32_t PhaseToTicks(uint32_t period, uint32_t degrees)
+{
+    const uint64_t ticks = (uint64_t)period + 1;
+    return (uint32_t)(((((uint64_t)(degrees % 360) * ticks) + 180) / 360) % ticks);
+}
+
+/**
+ * @brief   Encodes a dead time in the format of the DTG bits of the BDTR register.
+ *
+ * The dead time is rounded up to the next step, the longest one being 1008 ticks of the dead time
+ * clock. Longer dead times are clamped to it.
+ *
+ * @param   clock   Dead time clock in hertz, the timer's clock divided by its clock division.
+ * @param   ns      Dead time, in nanoseconds.
+ */
+constexpr uint8_t EncodeDeadTime(uint32_t clock, uint32_t ns)
+{
+    uint64_t ticks = (((uint64_t)clock * ns) + 999999999) / 1000000000;
+    if (ticks <= 127)
+    {
+        return (uint8_t)ticks;
+    }
+    if (ticks <= 2 * (64 + 63))
+    {
+        return (uint8_t)(0x80 | (((ticks + 1) / 2) - 64));
+    }
+    if (ticks <= 8 * (32 + 31))
+    {
+        return (uint8_t)(0xC0 | (((ticks + 7) / 8) - 32));
+    }
+    if (ticks <= 16 * (32 + 31))
+    {
+        return (uint8_t)(0xE0 | (((ticks + 15) / 16) - 32));
+    }
+    return 0xFF;
+}
+
+//! Gets the number of dead time clock ticks of an encoded dead time.
+constexpr uint32_t DecodeDeadTime(uint8_t dtg)
+{
+    if ((dtg & 0x80) == 0)
+    {
+        return dtg;
+    }
+    if ((dtg & 0xC0) == 0x80)
+    {
+        return 2 * (64 + (uint32_t)(dtg & 0x3F));
+    }
+    if ((dtg & 0xE0) == 0xC0)
+    {
+        return 8 * (32 + (uint32_t)(dtg & 0x1F));
+    }
+    return 16 * (32 + (uint32_t)(dtg & 0x1F));
+}
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+/**
+ * @brief   Remembers the settings of the last `N` frequencies requested.
+ *
+ * When full, the entry that was used the longest time ago is replaced.
+ */
+template<size_t N = 4>
+class TimingCache
+{
+    static_assert(N != 0, "A TimingCache must hold at least one entry");
+
+public:
+    //! Same as @ref SolveTiming, only solving the frequencies it doesn't remember.
+    Timing Solve(uint32_t clock,
+                 uint64_t hz,
+                 FitMode  mode         = FitMode::Nearest,
+                 uint32_t maxPeriod    = 0xFFFF,
+                 uint32_t maxPrescaler = 0xFFFF)
+    {
+        m_uses++;
+        Entry* oldest = &m_entries[0];
+        for (Entry& entry : m_entries)
+        {
+            if ((entry.lastUse != 0) && (entry.clock == clock) && (entry.hz == hz) &&
+                (entry.mode == mode) && (entry.maxPeriod == maxPeriod) &&
+                (entry.maxPrescaler == maxPrescaler))
+            {
+                entry.lastUse = m_uses;
+                return entry.timing;
+            }
+            if (entry.lastUse < oldest->lastUse)
+            {
+                oldest = &entry;
+            }
+        }
+
+        m_misses++;
+        *oldest = {clock,
+                   hz,
+                   mode,
+                   maxPeriod,
+                   maxPrescaler,
+                   SolveTiming(clock, hz, mode, maxPeriod, maxPrescaler),
+                   m_uses};
+        return oldest->timing;
+    }
+
+    void Clear() { m_entries = {}; }
+
+    //! Number of requests that had to be solved.
+    [[nodiscard]] size_t GetMisses() const { return m_misses; }
+
+private:
+    struct Entry
+    {
+        uint32_t clock        = 0;
+        uint64_t hz           = 0;
+        FitMode  mode         = FitMode::Nearest;
+        uint32_t maxPeriod    = 0;
+        uint32_t maxPrescaler = 0;
+        Timing   timing;
+        //! Value of m_uses when the entry was last used, 0 for an empty entry.
+        uint32_t lastUse = 0;
+    };
+
+    std::array<Entry, N> m_entries = {};
+    uint32_t             m_uses    = 0;
+    size_t               m_misses  = 0;
+};
+}    // namespace PWM
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
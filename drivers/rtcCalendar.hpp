@@ -0,0 +1,159 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  RTC
+ * @{
+ * @file        rtcCalendar.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/30
+ *
+ * @brief       Conversions between dates and times and Unix epochs, in UTC.
+ *
+ * Days are converted with closed-form arithmetic on 400-year eras, in which the calendar repeats
+ * itself, with years starting in March so that the leap day is the last day of the year. The
+ * months then follow a regular pattern that a multiplication finds, without a table to walk or
+ * leap years to count one by one.
+ *
+ * Epochs are 64-bit, negative before 1970, and don't overflow in 2038.
+ */
+#ifndef RTC_CALENDAR_HPP_
+#define RTC_CALENDAR_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_RTC) || defined(NILAI_TEST)
+#include <cstdint>
+
+namespace CEP_RTC
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+static constexpr int64_t SECONDS_PER_DAY = 86400;
+
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+//! Date and time of the RTC, without the HAL's types.
+struct CivilTime
+{
+    uint16_t year = 2000;
+    //! 1 for January, 12 for December.
+    uint8_t month = 1;
+    //! Day of the month, starts at 1.
+    uint8_t  day          = 1;
+    uint8_t  hours        = 0;
+    uint8_t  minutes      = 0;
+    uint8_t  seconds      = 0;
+    uint16_t milliseconds = 0;
+};
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+//! Divides, rounding down rather than towards 0 for negative numbers.
+constexpr int64_t FloorDivide(int64_t value, int64_t divisor)
+{
+    return (value / divisor) - (((value % divisor) < 0) ? 1 : 0);
+}
+
+constexpr bool IsLeapYear(uint16_t year)
+{
+    return ((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0));
+}
+
+//! @param  month   1 for January, 12 for December.
+constexpr uint8_t DaysInMonth(uint16_t year, uint8_t month)
+{
+    constexpr uint8_t DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return ((month == 2) && IsLeapYear(year)) ? 29 : DAYS[month - 1];
+}
+
+/**
+ * @brief   Gets the number of days between 1970-01-01 and a date, negative before it.
+ * @param   month   1 for January, 12 for December.
+ * @param   day     Day of the month, starts at 1.
+ */
+constexpr int64_t DaysFromCivil(int32_t year, uint32_t month, uint32_t day)
+{
+    // Years start in March, January and February belong to the year before.
+    year -= (month <= 2) ? 1 : 0;
+    const int32_t  era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t yoe = (uint32_t)(year - (era * 400));
+    // Days since March 1st: the months alternate between 31 and 30 days, but for February.
+    const uint32_t doy = (((153 * (month > 2 ? month - 3 : month + 9)) + 2) / 5) + day - 1;
+    const uint32_t doe = (yoe * 365) + (yoe / 4) - (yoe / 100) + doy;
+    // 719468 days from 0000-03-01 to 1970-01-01.
+    return ((int64_t)era * 146097) + (int64_t)doe - 719468;
+}
+
+/**
+ * @brief   Gets the date that is `days` days after 1970-01-01.
+ *
+ * Only fills in the date, the time is left to 00:00:00.000.
+ */
+constexpr CivilTime CivilFromDays(int64_t days)
+{
+    days += 719468;
+    const int64_t  era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t doe = (uint32_t)(days - (era * 146097));
+    // Corrects for the leap days of the era so far, which are missing from a 365 days division.
+    const uint32_t yoe = (doe - (doe / 1460) + (doe / 36524) - (doe / 146096)) / 365;
+    const uint32_t doy = doe - ((365 * yoe) + (yoe / 4) - (yoe / 100));
+    const uint32_t mp  = ((5 * doy) + 2) / 153;
+    const uint32_t m   = mp < 10 ? mp + 3 : mp - 9;
+
+    CivilTime civil;
+    civil.year  = (uint16_t)((int64_t)yoe + (era * 400) + (m <= 2 ? 1 : 0));
+    civil.month = (uint8_t)m;
+    civil.day   = (uint8_t)(doy - (((153 * mp) + 2) / 5) + 1);
+    return civil;
+}
+
+//! Gets the day of the week of a date, 1 for Monday to 7 for Sunday like the RTC.
+constexpr uint8_t WeekdayFromDays(int64_t days)
+{
+    // 1970-01-01 was a Thursday.
+    return (uint8_t)((((days % 7) + 10) % 7) + 1);
+}
+
+//! Gets the Unix epoch of a date and time, in seconds. The milliseconds are ignored.
+constexpr int64_t ToEpoch(const CivilTime& time)
+{
+    return (DaysFromCivil(time.year, time.month, time.day) * SECONDS_PER_DAY) +
+           (time.hours * 3600) + (time.minutes * 60) + time.seconds;
+}
+
+//! Gets the Unix epoch of a date and time, in milliseconds.
+constexpr int64_t ToEpochMs(const CivilTime& time)
+{
+    return (ToEpoch(time) * 1000) + time.milliseconds;
+}
+
+//! Gets the date and time of a Unix epoch, in seconds.
+constexpr CivilTime FromEpoch(int64_t epoch)
+{
+    const int64_t  days    = FloorDivide(epoch, SECONDS_PER_DAY);
+    const uint32_t seconds = (uint32_t)(epoch - (days * SECONDS_PER_DAY));
+
+    CivilTime time = CivilFromDays(days);
+    time.hours     = (uint8_t)(seconds / 3600);
+    time.minutes   = (uint8_t)((seconds / 60) % 60);
+    time.seconds   = (uint8_t)(seconds % 60);
+    return time;
+}
+
+//! Gets the date and time of a Unix epoch, in milliseconds.
+constexpr CivilTime FromEpochMs(int64_t epochMs)
+{
+    const int64_t seconds = FloorDivide(epochMs, 1000);
+
+    CivilTime time    = FromEpoch(seconds);
+    time.milliseconds = (uint16_t)(epochMs - (seconds * 1000));
+    return time;
+}
+}    // namespace CEP_RTC
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
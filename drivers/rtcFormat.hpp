@@ -0,0 +1,270 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  RTC
+ * @{
+ * @file        rtcFormat.hpp
+ * @author      Samuel Martel
+ * @date        2021/12/01
+ *
+ * @brief       Text and binary encodings of dates and times, without allocating.
+ *
+ * The text is written into the caller's buffer two digits at a time, from a table of the pairs
+ * "00" to "99", instead of dividing by 10 for every digit or going through printf.
+ *
+ * @ref CompactTime packs a date and time down to the millisecond into 7 bytes, for records that
+ * are stored by the thousands. Unlike an epoch, packing it doesn't need any calendar arithmetic.
+ */
+#ifndef RTC_FORMAT_HPP_
+#define RTC_FORMAT_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_RTC) || defined(NILAI_TEST)
+#include "drivers/rtcCalendar.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace CEP_RTC
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+// Number of characters of each format, without the terminating null.
+//! `HH:MM:SS`
+static constexpr size_t TIME_LENGTH = 8;
+//! `YY-MM-DD`
+static constexpr size_t DATE_LENGTH = 8;
+//! `YYYY-MM-DDTHH:MM:SSZ`
+static constexpr size_t ISO8601_LENGTH = 20;
+//! `YYYY-MM-DDTHH:MM:SS.mmmZ`
+static constexpr size_t ISO8601_MS_LENGTH = 24;
+
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+/**
+ * @brief   A date and time packed in 50 bits, stored in 7 bytes.
+ *
+ * Layout, from the most significant bits so that the values sort like the times they hold:
+ *  - [49:36] year, 0 to 9999.
+ *  - [35:32] month, [31:27] day.
+ *  - [26:22] hours, [21:16] minutes, [15:10] seconds.
+ *  - [9:0] milliseconds.
+ */
+struct CompactTime
+{
+    uint64_t value = 0;
+
+    //! Number of bytes written by @ref EncodeTo.
+    static constexpr size_t SIZE = 7;
+
+    static constexpr uint32_t YEAR_POS     = 36;
+    static constexpr uint32_t MONTH_POS    = 32;
+    static constexpr uint32_t DAY_POS      = 27;
+    static constexpr uint32_t HOURS_POS    = 22;
+    static constexpr uint32_t MINUTES_POS  = 16;
+    static constexpr uint32_t SECONDS_POS  = 10;
+    static constexpr uint64_t YEAR_MASK    = 0x3FFF;
+    static constexpr uint64_t MONTH_MASK   = 0x0F;
+    static constexpr uint64_t DAY_MASK     = 0x1F;
+    static constexpr uint64_t HOURS_MASK   = 0x1F;
+    static constexpr uint64_t MINUTES_MASK = 0x3F;
+    static constexpr uint64_t SECONDS_MASK = 0x3F;
+    static constexpr uint64_t MS_MASK      = 0x3FF;
+
+    static constexpr CompactTime Make(const CivilTime& time)
+    {
+        return CompactTime{((time.year & YEAR_MASK) << YEAR_POS) |
+                           ((time.month & MONTH_MASK) << MONTH_POS) |
+                           ((time.day & DAY_MASK) << DAY_POS) |
+                           ((time.hours & HOURS_MASK) << HOURS_POS) |
+                           ((time.minutes & MINUTES_MASK) << MINUTES_POS) |
+                           ((time.seconds & SECONDS_MASK) << SECONDS_POS) |
+                           (time.milliseconds & MS_MASK)};
+    }
+
+    [[nodiscard]] constexpr CivilTime ToCivil() const
+    {
+        CivilTime time;
+        time.year         = (uint16_t)((value >> YEAR_POS) & YEAR_MASK);
+        time.month        = (uint8_t)((value >> MONTH_POS) & MONTH_MASK);
+        time.day          = (uint8_t)((value >> DAY_POS) & DAY_MASK);
+        time.hours        = (uint8_t)((value >> HOURS_POS) & HOURS_MASK);
+        time.minutes      = (uint8_t)((value >> MINUTES_POS) & MINUTES_MASK);
+        time.seconds      = (uint8_t)((value >> SECONDS_POS) & SECONDS_MASK);
+        time.milliseconds = (uint16_t)(value & MS_MASK);
+        return time;
+    }
+
+    /**
+     * @brief   Writes the @ref SIZE bytes of the time, least significant first.
+     * @return  The number of bytes written, 0 if the buffer is too small.
+     */
+    constexpr size_t EncodeTo(uint8_t* buf, size_t len) const
+    {
+        if (len < SIZE)
+        {
+            return 0;
+        }
+        for (size_t i = 0; i < SIZE; i++)
+        {
+            buf[i] = (uint8_t)(value >> (8 * i));
+        }
+        return SIZE;
+    }
+
+    //! Reads the @ref SIZE bytes written by @ref EncodeTo.
+    static constexpr CompactTime DecodeFrom(const uint8_t* buf)
+    {
+        CompactTime time;
+        for (size_t i = 0; i < SIZE; i++)
+        {
+            time.value |= (uint64_t)buf[i] << (8 * i);
+        }
+        return time;
+    }
+
+    constexpr bool operator==(const CompactTime& o) const { return value == o.value; }
+    constexpr bool operator!=(const CompactTime& o) const { return value != o.value; }
+    constexpr bool operator<(const CompactTime& o) const { return value < o.value; }
+};
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+constexpr std::array<char, 200> MakeDigitPairs()
+{
+    std::array<char, 200> pairs = {};
+    for (size_t i = 0; i < 100; i++)
+    {
+        pairs[2 * i]       = (char)('0' + (i / 10));
+        pairs[(2 * i) + 1] = (char)('0' + (i % 10));
+    }
+    return pairs;
+}
+
+//! The characters of the numbers 0 to 99, two for each.
+static constexpr std::array<char, 200> DIGIT_PAIRS = MakeDigitPairs();
+
+//! Writes the two digits of `value`, which must be below 100.
+constexpr void WritePair(char* out, uint32_t value)
+{
+    out[0] = DIGIT_PAIRS[2 * value];
+    out[1] = DIGIT_PAIRS[(2 * value) + 1];
+}
+
+//! Writes the three digits of `value`, which must be below 1000.
+constexpr void WriteTriplet(char* out, uint32_t value)
+{
+    out[0] = (char)('0' + (value / 100));
+    WritePair(&out[1], value % 100);
+}
+
+/**
+ * @brief   Formats the time as `HH:MM:SS`.
+ * @return  The number of characters written, without the terminating null. 0 if the buffer
+ *          can't hold them along with the null, in which case nothing but the null is written.
+ */
+constexpr size_t FormatTime(const CivilTime& time, char* buf, size_t len)
+{
+    if (len <= TIME_LENGTH)
+    {
+        if (len != 0)
+        {
+            buf[0] = '\0';
+        }
+        return 0;
+    }
+    WritePair(&buf[0], time.hours);
+    buf[2] = ':';
+    WritePair(&buf[3], time.minutes);
+    buf[5] = ':';
+    WritePair(&buf[6], time.seconds);
+    buf[8] = '\0';
+    return TIME_LENGTH;
+}
+
+/**
+ * @brief   Formats the date as `YY-MM-DD`.
+ * @return  The number of characters written, like @ref FormatTime.
+ */
+constexpr size_t FormatDate(const CivilTime& time, char* buf, size_t len)
+{
+    if (len <= DATE_LENGTH)
+    {
+        if (len != 0)
+        {
+            buf[0] = '\0';
+        }
+        return 0;
+    }
+    WritePair(&buf[0], time.year % 100);
+    buf[2] = '-';
+    WritePair(&buf[3], time.month);
+    buf[5] = '-';
+    WritePair(&buf[6], time.day);
+    buf[8] = '\0';
+    return DATE_LENGTH;
+}
+
+/**
+ * @brief   Formats the date and time in UTC as ISO 8601, `YYYY-MM-DDTHH:MM:SS.mmmZ`.
+ * @param   withMilliseconds    False to leave out the milliseconds, `YYYY-MM-DDTHH:MM:SSZ`.
+ * @return  The number of characters written, like @ref FormatTime.
+ */
+constexpr size_t FormatIso8601(const CivilTime& time,
+                               char*            buf,
+                               size_t           len,
+                               bool             withMilliseconds = true)
+{
+    const size_t length = withMilliseconds ? ISO8601_MS_LENGTH : ISO8601_LENGTH;
+    if (len <= length)
+    {
+        if (len != 0)
+        {
+            buf[0] = '\0';
+        }
+        return 0;
+    }
+    WritePair(&buf[0], (time.year / 100) % 100);
+    WritePair(&buf[2], time.year % 100);
+    buf[4] = '-';
+    WritePair(&buf[5], time.month);
+    buf[7] = '-';
+    WritePair(&buf[8], time.day);
+    buf[10] = 'T';
+    FormatTime(time, &buf[11], TIME_LENGTH + 1);
+    if (withMilliseconds)
+    {
+        buf[19] = '.';
+        WriteTriplet(&buf[20], time.milliseconds);
+    }
+    buf[length - 1] = 'Z';
+    buf[length]     = '\0';
+    return length;
+}
+
+//! @param  weekday 1 for Monday to 7 for Sunday.
+//! @return `MON` to `SUN`, or `ERR` for an invalid day.
+constexpr const char* WeekdayName(uint8_t weekday)
+{
+    constexpr const char* NAMES[] = {"MON", "TUE", "WED", "THU", "FRI", "SAT", "SUN"};
+    return ((weekday >= 1) && (weekday <= 7)) ? NAMES[weekday - 1] : "ERR";
+}
+
+//! @param  month   1 for January to 12 for December.
+//! @return `JAN` to `DEC`, or `ERR` for an invalid month.
+constexpr const char* MonthName(uint8_t month)
+{
+    constexpr const char* NAMES[] = {
+      "JAN", "FEB", "MAR", "APR", "MAY", "JUN", "JUL", "AUG", "SEP", "OCT", "NOV", "DEC"};
+    return ((month >= 1) && (month <= 12)) ? NAMES[month - 1] : "ERR";
+}
+}    // namespace CEP_RTC
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -12,13 +12,20 @@
 #include "rtcModule.h"
 #if defined(NILAI_USE_RTC) && defined(HAL_RTC_MODULE_ENABLED)
 #include "services/logger.hpp"
-
-#include <ctime>
+#include "services/timebase.hpp"
 
 namespace CEP_RTC
 {
 Time::Time(const RTC_TimeTypeDef& time)
-: hours(time.Hours), minutes(time.Minutes), seconds(time.Seconds)
+: hours(time.Hours),
+  minutes(time.Minutes),
+  seconds(time.Seconds),
+  // The sub-second register counts down from the synchronous prescaler. It can be above it
+  // for a moment after a shift of the clock, the second then hasn't started yet.
+  milliseconds(time.SubSeconds > time.SecondFraction
+                 ? 0
+                 : (uint16_t)(((time.SecondFraction - time.SubSeconds) * 1000) /
+                              (time.SecondFraction + 1)))
 {
     switch (time.DayLightSaving)
     {
@@ -64,13 +71,20 @@ RTC_TimeTypeDef Time::ToHal() const
 
 std::string Time::ToStr() const
 {
-    char t[12] = {0};
-
-    sprintf(t, "%02i:%02i:%02i", hours, minutes, seconds);
-
+    char t[TIME_LENGTH + 1] = {0};
+    FormatTo(t, sizeof(t));
     return std::string{t};
 }
 
+size_t Time::FormatTo(char* buf, size_t len) const
+{
+    CivilTime time;
+    time.hours   = hours;
+    time.minutes = minutes;
+    time.seconds = seconds;
+    return FormatTime(time, buf, len);
+}
+
 Date::Date(const RTC_DateTypeDef& date)
 : year((uint16_t)(date.Year + 2000)), month(date.Month), day(date.Date), dotw(date.WeekDay)
 {
@@ -78,58 +92,12 @@ Date::Date(const RTC_DateTypeDef& date)
 
 std::string Date::DotWtoStr() const
 {
-    switch (dotw)
-    {
-        case RTC_WEEKDAY_MONDAY:
-            return "MON";
-        case RTC_WEEKDAY_TUESDAY:
-            return "TUE";
-        case RTC_WEEKDAY_WEDNESDAY:
-            return "WED";
-        case RTC_WEEKDAY_THURSDAY:
-            return "THU";
-        case RTC_WEEKDAY_FRIDAY:
-            return "FRI";
-        case RTC_WEEKDAY_SATURDAY:
-            return "SAT";
-        case RTC_WEEKDAY_SUNDAY:
-            return "SUN";
-        default:
-            return "ERR";
-    }
+    return std::string{GetDotWName()};
 }
 
 std::string Date::MonthtoStr() const
 {
-    switch (month)
-    {
-        case RTC_MONTH_JANUARY:
-            return "JAN";
-        case RTC_MONTH_FEBRUARY:
-            return "FEB";
-        case RTC_MONTH_MARCH:
-            return "MAR";
-        case RTC_MONTH_APRIL:
-            return "APR";
-        case RTC_MONTH_MAY:
-            return "MAY";
-        case RTC_MONTH_JUNE:
-            return "JUN";
-        case RTC_MONTH_JULY:
-            return "JUL";
-        case RTC_MONTH_AUGUST:
-            return "AUG";
-        case RTC_MONTH_SEPTEMBER:
-            return "SEP";
-        case RTC_MONTH_OCTOBER:
-            return "OCT";
-        case RTC_MONTH_NOVEMBER:
-            return "NOV";
-        case RTC_MONTH_DECEMBER:
-            return "DEC";
-        default:
-            return "ERR";
-    }
+    return std::string{GetMonthName()};
 }
 
 RTC_DateTypeDef Date::ToHal() const
@@ -146,12 +114,19 @@ RTC_DateTypeDef Date::ToHal() const
 
 std::string Date::ToStr() const
 {
-    char d[14] = {0};
-
-    sprintf(d, "%02i-%02i-%02i", year - 2000, month, day);
-
+    char d[DATE_LENGTH + 1] = {0};
+    FormatTo(d, sizeof(d));
     return std::string{d};
 }
+
+size_t Date::FormatTo(char* buf, size_t len) const
+{
+    CivilTime date;
+    date.year  = year;
+    date.month = month;
+    date.day   = day;
+    return FormatDate(date, buf, len);
+}
 }    // namespace CEP_RTC
 
 
@@ -180,18 +155,18 @@ RtcModule::RtcModule(RTC_HandleTypeDef* handle, const std::string& label)
  */
 bool RtcModule::DoPost()
 {
-    size_t firstTime = GetEpoch();
+    int64_t firstTime = GetEpoch();
     HAL_Delay(2000);
-    size_t secondTime = GetEpoch();
+    int64_t elapsed = GetEpoch() - firstTime;
 
-    if ((secondTime >= firstTime + 1) && (secondTime <= firstTime + 3))
+    if ((elapsed >= 1) && (elapsed <= 3))
     {
         LOG_INFO("[RTC]: POST OK");
         return true;
     }
     else
     {
-        LOG_ERROR("[RTC]: POST ERROR! (first: %i, second: %i)", firstTime, secondTime);
+        LOG_ERROR("[RTC]: POST ERROR! (%i seconds elapsed instead of 2)", (int)elapsed);
         return false;
     }
 }
@@ -208,6 +183,7 @@ void RtcModule::SetTime(const CEP_RTC::Time& time)
     {
         LOG_ERROR("[%s]: Unable to set the time!", m_label.c_str());
     }
+    Timebase::Invalidate();
 }
 
 CEP_RTC::Time RtcModule::GetTime()
@@ -234,6 +210,7 @@ void RtcModule::SetDate(const CEP_RTC::Date& date)
     {
         LOG_ERROR("[%s]: Unable to set the date!", m_label.c_str());
     }
+    Timebase::Invalidate();
 }
 
 CEP_RTC::Date RtcModule::GetDate()
@@ -254,58 +231,55 @@ CEP_RTC::Date RtcModule::GetDate()
 
 CEP_RTC::Timestamp RtcModule::GetTimestamp()
 {
-    return CEP_RTC::Timestamp(GetDate(), GetTime());
+    // Reading the time locks the date until it's read as well.
+    RTC_TimeTypeDef halTime = {};
+    RTC_DateTypeDef halDate = {};
+    HAL_RTC_GetTime(m_handle, &halTime, RTC_FORMAT_BIN);
+    HAL_RTC_GetDate(m_handle, &halDate, RTC_FORMAT_BIN);
+
+    return CEP_RTC::Timestamp(CEP_RTC::Date(halDate), CEP_RTC::Time(halTime));
+}
+
+CEP_RTC::Timestamp RtcModule::GetTimestamp(uint16_t& milliseconds)
+{
+    CEP_RTC::Timestamp timestamp = GetTimestamp();
+    milliseconds                 = timestamp.time.milliseconds;
+    return timestamp;
 }
 
-size_t RtcModule::GetEpoch()
+int64_t RtcModule::GetEpoch()
 {
-    return GetEpoch(GetDate(), GetTime());
+    return GetTimestamp().ToEpoch();
 }
 
-size_t RtcModule::GetEpoch(const CEP_RTC::Date& date, const CEP_RTC::Time& time)
+int64_t RtcModule::GetEpoch(const CEP_RTC::Date& date, const CEP_RTC::Time& time)
 {
-    time_t    epoch = {0};
-    struct tm tim   = {};
-
-    tim.tm_year = (date.year - 1900);
-    tim.tm_mon  = date.month - 1;
-    tim.tm_mday = date.day;
-    tim.tm_hour = time.hours;
-    tim.tm_min  = time.minutes;
-    tim.tm_sec  = time.seconds;
-
-    epoch = mktime(&tim);
-    return (size_t)epoch;
+    return CEP_RTC::Timestamp(date, time).ToEpoch();
 }
 
-CEP_RTC::Timestamp::Timestamp(size_t epoch)
+CEP_RTC::Timestamp::Timestamp(const CivilTime& civil)
+: date(civil.year,
+       civil.month,
+       civil.day,
+       WeekdayFromDays(DaysFromCivil(civil.year, civil.month, civil.day)))
 {
-    time_t     e = epoch;
-    struct tm* tim;
-
-    tim          = gmtime(&e);
-    date.year    = (uint16_t)(tim->tm_year + 1900);
-    date.month   = (uint8_t)(tim->tm_mon + 1);
-    date.day     = (uint8_t)(tim->tm_mday);
-    time.hours   = (uint8_t)(tim->tm_hour);
-    time.minutes = (uint8_t)(tim->tm_min);
-    time.seconds = (uint8_t)(tim->tm_sec);
+    time.hours        = civil.hours;
+    time.minutes      = civil.minutes;
+    time.seconds      = civil.seconds;
+    time.milliseconds = civil.milliseconds;
 }
 
-size_t CEP_RTC::Timestamp::ToEpoch() const
+CEP_RTC::CivilTime CEP_RTC::Timestamp::ToCivil() const
 {
-    time_t    epoch = {0};
-    struct tm tim   = {};
-
-    tim.tm_year = (date.year - 1900);
-    tim.tm_mon  = date.month - 1;
-    tim.tm_mday = date.day;
-    tim.tm_hour = time.hours;
-    tim.tm_min  = time.minutes;
-    tim.tm_sec  = time.seconds;
-
-    epoch = mktime(&tim);
-    return (size_t)epoch;
+    CivilTime civil;
+    civil.year         = date.year;
+    civil.month        = date.month;
+    civil.day          = date.day;
+    civil.hours        = time.hours;
+    civil.minutes      = time.minutes;
+    civil.seconds      = time.seconds;
+    civil.milliseconds = time.milliseconds;
+    return civil;
 }
 
 #endif
@@ -22,6 +22,8 @@
 #include "defines/macros.hpp"
 #include "defines/misc.hpp"
 #include "defines/module.hpp"
+#include "drivers/rtcCalendar.hpp"
+#include "drivers/rtcFormat.hpp"
 
 #include <string>
 #include <vector>
@@ -52,6 +54,8 @@ struct Time
     uint8_t hours   = 0;
     uint8_t minutes = 0;
     uint8_t seconds = 0;
+    //! Milliseconds elapsed in the current second, from the sub-second register.
+    uint16_t milliseconds = 0;
 
     DayLightSaving dayLightSaving = DayLightSaving::None;
 
@@ -60,24 +64,35 @@ struct Time
 
     RTC_TimeTypeDef ToHal() const;
     std::string     ToStr() const;
+    //! Writes `HH:MM:SS` into `buf`, see @ref FormatTime.
+    size_t FormatTo(char* buf, size_t len) const;
 };
 
 struct Date
 {
     uint16_t year  = 0;
-    uint8_t  month = 0;    // Month is coded in BCD. 0x01 is January, 0x12 is December
+    uint8_t  month = 0;    // 1 is January, 12 is December
     uint8_t  day   = 0;    // Day of the month, starts at 1.
     uint8_t  dotw  = 1;    // Day of the week, 1 is Monday, 7 is Sunday
 
     Date() = default;
-    Date(uint16_t y, uint8_t m, uint8_t d, uint8_t wd = 1) : year(y), month(m), day(d), dotw(wd) {}
+    constexpr Date(uint16_t y, uint8_t m, uint8_t d, uint8_t wd = 1)
+    : year(y), month(m), day(d), dotw(wd)
+    {
+    }
     Date(const RTC_DateTypeDef& date);
 
     std::string DotWtoStr() const;
     std::string MonthtoStr() const;
+    //! Same as @ref DotWtoStr, without allocating.
+    const char* GetDotWName() const { return WeekdayName(dotw); }
+    //! Same as @ref MonthtoStr, without allocating.
+    const char* GetMonthName() const { return MonthName(month); }
 
     RTC_DateTypeDef ToHal() const;
     std::string     ToStr() const;
+    //! Writes `YY-MM-DD` into `buf`, see @ref FormatDate.
+    size_t FormatTo(char* buf, size_t len) const;
 };
 
 struct Timestamp
@@ -87,9 +102,35 @@ struct Timestamp
 
     Timestamp() = default;
     Timestamp(const Date& d, const Time& t) : date(d), time(t) {}
-    Timestamp(size_t epoch);
-
-    size_t ToEpoch() const;
+    //! @param  epoch   Unix epoch in seconds, in UTC. See @ref FromEpoch for the dates before 1970.
+    Timestamp(size_t epoch) : Timestamp(CEP_RTC::FromEpoch((int64_t)epoch)) {}
+    Timestamp(const CivilTime& civil);
+
+    //! @param  epoch   Unix epoch in seconds, in UTC.
+    static Timestamp FromEpoch(int64_t epoch) { return Timestamp(CEP_RTC::FromEpoch(epoch)); }
+    //! @param  epochMs Unix epoch in milliseconds, in UTC.
+    static Timestamp FromEpochMs(int64_t epochMs)
+    {
+        return Timestamp(CEP_RTC::FromEpochMs(epochMs));
+    }
+
+    //! Unix epoch in seconds, treating the date and time as UTC.
+    int64_t ToEpoch() const { return CEP_RTC::ToEpoch(ToCivil()); }
+    //! Unix epoch in milliseconds, treating the date and time as UTC.
+    int64_t   ToEpochMs() const { return CEP_RTC::ToEpochMs(ToCivil()); }
+    CivilTime ToCivil() const;
+
+    //! Writes `YYYY-MM-DDTHH:MM:SS.mmmZ` into `buf`, see @ref FormatIso8601.
+    size_t FormatTo(char* buf, size_t len, bool withMilliseconds = true) const
+    {
+        return FormatIso8601(ToCivil(), buf, len, withMilliseconds);
+    }
+
+    CompactTime      ToCompact() const { return CompactTime::Make(ToCivil()); }
+    static Timestamp FromCompact(const CompactTime& compact)
+    {
+        return Timestamp(compact.ToCivil());
+    }
 };
 
 }    // namespace CEP_RTC
@@ -115,10 +156,18 @@ public:
     void          SetDate(const CEP_RTC::Date& date);
     CEP_RTC::Date GetDate();
 
+    /**
+     * @brief   Reads the date and time together, down to the millisecond.
+     *
+     * Errors aren't logged, the logger's timestamps come from it.
+     */
     CEP_RTC::Timestamp GetTimestamp();
+    //! Same as @ref GetTimestamp, also returning the milliseconds elapsed in the current second.
+    CEP_RTC::Timestamp GetTimestamp(uint16_t& milliseconds);
 
-    size_t        GetEpoch();
-    static size_t GetEpoch(const CEP_RTC::Date& date, const CEP_RTC::Time& time);
+    //! Unix epoch in seconds, the RTC being in UTC.
+    int64_t        GetEpoch();
+    static int64_t GetEpoch(const CEP_RTC::Date& date, const CEP_RTC::Time& time);
 
     static RtcModule* Get() { return s_instance; }
 
@@ -0,0 +1,58 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  SPI
+ * @{
+ * @file        spiClock.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/16
+ *
+ * @brief       Selection of the SPI clock divider for a device's maximum clock frequency.
+ */
+#ifndef SPI_CLOCK_HPP_
+#define SPI_CLOCK_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_SPI) || defined(NILAI_TEST)
+#include <cstdint>
+
+namespace CEP_SPI
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+//! Largest value of the BR field of CR1, dividing the clock by 256.
+static constexpr uint32_t MAX_BAUD_RATE_DIVIDER = 7;
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+/**
+ * @brief   Finds the fastest SPI clock that doesn't exceed a device's maximum frequency.
+ * @param   sourceClock Frequency of the clock feeding the SPI peripheral, in Hz.
+ * @param   maxClock    Maximum frequency supported by the device, in Hz.
+ * @return  The value of the BR field of CR1, the SPI clock being sourceClock / 2^(BR + 1).
+ *          @ref MAX_BAUD_RATE_DIVIDER if even that is too fast.
+ */
+constexpr uint32_t GetBaudRateDivider(uint32_t sourceClock, uint32_t maxClock)
+{
+    uint32_t br = 0;
+    while ((br < MAX_BAUD_RATE_DIVIDER) && ((sourceClock >> (br + 1)) > maxClock))
+    {
+        br++;
+    }
+    return br;
+}
+
+//! Frequency of the SPI clock for a value of the BR field of CR1, in Hz.
+constexpr uint32_t GetSpiClock(uint32_t sourceClock, uint32_t br)
+{
+    return sourceClock >> (br + 1);
+}
+}    // namespace CEP_SPI
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
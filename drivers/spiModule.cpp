@@ -16,7 +16,7 @@
  * ------------------------------------------------------------------------------------
  */
 #include "drivers/spiModule.hpp"
-#if defined(NILAI_USE_SPI) && defined(HAL_CAN_MODULE_ENABLED)
+#if defined(NILAI_USE_SPI) && defined(HAL_SPI_MODULE_ENABLED)
 #include "processes/application.hpp"
 #include "defines/macros.hpp"
 
@@ -29,6 +29,13 @@
 /* Defines
  * -------------------------------------------------------------------------------------
  */
+//! Maximum number of SPI modules receiving the HAL's SPI callbacks.
+static constexpr size_t MAX_MODULES = 6;
+
+/*************************************************************************************************/
+/* Private variables
+ * ------------------------------------------------------------------------------ */
+static std::array<SpiModule*, MAX_MODULES> s_modules = {};
 
 /*************************************************************************************************/
 /* Public function definitions
@@ -37,11 +44,24 @@ SpiModule::SpiModule(SPI_HandleTypeDef* handle, const std::string& label)
 : m_label(label), m_handle(handle)
 {
     CEP_ASSERT(handle != nullptr, "SPI Handle is NULL!");
+
+    // Register the module to receive the completion callbacks of its asynchronous transactions.
+    auto it = std::find(s_modules.begin(), s_modules.end(), nullptr);
+    CEP_ASSERT(it != s_modules.end(), "Too many SPI modules!");
+    *it = this;
+
+    // The transfers without a device keep the settings the peripheral was initialized with.
+    m_defaultDevice.polarity = (CEP_SPI::Polarity)handle->Init.CLKPolarity;
+    m_defaultDevice.phase    = (CEP_SPI::Phase)handle->Init.CLKPhase;
+    m_defaultBaudRate        = handle->Init.BaudRatePrescaler & SPI_CR1_BR;
+
     LOG_INFO("[%s]: Initialized", m_label.c_str());
 }
 
 SpiModule::~SpiModule()
 {
+    std::replace(s_modules.begin(), s_modules.end(), this, static_cast<SpiModule*>(nullptr));
+
     /* Abort ongoing messages on SPI peripheral */
     if (HAL_SPI_Abort_IT(m_handle) != HAL_OK)
     {
@@ -71,7 +91,7 @@ void SpiModule::Run()
 {
 }
 
-CEP_SPI::Status SpiModule::Transmit(const std::vector<uint8_t> pkt)
+CEP_SPI::Status SpiModule::Transmit(const std::vector<uint8_t>& pkt)
 {
     return Transmit(pkt.data(), pkt.size());
 }
@@ -82,7 +102,7 @@ CEP_SPI::Status SpiModule::Transmit(const uint8_t* data, size_t len)
     CEP_ASSERT(len != 0, "SPI Transmit data length is 0 in SpiModule::Transmit");
 
     // Wait for peripheral to be free.
-    if (WaitUntilNotBusy() == false)
+    if (WaitForBus() == false)
     {
         return CEP_SPI::Status::TIMEOUT;
     }
@@ -104,7 +124,7 @@ CEP_SPI::Status SpiModule::Receive(uint8_t* ouptutData, size_t len)
     CEP_ASSERT(len > 0, "Length is 0 in SpiModule::Receive");
 
     // Wait for SPI peripheral to be ready.
-    if (WaitUntilNotBusy() == false)
+    if (WaitForBus() == false)
     {
         return CEP_SPI::Status::TIMEOUT;
     }
@@ -125,10 +145,14 @@ SpiModule::Transaction(const uint8_t* txData, size_t txLen, uint8_t* rxData, siz
     CEP_ASSERT(txData != nullptr, "TxData is NULL in SpiModule::Transaction");
     CEP_ASSERT(rxData != nullptr, "RxData is NULL in SpiModule::Transaction");
     CEP_ASSERT(txLen > 0, "TxLen is 0 in SpiModule::Transaction");
-    CEP_ASSERT(txLen == rxLen, "TxLen is not equal to RxLen in SpiModule::Transaction");
+
+    if (txLen != rxLen)
+    {
+        return Exchange({txData, txLen}, {rxData, rxLen});
+    }
 
     // Wait for SPI peripheral to be ready.
-    if (WaitUntilNotBusy() == false)
+    if (WaitForBus() == false)
     {
         return CEP_SPI::Status::TIMEOUT;
     }
@@ -156,6 +180,211 @@ SpiModule::Transaction(const std::vector<uint8_t>& txData, std::vector<uint8_t>&
     return Transaction(txData.data(), txData.size(), rxData.data(), rxData.size());
 }
 
+CEP_SPI::Status
+SpiModule::WriteRead(cep::Span<const uint8_t> tx, cep::Span<uint8_t> rx, uint8_t dummy)
+{
+    if (WaitForBus() == false)
+    {
+        return CEP_SPI::Status::TIMEOUT;
+    }
+
+    HalPort port = {m_handle};
+    if (!CEP_SPI::WriteThenRead(port, tx, rx, dummy))
+    {
+        CEP_SPI::Status status = (CEP_SPI::Status)m_handle->ErrorCode;
+        m_status |= status;
+        ErrorHandler();
+        return status;
+    }
+
+    return CEP_SPI::Status::NONE;
+}
+
+CEP_SPI::Status
+SpiModule::Exchange(cep::Span<const uint8_t> tx, cep::Span<uint8_t> rx, uint8_t dummy)
+{
+    if (WaitForBus() == false)
+    {
+        return CEP_SPI::Status::TIMEOUT;
+    }
+
+    HalPort port = {m_handle};
+    if (!CEP_SPI::Exchange(port, tx, rx, dummy))
+    {
+        CEP_SPI::Status status = (CEP_SPI::Status)m_handle->ErrorCode;
+        m_status |= status;
+        ErrorHandler();
+        return status;
+    }
+
+    return CEP_SPI::Status::NONE;
+}
+
+CEP_SPI::DeviceId SpiModule::AddDevice(const CEP_SPI::Device& device)
+{
+    if (m_deviceCount == MAX_DEVICES)
+    {
+        LOG_ERROR("[%s]: Too many devices on the bus!", m_label.c_str());
+        return CEP_SPI::NO_DEVICE;
+    }
+
+    CEP_SPI::DeviceId id = m_deviceCount++;
+    m_devices[id]        = device;
+    m_baudRates[id] =
+      device.maxClock == 0
+        ? m_defaultBaudRate
+        : (CEP_SPI::GetBaudRateDivider(GetSourceClock(), device.maxClock) << SPI_CR1_BR_Pos);
+
+    // Make sure the device isn't selected until we talk to it.
+    if (device.cs.port != nullptr)
+    {
+        device.cs.Set(true);
+    }
+
+    return id;
+}
+
+bool SpiModule::Acquire(CEP_SPI::DeviceId device)
+{
+    uint32_t timeoutTime = HAL_GetTick() + SpiModule::TIMEOUT;
+    while (HAL_GetTick() <= timeoutTime)
+    {
+        if (TryAcquire(device))
+        {
+            return true;
+        }
+    }
+
+    LOG_ERROR("[%s]: Timed out while waiting for the bus", m_label.c_str());
+    return false;
+}
+
+bool SpiModule::TryAcquire(CEP_SPI::DeviceId device)
+{
+    CEP_ASSERT(device < m_deviceCount, "Invalid device in SpiModule::TryAcquire");
+    if (m_holder == device)
+    {
+        return true;
+    }
+
+    // The bus must be taken atomically, the completion interrupt starts queued transactions.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool isFree = (m_holder == CEP_SPI::NO_DEVICE) && m_queue.Empty() &&
+                  (m_handle->State == HAL_SPI_STATE_READY);
+    if (isFree)
+    {
+        m_holder = device;
+    }
+    __set_PRIMASK(primask);
+
+    if (!isFree)
+    {
+        return false;
+    }
+
+    SelectDevice(device);
+    if (m_devices[device].cs.port != nullptr)
+    {
+        m_devices[device].cs.Set(false);
+    }
+    return true;
+}
+
+void SpiModule::Release()
+{
+    CEP_SPI::DeviceId holder = m_holder;
+    if (holder == CEP_SPI::NO_DEVICE)
+    {
+        return;
+    }
+
+    if (m_devices[holder].cs.port != nullptr)
+    {
+        m_devices[holder].cs.Set(true);
+    }
+
+    // Start the transactions that were queued while the bus was held.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    m_holder = CEP_SPI::NO_DEVICE;
+    if (!m_queue.Empty())
+    {
+        StartNextTransaction();
+    }
+    __set_PRIMASK(primask);
+}
+
+CEP_SPI::Status SpiModule::Transmit(CEP_SPI::DeviceId device, const uint8_t* data, size_t len)
+{
+    return WithDevice(device, [&]() { return Transmit(data, len); });
+}
+
+CEP_SPI::Status SpiModule::Receive(CEP_SPI::DeviceId device, uint8_t* data, size_t len)
+{
+    return WithDevice(device, [&]() { return Receive(data, len); });
+}
+
+CEP_SPI::Status SpiModule::Transaction(CEP_SPI::DeviceId device,
+                                       const uint8_t*    txData,
+                                       uint8_t*          rxData,
+                                       size_t            len)
+{
+    return WithDevice(device, [&]() { return Transaction(txData, len, rxData, len); });
+}
+
+CEP_SPI::Status SpiModule::WriteRead(CEP_SPI::DeviceId        device,
+                                     cep::Span<const uint8_t> tx,
+                                     cep::Span<uint8_t>       rx,
+                                     uint8_t                  dummy)
+{
+    // The chip select stays asserted between the write and the read.
+    return WithDevice(device, [&]() { return WriteRead(tx, rx, dummy); });
+}
+
+CEP_SPI::Status SpiModule::Exchange(CEP_SPI::DeviceId        device,
+                                    cep::Span<const uint8_t> tx,
+                                    cep::Span<uint8_t>       rx,
+                                    uint8_t                  dummy)
+{
+    return WithDevice(device, [&]() { return Exchange(tx, rx, dummy); });
+}
+
+bool SpiModule::QueueTransaction(const CEP_SPI::AsyncTransaction& transaction)
+{
+    CEP_ASSERT((transaction.txData != nullptr) || (transaction.rxData != nullptr),
+               "No buffers in SpiModule::QueueTransaction");
+    CEP_ASSERT(transaction.len != 0, "Length is 0 in SpiModule::QueueTransaction");
+    CEP_ASSERT((transaction.device == CEP_SPI::NO_DEVICE) || (transaction.device < m_deviceCount),
+               "Invalid device in SpiModule::QueueTransaction");
+
+    // The queue is shared between the application and the completion interrupt.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    bool queued = m_queue.Push(transaction);
+    // If it is the only transaction in the queue and the bus isn't held, nothing is on the bus:
+    // start it now.
+    if (queued && (m_queue.Size() == 1) && (m_holder == CEP_SPI::NO_DEVICE))
+    {
+        StartNextTransaction();
+    }
+
+    __set_PRIMASK(primask);
+    return queued;
+}
+
+void SpiModule::HandleTransferComplete()
+{
+    EndTransaction(CEP_SPI::Status::NONE);
+}
+
+void SpiModule::HandleTransferError()
+{
+    CEP_SPI::Status status = (CEP_SPI::Status)m_handle->ErrorCode;
+    EndTransaction(status == CEP_SPI::Status::NONE ? CEP_SPI::Status::FLAG : status);
+}
+
 /*************************************************************************************************/
 /* Private functions definitions
  * --------------------------------------------------------------- */
@@ -206,8 +435,13 @@ bool SpiModule::WaitUntilNotBusy()
     // While the SPI port is busy and the timeout wasn't hit:
     while (HAL_GetTick() <= timeoutTime)
     {
-        // Check if the SPI port is ready.
-        if (m_handle->State == HAL_SPI_STATE_READY)
+        // Check if the SPI port is ready and that no asynchronous transaction is pending.
+        // Transactions queued while a device holds the bus only start once it is released, only
+        // the holder's own transfers can run in the meantime.
+        CEP_SPI::DeviceId holder = m_holder;
+        bool              isFree = (holder == CEP_SPI::NO_DEVICE) ? m_queue.Empty()
+                                                                  : (holder == m_transferDevice);
+        if ((m_handle->State == HAL_SPI_STATE_READY) && isFree)
         {
             return true;
         }
@@ -215,6 +449,209 @@ bool SpiModule::WaitUntilNotBusy()
 
     return false;
 }
+
+/**
+ * Waits for the bus, then applies the settings of the device the blocking transfer is for.
+ * The legacy calls have no device, they get the settings the peripheral was initialized with.
+ */
+bool SpiModule::WaitForBus()
+{
+    if (!WaitUntilNotBusy())
+    {
+        return false;
+    }
+
+    SelectDevice(m_transferDevice);
+    return true;
+}
+
+/**
+ * Starts the transaction at the front of the queue.
+ * Must be called with the interrupts disabled or from the SPI interrupt.
+ */
+void SpiModule::StartNextTransaction()
+{
+    const CEP_SPI::AsyncTransaction& next = m_queue.Front();
+
+    SelectDevice(next.device);
+    const cep::Pin& cs = next.device != CEP_SPI::NO_DEVICE ? m_devices[next.device].cs : next.cs;
+    if (cs.port != nullptr)
+    {
+        cs.Set(false);
+    }
+
+    auto*             tx  = const_cast<uint8_t*>(next.txData);
+    uint8_t*          rx  = next.rxData;
+    auto              len = (uint16_t)next.len;
+    HAL_StatusTypeDef s   = HAL_ERROR;
+    if ((tx != nullptr) && (rx != nullptr))
+    {
+        s = ((m_handle->hdmatx != nullptr) && (m_handle->hdmarx != nullptr))
+              ? HAL_SPI_TransmitReceive_DMA(m_handle, tx, rx, len)
+              : HAL_SPI_TransmitReceive_IT(m_handle, tx, rx, len);
+    }
+    else if (tx != nullptr)
+    {
+        s = (m_handle->hdmatx != nullptr) ? HAL_SPI_Transmit_DMA(m_handle, tx, len)
+                                          : HAL_SPI_Transmit_IT(m_handle, tx, len);
+    }
+    else
+    {
+        // In full-duplex, the HAL receives by sending the buffer itself, which holds the
+        // previous data. Sending dummy bytes instead keeps it from being taken as commands.
+        std::fill(rx, rx + len, CEP_SPI::DUMMY_BYTE);
+        // It also needs both DMA streams to do so.
+        s = ((m_handle->hdmatx != nullptr) && (m_handle->hdmarx != nullptr))
+              ? HAL_SPI_Receive_DMA(m_handle, rx, len)
+              : HAL_SPI_Receive_IT(m_handle, rx, len);
+    }
+
+    if (s != HAL_OK)
+    {
+        // Most likely a blocking transfer is using the bus, report it and move on.
+        EndTransaction(s == HAL_BUSY ? CEP_SPI::Status::FLAG
+                                     : (CEP_SPI::Status)m_handle->ErrorCode);
+    }
+}
+
+/**
+ * Ends the transaction at the front of the queue, starts the next one and calls the callback.
+ * The next transaction is started first to keep the bus busy while the callback runs.
+ */
+void SpiModule::EndTransaction(CEP_SPI::Status status)
+{
+    if (m_queue.Empty())
+    {
+        return;
+    }
+
+    CEP_SPI::AsyncTransaction done;
+    m_queue.Pop(done);
+
+    const cep::Pin& cs = done.device != CEP_SPI::NO_DEVICE ? m_devices[done.device].cs : done.cs;
+    if (cs.port != nullptr)
+    {
+        cs.Set(true);
+    }
+
+    if (!m_queue.Empty())
+    {
+        StartNextTransaction();
+    }
+
+    if (done.callback)
+    {
+        done.callback(status);
+    }
+}
+
+/**
+ * Applies the settings of a device to the peripheral, if they aren't already.
+ * @ref CEP_SPI::NO_DEVICE stands for the settings the peripheral was initialized with.
+ */
+void SpiModule::SelectDevice(CEP_SPI::DeviceId device)
+{
+    if (device == m_activeDevice)
+    {
+        return;
+    }
+
+    bool                   isDefault = (device == CEP_SPI::NO_DEVICE);
+    const CEP_SPI::Device& d         = isDefault ? m_defaultDevice : m_devices[device];
+    uint32_t               baudRate  = isDefault ? m_defaultBaudRate : m_baudRates[device];
+    m_handle->Init.CLKPolarity       = (uint32_t)d.polarity;
+    m_handle->Init.CLKPhase          = (uint32_t)d.phase;
+    m_handle->Init.BaudRatePrescaler = baudRate;
+
+    // The clock can only be reconfigured while the peripheral is disabled, the HAL enables it back
+    // at the start of the next transfer.
+    __HAL_SPI_DISABLE(m_handle);
+    MODIFY_REG(m_handle->Instance->CR1,
+               SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_BR,
+               (uint32_t)d.polarity | (uint32_t)d.phase | baudRate);
+
+    m_activeDevice = device;
+}
+
+/**
+ * Frequency of the clock feeding the peripheral.
+ */
+uint32_t SpiModule::GetSourceClock() const
+{
+    // SPI1, SPI4, SPI5 and SPI6 are on APB2, the others on APB1.
+#if defined(SPI1)
+    if (m_handle->Instance == SPI1)
+    {
+        return HAL_RCC_GetPCLK2Freq();
+    }
+#endif
+#if defined(SPI4)
+    if (m_handle->Instance == SPI4)
+    {
+        return HAL_RCC_GetPCLK2Freq();
+    }
+#endif
+#if defined(SPI5)
+    if (m_handle->Instance == SPI5)
+    {
+        return HAL_RCC_GetPCLK2Freq();
+    }
+#endif
+#if defined(SPI6)
+    if (m_handle->Instance == SPI6)
+    {
+        return HAL_RCC_GetPCLK2Freq();
+    }
+#endif
+    return HAL_RCC_GetPCLK1Freq();
+}
+
+/*************************************************************************************************/
+/* HAL callbacks
+ * ------------------------------------------------------------------------------------ */
+static SpiModule* FindModule(SPI_HandleTypeDef* hspi)
+{
+    for (SpiModule* module : s_modules)
+    {
+        if ((module != nullptr) && (module->GetHandle() == hspi))
+        {
+            return module;
+        }
+    }
+    return nullptr;
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    if (SpiModule* module = FindModule(hspi); module != nullptr)
+    {
+        module->HandleTransferComplete();
+    }
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    if (SpiModule* module = FindModule(hspi); module != nullptr)
+    {
+        module->HandleTransferComplete();
+    }
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+    if (SpiModule* module = FindModule(hspi); module != nullptr)
+    {
+        module->HandleTransferComplete();
+    }
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi)
+{
+    if (SpiModule* module = FindModule(hspi); module != nullptr)
+    {
+        module->HandleTransferError();
+    }
+}
 #endif
 /**
  * @}
@@ -20,11 +20,19 @@
 #if defined(NILAI_USE_SPI)
 #include "defines/internalConfig.h"
 #include NILAI_HAL_HEADER
-#if defined(HAL_CAN_MODULE_ENABLED)
+#if defined(HAL_SPI_MODULE_ENABLED)
+#include "defines/inplaceFunction.hpp"
 #include "defines/macros.hpp"
 #include "defines/misc.hpp"
 #include "defines/module.hpp"
+#include "defines/pin.h"
+#include "defines/ringBuffer.hpp"
+#include "defines/span.hpp"
+#include "drivers/spiClock.hpp"
+#include "drivers/spiTransfer.hpp"
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -118,6 +126,54 @@ enum class SectionState
     NOT_COMPLETE,
     COMPLETE,
 };
+
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+//! Handle of a device registered with @ref SpiModule::AddDevice.
+using DeviceId = size_t;
+static constexpr DeviceId NO_DEVICE = SIZE_MAX;
+
+/**
+ * @brief   A device sharing the bus, with the settings it needs.
+ */
+struct Device
+{
+    //! Chip select of the device, active low.
+    cep::Pin cs       = {};
+    Polarity polarity = Polarity::LOW;
+    Phase    phase    = Phase::EDGE1;
+    //! Fastest clock supported by the device, in Hz. 0 keeps the speed the peripheral was
+    //! initialized with.
+    uint32_t maxClock = 0;
+};
+
+/**
+ * @brief   Called from the SPI interrupt when an asynchronous transaction ends.
+ * @param   status  Status::NONE if the transaction succeeded, the error otherwise.
+ */
+using TransactionCallback = cep::InplaceFunction<void(Status)>;
+
+/**
+ * @brief   A transfer queued with @ref SpiModule::QueueTransaction.
+ *
+ * The buffers are not copied, they must stay valid until the callback has been called.
+ */
+struct AsyncTransaction
+{
+    //! Device to talk to. Its settings are applied and its chip select is used instead of `cs`.
+    DeviceId device = NO_DEVICE;
+    //! Chip select of the device, active low. Left alone if its port is nullptr.
+    cep::Pin cs = {};
+    //! Data to send, nullptr to only receive.
+    const uint8_t* txData = nullptr;
+    //! Where to put the received data, nullptr to only send. When only receiving, it is filled
+    //! with @ref DUMMY_BYTE when the transaction starts, which is what is sent.
+    uint8_t* rxData = nullptr;
+    //! Number of bytes exchanged.
+    size_t len = 0;
+
+    TransactionCallback callback = {};
+};
 /*************************************************************************************************/
 }    // namespace CEP_SPI
 
@@ -135,7 +191,7 @@ public:
     virtual void               Run() override;
     virtual const std::string& GetLabel() const override { return m_label; }
 
-    CEP_SPI::Status Transmit(const std::vector<uint8_t> pkt);
+    CEP_SPI::Status Transmit(const std::vector<uint8_t>& pkt);
     CEP_SPI::Status Transmit(const uint8_t* data, size_t len);
 
     inline CEP_SPI::Status TransmitByte(uint8_t data) { return Transmit(&data, 1); }
@@ -144,7 +200,8 @@ public:
         // Send the data in little-endian mode, for backward compatibility.
         // This method is slower than straight up reinterpret_cast, but it is
         // consistent across all implementation.
-        return Transmit({(uint8_t)(data & 0x00FF), (uint8_t)(data >> 8)});
+        uint8_t bytes[2] = {(uint8_t)(data & 0x00FF), (uint8_t)(data >> 8)};
+        return Transmit(&bytes[0], 2);
     }
 
     CEP_SPI::Status Receive(uint8_t* ouptutData, size_t len);
@@ -158,8 +215,9 @@ public:
         return Receive(reinterpret_cast<uint8_t*>(outputData), 2);
     }
 
+    //! Full-duplex transfer. If the lengths differ, see @ref Exchange.
     CEP_SPI::Status Transaction(const uint8_t* txData, size_t txLen, uint8_t* rxData, size_t rxLen);
-    // #TODO Explain difference between const std::vector& and std::vector&
+    //! Full-duplex transfer. `rxData` is resized to the size of `txData`, which may allocate.
     CEP_SPI::Status Transaction(const std::vector<uint8_t>& txData, std::vector<uint8_t>& rxData);
 
     inline CEP_SPI::Status TransactionByte(uint8_t txData, uint8_t* rxData)
@@ -174,16 +232,189 @@ public:
                            2);
     }
 
+    /*********************************************************************************************/
+    /* Allocation-free transfers */
+    /**
+     * @brief   Sends `tx`, then receives `rx.size()` bytes while sending `dummy`.
+     *
+     * The dummy bytes are written in `rx` before the read, the caller doesn't need to pad
+     * anything. Either span can be empty.
+     */
+    CEP_SPI::Status WriteRead(cep::Span<const uint8_t> tx,
+                              cep::Span<uint8_t>       rx,
+                              uint8_t                  dummy = CEP_SPI::DUMMY_BYTE);
+    CEP_SPI::Status Write(cep::Span<const uint8_t> tx) { return WriteRead(tx, {}); }
+    CEP_SPI::Status Read(cep::Span<uint8_t> rx, uint8_t dummy = CEP_SPI::DUMMY_BYTE)
+    {
+        return WriteRead({}, rx, dummy);
+    }
+
+    /**
+     * @brief   Full-duplex transfer, the lengths can differ.
+     *
+     * The bytes received past the end of `rx` are discarded, `dummy` is sent past the end of
+     * `tx`.
+     */
+    CEP_SPI::Status Exchange(cep::Span<const uint8_t> tx,
+                             cep::Span<uint8_t>       rx,
+                             uint8_t                  dummy = CEP_SPI::DUMMY_BYTE);
+
+    /*********************************************************************************************/
+    /* Bus sharing */
+    /**
+     * @brief   Registers a device on the bus.
+     *
+     * The peripheral is reconfigured with the device's polarity, phase and clock speed only when
+     * the device being talked to changes.
+     *
+     * @return  The handle of the device, or @ref CEP_SPI::NO_DEVICE if there is no room left.
+     */
+    CEP_SPI::DeviceId AddDevice(const CEP_SPI::Device& device);
+
+    /**
+     * @brief   Takes the bus for a device: applies its settings and asserts its chip select.
+     *
+     * The bus stays held, chip select included, until @ref Release is called. This makes
+     * sequences of transfers atomic with respect to the other devices and the queued
+     * transactions, which are only started once the bus is released.
+     *
+     * The sequence must use the overloads taking the device. The ones without a device wait for
+     * the bus to be released, and time out if it isn't.
+     *
+     * @return  False if the bus didn't become free before the timeout.
+     */
+    bool Acquire(CEP_SPI::DeviceId device);
+    //! Same as @ref Acquire, but gives up right away if the bus isn't free.
+    bool TryAcquire(CEP_SPI::DeviceId device);
+    //! Deasserts the chip select of the device holding the bus and starts the queued transactions.
+    void Release();
+    [[nodiscard]] CEP_SPI::DeviceId GetHolder() const { return m_holder; }
+
+    /**
+     * @brief   Transfers to a device, taking the bus for the duration of the transfer.
+     *
+     * If the device is already holding the bus, the transfer is part of its sequence and the bus
+     * stays held.
+     */
+    CEP_SPI::Status Transmit(CEP_SPI::DeviceId device, const uint8_t* data, size_t len);
+    CEP_SPI::Status Receive(CEP_SPI::DeviceId device, uint8_t* data, size_t len);
+    CEP_SPI::Status
+    Transaction(CEP_SPI::DeviceId device, const uint8_t* txData, uint8_t* rxData, size_t len);
+    CEP_SPI::Status WriteRead(CEP_SPI::DeviceId        device,
+                              cep::Span<const uint8_t> tx,
+                              cep::Span<uint8_t>       rx,
+                              uint8_t                  dummy = CEP_SPI::DUMMY_BYTE);
+    CEP_SPI::Status Exchange(CEP_SPI::DeviceId        device,
+                             cep::Span<const uint8_t> tx,
+                             cep::Span<uint8_t>       rx,
+                             uint8_t                  dummy = CEP_SPI::DUMMY_BYTE);
+
+    /*********************************************************************************************/
+    /* Asynchronous transactions */
+    /**
+     * @brief   Queues a transfer that runs in the background, using DMA when the handle has DMA
+     *          channels linked to it and interrupts otherwise.
+     *
+     * Transactions are started one after the other from the completion interrupt, the main loop
+     * is never blocked. The blocking methods wait for the queue to be empty before using the bus.
+     *
+     * Can be called from an interrupt, including from a transaction's callback.
+     *
+     * @param   transaction The transaction, see @ref CEP_SPI::AsyncTransaction.
+     * @return  True if the transaction was queued, false if the queue is full.
+     */
+    bool QueueTransaction(const CEP_SPI::AsyncTransaction& transaction);
+
+    [[nodiscard]] size_t GetPendingTransactions() const { return m_queue.Size(); }
+    [[nodiscard]] bool   IsIdle() const { return m_queue.Empty(); }
+
+    //! Called by the HAL's SPI callbacks, not meant to be called by the application.
+    void HandleTransferComplete();
+    //! Called by the HAL's SPI callbacks, not meant to be called by the application.
+    void HandleTransferError();
+
+    [[nodiscard]] SPI_HandleTypeDef* GetHandle() const { return m_handle; }
+
+    static constexpr size_t QUEUE_SIZE  = 8;
+    static constexpr size_t MAX_DEVICES = 8;
+
 private:
+    //! Port of the transfers of spiTransfer.hpp, over the HAL's blocking functions.
+    struct HalPort
+    {
+        SPI_HandleTypeDef* handle;
+
+        bool Write(const uint8_t* data, size_t len)
+        {
+            return HAL_SPI_Transmit(handle, const_cast<uint8_t*>(data), (uint16_t)len, TIMEOUT) ==
+                   HAL_OK;
+        }
+        bool Read(uint8_t* data, size_t len)
+        {
+            // In full-duplex master mode, the HAL sends the content of the buffer while receiving.
+            return HAL_SPI_Receive(handle, data, (uint16_t)len, TIMEOUT) == HAL_OK;
+        }
+        bool Exchange(const uint8_t* tx, uint8_t* rx, size_t len)
+        {
+            return HAL_SPI_TransmitReceive(
+                     handle, const_cast<uint8_t*>(tx), rx, (uint16_t)len, TIMEOUT) == HAL_OK;
+        }
+    };
+
     std::string        m_label;
     SPI_HandleTypeDef* m_handle;
     CEP_SPI::Status    m_status = CEP_SPI::Status::NONE;
 
+    //! The transaction at the front is the one on the bus.
+    cep::RingBuffer<CEP_SPI::AsyncTransaction, QUEUE_SIZE> m_queue;
+
+    std::array<CEP_SPI::Device, MAX_DEVICES> m_devices     = {};
+    size_t                                    m_deviceCount = 0;
+    //! Settings the peripheral was initialized with, for the transfers without a device.
+    CEP_SPI::Device m_defaultDevice   = {};
+    uint32_t        m_defaultBaudRate = 0;
+    //! Device whose settings are applied to the peripheral, NO_DEVICE for the default ones.
+    CEP_SPI::DeviceId m_activeDevice = CEP_SPI::NO_DEVICE;
+    //! Device holding the bus between @ref Acquire and @ref Release.
+    volatile CEP_SPI::DeviceId m_holder = CEP_SPI::NO_DEVICE;
+    //! Device the blocking transfer in progress is for, NO_DEVICE for the legacy calls.
+    CEP_SPI::DeviceId m_transferDevice = CEP_SPI::NO_DEVICE;
+    //! Value of the BR field of CR1 for each device, already shifted in place.
+    std::array<uint32_t, MAX_DEVICES> m_baudRates = {};
+
     constexpr static uint16_t TIMEOUT = 200;
 
 private:
     void ErrorHandler();
     bool WaitUntilNotBusy();
+    bool WaitForBus();
+    void     StartNextTransaction();
+    void     EndTransaction(CEP_SPI::Status status);
+    void     SelectDevice(CEP_SPI::DeviceId device);
+    uint32_t GetSourceClock() const;
+
+    template<typename Func>
+    CEP_SPI::Status WithDevice(CEP_SPI::DeviceId device, Func&& transfer)
+    {
+        // A device already holding the bus is in the middle of a sequence, leave it held.
+        bool isSequence = (m_holder == device);
+        if (!isSequence && !Acquire(device))
+        {
+            return CEP_SPI::Status::TIMEOUT;
+        }
+
+        // The transfer runs through the legacy calls, which must let the holder through.
+        CEP_SPI::DeviceId previous = m_transferDevice;
+        m_transferDevice           = device;
+        CEP_SPI::Status status     = transfer();
+        m_transferDevice           = previous;
+
+        if (!isSequence)
+        {
+            Release();
+        }
+        return status;
+    }
 };
 #else
 #if WARN_MISSING_STM_DRIVERS
@@ -0,0 +1,109 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  SPI
+ * @{
+ * @file        spiTransfer.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/17
+ *
+ * @brief       Allocation-free transfers whose write and read lengths differ.
+ *
+ * The transfers are built on three primitives provided by a port, which must be a type with:
+ *  - `bool Write(const uint8_t* data, size_t len)`: sends `len` bytes, ignoring what's received.
+ *  - `bool Read(uint8_t* data, size_t len)`: sends the content of `data` while receiving into it.
+ *  - `bool Exchange(const uint8_t* tx, uint8_t* rx, size_t len)`: full-duplex transfer.
+ *
+ * Each primitive returns false on error. @ref SpiModule provides a port over the HAL, the tests
+ * use a mocked one.
+ */
+#ifndef SPI_TRANSFER_HPP_
+#define SPI_TRANSFER_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_SPI) || defined(NILAI_TEST)
+#include "defines/span.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace CEP_SPI
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+//! Byte sent while reading, when the device doesn't care about what it receives.
+static constexpr uint8_t DUMMY_BYTE = 0xFF;
+
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+/**
+ * @brief   Sends `tx`, then receives `rx.size()` bytes while sending `dummy`.
+ *
+ * The dummy bytes are written directly in `rx` before being sent, no padding buffer is needed.
+ * Either span can be empty.
+ *
+ * @return  False if a primitive of the port failed.
+ */
+template<typename Port>
+bool WriteThenRead(Port&                    port,
+                   cep::Span<const uint8_t> tx,
+                   cep::Span<uint8_t>       rx,
+                   uint8_t                  dummy = DUMMY_BYTE)
+{
+    if (!tx.empty() && !port.Write(tx.data(), tx.size()))
+    {
+        return false;
+    }
+
+    if (!rx.empty())
+    {
+        std::fill(rx.begin(), rx.end(), dummy);
+        return port.Read(rx.data(), rx.size());
+    }
+
+    return true;
+}
+
+/**
+ * @brief   Full-duplex transfer of `max(tx.size(), rx.size())` bytes.
+ *
+ * If `tx` is the longest, the bytes received past the end of `rx` are discarded. If `rx` is the
+ * longest, `dummy` is sent past the end of `tx`.
+ *
+ * @return  False if a primitive of the port failed.
+ */
+template<typename Port>
+bool Exchange(Port&                    port,
+              cep::Span<const uint8_t> tx,
+              cep::Span<uint8_t>       rx,
+              uint8_t                  dummy = DUMMY_BYTE)
+{
+    size_t common = std::min(tx.size(), rx.size());
+    if ((common != 0) && !port.Exchange(tx.data(), rx.data(), common))
+    {
+        return false;
+    }
+
+    if (tx.size() > common)
+    {
+        return port.Write(tx.data() + common, tx.size() - common);
+    }
+    if (rx.size() > common)
+    {
+        cep::Span<uint8_t> rest = rx.subspan(common);
+        std::fill(rest.begin(), rest.end(), dummy);
+        return port.Read(rest.data(), rest.size());
+    }
+
+    return true;
+}
+}    // namespace CEP_SPI
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,111 @@
+/**
+ * @addtogroup  drivers
+ * @{
+ * @addtogroup  TIM
+ * @{
+ * @file        timerClock.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/29
+ *
+ * @brief       Frequency of the clock feeding the counter of a timer.
+ */
+#ifndef TIMER_CLOCK_HPP_
+#define TIMER_CLOCK_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#include "defines/internalConfig.h"
+#include NILAI_HAL_HEADER
+#if defined(HAL_TIM_MODULE_ENABLED)
+#include <cstdint>
+
+namespace CEP_TIM
+{
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+//! True if the timer is on APB2, false if it is on APB1.
+inline bool IsOnApb2(const TIM_TypeDef* instance)
+{
+    // TIM1, TIM8 to TIM11, TIM15 to TIM17 and TIM20 are on APB2, the others on APB1.
+#if defined(TIM1)
+    if (instance == TIM1)
+    {
+        return true;
+    }
+#endif
+#if defined(TIM8)
+    if (instance == TIM8)
+    {
+        return true;
+    }
+#endif
+#if defined(TIM9)
+    if (instance == TIM9)
+    {
+        return true;
+    }
+#endif
+#if defined(TIM10)
+    if (instance == TIM10)
+    {
+        return true;
+    }
+#endif
+#if defined(TIM11)
+    if (instance == TIM11)
+    {
+        return true;
+    }
+#endif
+#if defined(TIM15)
+    if (instance == TIM15)
+    {
+        return true;
+    }
+#endif
+#if defined(TIM16)
+    if (instance == TIM16)
+    {
+        return true;
+    }
+#endif
+#if defined(TIM17)
+    if (instance == TIM17)
+    {
+        return true;
+    }
+#endif
+#if defined(TIM20)
+    if (instance == TIM20)
+    {
+        return true;
+    }
+#endif
+    return false;
+}
+
+/**
+ * @brief   Frequency of the clock of a timer's counter, before its prescaler.
+ * @param   instance    The timer, which tells on which APB bus it is.
+ * @return  The frequency, in Hz.
+ */
+inline uint32_t GetTimerClock(const TIM_TypeDef* instance)
+{
+    // The timers run at twice the APB clock when the APB clock is divided.
+    if (IsOnApb2(instance))
+    {
+        uint32_t pclk = HAL_RCC_GetPCLK2Freq();
+        return (RCC->CFGR & RCC_CFGR_PPRE2_2) == 0 ? pclk : 2 * pclk;
+    }
+
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    return (RCC->CFGR & RCC_CFGR_PPRE1_2) == 0 ? pclk : 2 * pclk;
+}
+}    // namespace CEP_TIM
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
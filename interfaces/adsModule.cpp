@@ -27,6 +27,8 @@
 AdsModule::AdsModule(SpiModule* spi, const std::string& label)
     : m_spi(spi), m_label(label), m_config(ADS::Config( ))
 {
+    // There is no register between the channel enable and the channel 1 digital gain.
+    m_registers.Reserve(ADS::Registers::ChannelEnable::Address + 1);
     ADS_INFO("Initialized.");
 }
 
@@ -48,6 +50,13 @@ void AdsModule::Run( )
 {
     static bool wasTriggered = false;
 
+    if (m_sampleReady)
+    {
+        m_sampleReady   = false;
+        m_samplePending = false;
+        ProcessSample(m_sampleData.data( ));
+    }
+
     if (m_hasTriggered != wasTriggered)
     {
         wasTriggered = m_hasTriggered;
@@ -75,91 +84,93 @@ void AdsModule::Configure(const ADS::Config& config, bool force)
 
     uint32_t startTime = HAL_GetTick( );
 
+    // If the ADS still holds what we last wrote to it, only the registers that changed need to be
+    // written, there's no need to reset it.
+    bool needsReset = force || !m_isConfigured || m_registers.IsAnyDirty( ) ||
+                      !(config.pins == m_config.pins);
+
     m_config       = config;
     m_active       = false;
     m_isConfigured = false;
 
-    ADS_INFO("Configuring ADS...");
-    Reset( );
-
-    // CMD -> 0x0011    Resp -> 0xFF04
-    if (SendCommand(ADS::SysCommands::Reset, ADS::Acknowledges::Ready) == false)
-    {
-        ADS_ERROR("Unable to reset.");
-        return;
-    }
-
-    // CMD -> 0x0655    Resp -> 0x0655
-    if (SendCommand(ADS::SysCommands::Unlock, ADS::Acknowledges::Unlock) == false)
-    {
-        ADS_ERROR("Unable to unlock.");
-        return;
-    }
-
-    ADS::Registers::ClockConfig1 clk1(m_config);
-    if (SendConfig(ADS::Registers::ClockConfig1::Address, clk1.value) == false)
-    {
-        ADS_ERROR("Unable to setup Clock Config 1 Register.");
-        return;
-    }
-
-    ADS::Registers::ClockConfig2 clk2(m_config);
-    if (SendConfig(ADS::Registers::ClockConfig2::Address, clk2.value) == false)
-    {
-        ADS_ERROR("Unable to setup Clock Config 2 Register.");
-        return;
-    }
-
-    ADS::Registers::DigitalSysConfig dsc(m_config);
-    if (SendConfig(ADS::Registers::DigitalSysConfig::Address, dsc.value) == false)
+    if (m_device == CEP_SPI::NO_DEVICE)
     {
-        ADS_ERROR("Unable to setup Digital System Configuration Register.");
-        return;
-    }
-
-    ADS::Registers::AnalogSysConfig asc(m_config);
-    if (SendConfig(ADS::Registers::AnalogSysConfig::Address, asc.value) == false)
-    {
-        ADS_ERROR("Unable to setup Analog System Configuration Register");
-        return;
+        CEP_SPI::Device device;
+        device.cs       = m_config.pins.chipSelect;
+        device.polarity = CEP_SPI::Polarity::LOW;
+        device.phase    = CEP_SPI::Phase::EDGE2;
+        device.maxClock = MaxClock;
+        m_device        = m_spi->AddDevice(device);
+        if (m_device == CEP_SPI::NO_DEVICE)
+        {
+            ADS_ERROR("Unable to add the ADS to the SPI bus.");
+            return;
+        }
     }
 
-    ADS::Registers::Ch1DigitalGain ch1(m_config);
-    if (SendConfig(ADS::Registers::Ch1DigitalGain::Address, ch1.value) == false)
+    m_registers.Set(ADS::Registers::ClockConfig1::Address,
+                    ADS::Registers::ClockConfig1(m_config).value);
+    m_registers.Set(ADS::Registers::ClockConfig2::Address,
+                    ADS::Registers::ClockConfig2(m_config).value);
+    m_registers.Set(ADS::Registers::DigitalSysConfig::Address,
+                    ADS::Registers::DigitalSysConfig(m_config).value);
+    m_registers.Set(ADS::Registers::AnalogSysConfig::Address,
+                    ADS::Registers::AnalogSysConfig(m_config).value);
+    m_registers.Set(ADS::Registers::Ch1DigitalGain::Address,
+                    ADS::Registers::Ch1DigitalGain(m_config).value);
+    m_registers.Set(ADS::Registers::Ch2DigitalGain::Address,
+                    ADS::Registers::Ch2DigitalGain(m_config).value);
+    m_registers.Set(ADS::Registers::Ch3DigitalGain::Address,
+                    ADS::Registers::Ch3DigitalGain(m_config).value);
+    m_registers.Set(ADS::Registers::Ch4DigitalGain::Address,
+                    ADS::Registers::Ch4DigitalGain(m_config).value);
+    m_registers.Set(ADS::Registers::ChannelEnable::Address,
+                    ADS::Registers::ChannelEnable(m_config).value);
+
+    if (needsReset)
     {
-        ADS_ERROR("Unable to setup Channel 1 Digital Gain.");
-        return;
-    }
+        ADS_INFO("Configuring ADS...");
+        Reset( );
 
-    ADS::Registers::Ch2DigitalGain ch2(m_config);
-    if (SendConfig(ADS::Registers::Ch2DigitalGain::Address, ch2.value) == false)
-    {
-        ADS_ERROR("Unable to setup Channel 2 Digital Gain.");
-        return;
+        // CMD -> 0x0011    Resp -> 0xFF04
+        if (SendCommand(ADS::SysCommands::Reset, ADS::Acknowledges::Ready) == false)
+        {
+            ADS_ERROR("Unable to reset.");
+            return;
+        }
+        m_registers.MarkAllDirty( );
     }
-
-    ADS::Registers::Ch3DigitalGain ch3(m_config);
-    if (SendConfig(ADS::Registers::Ch3DigitalGain::Address, ch3.value) == false)
+    else
     {
-        ADS_ERROR("Unable to setup Channel 3 Digital Gain.");
-        return;
+        ADS_INFO("Updating ADS configuration...");
     }
 
-    ADS::Registers::Ch4DigitalGain ch4(m_config);
-    if (SendConfig(ADS::Registers::Ch4DigitalGain::Address, ch4.value) == false)
+    // CMD -> 0x0655    Resp -> 0x0655
+    if (SendCommand(ADS::SysCommands::Unlock, ADS::Acknowledges::Unlock) == false)
     {
-        ADS_ERROR("Unable to setup Channel 4 Digital Gain.");
+        ADS_ERROR("Unable to unlock.");
         return;
     }
 
-    ADS::Registers::ChannelEnable en(m_config);
-    if (SendConfig(ADS::Registers::ChannelEnable::Address, en.value) == false)
+    // The ADS131 has no burst write, the registers are written one by one in address order.
+    // The analog, digital and clock registers therefore come before the channel enable one.
+    bool written = m_registers.Flush(
+      [this](uint16_t addr, const uint8_t* data, size_t)
+      {
+          if (SendConfig((uint8_t)addr, *data) == false)
+          {
+              ADS_ERROR("Unable to setup register 0x%02X.", addr);
+              return false;
+          }
+          return true;
+      },
+      1);
+    if (written == false)
     {
-        ADS_ERROR("Unable to setup Channel Enable register.");
         return;
     }
 
-    if (SendCommand(ADS::SysCommands::Wakeup, ADS::Acknowledges::Wakeup) == false)
+    if (needsReset && (SendCommand(ADS::SysCommands::Wakeup, ADS::Acknowledges::Wakeup) == false))
     {
         ADS_ERROR("Unable to wake ADS.");
         return;
@@ -198,6 +209,8 @@ void AdsModule::Disable( )
         HAL_GPIO_WritePin(cs.port, cs.pin, GPIO_PIN_SET);
         HAL_GPIO_WritePin(rst.port, rst.pin, GPIO_PIN_RESET);
         m_active = false;
+        // The registers are lost while the ADS is held in reset.
+        m_registers.MarkAllDirty( );
     }
 }
 
@@ -228,83 +241,47 @@ const AdsPacket& AdsModule::RefreshValues(uint32_t timeout)
 
     uint8_t data[16];
 
-    // Activate CS to start transaction.
-    HAL_GPIO_WritePin(m_config.pins.chipSelect.port, m_config.pins.chipSelect.pin, GPIO_PIN_RESET);
-    m_spi->Receive(&data[0], sizeof_array(data));
-    // Release CS to complete transaction.
-    HAL_GPIO_WritePin(m_config.pins.chipSelect.port, m_config.pins.chipSelect.pin, GPIO_PIN_SET);
+    if (m_spi->Receive(m_device, &data[0], sizeof_array(data)) != CEP_SPI::Status::NONE)
+    {
+        return m_latestFrame;
+    }
 
-    // First 3 bytes are for the status.
-    // TODO: Maybe check status?
-    // Each consecutive trio of bytes represent the data of a channel.
-    float chs[4] = {CalculateTension(&data[3]),
-                    CalculateTension(&data[6]),
-                    CalculateTension(&data[9]),
-                    CalculateTension(&data[12])};
+    ProcessSample(&data[0]);
 
-    // Check for the trigger, if we haven't triggered yet.
-    if (m_hasTriggered == true)
+    return m_latestFrame;
+}
+
+bool AdsModule::RequestValues( )
+{
+    if (!m_active || m_samplePending)
     {
-        m_channels.channel1[m_samplesTaken] = chs[0];
-        m_channels.channel2[m_samplesTaken] = chs[1];
-        m_channels.channel3[m_samplesTaken] = chs[2];
-        m_channels.channel4[m_samplesTaken] = chs[3];
-        ++m_samplesTaken;
+        return false;
     }
-    else
+
+    CEP_SPI::AsyncTransaction transaction;
+    transaction.device   = m_device;
+    transaction.rxData   = m_sampleData.data( );
+    transaction.len      = m_sampleData.size( );
+    // Called from the SPI interrupt, the sample is processed by Run.
+    transaction.callback = [this](CEP_SPI::Status status)
     {
-        static float lastRead = std::numeric_limits<float>::lowest( );
-        if (lastRead == std::numeric_limits<float>::lowest( ))
-        {
-            lastRead = chs[m_trigChannel];
-        }
-        if (m_trigEdge == TrigEdge::Alter)
-        {
-            // If the tension we're measuring now is different from the last reading, triggered.
-            if ((chs[m_trigChannel] > lastRead) || (chs[m_trigChannel] < lastRead))
-            {
-                m_hasTriggered = true;
-            }
-        }
-        else if (m_trigEdge == TrigEdge::Rising)
+        if (status == CEP_SPI::Status::NONE)
         {
-            // If the tension we're measuring now is higher than the last reading, triggered.
-            if (chs[m_trigChannel] > lastRead)
-            {
-                m_hasTriggered = true;
-            }
+            m_sampleReady = true;
         }
-        else if (m_trigEdge == TrigEdge::Falling)
+        else
         {
-            // If the tension we're measuring now is lower than the last reading, triggered.
-            if (chs[m_trigChannel] < lastRead)
-            {
-                m_hasTriggered = true;
-            }
+            m_samplePending = false;
         }
+    };
 
-        m_channels.channel1[0] = chs[0];
-        m_channels.channel2[0] = chs[1];
-        m_channels.channel3[0] = chs[2];
-        m_channels.channel4[0] = chs[3];
-    }
-
-    // If we're at the end of our buffers:
-    if (m_samplesTaken >= m_samplesToTake)
+    m_samplePending = true;
+    if (!m_spi->QueueTransaction(transaction))
     {
-        m_hasTriggered = false;
-        UpdateLatestFrame( );
-        if (m_repeat == false)
-        {
-            Disable( );
-        }
-        if (m_callback)
-        {
-            m_callback(m_latestFrame);
-        }
+        m_samplePending = false;
+        return false;
     }
-
-    return m_latestFrame;
+    return true;
 }
 
 /*****************************************************************************/
@@ -391,21 +368,11 @@ bool AdsModule::SendConfig(uint8_t addr, uint8_t data)
 
 uint16_t AdsModule::Send(uint16_t data)
 {
-    std::vector<uint8_t> pkt = std::vector<uint8_t>(6);
-    pkt[0]                   = ((uint8_t*)&data)[0];
-    pkt[1]                   = ((uint8_t*)&data)[1];
-
-    // Create a vector containing 6 uint8_t set to 0.
-    std::vector<uint8_t> resp = std::vector<uint8_t>(6);
-
-    // Activate CS to start transaction.
-    HAL_GPIO_WritePin(m_config.pins.chipSelect.port, m_config.pins.chipSelect.pin, GPIO_PIN_RESET);
+    uint8_t pkt[6]  = {((uint8_t*)&data)[0], ((uint8_t*)&data)[1], 0, 0, 0, 0};
+    uint8_t resp[6] = {0};
 
     // Send a single 24-bits word (as 3 8-bits words).
-    m_spi->Transaction(pkt, resp);
-
-    // Release CS to end transaction.
-    HAL_GPIO_WritePin(m_config.pins.chipSelect.port, m_config.pins.chipSelect.pin, GPIO_PIN_SET);
+    m_spi->Transaction(m_device, &pkt[0], &resp[0], sizeof_array(pkt));
 
     return (cep::combine(&resp[0], 2));
 }
@@ -414,18 +381,12 @@ uint16_t AdsModule::ReadCommandResponse( )
 {
     uint32_t response = 0;
 
-    // Activate CS to start transaction.
-    HAL_GPIO_WritePin(m_config.pins.chipSelect.port, m_config.pins.chipSelect.pin, GPIO_PIN_RESET);
-
-    m_spi->Receive(reinterpret_cast<uint8_t*>(&response), 3);
-
-    // Release CS to end transaction.
-    HAL_GPIO_WritePin(m_config.pins.chipSelect.port, m_config.pins.chipSelect.pin, GPIO_PIN_SET);
+    m_spi->Receive(m_device, reinterpret_cast<uint8_t*>(&response), 3);
 
     return (cep::swap((uint16_t)response));
 }
 
-float AdsModule::CalculateTension(uint8_t* data)
+float AdsModule::CalculateTension(const uint8_t* data)
 {
     int32_t up  = ((int32_t)data[0] << 24);
     int32_t mid = ((int32_t)data[1] << 16);
@@ -472,6 +433,79 @@ const std::vector<float>& AdsModule::GetChannel(size_t channel) const
     return m_channels[channel];
 }
 
+void AdsModule::ProcessSample(const uint8_t* data)
+{
+    // First 3 bytes are for the status.
+    // TODO: Maybe check status?
+    // Each consecutive trio of bytes represent the data of a channel.
+    float chs[4] = {CalculateTension(&data[3]),
+                    CalculateTension(&data[6]),
+                    CalculateTension(&data[9]),
+                    CalculateTension(&data[12])};
+
+    // Check for the trigger, if we haven't triggered yet.
+    if (m_hasTriggered == true)
+    {
+        m_channels.channel1[m_samplesTaken] = chs[0];
+        m_channels.channel2[m_samplesTaken] = chs[1];
+        m_channels.channel3[m_samplesTaken] = chs[2];
+        m_channels.channel4[m_samplesTaken] = chs[3];
+        ++m_samplesTaken;
+    }
+    else
+    {
+        static float lastRead = std::numeric_limits<float>::lowest( );
+        if (lastRead == std::numeric_limits<float>::lowest( ))
+        {
+            lastRead = chs[m_trigChannel];
+        }
+        if (m_trigEdge == TrigEdge::Alter)
+        {
+            // If the tension we're measuring now is different from the last reading, triggered.
+            if ((chs[m_trigChannel] > lastRead) || (chs[m_trigChannel] < lastRead))
+            {
+                m_hasTriggered = true;
+            }
+        }
+        else if (m_trigEdge == TrigEdge::Rising)
+        {
+            // If the tension we're measuring now is higher than the last reading, triggered.
+            if (chs[m_trigChannel] > lastRead)
+            {
+                m_hasTriggered = true;
+            }
+        }
+        else if (m_trigEdge == TrigEdge::Falling)
+        {
+            // If the tension we're measuring now is lower than the last reading, triggered.
+            if (chs[m_trigChannel] < lastRead)
+            {
+                m_hasTriggered = true;
+            }
+        }
+
+        m_channels.channel1[0] = chs[0];
+        m_channels.channel2[0] = chs[1];
+        m_channels.channel3[0] = chs[2];
+        m_channels.channel4[0] = chs[3];
+    }
+
+    // If we're at the end of our buffers:
+    if (m_samplesTaken >= m_samplesToTake)
+    {
+        m_hasTriggered = false;
+        UpdateLatestFrame( );
+        if (m_repeat == false)
+        {
+            Disable( );
+        }
+        if (m_callback)
+        {
+            m_callback(m_latestFrame);
+        }
+    }
+}
+
 void AdsModule::UpdateLatestFrame( )
 {
     float tot1 = 0, tot2 = 0, tot3 = 0, tot4 = 0;
@@ -19,9 +19,11 @@
 
 #        include "shared/defines/misc.hpp"
 #        include "shared/defines/module.hpp"
+#        include "shared/defines/registerMap.hpp"
 
 #        include "shared/drivers/spiModule.hpp"
 
+#        include <array>
 #        include <string>
 #        include <vector>
 
@@ -119,7 +121,17 @@ public:
 
     // Using timeout = 0 skips the waiting for DRDY
     const AdsPacket& RefreshValues(uint32_t timeout = 0);
-    inline float     CalculateTension(uint8_t* data);
+    /**
+     * @brief   Reads a sample in the background, without blocking.
+     *
+     * The sample is processed by the next call to @ref Run once the transfer is done, exactly like
+     * @ref RefreshValues would have.
+     *
+     * @return  True if the read was started, false if the scope isn't active, a read is already
+     *          pending or the SPI queue is full.
+     */
+    bool RequestValues( );
+    inline float     CalculateTension(const uint8_t* data);
 
     bool IsActive( ) const { return m_active; }
 
@@ -141,11 +153,17 @@ public:
     void ClearBuffers( ) { m_channels.clear( ); }
 
 private:
-    bool        m_active = false;
-    SpiModule*  m_spi;
+    bool              m_active = false;
+    SpiModule*        m_spi;
+    CEP_SPI::DeviceId m_device = CEP_SPI::NO_DEVICE;
     std::string m_label = "";
     ADS::Config m_config;
     bool        m_isConfigured = false;
+    //! What was last written to the ADS, from the analog system configuration to the channel 4
+    //! digital gain.
+    cep::RegisterMap<ADS::Registers::Ch4DigitalGain::Address -
+                     ADS::Registers::AnalogSysConfig::Address + 1>
+      m_registers {ADS::Registers::AnalogSysConfig::Address};
     AdsPacket   m_latestFrame;
     uint32_t    m_lastStartTime = 0;
 
@@ -159,6 +177,11 @@ private:
     uint16_t                              m_samplesTaken    = 0;
     std::function<void(const AdsPacket&)> m_callback;
     bool                                  m_repeat = true;
+
+    std::array<uint8_t, 16> m_sampleData    = {};
+    volatile bool           m_samplePending = false;
+    volatile bool           m_sampleReady   = false;
+
     struct
     {
         std::vector<float> channel1 = std::vector<float>(1024, 0.0f);
@@ -220,6 +243,8 @@ private:
 
 private:
     static const uint8_t MaxInitAttempts = 10;
+    //! The ADS131 latches data on the falling edge of SCLK and accepts up to 25MHz.
+    static constexpr uint32_t MaxClock = 25000000;
 
 private:
     inline void     Reset( );
@@ -229,6 +254,7 @@ private:
     inline uint16_t ReadCommandResponse( );
     inline float    ConvertToVolt(int32_t val);
     inline uint32_t ConvertToHex(float val);
+    void            ProcessSample(const uint8_t* data);
     void            UpdateLatestFrame( );
 };
 
@@ -44,13 +44,14 @@ Ltc2498Module::Ltc2498Module(
 : m_label(label)
 , m_spi(spi)
 , m_misoPin(inPin)
-, m_csPin(csPin)
 , m_vcom(vcom) {
-    // Enable the LTC2498 chip select signal to monitor its status.
-    m_csPin.Set(false);
-
-    // Configure the MISO pin as a GPIO input to monitor the LTC's status.
-    SetMisoAsGpio();
+    CEP_SPI::Device device;
+    device.cs       = csPin;
+    device.polarity = CEP_SPI::Polarity::LOW;
+    device.phase    = CEP_SPI::Phase::EDGE1;
+    device.maxClock = MAX_CLOCK;
+    m_device        = m_spi->AddDevice(device);
+    CEP_ASSERT(m_device != CEP_SPI::NO_DEVICE, "Unable to add the LTC2498 to the SPI bus");
 
     LTC_INFO("Initialized");
 }
@@ -89,14 +90,10 @@ bool Ltc2498Module::DoPost() {
     }
 
     // MISO pin == 0 -> Conversion is complete!
-    SetMisoAsMiso();
-
     std::array<uint8_t, 4> resp = SetNextConvAndReadResults({});
 
     ParseConversionResult(resp, config);
 
-    SetMisoAsGpio();
-
     const LTC2498::Reading& reading = GetLastReading();
     // Calculate the temperature from the reading.
     float temp = ((float)(reading.raw) / 314.0f) - 273.15f;
@@ -111,33 +108,36 @@ bool Ltc2498Module::DoPost() {
 }
 
 void Ltc2498Module::Run() {
-    if (m_isConverting == false) {
-        // No conversions currently on the way, no need to do anything.
+    if (m_transferDone == true) {
+        // The result of the last conversion came in and the next conversion is started.
+        HandleResults();
         return;
     }
 
-    if (m_misoPin.Get() == false) {
-        // MISO pin == 0 -> Conversion is complete!
-        SetMisoAsMiso();
+    if ((m_isConverting == false) || (m_transferPending == true)) {
+        // No conversions currently on the way, or we're already reading it.
+        return;
+    }
 
-        auto                        callback = m_lastReading.config.callback;
-        LTC2498::ConversionSettings lastConf = m_lastReading.config;
+    if (IsConversionInProgress() == false) {
+        // MISO pin == 0 -> Conversion is complete!
+        m_readConfig = m_lastReading.config;
 
-        std::array<uint8_t, 4> nextConversion = {0};
+        m_txData = {0};
         // Check if we have a conversion queued up.
         auto next = GetNextConversion();
         if (next != m_conversions.end()) {
-            nextConversion = next->ToRegValues();
+            m_txData = next->ToRegValues();
 
             // Pre-saves the conversion settings.
             m_lastReading.config = *next;
         }
 
-        std::array<uint8_t, 4> resp = SetNextConvAndReadResults(nextConversion);
-
-        ParseConversionResult(resp, lastConf);
-        if (callback) { callback(m_lastReading.reading, lastConf); }
-        SetMisoAsGpio();
+        if (QueueNextConvAndReadResults() == false) {
+            // The SPI queue is full, do it the blocking way.
+            m_rxData = SetNextConvAndReadResults(m_txData);
+            HandleResults();
+        }
     }
 }
 
@@ -161,49 +161,33 @@ bool Ltc2498Module::QueueConversions(const std::vector<LTC2498::ConversionSettin
 }
 
 /**
+ * While the LTC2498 is selected and the bus is idle, MISO holds the end of conversion flag.
  * If MISO is 1: Conversion in progress.
  * If MISO is 0: No conversion in progress.
+ *
+ * The pin is read while in its alternate function, its level is still visible in the GPIO's input
+ * register.
  * @return
  */
 bool Ltc2498Module::IsConversionInProgress() const {
-    return m_misoPin.Get();
-}
-
-bool Ltc2498Module::StartConversion(const LTC2498::ConversionSettings& config) {
-    return QueueConversions({config}, false);
-}
-
-void Ltc2498Module::SetMisoAsGpio() {
-    // We don't really need to blip the chip select like that, but doing so allows the SPI
-    // transaction to be debugged with a logic analyzer.
-    m_csPin.Set(true);
-    HAL_GPIO_DeInit(m_misoPin.port, m_misoPin.pin);
+    if (m_spi->TryAcquire(m_device) == false) {
+        // Someone else is using the bus, we'll check again later.
+        return true;
+    }
 
-    GPIO_InitTypeDef GPIO_InitStruct = {};
+    // MISO may still be floating right after CS falls: the conversion is only over once it reads
+    // low several times in a row.
+    bool isConverting = false;
+    for (size_t i = 0; (i < EOC_SAMPLES) && !isConverting; i++) {
+        isConverting = m_misoPin.Get();
+    }
 
-    GPIO_InitStruct.Pin  = m_misoPin.pin;
-    GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    HAL_GPIO_Init(m_misoPin.port, &GPIO_InitStruct);
-    m_csPin.Set(false);
+    m_spi->Release();
+    return isConverting;
 }
 
-void Ltc2498Module::SetMisoAsMiso() {
-    // We don't really need to blip the chip select like that, but doing so allows the SPI
-    // transaction to be debugged with a logic analyzer.
-    m_csPin.Set(true);
-    HAL_GPIO_DeInit(m_misoPin.port, m_misoPin.pin);
-
-    GPIO_InitTypeDef GPIO_InitStruct = {};
-
-    GPIO_InitStruct.Pin   = m_misoPin.pin;
-    GPIO_InitStruct.Mode  = GPIO_MODE_AF_PP;
-    GPIO_InitStruct.Pull  = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
-    // TODO Change GPIO_AF5_SPI1 for something generic that works with other SPI peripherals.
-    GPIO_InitStruct.Alternate = GPIO_AF5_SPI1;
-    HAL_GPIO_Init(m_misoPin.port, &GPIO_InitStruct);
-    m_csPin.Set(false);
+bool Ltc2498Module::StartConversion(const LTC2498::ConversionSettings& config) {
+    return QueueConversions({config}, false);
 }
 
 /**
@@ -237,7 +221,7 @@ std::array<uint8_t, 4> Ltc2498Module::SetNextConvAndReadResults(const std::array
     std::array<uint8_t, 4> resp = {0};
 
     // Read the conversion result and (maybe) start the next one.
-    if (m_spi->Transaction(config.data(), config.size(), resp.data(), resp.size()) != CEP_SPI::Status::NONE) {
+    if (m_spi->Transaction(m_device, config.data(), resp.data(), resp.size()) != CEP_SPI::Status::NONE) {
         LTC_ERROR("Unable to communicate with the ADC!");
     }
 
@@ -251,6 +235,50 @@ std::array<uint8_t, 4> Ltc2498Module::SetNextConvAndReadResults(const std::array
     return resp;
 }
 
+/**
+ * Reads the result of the conversion and sends the configuration of the next one in the
+ * background. @ref Run calls @ref HandleResults once the transfer is done.
+ * @return False if the transaction couldn't be queued.
+ */
+bool Ltc2498Module::QueueNextConvAndReadResults() {
+    CEP_SPI::AsyncTransaction transaction;
+    transaction.device   = m_device;
+    transaction.txData   = m_txData.data();
+    transaction.rxData   = m_rxData.data();
+    transaction.len      = m_txData.size();
+    transaction.callback = [this](CEP_SPI::Status status) {
+        // Called from the SPI interrupt, the results are handled by Run.
+        m_transferStatus = status;
+        m_transferDone   = true;
+    };
+
+    m_transferPending = true;
+    m_transferDone    = false;
+    if (m_spi->QueueTransaction(transaction) == false) {
+        m_transferPending = false;
+        return false;
+    }
+
+    // If all bytes of the configuration are 0, there's no conversion taking place.
+    m_isConverting = !(m_txData[0] == 0 && m_txData[1] == 0 && m_txData[2] == 0 && m_txData[3] == 0);
+    return true;
+}
+
+void Ltc2498Module::HandleResults() {
+    m_transferDone    = false;
+    m_transferPending = false;
+
+    if (m_transferStatus != CEP_SPI::Status::NONE) {
+        // Whatever is in the buffer isn't a reading.
+        LTC_ERROR("Unable to communicate with the ADC!");
+        m_transferStatus = CEP_SPI::Status::NONE;
+        return;
+    }
+
+    ParseConversionResult(m_rxData, m_readConfig);
+    if (m_readConfig.callback) { m_readConfig.callback(m_lastReading.reading, m_readConfig); }
+}
+
 void Ltc2498Module::ParseConversionResult(
   const std::array<uint8_t, 4>&      resp,
   const LTC2498::ConversionSettings& config) {
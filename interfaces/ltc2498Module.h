@@ -172,10 +172,16 @@ class Ltc2498Module : public cep::Module {
 
   private:
     std::string m_label   = "";
-    SpiModule*  m_spi     = nullptr;
-    cep::Pin    m_misoPin = {};
-    cep::Pin    m_csPin   = {};
-    float       m_vcom    = 0.00f;
+    SpiModule*        m_spi     = nullptr;
+    CEP_SPI::DeviceId m_device  = CEP_SPI::NO_DEVICE;
+    cep::Pin          m_misoPin = {};
+    float             m_vcom    = 0.00f;
+
+    //! The LTC2498 latches data on the rising edge of SCK and accepts up to 2MHz.
+    static constexpr uint32_t MAX_CLOCK = 2000000;
+    //! MISO takes up to 200ns to leave high impedance after CS falls, it must read low this many
+    //! times in a row before the conversion is considered over.
+    static constexpr size_t EOC_SAMPLES = 8;
 
     std::vector<LTC2498::ConversionSettings> m_conversions       = {};
     LTC2498::CurrentConversion               m_currentConversion = m_conversions.end();
@@ -185,11 +191,19 @@ class Ltc2498Module : public cep::Module {
 
     LTC2498::Reading m_lastReading = {};
 
+    //! Buffers of the asynchronous transaction that reads a result and starts the next conversion.
+    std::array<uint8_t, 4>      m_txData          = {};
+    std::array<uint8_t, 4>      m_rxData          = {};
+    LTC2498::ConversionSettings m_readConfig      = {};
+    volatile bool               m_transferPending = false;
+    volatile bool               m_transferDone    = false;
+    volatile CEP_SPI::Status    m_transferStatus  = CEP_SPI::Status::NONE;
+
   private:
-    void                       SetMisoAsGpio();
-    void                       SetMisoAsMiso();
     LTC2498::CurrentConversion GetNextConversion();
     std::array<uint8_t, 4>     SetNextConvAndReadResults(const std::array<uint8_t, 4>& config);
+    bool                       QueueNextConvAndReadResults();
+    void                       HandleResults();
     void ParseConversionResult(const std::array<uint8_t, 4>& resp, const LTC2498::ConversionSettings& config);
 };
 
@@ -25,41 +25,70 @@ Pca9505Module::Pca9505Module(const PCA9505::Config& config, const std::string& l
     HAL_GPIO_WritePin(m_reset.port, m_reset.pin, GPIO_PIN_SET);
     HAL_GPIO_WritePin(m_outputEnable.port, m_outputEnable.pin, GPIO_PIN_SET);
 
+    // Each bank has 5 registers followed by 3 unused addresses.
+    m_registers.Reserve(OUTPUT_REG + 5, 3);
+    m_registers.Reserve(POLARITY_REG + 5, 3);
+    m_registers.Reserve(DIRECTION_REG + 5, 3);
+
     // For each pin in the configuration:
     for (const auto& pin : config.pinConfig)
     {
         // Update the pin's port information.
         uint8_t port = (uint8_t)pin.port;
-        m_directions[port] |= ((uint8_t)pin.direction << (uint8_t)pin.pin);
-        m_polarities[port] |= ((uint8_t)pin.polarity << (uint8_t)pin.pin);
-        m_interrupts[port] |= ((uint8_t)pin.interrupt << (uint8_t)pin.pin);
-        m_ports[port].port |= ((uint8_t)pin.state << (uint8_t)pin.pin);
+        SetBit(OUTPUT_REG + port, pin.pin, pin.state);
+        SetBit(POLARITY_REG + port, pin.pin, pin.polarity == PCA9505::Polarity::Inverted);
+        SetBit(DIRECTION_REG + port, pin.pin, pin.direction == PCA9505::Direction::Input);
+        SetBit(INTERRUPT_REG + port, pin.pin, pin.interrupt == PCA9505::Interrupt::Disable);
     }
 
-    // Copy the ports' states in a temporary vector.
-    std::vector<uint8_t> states = std::vector<uint8_t>(5);
-    for (const auto& p : m_ports)
+    // Send the whole configuration to the chip, one bank at a time.
+    // If the address is still being looked for, the registers stay dirty and Run sends them.
+    if (ResolveAddress())
     {
-        states.emplace_back(p.port);
+        m_registers.Flush(
+          [this](uint16_t reg, const uint8_t* data, size_t len)
+          {
+              return m_i2c->TransmitToRegister(m_address,
+                                               (uint8_t)(reg | AUTO_INCREMENT),
+                                               cep::Span<const uint8_t>(data, len)) ==
+                     CEP_I2C::Status::Ok;
+          });
     }
 
-    // Send the configuration to the chip.
-    m_i2c->TransmitFrameToRegister(m_address, 0x88, states);
-    m_i2c->TransmitFrameToRegister(m_address, 0x90, m_polarities.data(), m_polarities.size());
-    m_i2c->TransmitFrameToRegister(m_address, 0x98, m_directions.data(), m_directions.size());
-    m_i2c->TransmitFrameToRegister(m_address, 0xA0, m_interrupts.data(), m_interrupts.size());
-
     LOG_INFO("[%s]: Initialized", m_label.c_str());
 }
 
 bool Pca9505Module::DoPost()
 {
-#warning No POSTs have been written for this module!
-    return false;
+    if (!m_i2c->GetInventory().IsComplete())
+    {
+        m_i2c->Scan();
+    }
+
+    if (!ResolveAddress() || !m_i2c->GetInventory().Contains(m_address))
+    {
+        LOG_ERROR("[%s]: No device at 0x%02X", m_label.c_str(), m_address);
+        return false;
+    }
+
+    LOG_INFO("[%s]: POST OK", m_label.c_str());
+    return true;
 }
 
 void Pca9505Module::Run()
 {
+    if (m_writeErrors != CEP_I2C::Status::Ok)
+    {
+        LOG_ERROR("[%s]: Unable to write to the PCA9505: 0x%08X",
+                  m_label.c_str(),
+                  (uint32_t)m_writeErrors);
+        m_writeErrors = CEP_I2C::Status::Ok;
+        // We don't know which registers were lost, send everything again.
+        m_registers.MarkAllDirty();
+    }
+
+    Flush();
+
     //    static uint32_t lastRead = 0;
     //
     //    if (HAL_GetTick( ) > lastRead + 10)
@@ -103,53 +132,12 @@ void Pca9505Module::ReleaseReset()
 
 void Pca9505Module::ConfigurePin(const PCA9505::PinConfig& config)
 {
-    uint8_t offset = (uint8_t)config.port;
-    uint8_t pos    = (uint8_t)config.pin;
-
-    uint8_t state = (uint8_t)config.state << pos;
-    if (config.state == false)
-    {
-        m_ports[offset].port &= ~state;
-    }
-    else
-    {
-        m_ports[offset].port |= state;
-    }
-
-    uint8_t direction = (uint8_t)config.direction << pos;
-    if (config.direction == PCA9505::Direction::Output)
-    {
-        m_directions[offset] &= ~direction;
-    }
-    else
-    {
-        m_directions[offset] |= direction;
-    }
-
-    uint8_t polarity = (uint8_t)config.polarity << pos;
-    if (config.polarity == PCA9505::Polarity::Normal)
-    {
-        m_polarities[offset] &= ~polarity;
-    }
-    else
-    {
-        m_polarities[offset] |= polarity;
-    }
-
-    uint8_t interrupt = (uint8_t)config.interrupt << pos;
-    if (config.interrupt == PCA9505::Interrupt::Disable)
-    {
-        m_interrupts[offset] &= ~interrupt;
-    }
-    else
-    {
-        m_interrupts[offset] |= interrupt;
-    }
+    uint8_t port = (uint8_t)config.port;
 
-    m_i2c->TransmitFrameToRegister(m_address, 0x08 + offset, {m_ports[offset].port});
-    m_i2c->TransmitFrameToRegister(m_address, 0x10 + offset, {m_polarities[offset]});
-    m_i2c->TransmitFrameToRegister(m_address, 0x18 + offset, {m_directions[offset]});
-    m_i2c->TransmitFrameToRegister(m_address, 0x20 + offset, {m_interrupts[offset]});
+    SetBit(OUTPUT_REG + port, config.pin, config.state);
+    SetBit(POLARITY_REG + port, config.pin, config.polarity == PCA9505::Polarity::Inverted);
+    SetBit(DIRECTION_REG + port, config.pin, config.direction == PCA9505::Direction::Input);
+    SetBit(INTERRUPT_REG + port, config.pin, config.interrupt == PCA9505::Interrupt::Disable);
 }
 
 void Pca9505Module::ConfigurePort(
@@ -157,15 +145,10 @@ void Pca9505Module::ConfigurePort(
 {
     uint8_t portId = (uint8_t)port;
 
-    m_ports[portId].port = states;
-    m_directions[portId] = directions;
-    m_polarities[portId] = polarities;
-    m_interrupts[portId] = interrupts;
-
-    m_i2c->TransmitFrameToRegister(m_address, 0x08 + portId, {m_ports[portId].port});
-    m_i2c->TransmitFrameToRegister(m_address, 0x10 + portId, {m_polarities[portId]});
-    m_i2c->TransmitFrameToRegister(m_address, 0x18 + portId, {m_directions[portId]});
-    m_i2c->TransmitFrameToRegister(m_address, 0x20 + portId, {m_interrupts[portId]});
+    m_registers.Set(OUTPUT_REG + portId, states);
+    m_registers.Set(POLARITY_REG + portId, polarities);
+    m_registers.Set(DIRECTION_REG + portId, directions);
+    m_registers.Set(INTERRUPT_REG + portId, interrupts);
 }
 
 bool Pca9505Module::ReadPin(PCA9505::Ports port, PCA9505::Pins pin)
@@ -178,37 +161,101 @@ bool Pca9505Module::ReadPin(PCA9505::Ports port, PCA9505::Pins pin)
 
 PCA9505::PortState Pca9505Module::ReadPort(PCA9505::Ports port)
 {
-    auto frame = m_i2c->ReceiveFrameFromRegister(m_address, 0x80, 5);
-
-    auto frameData = frame.data.begin();
-    for (auto& p : m_ports)
+    // Read the 5 input ports at once, with auto-increment.
+    std::array<uint8_t, 5> inputs = {};
+    if (ResolveAddress() && m_i2c->ReceiveFromRegister(m_address, INPUT_REG | AUTO_INCREMENT, inputs) ==
+        CEP_I2C::Status::Ok)
     {
-        p.port = *frameData++;
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            m_inputs[i].port = inputs[i];
+        }
     }
 
-    return m_ports[(uint8_t)port];
+    return m_inputs[(uint8_t)port];
 }
 
 void Pca9505Module::WritePin(PCA9505::Ports port, PCA9505::Pins pin, bool state)
 {
-    uint8_t portState = 0x01 << (uint8_t)pin;
+    SetBit(OUTPUT_REG + (uint8_t)port, pin, state);
+}
+
+void Pca9505Module::WritePort(PCA9505::Ports port, uint8_t state)
+{
+    m_registers.Set(OUTPUT_REG + (uint8_t)port, state);
+}
+
+bool Pca9505Module::Flush()
+{
+    if (!ResolveAddress())
+    {
+        return false;
+    }
+
+    // The unused addresses between the banks split the bursts, no need for a page size.
+    return m_registers.Flush([this](uint16_t reg, const uint8_t* data, size_t len)
+                             { return QueueWrite(reg, data, len); });
+}
+
+/**
+ * Looks for the chip in the inventory of the bus if its address wasn't given.
+ * Doesn't wait for the scan, it is started if needed and the address is resolved by a later call.
+ * @return  True once the address is known.
+ */
+bool Pca9505Module::ResolveAddress()
+{
+    if (m_address != PCA9505::FIND_ADDRESS)
+    {
+        return true;
+    }
 
-    if (state == false)
+    const CEP_I2C::Inventory& inventory = m_i2c->GetInventory();
+    if (!inventory.IsComplete())
     {
-        m_ports[(uint8_t)port].port &= ~portState;
+        if (!m_i2c->IsScanning())
+        {
+            m_i2c->StartScan();
+        }
+        return false;
     }
-    else
+
+    m_address = inventory.Find(PCA9505::FIRST_ADDRESS, PCA9505::LAST_ADDRESS);
+    if (m_address == CEP_I2C::Inventory::NO_DEVICE)
     {
-        m_ports[(uint8_t)port].port |= portState;
+        LOG_ERROR("[%s]: No PCA9505 found on the bus", m_label.c_str());
+        m_address = PCA9505::FIRST_ADDRESS;
     }
+    return true;
+}
 
-    m_i2c->TransmitFrameToRegister(m_address, 0x08 + (uint8_t)port, {m_ports[(uint8_t)port].port});
+void Pca9505Module::SetBit(uint8_t reg, PCA9505::Pins pin, bool state)
+{
+    uint8_t mask = 0x01 << (uint8_t)pin;
+    m_registers.Modify(reg, mask, state ? mask : 0x00);
 }
 
-void Pca9505Module::WritePort(PCA9505::Ports port, uint8_t state)
+/**
+ * Writes consecutive registers in the background.
+ * The values are read when the transfer starts, `data` must point into the register map.
+ */
+bool Pca9505Module::QueueWrite(uint16_t reg, const uint8_t* data, size_t len)
 {
-    m_ports[(uint8_t)port].port = state;
+    CEP_I2C::Transaction transaction;
+    transaction.address  = m_address;
+    transaction.reg      = reg | AUTO_INCREMENT;
+    transaction.regSize  = 1;
+    transaction.txData   = data;
+    transaction.txLen    = len;
+    transaction.callback = [this](CEP_I2C::Status status)
+    {
+        // Called from the I2C interrupt, the errors are logged by Run.
+        if (status != CEP_I2C::Status::Ok)
+        {
+            m_writeErrors = (CEP_I2C::Status)((uint32_t)m_writeErrors | (uint32_t)status);
+        }
+    };
 
-    m_i2c->TransmitFrameToRegister(m_address, 0x08 + (uint8_t)port, {m_ports[(uint8_t)port].port});
+    // If the queue is full, the registers stay dirty and are sent by the next flush.
+    return m_i2c->QueueTransaction(transaction);
 }
 #endif
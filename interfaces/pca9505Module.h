@@ -18,6 +18,7 @@
 /* Includes */
 #include "defines/module.hpp"
 #include "defines/pin.h"
+#include "defines/registerMap.hpp"
 #include "drivers/i2cModule.hpp"
 
 #include <array>
@@ -31,6 +32,12 @@
 /*****************************************************************************/
 /* Exported types */
 namespace PCA9505 {
+//! Range of addresses selectable with the address pins.
+static constexpr uint8_t FIRST_ADDRESS = 0x40;
+static constexpr uint8_t LAST_ADDRESS  = 0x4E;
+//! Use the first PCA9505 found on the bus.
+static constexpr uint8_t FIND_ADDRESS = 0x00;
+
 enum class Pins
 {
     p0 = 0x0000,
@@ -91,7 +98,7 @@ struct PinConfig {
 
 struct Config {
     I2cModule* i2c = nullptr;
-    //! Set by hardware, between 0x40 and 0x4E.
+    //! Set by hardware, between 0x40 and 0x4E. FIND_ADDRESS to look for it on the bus.
     uint8_t                address      = 0x40;
     cep::Pin               outputEnable = {};
     cep::Pin               interrupt    = {};
@@ -139,10 +146,16 @@ class Pca9505Module : public cep::Module {
     bool               ReadPin(PCA9505::Ports port, PCA9505::Pins pin);
     PCA9505::PortState ReadPort(PCA9505::Ports port);
 
-    // #TODO: Optimize WritePin to Bank Write requests and WritePort once each loop
+    // The configuration and the outputs are only cached, they are sent to the chip by Run.
     void WritePin(PCA9505::Ports port, PCA9505::Pins pin, bool state);
     void WritePort(PCA9505::Ports port, uint8_t state);
 
+    /**
+     * @brief   Sends the registers that changed since the last flush, in the background.
+     * @return  True if all of them were queued.
+     */
+    bool Flush();
+
   private:
     I2cModule*  m_i2c;
     uint8_t     m_address;
@@ -151,10 +164,26 @@ class Pca9505Module : public cep::Module {
     cep::Pin                          m_outputEnable;
     cep::Pin                          m_interrupt;
     cep::Pin                          m_reset;
-    std::array<PCA9505::PortState, 5> m_ports;
-    std::array<uint8_t, 5>            m_directions;
-    std::array<uint8_t, 5>            m_polarities;
-    std::array<uint8_t, 5>            m_interrupts;
+    std::array<PCA9505::PortState, 5> m_inputs = {};
+
+    static constexpr uint8_t INPUT_REG     = 0x00;
+    static constexpr uint8_t OUTPUT_REG    = 0x08;
+    static constexpr uint8_t POLARITY_REG  = 0x10;
+    static constexpr uint8_t DIRECTION_REG = 0x18;
+    static constexpr uint8_t INTERRUPT_REG = 0x20;
+    //! Set in the register address to access consecutive registers in a single transfer.
+    static constexpr uint8_t AUTO_INCREMENT = 0x80;
+
+    //! Output, polarity, direction and interrupt mask banks.
+    cep::RegisterMap<INTERRUPT_REG + 5 - OUTPUT_REG> m_registers {OUTPUT_REG};
+
+    //! Errors of the asynchronous writes, reported by Run.
+    volatile CEP_I2C::Status m_writeErrors = CEP_I2C::Status::Ok;
+
+  private:
+    bool ResolveAddress();
+    void SetBit(uint8_t reg, PCA9505::Pins pin, bool state);
+    bool QueueWrite(uint16_t reg, const uint8_t* data, size_t len);
 };
 
 /*****************************************************************************/
@@ -75,6 +75,7 @@
 //#define NILAI_USE_SPI
 //#define NILAI_USE_UART
 //#define NILAI_USE_PWM
+//#define NILAI_USE_CAPTURE
 //#define NILAI_USE_RTC
 
 // Interfaces
@@ -97,6 +98,7 @@
 //#define NILAI_USE_LOGGER
 //#define NILAI_USE_FILE_LOGGER
 //#define NILAI_USE_FILESYSTEM
+//#define NILAI_USE_CAN_RECORDER
 
 /**
  * @}
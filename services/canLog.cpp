@@ -0,0 +1,101 @@
+/**
+ * @addtogroup  services
+ * @{
+ * @addtogroup  canLog
+ * @{
+ * @file        canLog.cpp
+ * @author      Samuel Martel
+ * @date        2021/11/15
+ *
+ * @brief       Replay engine for binary CAN traffic logs.
+ */
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#include "services/canLog.hpp"
+
+#if defined(NILAI_USE_CAN_RECORDER) || defined(NILAI_TEST)
+
+namespace CEP_CAN
+{
+LogReplay::LogReplay(const std::vector<uint8_t>& log)
+{
+    if (log.size() < sizeof(LogHeader))
+    {
+        return;
+    }
+
+    std::memcpy(&m_header, log.data(), sizeof(LogHeader));
+    if ((m_header.magic != LOG_MAGIC) || (m_header.version != LOG_VERSION) ||
+        (m_header.recordSize != sizeof(CompactFrame)))
+    {
+        return;
+    }
+
+    size_t count = (log.size() / sizeof(CompactFrame)) - 1;
+    m_records.reserve(count);
+    m_offsets.reserve(count);
+
+    uint64_t offset   = 0;
+    uint32_t lastTime = 0;
+    for (size_t i = 1; i <= count; i++)
+    {
+        CompactFrame record;
+        std::memcpy(
+          static_cast<void*>(&record), &log[i * sizeof(CompactFrame)], sizeof(CompactFrame));
+        if (IsLogPadding(record))
+        {
+            continue;
+        }
+
+        // Timestamps are 28 bits wide, accumulate the differences to survive the wrap-around.
+        uint32_t time = record.GetTimestamp();
+        if (!m_records.empty())
+        {
+            offset += (time - lastTime) & CompactFrame::TIMESTAMP_MASK;
+        }
+        lastTime = time;
+
+        m_records.push_back(record);
+        m_offsets.push_back(offset);
+    }
+
+    m_isValid = true;
+}
+
+void LogReplay::Start(uint32_t now, float speed)
+{
+    m_next  = 0;
+    m_start = now;
+    m_speed = speed < 0.0f ? 0.0f : speed;
+}
+
+size_t LogReplay::Step(uint32_t now, const Sink& sink)
+{
+    size_t   delivered = 0;
+    uint64_t elapsed   = (uint64_t)(uint32_t)(now - m_start);
+    uint64_t logTime   = (uint64_t)((double)elapsed * (double)m_speed);
+
+    while ((m_next < m_records.size()) && ((m_speed == 0.0f) || (m_offsets[m_next] <= logTime)))
+    {
+        CompactFrame frame = m_records[m_next];
+        bool         tx    = (frame.header & LOG_TX_FLAG) != 0;
+        frame.header &= ~LOG_TX_FLAG;
+
+        if (sink)
+        {
+            sink(frame, tx);
+        }
+        m_next++;
+        delivered++;
+    }
+
+    return delivered;
+}
+}    // namespace CEP_CAN
+
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,270 @@
+/**
+ * @addtogroup  services
+ * @{
+ * @addtogroup  canLog
+ * @{
+ * @file        canLog.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/15
+ *
+ * @brief       Binary CAN traffic log: file format, double-buffered writer and replay engine.
+ *
+ * A log is a sequence of 16-byte records. The first record is a @ref CEP_CAN::LogHeader, every
+ * other one is a @ref CEP_CAN::CompactFrame whose unused header bit marks transmitted frames.
+ * Logs are always a whole number of 512-byte sectors long, the end of the last sector is filled
+ * with padding records.
+ *
+ * Logs are recorded by @ref CanRecorder.
+ */
+#ifndef CAN_LOG_HPP_
+#define CAN_LOG_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_CAN_RECORDER) || defined(NILAI_TEST)
+#    include "drivers/canFrame.hpp"
+
+#    include <array>
+#    include <atomic>
+#    include <cstddef>
+#    include <cstdint>
+#    include <cstring>
+#    include <functional>
+#    include <vector>
+
+namespace CEP_CAN
+{
+/*************************************************************************************************/
+/* Defines ------------------------------------------------------------------------------------- */
+//! "NCAN", in little endian.
+static constexpr uint32_t LOG_MAGIC              = 0x4E41434E;
+static constexpr uint16_t LOG_VERSION            = 1;
+static constexpr size_t   LOG_SECTOR_SIZE        = 512;
+static constexpr size_t   LOG_RECORDS_PER_SECTOR = LOG_SECTOR_SIZE / sizeof(CompactFrame);
+//! Set in the header of the frames that were transmitted rather than received.
+static constexpr uint32_t LOG_TX_FLAG = 0x80000000;
+
+/*************************************************************************************************/
+/* Types --------------------------------------------------------------------------------------- */
+struct LogHeader
+{
+    uint32_t magic      = LOG_MAGIC;
+    uint16_t version    = LOG_VERSION;
+    uint16_t recordSize = sizeof(CompactFrame);
+    //! System tick at which the recording started, in milliseconds.
+    uint32_t startTick = 0;
+    uint32_t reserved  = 0;
+};
+static_assert(sizeof(LogHeader) == sizeof(CompactFrame), "The log header must fit in a record");
+
+/**
+ * @brief   Record used to fill the end of the last sector of a log.
+ *
+ * A DLC of 15 can't come from a real frame, which makes it unambiguous.
+ */
+constexpr CompactFrame MakeLogPadding()
+{
+    CompactFrame padding;
+    padding.header = 0xFFFFFFFF;
+    padding.info   = 0xFFFFFFFF;
+    padding.data   = 0xFFFFFFFFFFFFFFFF;
+    return padding;
+}
+
+constexpr bool IsLogPadding(const CompactFrame& record)
+{
+    return (record.header == 0xFFFFFFFF) && (record.info == 0xFFFFFFFF);
+}
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+/**
+ * @brief   Double buffer of log records, flushed one buffer at a time.
+ *
+ * Frames are added to the active buffer. When it is full it becomes ready to be written and the
+ * other buffer becomes the active one. If the other buffer hasn't been written yet, the frame is
+ * dropped instead.
+ *
+ * Each buffer is a whole number of sectors, so writing them one after the other keeps the file
+ * sector-aligned.
+ *
+ * @ref Push can be called from an interrupt while the main loop writes the ready buffer: the
+ * handoff of the buffers goes through atomics, @ref GetReadyBuffer and @ref ReleaseReadyBuffer
+ * don't need the interrupts to be masked. @ref Push must not interrupt itself, and mustn't be
+ * called at all during @ref Begin and @ref Finish.
+ *
+ * @tparam  Sectors Number of sectors in each buffer.
+ */
+template<size_t Sectors>
+class LogBuffer
+{
+public:
+    static constexpr size_t RECORDS_PER_BUFFER = Sectors * LOG_RECORDS_PER_SECTOR;
+    static constexpr size_t BUFFER_SIZE        = RECORDS_PER_BUFFER * sizeof(CompactFrame);
+
+    /**
+     * @brief   Empties the buffers and starts a new log with its header.
+     * @param   startTick   Current system tick, in milliseconds.
+     */
+    void Begin(uint32_t startTick)
+    {
+        m_active.store(0, std::memory_order_relaxed);
+        m_ready[0].store(false, std::memory_order_relaxed);
+        m_ready[1].store(false, std::memory_order_relaxed);
+        m_fill    = 0;
+        m_dropped = 0;
+
+        LogHeader header;
+        header.startTick = startTick;
+        std::memcpy(static_cast<void*>(&m_buffers[0][0]), &header, sizeof(header));
+        m_fill = 1;
+    }
+
+    /**
+     * @brief   Adds a frame to the log.
+     * @param   frame   The frame.
+     * @param   tx      True if the frame was transmitted, false if it was received.
+     * @return  True if the frame was added, false if it was dropped because both buffers are full.
+     */
+    bool Push(const CompactFrame& frame, bool tx)
+    {
+        size_t active = m_active.load(std::memory_order_relaxed);
+        if (m_fill == RECORDS_PER_BUFFER)
+        {
+            // The other buffer can only be reused once the main loop is done reading it.
+            size_t next = active ^ 1;
+            if (m_ready[next].load(std::memory_order_acquire))
+            {
+                m_dropped++;
+                return false;
+            }
+            // The records must be visible before the buffer is handed out.
+            m_ready[active].store(true, std::memory_order_release);
+            m_active.store(next, std::memory_order_release);
+            active = next;
+            m_fill = 0;
+        }
+
+        CompactFrame& record = m_buffers[active][m_fill++];
+        record               = frame;
+        record.header        = (frame.header & ~LOG_TX_FLAG) | (tx ? LOG_TX_FLAG : 0U);
+        return true;
+    }
+
+    /**
+     * @brief   Gets the full buffer waiting to be written, if there is one.
+     * @return  A buffer of @ref BUFFER_SIZE bytes, or nullptr.
+     */
+    [[nodiscard]] const CompactFrame* GetReadyBuffer() const
+    {
+        // While a buffer is ready, Push can't switch to it: the active buffer doesn't change.
+        size_t other = m_active.load(std::memory_order_acquire) ^ 1;
+        if (m_ready[other].load(std::memory_order_acquire))
+        {
+            return m_buffers[other].data();
+        }
+        return nullptr;
+    }
+
+    //! Marks the ready buffer as written, making it available for new frames.
+    void ReleaseReadyBuffer()
+    {
+        size_t other = m_active.load(std::memory_order_acquire) ^ 1;
+        m_ready[other].store(false, std::memory_order_release);
+    }
+
+    /**
+     * @brief   Pads the active buffer to the end of its current sector and hands it out.
+     *
+     * The ready buffer, if any, must be written before this one.
+     *
+     * @param   size    Number of bytes to write, always a multiple of the sector size.
+     * @return  The active buffer.
+     */
+    const CompactFrame* Finish(size_t& size)
+    {
+        size_t active = m_active.load(std::memory_order_acquire);
+        while ((m_fill % LOG_RECORDS_PER_SECTOR) != 0)
+        {
+            m_buffers[active][m_fill++] = MakeLogPadding();
+        }
+        size = m_fill * sizeof(CompactFrame);
+        return m_buffers[active].data();
+    }
+
+    [[nodiscard]] uint32_t GetDropped() const { return m_dropped; }
+
+private:
+    std::array<std::array<CompactFrame, RECORDS_PER_BUFFER>, 2> m_buffers = {};
+
+    //! Shared with the main loop.
+    std::atomic<size_t>              m_active = 0;
+    std::array<std::atomic<bool>, 2> m_ready  = {};
+    //! Only used by @ref Push.
+    size_t   m_fill    = 0;
+    uint32_t m_dropped = 0;
+};
+
+/**
+ * @brief   Plays a recorded log back, at the original speed or faster.
+ *
+ * The replay is driven by the caller's clock: every call to @ref Step delivers the frames whose
+ * time has come since @ref Start.
+ */
+class LogReplay
+{
+public:
+    /**
+     * @param   frame   The frame, without the log flags.
+     * @param   tx      True if the frame had been transmitted by the recording device.
+     */
+    using Sink = std::function<void(const CompactFrame& frame, bool tx)>;
+
+    explicit LogReplay(const std::vector<uint8_t>& log);
+
+    [[nodiscard]] bool             IsValid() const { return m_isValid; }
+    [[nodiscard]] const LogHeader& GetHeader() const { return m_header; }
+    [[nodiscard]] size_t           GetFrameCount() const { return m_records.size(); }
+    //! Time between the first and the last frame of the log, in milliseconds.
+    [[nodiscard]] uint64_t GetDuration() const
+    {
+        return m_offsets.empty() ? 0 : m_offsets.back();
+    }
+
+    /**
+     * @brief   Starts (or restarts) the replay.
+     * @param   now     Current time of the caller's clock, in milliseconds.
+     * @param   speed   1.0f for the original speed, 2.0f for twice as fast, etc.
+     *                  0.0f delivers every frame on the next call to @ref Step.
+     */
+    void Start(uint32_t now, float speed = 1.0f);
+
+    /**
+     * @brief   Delivers the frames that are due.
+     * @param   now     Current time of the caller's clock, in milliseconds.
+     * @param   sink    Called for each frame.
+     * @return  The number of frames delivered.
+     */
+    size_t Step(uint32_t now, const Sink& sink);
+
+    [[nodiscard]] bool IsDone() const { return m_next >= m_records.size(); }
+
+private:
+    bool                      m_isValid = false;
+    LogHeader                 m_header;
+    std::vector<CompactFrame> m_records;
+    //! Time of each record relative to the first one, in milliseconds.
+    std::vector<uint64_t> m_offsets;
+
+    size_t   m_next  = 0;
+    uint32_t m_start = 0;
+    float    m_speed = 1.0f;
+};
+}    // namespace CEP_CAN
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,175 @@
+/**
+ * @addtogroup canRecorder.cpp
+ * @{
+ *******************************************************************************
+ * @file	canRecorder.cpp
+ * @author	Samuel Martel
+ * @brief   Records the traffic of a CAN bus into a binary log on the filesystem.
+ * Created on: Nov 15, 2021
+ *******************************************************************************
+ */
+#if defined(NILAI_USE_CAN_RECORDER)
+#    include "canRecorder.h"
+
+#    include "services/logger.hpp"
+
+CanRecorder::CanRecorder(const std::string& label, CanModule* can, const std::string& path)
+: m_label(label), m_path(path), m_can(can)
+{
+    CEP_ASSERT(can != nullptr, "[%s]: CanModule is NULL!", m_label.c_str());
+
+    LOG_INFO("[%s]: Initialized", m_label.c_str());
+}
+
+CanRecorder::~CanRecorder()
+{
+    Stop();
+}
+
+bool CanRecorder::DoPost()
+{
+    using namespace cep::Filesystem;
+
+    File   file;
+    Result r = file.Open(m_path, FileModes::Write | FileModes::OpenAlways);
+    if (r != Result::Ok)
+    {
+        LOG_ERROR("[%s]: POST error, unable to open log file: %s",
+                  m_label.c_str(),
+                  ResultToStr(r).c_str());
+        return false;
+    }
+    file.Close();
+
+    LOG_INFO("[%s]: POST OK!", m_label.c_str());
+    return true;
+}
+
+void CanRecorder::Run()
+{
+    if (!m_isRecording)
+    {
+        return;
+    }
+
+    const CEP_CAN::CompactFrame* ready = m_buffer.GetReadyBuffer();
+    if (ready != nullptr)
+    {
+        if (!WriteToFile(ready, decltype(m_buffer)::BUFFER_SIZE))
+        {
+            // Nowhere to put the frames anymore, give up on this recording.
+            m_can->ClearFrameObserver();
+            m_isRecording = false;
+            m_file.Close();
+            return;
+        }
+        m_buffer.ReleaseReadyBuffer();
+    }
+
+    if (HAL_GetTick() - m_lastSync >= SYNC_INTERVAL)
+    {
+        m_lastSync = HAL_GetTick();
+        m_file.Sync();
+    }
+}
+
+/**
+ * @brief   Creates the log file, overwriting it if it exists, and starts recording.
+ * @return  True if recording started.
+ */
+bool CanRecorder::Start()
+{
+    using namespace cep::Filesystem;
+
+    if (m_isRecording)
+    {
+        return true;
+    }
+
+    Result r = m_file.Open(m_path, FileModes::Write | FileModes::CreateAlways);
+    if (r != Result::Ok)
+    {
+        LOG_ERROR("[%s]: Unable to create log file: %s", m_label.c_str(), ResultToStr(r).c_str());
+        return false;
+    }
+
+    m_recorded = 0;
+    m_lastSync = HAL_GetTick();
+    m_buffer.Begin(HAL_GetTick());
+    m_isRecording = true;
+
+    m_can->SetFrameObserver([this](const CEP_CAN::CompactFrame& frame, bool tx)
+                            { Record(frame, tx); });
+
+    LOG_INFO("[%s]: Recording to %s", m_label.c_str(), m_path.c_str());
+    return true;
+}
+
+/**
+ * @brief   Stops recording, writes what is left in the buffers and closes the log file.
+ */
+void CanRecorder::Stop()
+{
+    if (!m_isRecording)
+    {
+        return;
+    }
+
+    m_can->ClearFrameObserver();
+    m_isRecording = false;
+
+    const CEP_CAN::CompactFrame* ready = m_buffer.GetReadyBuffer();
+    if (ready != nullptr)
+    {
+        WriteToFile(ready, decltype(m_buffer)::BUFFER_SIZE);
+        m_buffer.ReleaseReadyBuffer();
+    }
+
+    size_t                       len  = 0;
+    const CEP_CAN::CompactFrame* last = m_buffer.Finish(len);
+    if (len != 0)
+    {
+        WriteToFile(last, len);
+    }
+
+    m_file.Close();
+
+    LOG_INFO("[%s]: Recorded %i frames, dropped %i",
+             m_label.c_str(),
+             (int)m_recorded,
+             (int)m_buffer.GetDropped());
+}
+
+/**
+ * @brief   Adds a frame to the log. Called by the CanModule, possibly from its interrupt handler.
+ *
+ * The handoff of the buffers with @ref Run is lock-free, the interrupts are only masked so that
+ * pushing a frame from the main loop doesn't get interrupted by pushing one from the interrupt.
+ */
+void CanRecorder::Record(const CEP_CAN::CompactFrame& frame, bool tx)
+{
+    // Frames come from both the CAN interrupt and the main loop.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (m_buffer.Push(frame, tx))
+    {
+        m_recorded++;
+    }
+    __set_PRIMASK(primask);
+}
+
+bool CanRecorder::WriteToFile(const CEP_CAN::CompactFrame* data, size_t len)
+{
+    using namespace cep::Filesystem;
+
+    size_t written = 0;
+    Result r       = m_file.Write(data, len, &written);
+    if ((r != Result::Ok) || (written != len))
+    {
+        LOG_ERROR("[%s]: Unable to write to log file: %s", m_label.c_str(), ResultToStr(r).c_str());
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @addtogroup canRecorder.h
+ * @{
+ *******************************************************************************
+ * @file	canRecorder.h
+ * @author	Samuel Martel
+ * @brief   Records the traffic of a CAN bus into a binary log on the filesystem.
+ * Created on: Nov 15, 2021
+ *******************************************************************************
+ */
+
+#ifndef CANRECORDER_H_
+#define CANRECORDER_H_
+
+/***********************************************/
+/* Includes */
+#if defined(NILAI_USE_CAN_RECORDER)
+#    if !defined(NILAI_USE_CAN) || !defined(NILAI_USE_FILESYSTEM)
+#        error The CAN recorder requires the CAN and filesystem modules!
+#    endif
+#    include "defines/module.hpp"
+
+#    include "drivers/canModule.hpp"
+#    include "services/canLog.hpp"
+#    include "services/file.h"
+#    include "services/filesystem.h"
+
+#    include <string>
+
+/***********************************************/
+/* Defines */
+#    if !defined(NILAI_CAN_RECORDER_BUFFER_SECTORS)
+//! Number of 512-byte sectors in each of the two buffers.
+#        define NILAI_CAN_RECORDER_BUFFER_SECTORS 2
+#    endif
+#    if !defined(NILAI_CAN_RECORDER_SYNC_INTERVAL)
+//! Time between two syncs of the log file, in milliseconds.
+#        define NILAI_CAN_RECORDER_SYNC_INTERVAL 1000
+#    endif
+
+/**
+ * Streams every frame received and transmitted by a CanModule into a log file, in the format
+ * described in canLog.hpp.
+ *
+ * Frames are collected in one buffer while the other one is written to the file from Run, a
+ * buffer at a time. If the filesystem can't keep up, frames are dropped and counted.
+ */
+class CanRecorder : public cep::Module
+{
+public:
+    CanRecorder(const std::string& label, CanModule* can, const std::string& path = "can.bin");
+    virtual ~CanRecorder() override;
+
+    virtual bool               DoPost() override;
+    virtual void               Run() override;
+    virtual const std::string& GetLabel() const override { return m_label; }
+
+    bool Start();
+    void Stop();
+    bool IsRecording() const { return m_isRecording; }
+
+    uint32_t GetRecordedFrames() const { return m_recorded; }
+    uint32_t GetDroppedFrames() const { return m_buffer.GetDropped(); }
+
+private:
+    void Record(const CEP_CAN::CompactFrame& frame, bool tx);
+    bool WriteToFile(const CEP_CAN::CompactFrame* data, size_t len);
+
+private:
+    std::string m_label = "";
+    std::string m_path  = "";
+    CanModule*  m_can   = nullptr;
+
+    cep::Filesystem::File m_file;
+    bool                  m_isRecording = false;
+    uint32_t              m_recorded    = 0;
+    uint32_t              m_lastSync    = 0;
+
+    CEP_CAN::LogBuffer<NILAI_CAN_RECORDER_BUFFER_SECTORS> m_buffer;
+
+    static constexpr uint32_t SYNC_INTERVAL = NILAI_CAN_RECORDER_SYNC_INTERVAL;
+};
+
+/**
+ * @}
+ */
+/* END OF FILE */
+#endif
+#endif /* CANRECORDER_H_ */
@@ -41,16 +41,13 @@
 #    elif !defined(NILAI_USE_RTC)
 #        error NILAI_LOGGER_USE_RTC was defined, the RTC module must also be enabled!
 #    else
-#        include "drivers/rtcModule.h"
+#        include "services/timebase.hpp"
 #        define LOG_HELPER(msg, ...)                                                               \
             do                                                                                     \
             {                                                                                      \
                 Logger::Get( ) != nullptr                                                          \
-                    ? Logger::Get( )->Log("[%s %s.%03i] " msg,                                     \
-                                          RtcModule::Get( )->GetDate( ).ToStr( ).c_str( ),         \
-                                          RtcModule::Get( )->GetTime( ).ToStr( ).c_str( ),         \
-                                          HAL_GetTick( ) % 1000,                                   \
-                                          ##__VA_ARGS__)                                           \
+                    ? Logger::Get( )->Log(                                                         \
+                        "[%s] " msg, Timebase::GetTimestamp( ), ##__VA_ARGS__)                     \
                     : (void)0;                                                                     \
             } while (0)
 #        define INT_NILAI_LOG_IMPL_OK
@@ -0,0 +1,32 @@
+/**
+ * @addtogroup  services
+ * @{
+ * @addtogroup  timebase
+ * @{
+ * @file        timebase.cpp
+ * @author      Samuel Martel
+ * @date        2021/11/29
+ */
+#include "timebase.hpp"
+#if defined(NILAI_USE_RTC) && defined(HAL_RTC_MODULE_ENABLED)
+#include "drivers/rtcModule.h"
+
+CEP_RTC::TimestampCache Timebase::s_cache;
+
+const char* Timebase::GetTimestamp()
+{
+    uint32_t   tick = HAL_GetTick();
+    RtcModule* rtc  = RtcModule::Get();
+    if ((rtc != nullptr) && s_cache.NeedsSync(tick))
+    {
+        s_cache.Sync(rtc->GetTimestamp().ToCivil(), tick);
+    }
+    return s_cache.Format(tick);
+}
+
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,58 @@
+/**
+ * @addtogroup  services
+ * @{
+ * @addtogroup  timebase
+ * @{
+ * @file        timebase.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/29
+ *
+ * @brief       Current date and time with millisecond resolution, as cheap to get as the tick.
+ *
+ * The RTC is read at most once per second, the system tick filling in the milliseconds in
+ * between. The logger uses it to timestamp its lines when NILAI_LOGGER_USE_RTC is defined.
+ */
+#ifndef TIMEBASE_HPP_
+#define TIMEBASE_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_RTC)
+#include "defines/internalConfig.h"
+#include NILAI_HAL_HEADER
+#if defined(HAL_RTC_MODULE_ENABLED)
+#include "services/timestampCache.hpp"
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+class Timebase
+{
+public:
+    /**
+     * @brief   Gets the current date and time, as `YY-MM-DD HH:MM:SS.mmm`.
+     *
+     * Until an @ref RtcModule exists, the time counts from 00-01-01 00:00:00.000 at boot.
+     *
+     * @return  The text, valid until the next call.
+     */
+    static const char* GetTimestamp();
+
+    /**
+     * @brief   Makes the next timestamp read the RTC.
+     *
+     * Called when the RTC is set. Can also be called from the RTC's wakeup interrupt, to keep
+     * the timestamps in step with the RTC rather than with the tick.
+     */
+    static void Invalidate() { s_cache.Invalidate(); }
+
+private:
+    static CEP_RTC::TimestampCache s_cache;
+};
+
+#endif
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,143 @@
+/**
+ * @addtogroup  services
+ * @{
+ * @addtogroup  timebase
+ * @{
+ * @file        timestampCache.hpp
+ * @author      Samuel Martel
+ * @date        2021/11/29
+ *
+ * @brief       Timestamps extrapolated from an occasional reading of the RTC, kept as text.
+ *
+ * The RTC is slow to read, and formatting its date and time for every log line is most of the
+ * cost of logging. The cache is synced with a reading of the RTC about once per second, the
+ * system tick measuring the time elapsed since then. The text is only rewritten when the second
+ * changes, otherwise only the milliseconds are.
+ *
+ * The cache is synced by @ref Timebase.
+ */
+#ifndef TIMESTAMP_CACHE_HPP_
+#define TIMESTAMP_CACHE_HPP_
+/*************************************************************************************************/
+/* Includes ------------------------------------------------------------------------------------ */
+#if defined(NILAI_USE_RTC) || defined(NILAI_TEST)
+#include "drivers/rtcCalendar.hpp"
+#include "drivers/rtcFormat.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace CEP_RTC
+{
+/*************************************************************************************************/
+/* Functions ----------------------------------------------------------------------------------- */
+//! Moves `time` forward by `seconds`, carrying into the minutes, hours, days, months and years.
+constexpr void AddSeconds(CivilTime& time, uint32_t seconds)
+{
+    uint32_t total = time.seconds + seconds;
+    time.seconds   = (uint8_t)(total % 60);
+    total          = time.minutes + (total / 60);
+    time.minutes   = (uint8_t)(total % 60);
+    total          = time.hours + (total / 60);
+    time.hours     = (uint8_t)(total % 24);
+
+    // Whole days, at most a handful between two syncs.
+    for (uint32_t days = total / 24; days != 0; days--)
+    {
+        if (time.day < DaysInMonth(time.year, time.month))
+        {
+            time.day++;
+            continue;
+        }
+        time.day = 1;
+        if (++time.month > 12)
+        {
+            time.month = 1;
+            time.year++;
+        }
+    }
+}
+
+/*************************************************************************************************/
+/* Classes ------------------------------------------------------------------------------------- */
+/**
+ * @brief   Formats the time as `YY-MM-DD HH:MM:SS.mmm`, from the last sync and the current tick.
+ *
+ * Not meant to be used from interrupts, except for @ref Invalidate.
+ */
+class TimestampCache
+{
+public:
+    //! Number of characters of a timestamp, without the terminating null.
+    static constexpr size_t LENGTH = 21;
+    //! Longest time between two syncs, in ticks of 1ms.
+    static constexpr uint32_t SYNC_PERIOD = 1000;
+
+    //! Sets the time as it was at `tick`.
+    void Sync(const CivilTime& time, uint32_t tick)
+    {
+        m_base        = time;
+        m_baseTick    = tick;
+        m_isFormatted = false;
+        m_isSynced.store(true, std::memory_order_relaxed);
+    }
+
+    //! Forces the next timestamp to sync first, after the RTC was set or its wakeup interrupt.
+    void Invalidate() { m_isSynced.store(false, std::memory_order_relaxed); }
+
+    [[nodiscard]] bool NeedsSync(uint32_t tick) const
+    {
+        return !m_isSynced.load(std::memory_order_relaxed) || ((tick - m_baseTick) >= SYNC_PERIOD);
+    }
+
+    /**
+     * @brief   Gets the timestamp of `tick`, which can't be before the last sync.
+     * @return  The text, valid until the next call.
+     */
+    const char* Format(uint32_t tick)
+    {
+        uint32_t elapsed = (tick - m_baseTick) + m_base.milliseconds;
+        uint32_t seconds = elapsed / 1000;
+        if (!m_isFormatted || (seconds != m_formattedSeconds))
+        {
+            CivilTime time = m_base;
+            AddSeconds(time, seconds);
+            WriteDateTime(time);
+            m_formattedSeconds = seconds;
+            m_isFormatted      = true;
+        }
+
+        WriteTriplet(&m_text[18], elapsed % 1000);
+        return m_text.data();
+    }
+
+private:
+    void WriteDateTime(const CivilTime& time)
+    {
+        FormatDate(time, &m_text[0], DATE_LENGTH + 1);
+        m_text[8] = ' ';
+        FormatTime(time, &m_text[9], TIME_LENGTH + 1);
+        m_text[17] = '.';
+    }
+
+private:
+    CivilTime         m_base;
+    uint32_t          m_baseTick = 0;
+    std::atomic<bool> m_isSynced = false;
+
+    //! Seconds since the sync that the date and time of the text are for.
+    uint32_t                     m_formattedSeconds = 0;
+    bool                         m_isFormatted      = false;
+    std::array<char, LENGTH + 1> m_text             = {"00-00-00 00:00:00.000"};
+};
+}    // namespace CEP_RTC
+
+#endif
+#endif
+/**
+ * @}
+ * @}
+ */
+/* ----- END OF FILE ----- */
@@ -0,0 +1,266 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the fixed-point ADC calibrations.
+ *
+ * @date 2021-11-23
+ *
+ ******************************************************************************
+ */
+#include "drivers/adcCalibration.hpp"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace CEP_ADC;
+
+//! One LSB of a Q16.16 value.
+static constexpr float Q16_LSB = 1.0f / 65536.0f;
+
+TEST(AdcCalibration, Q16Conversions)
+{
+    EXPECT_EQ(0x00010000, ToQ16(1.0f));
+    EXPECT_EQ(-0x00018000, ToQ16(-1.5f));
+    EXPECT_EQ(0, ToQ16(0.0f));
+    EXPECT_FLOAT_EQ(3.25f, ToFloat(ToQ16(3.25f)));
+}
+
+TEST(AdcCalibration, DefaultMatchesFloatConversion)
+{
+    ChannelCalibration cal;
+    EXPECT_TRUE(cal.IsLinear());
+    for (uint32_t raw = 0; raw <= 4095; raw++)
+    {
+        float expected = ((float)raw / 4095.0f) * 3.3f;
+        EXPECT_NEAR(expected, ToFloat(cal.Apply((uint16_t)raw)), 2 * Q16_LSB) << raw;
+    }
+}
+
+TEST(AdcCalibration, LinearFromPoints)
+{
+    // A 2.5V reference reads 3080 and the ground reads 12.
+    constexpr LinearCalibration cal = LinearCalibration::FromPoints(12, 0.0f, 3080, 2.5f);
+    EXPECT_NEAR(0.0f, ToFloat(cal.Apply(12)), 2 * Q16_LSB);
+    EXPECT_NEAR(2.5f, ToFloat(cal.Apply(3080)), 2 * Q16_LSB);
+    EXPECT_NEAR(1.25f, ToFloat(cal.Apply(1546)), 2 * Q16_LSB);
+    // Below the offset, the value goes negative.
+    EXPECT_LT(cal.Apply(0), 0);
+}
+
+TEST(AdcCalibration, LinearNegativeGain)
+{
+    LinearCalibration cal = LinearCalibration::FromFloat(-0.01f, 40.0f);
+    EXPECT_NEAR(40.0f, ToFloat(cal.Apply(0)), Q16_LSB);
+    EXPECT_NEAR(0.0f, ToFloat(cal.Apply(4000)), 4 * Q16_LSB);
+    EXPECT_NEAR(-0.95f, ToFloat(cal.Apply(4095)), 4 * Q16_LSB);
+}
+
+TEST(AdcCalibration, PiecewiseRejectsBadPoints)
+{
+    PiecewiseCalibration   table;
+    const CalibrationPoint one[]      = {{100, 1.0f}};
+    const CalibrationPoint unsorted[] = {{100, 1.0f}, {50, 2.0f}};
+    const CalibrationPoint twice[]    = {{100, 1.0f}, {100, 2.0f}};
+    const CalibrationPoint good[]     = {{0, 0.0f}, {4095, 3.3f}};
+    EXPECT_FALSE(table.Build(one, 1));
+    EXPECT_FALSE(table.Build(unsorted, 2));
+    EXPECT_FALSE(table.Build(twice, 2));
+    EXPECT_FALSE(table.Build(good, 2, 3));
+    EXPECT_FALSE(table.Build(good, 2, 17));
+    EXPECT_TRUE(table.Build(good, 2));
+}
+
+TEST(AdcCalibration, PiecewiseMatchesLinear)
+{
+    PiecewiseCalibration   table;
+    const CalibrationPoint points[] = {{0, 0.0f}, {4095, 3.3f}};
+    ASSERT_TRUE(table.Build(points, 2));
+
+    ChannelCalibration linear;
+    ChannelCalibration piecewise(&table);
+    EXPECT_FALSE(piecewise.IsLinear());
+    for (uint32_t raw = 0; raw <= 4095; raw++)
+    {
+        EXPECT_NEAR(ToFloat(linear.Apply((uint16_t)raw)),
+                    ToFloat(piecewise.Apply((uint16_t)raw)),
+                    4 * Q16_LSB)
+          << raw;
+    }
+}
+
+TEST(AdcCalibration, PiecewiseFollowsPoints)
+{
+    // A thermistor-like curve, with points that aren't on the segments' boundaries.
+    const CalibrationPoint points[] = {
+      {100, -20.0f}, {1000, 10.0f}, {2000, 25.0f}, {3000, 45.0f}, {3900, 90.0f}};
+    PiecewiseCalibration table;
+    ASSERT_TRUE(table.Build(points, std::size(points)));
+
+    // The points themselves are only exact when they fall on a breakpoint.
+    EXPECT_NEAR(25.0f, ToFloat(table.Apply(2048)), 1.0f);
+    EXPECT_NEAR(10.0f, ToFloat(table.Apply(1024)), 1.0f);
+    // Below the first point and above the last one, the curve is extrapolated.
+    EXPECT_LT(table.Apply(0), ToQ16(-20.0f));
+    EXPECT_GT(table.Apply(4095), ToQ16(90.0f));
+
+    // The curve is monotonic like the points.
+    for (uint32_t raw = 1; raw <= 4095; raw++)
+    {
+        EXPECT_GE(table.Apply((uint16_t)raw), table.Apply((uint16_t)(raw - 1))) << raw;
+    }
+}
+
+TEST(AdcCalibration, PiecewiseExactOnBreakpoints)
+{
+    // With 16-bit samples, the segments are 4096 wide.
+    const CalibrationPoint points[] = {{0, 0.0f}, {4096, 1.0f}, {8192, 3.0f}, {65535, 3.0f}};
+    PiecewiseCalibration   table;
+    ASSERT_TRUE(table.Build(points, std::size(points), 16));
+
+    EXPECT_EQ(ToQ16(0.0f), table.Apply(0));
+    EXPECT_EQ(ToQ16(1.0f), table.Apply(4096));
+    EXPECT_EQ(ToQ16(3.0f), table.Apply(8192));
+    EXPECT_EQ(ToQ16(0.5f), table.Apply(2048));
+    EXPECT_EQ(ToQ16(2.0f), table.Apply(6144));
+    EXPECT_EQ(ToQ16(3.0f), table.Apply(65535));
+}
+
+TEST(AdcCalibration, OversampledReadings)
+{
+    // 14-bit readings from a 12-bit calibration.
+    PiecewiseCalibration   table;
+    const CalibrationPoint points[] = {{0, 0.0f}, {2048, 1.0f}, {4095, 3.0f}};
+    ASSERT_TRUE(table.Build(points, std::size(points)));
+    const ChannelCalibration linear;
+    const ChannelCalibration piecewise(&table);
+
+    for (uint32_t raw = 0; raw < 4095; raw += 13)
+    {
+        EXPECT_EQ(linear.Apply((uint16_t)raw), linear.Apply((uint16_t)(raw * 4), 2)) << raw;
+        EXPECT_EQ(piecewise.Apply((uint16_t)raw), piecewise.Apply((uint16_t)(raw * 4), 2)) << raw;
+    }
+    // The extra bits fall between the readings.
+    EXPECT_NEAR(ToFloat(linear.Apply(2001 * 4 + 2, 2)),
+                (ToFloat(linear.Apply(2001)) + ToFloat(linear.Apply(2002))) / 2,
+                2 * Q16_LSB);
+}
+
+TEST(AdcCalibration, ConvertBlock)
+{
+    PiecewiseCalibration   table;
+    const CalibrationPoint points[] = {{0, 10.0f}, {4095, 20.0f}};
+    ASSERT_TRUE(table.Build(points, 2));
+
+    const ChannelCalibration cals[] = {
+      ChannelCalibration(),
+      ChannelCalibration(LinearCalibration::FromFloat(0.001f, -1.0f)),
+      ChannelCalibration(&table)};
+    constexpr size_t      FRAMES   = 5;
+    constexpr size_t      CHANNELS = 3;
+    std::vector<uint16_t> samples(FRAMES * CHANNELS);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        samples[i] = (uint16_t)(i * 271);
+    }
+    Block block;
+    block.samples  = samples.data();
+    block.frames   = FRAMES;
+    block.channels = CHANNELS;
+
+    std::vector<q16_t> values(samples.size());
+    std::vector<float> floats(samples.size());
+    ConvertBlock(block, cals, values.data());
+    ConvertBlock(block, cals, floats.data());
+
+    for (size_t f = 0; f < FRAMES; f++)
+    {
+        for (size_t c = 0; c < CHANNELS; c++)
+        {
+            size_t i = (f * CHANNELS) + c;
+            EXPECT_EQ(cals[c].Apply(block.Get(f, c)), values[i]) << f << ", " << c;
+            EXPECT_FLOAT_EQ(ToFloat(values[i]), floats[i]) << f << ", " << c;
+        }
+    }
+}
+
+/*************************************************************************************************/
+/* Benchmark ----------------------------------------------------------------------------------- */
+/**
+ * Compares the conversion of blocks of samples to volts in floating-point, the way the ADC module
+ * used to do it one sample at a time, with the fixed-point batch conversion.
+ *
+ * Only prints the results, the timings depend too much on the host to be asserted. Disabled so
+ * that it doesn't slow down the tests, run it with --gtest_also_run_disabled_tests.
+ */
+TEST(AdcCalibration, DISABLED_Benchmark)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t BLOCKS   = 20000;
+    constexpr size_t FRAMES   = 32;
+    constexpr size_t CHANNELS = 4;
+    constexpr size_t SAMPLES  = FRAMES * CHANNELS;
+
+    std::vector<uint16_t> samples(SAMPLES);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        samples[i] = (uint16_t)((i * 977) & 0x0FFF);
+    }
+    Block block;
+    block.samples  = samples.data();
+    block.frames   = FRAMES;
+    block.channels = CHANNELS;
+
+    std::vector<float> volts(SAMPLES);
+    auto               start = Clock::now();
+    for (size_t b = 0; b < BLOCKS; b++)
+    {
+        for (size_t i = 0; i < SAMPLES; i++)
+        {
+            volts[i] = ((static_cast<float>(samples[i]) / 4095.0f) * 3.3f);
+        }
+        samples[b % SAMPLES] ^= (uint16_t)(volts[b % SAMPLES] > 1.0f);
+    }
+    auto floatTime = Clock::now() - start;
+
+    const ChannelCalibration cals[CHANNELS] = {};
+    std::vector<q16_t>       values(SAMPLES);
+    start = Clock::now();
+    for (size_t b = 0; b < BLOCKS; b++)
+    {
+        ConvertBlock(block, cals, values.data());
+        samples[b % SAMPLES] ^= (uint16_t)(values[b % SAMPLES] > ToQ16(1.0f));
+    }
+    auto fixedTime = Clock::now() - start;
+
+    PiecewiseCalibration   table;
+    const CalibrationPoint points[] = {{0, 0.0f}, {2000, 1.5f}, {4095, 3.3f}};
+    table.Build(points, std::size(points));
+    const ChannelCalibration tables[CHANNELS] = {&table, &table, &table, &table};
+    start                                     = Clock::now();
+    for (size_t b = 0; b < BLOCKS; b++)
+    {
+        ConvertBlock(block, tables, values.data());
+        samples[b % SAMPLES] ^= (uint16_t)(values[b % SAMPLES] > ToQ16(1.0f));
+    }
+    auto tableTime = Clock::now() - start;
+
+    auto perSample = [](Clock::duration d)
+    {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() /
+               (BLOCKS * SAMPLES);
+    };
+    std::printf("[ BENCHMARK] float:     %.2f ns/sample\n", perSample(floatTime));
+    std::printf("[ BENCHMARK] linear:    %.2f ns/sample\n", perSample(fixedTime));
+    std::printf("[ BENCHMARK] piecewise: %.2f ns/sample\n", perSample(tableTime));
+
+    // Both paths agree on what they converted last.
+    for (size_t i = 0; i < SAMPLES; i++)
+    {
+        EXPECT_NEAR(((float)samples[i] / 4095.0f) * 3.3f,
+                    ToFloat(cals[i % CHANNELS].Apply(samples[i])),
+                    2 * Q16_LSB);
+    }
+}
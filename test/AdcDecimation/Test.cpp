@@ -0,0 +1,269 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the ADC's oversampling and decimation filters.
+ *
+ * @date 2021-11-24
+ *
+ ******************************************************************************
+ */
+#include "drivers/adcDecimation.hpp"
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <vector>
+
+using namespace CEP_ADC;
+
+static uint32_t NaiveSum(const uint16_t* samples, size_t stride, size_t count)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += samples[i * stride];
+    }
+    return sum;
+}
+
+TEST(AdcDecimation, SumSamplesMatchesNaiveSum)
+{
+    std::vector<uint16_t> samples(1000);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        samples[i] = (uint16_t)(((uint32_t)i * 2654435761U) >> 20);    // 12 bits.
+    }
+
+    // Every alignment and length around the unrolled and packed runs.
+    for (size_t stride : {1, 2, 3, 4})
+    {
+        for (size_t offset = 0; offset < 4; offset++)
+        {
+            for (size_t count = 0; count < 80; count++)
+            {
+                EXPECT_EQ(NaiveSum(samples.data() + offset, stride, count),
+                          SumSamples(samples.data() + offset, stride, count, 12))
+                  << stride << ", " << offset << ", " << count;
+            }
+        }
+    }
+}
+
+TEST(AdcDecimation, SumSamplesDoesNotCarryBetweenLanes)
+{
+    // Full-scale samples fill the lanes as much as they can take.
+    for (uint8_t bits : {8, 12, 14, 16})
+    {
+        std::vector<uint16_t> samples(4096, (uint16_t)((1UL << bits) - 1));
+        EXPECT_EQ(NaiveSum(samples.data(), 1, samples.size()),
+                  SumSamples(samples.data(), 1, samples.size(), bits))
+          << (int)bits;
+    }
+}
+
+TEST(AdcDecimation, RejectsBadConfig)
+{
+    Decimator        decimator;
+    DecimationConfig config;
+    EXPECT_FALSE(decimator.IsEnabled());
+    EXPECT_TRUE(decimator.Configure(config));
+    EXPECT_TRUE(decimator.IsEnabled());
+
+    DecimationConfig bad = config;
+    bad.order            = 0;
+    EXPECT_FALSE(decimator.Configure(bad));
+    EXPECT_FALSE(decimator.IsEnabled());
+
+    bad       = config;
+    bad.order = MAX_CIC_ORDER + 1;
+    EXPECT_FALSE(decimator.Configure(bad));
+
+    // More bits than a sample can hold.
+    bad           = config;
+    bad.extraBits = 5;
+    EXPECT_FALSE(decimator.Configure(bad));
+
+    // More bits than the filter gains.
+    bad           = config;
+    bad.ratioLog2 = 1;
+    EXPECT_FALSE(decimator.Configure(bad));
+
+    // The CIC's integrators would need more than 32 bits.
+    bad           = config;
+    bad.order     = 4;
+    bad.ratioLog2 = 6;
+    EXPECT_FALSE(decimator.Configure(bad));
+
+    const std::array<int16_t, MAX_FIR_TAPS + 1> taps = {};
+    bad                                              = config;
+    bad.fir                                          = taps;
+    EXPECT_FALSE(decimator.Configure(bad));
+}
+
+TEST(AdcDecimation, BoxcarGainsResolution)
+{
+    // A signal of 1000.25 LSB, dithered by the noise.
+    std::vector<uint16_t> samples(64);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        samples[i] = (i % 4) == 0 ? 1001 : 1000;
+    }
+
+    Decimator decimator;
+    ASSERT_TRUE(decimator.Configure({}));
+    std::vector<uint16_t> out(samples.size());
+    ASSERT_EQ(4, decimator.Process(samples.data(), 1, samples.size(), out.data()));
+    for (size_t i = 0; i < 4; i++)
+    {
+        // 14 bits: 1000.25 * 4.
+        EXPECT_EQ(4001, out[i]);
+    }
+    EXPECT_EQ(4001, decimator.GetLatest());
+}
+
+TEST(AdcDecimation, KeepsStateBetweenBlocks)
+{
+    std::vector<uint16_t> samples(1000);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        samples[i] = (uint16_t)(2048 + ((i * 37) % 301) - 150);
+    }
+
+    for (uint8_t order = 1; order <= MAX_CIC_ORDER; order++)
+    {
+        DecimationConfig config;
+        config.order     = order;
+        config.ratioLog2 = 3;
+        Decimator whole;
+        Decimator split;
+        ASSERT_TRUE(whole.Configure(config));
+        ASSERT_TRUE(split.Configure(config));
+
+        std::vector<uint16_t> expected(samples.size());
+        expected.resize(whole.Process(samples.data(), 1, samples.size(), expected.data()));
+
+        // Blocks whose sizes aren't multiples of the ratio.
+        std::vector<uint16_t> actual(samples.size());
+        size_t                produced = 0;
+        for (size_t at = 0, len = 1; at < samples.size(); at += len, len = (len * 3) % 17 + 1)
+        {
+            len = std::min(len, samples.size() - at);
+            produced += split.Process(samples.data() + at, 1, len, actual.data() + produced);
+        }
+        actual.resize(produced);
+
+        EXPECT_EQ(expected, actual) << (int)order;
+    }
+}
+
+TEST(AdcDecimation, CicSettlesOnDc)
+{
+    for (uint8_t order = 2; order <= MAX_CIC_ORDER; order++)
+    {
+        DecimationConfig config;
+        config.order     = order;
+        config.ratioLog2 = 4;
+        config.extraBits = 4;
+        Decimator decimator;
+        ASSERT_TRUE(decimator.Configure(config));
+
+        std::vector<uint16_t> samples(16 * 10, 4095);
+        std::vector<uint16_t> out(10);
+        ASSERT_EQ(10, decimator.Process(samples.data(), 1, samples.size(), out.data()));
+
+        // Ramps up during `order` outputs, then gives the full scale in 16 bits.
+        EXPECT_LT(out[0], 65520) << (int)order;
+        for (size_t i = order; i < out.size(); i++)
+        {
+            EXPECT_EQ(65520, out[i]) << (int)order << ", " << i;
+        }
+    }
+}
+
+TEST(AdcDecimation, CicWrapsAround)
+{
+    // Order 4 with a ratio of 32 needs all 32 bits, the integrators overflow many times.
+    DecimationConfig config;
+    config.order     = 4;
+    config.ratioLog2 = 5;
+    config.extraBits = 4;
+    Decimator decimator;
+    ASSERT_TRUE(decimator.Configure(config));
+
+    std::vector<uint16_t> samples(32 * 200, 3000);
+    std::vector<uint16_t> out(200);
+    ASSERT_EQ(200, decimator.Process(samples.data(), 1, samples.size(), out.data()));
+    EXPECT_EQ(48000, out.back());
+}
+
+TEST(AdcDecimation, StridedChannel)
+{
+    // Three channels, the second one is decimated.
+    constexpr size_t      FRAMES = 32;
+    std::vector<uint16_t> samples(FRAMES * 3);
+    for (size_t f = 0; f < FRAMES; f++)
+    {
+        samples[(f * 3) + 0] = 4095;
+        samples[(f * 3) + 1] = (uint16_t)(100 + f);
+        samples[(f * 3) + 2] = 0;
+    }
+    Block block;
+    block.samples  = samples.data();
+    block.frames   = FRAMES;
+    block.channels = 3;
+
+    DecimationConfig config;
+    config.extraBits = 0;
+    Decimator decimator;
+    ASSERT_TRUE(decimator.Configure(config));
+    std::array<uint16_t, 2> out = {};
+    ASSERT_EQ(2, decimator.Process(block, 1, out.data()));
+    // Averages of 100..115 and 116..131, rounded.
+    EXPECT_EQ(108, out[0]);
+    EXPECT_EQ(124, out[1]);
+}
+
+TEST(AdcDecimation, Fir)
+{
+    // Averages the last two outputs.
+    const std::array<int16_t, 2> taps = {16384, 16384};
+    DecimationConfig             config;
+    config.ratioLog2 = 2;
+    config.extraBits = 0;
+    config.fir       = taps;
+    Decimator decimator;
+    ASSERT_TRUE(decimator.Configure(config));
+
+    const std::vector<uint16_t> samples = {
+      100, 100, 100, 100, 300, 300, 300, 300, 300, 300, 300, 300};
+    std::array<uint16_t, 3> out = {};
+    ASSERT_EQ(3, decimator.Process(samples.data(), 1, samples.size(), out.data()));
+    EXPECT_EQ(50, out[0]);
+    EXPECT_EQ(200, out[1]);
+    EXPECT_EQ(300, out[2]);
+}
+
+TEST(AdcDecimation, FirOutputIsClamped)
+{
+    // Overshoots on a step, which must not wrap around.
+    const std::array<int16_t, 2> taps = {32767, -16384};
+    DecimationConfig             config;
+    config.ratioLog2 = 2;
+    config.extraBits = 0;
+    config.fir       = taps;
+    Decimator decimator;
+    ASSERT_TRUE(decimator.Configure(config));
+
+    std::vector<uint16_t> samples(8, 4000);
+    std::fill(samples.begin(), samples.begin() + 4, 0);
+    std::array<uint16_t, 2> out = {};
+    ASSERT_EQ(2, decimator.Process(samples.data(), 1, samples.size(), out.data()));
+    EXPECT_EQ(0, out[0]);
+    EXPECT_EQ(4000, out[1]);
+
+    // A falling step undershoots below 0.
+    std::vector<uint16_t> fall(8, 0);
+    std::fill(fall.begin(), fall.begin() + 4, 4095);
+    ASSERT_EQ(2, decimator.Process(fall.data(), 1, fall.size(), out.data()));
+    EXPECT_EQ(0, out[1]);
+}
@@ -0,0 +1,152 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the ADC stream's timing and double buffering.
+ *
+ * @date 2021-11-22
+ *
+ ******************************************************************************
+ */
+#include "drivers/adcStream.hpp"
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <vector>
+
+using namespace CEP_ADC;
+
+TEST(AdcStream, TriggerTimingExact)
+{
+    // 80MHz timer, 10kHz: 8000 ticks fit in the period.
+    TriggerTiming timing = ComputeTriggerTiming(80000000, 10000);
+    EXPECT_EQ(0, timing.prescaler);
+    EXPECT_EQ(7999, timing.period);
+    EXPECT_EQ(10000, timing.rate);
+}
+
+TEST(AdcStream, TriggerTimingNeedsPrescaler)
+{
+    // 80MHz timer, 100Hz: 800000 ticks, the prescaler must divide by at least 13.
+    TriggerTiming timing = ComputeTriggerTiming(80000000, 100);
+    EXPECT_EQ(12, timing.prescaler);
+    EXPECT_LE(timing.period, 0xFFFF);
+    EXPECT_EQ(100, timing.rate);
+
+    // A 32-bit timer doesn't need it.
+    timing = ComputeTriggerTiming(80000000, 100, 0xFFFFFFFF);
+    EXPECT_EQ(0, timing.prescaler);
+    EXPECT_EQ(799999, timing.period);
+}
+
+TEST(AdcStream, TriggerTimingRounds)
+{
+    // 80MHz / 48kHz = 1666.67 ticks, 1667 is the closest.
+    TriggerTiming timing = ComputeTriggerTiming(80000000, 48000);
+    EXPECT_EQ(1666, timing.period);
+    EXPECT_EQ(47990, timing.rate);
+}
+
+TEST(AdcStream, TriggerTimingOutOfReach)
+{
+    EXPECT_EQ(0, ComputeTriggerTiming(80000000, 0).rate);
+    EXPECT_EQ(0, ComputeTriggerTiming(1000, 2000).rate);
+    // Would need a prescaler above 65536 with an 8-bit period.
+    EXPECT_EQ(0, ComputeTriggerTiming(80000000, 1, 0xFF).rate);
+}
+
+class PingPongTest : public ::testing::Test
+{
+protected:
+    static constexpr size_t FRAMES   = 4;
+    static constexpr size_t CHANNELS = 3;
+
+    std::vector<uint16_t> buffer = std::vector<uint16_t>(2 * FRAMES * CHANNELS);
+    PingPong              pingPong;
+
+    void SetUp() override
+    {
+        std::iota(buffer.begin(), buffer.end(), 0);
+        pingPong.Reset(buffer.data(), FRAMES, CHANNELS);
+    }
+};
+
+TEST_F(PingPongTest, NothingBeforeTheFirstHalf)
+{
+    Block block;
+    EXPECT_EQ(buffer.size(), pingPong.GetBufferSize());
+    EXPECT_FALSE(pingPong.Acquire(block));
+    EXPECT_EQ(nullptr, pingPong.GetLatestFrame());
+}
+
+TEST_F(PingPongTest, HalvesAlternate)
+{
+    Block block;
+
+    pingPong.HandleHalfComplete();
+    ASSERT_TRUE(pingPong.Acquire(block));
+    EXPECT_EQ(buffer.data(), block.samples);
+    EXPECT_EQ(0, block.sequence);
+    EXPECT_EQ(FRAMES, block.frames);
+    EXPECT_EQ(CHANNELS, block.channels);
+    EXPECT_EQ(7, block.Get(2, 1));
+    EXPECT_TRUE(pingPong.Release());
+    EXPECT_FALSE(pingPong.Acquire(block));
+
+    pingPong.HandleComplete();
+    ASSERT_TRUE(pingPong.Acquire(block));
+    EXPECT_EQ(buffer.data() + (FRAMES * CHANNELS), block.samples);
+    EXPECT_EQ(1, block.sequence);
+    EXPECT_TRUE(pingPong.Release());
+
+    pingPong.HandleHalfComplete();
+    ASSERT_TRUE(pingPong.Acquire(block));
+    EXPECT_EQ(buffer.data(), block.samples);
+    EXPECT_TRUE(pingPong.Release());
+
+    EXPECT_EQ(0, pingPong.GetOverruns());
+}
+
+TEST_F(PingPongTest, LatestFrame)
+{
+    pingPong.HandleHalfComplete();
+    ASSERT_NE(nullptr, pingPong.GetLatestFrame());
+    EXPECT_EQ(9, pingPong.GetLatestFrame()[0]);
+
+    pingPong.HandleComplete();
+    EXPECT_EQ(21, pingPong.GetLatestFrame()[0]);
+    EXPECT_EQ(23, pingPong.GetLatestFrame()[2]);
+}
+
+TEST_F(PingPongTest, MissedBlocksAreOverruns)
+{
+    Block block;
+
+    pingPong.HandleHalfComplete();
+    pingPong.HandleComplete();
+    pingPong.HandleHalfComplete();
+
+    // Only the last one can still be used.
+    ASSERT_TRUE(pingPong.Acquire(block));
+    EXPECT_EQ(2, block.sequence);
+    EXPECT_EQ(buffer.data(), block.samples);
+    EXPECT_EQ(2, pingPong.GetOverruns());
+}
+
+TEST_F(PingPongTest, SlowConsumerIsDetected)
+{
+    Block block;
+
+    pingPong.HandleHalfComplete();
+    ASSERT_TRUE(pingPong.Acquire(block));
+    // The other half completes while the block is being processed.
+    pingPong.HandleComplete();
+    EXPECT_FALSE(pingPong.Release());
+    EXPECT_EQ(1, pingPong.GetOverruns());
+
+    // The next block is still delivered.
+    ASSERT_TRUE(pingPong.Acquire(block));
+    EXPECT_EQ(1, block.sequence);
+    EXPECT_TRUE(pingPong.Release());
+    EXPECT_EQ(1, pingPong.GetOverruns());
+}
@@ -0,0 +1,31 @@
+/**
+ ******************************************************************************
+ * @file    SingleWatchdog.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the watchdog table of the ADCs with a single analog watchdog (F4, F7).
+ *
+ * @date 2021-11-25
+ *
+ ******************************************************************************
+ */
+#include "drivers/adcWatchdog.hpp"
+#include <gtest/gtest.h>
+
+using namespace CEP_ADC;
+
+static_assert(WATCHDOG_COUNT == 1);
+
+TEST(AdcSingleWatchdog, Assign)
+{
+    WatchdogTable table;
+    EXPECT_EQ(NO_CHANNEL, table.GetChannel(0));
+
+    table.Reset(12);
+    EXPECT_EQ(0, table.Assign(4, {1001, 1999}));
+    EXPECT_EQ((Window {1001, 1999}), table.GetWindow(0));
+    EXPECT_EQ(NO_WATCHDOG, table.Assign(5, {0, 100}));
+
+    table.Release(4);
+    EXPECT_EQ(0, table.Assign(5, {0, 100}));
+    EXPECT_EQ(5, table.GetChannel(0));
+}
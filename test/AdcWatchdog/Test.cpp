@@ -0,0 +1,116 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the assignment of the ADC's analog watchdogs.
+ *
+ * @date 2021-11-25
+ *
+ ******************************************************************************
+ */
+#include "drivers/adcWatchdog.hpp"
+#include <gtest/gtest.h>
+
+using namespace CEP_ADC;
+
+TEST(AdcWatchdog, WindowContains)
+{
+    constexpr Window window = {1000, 2000};
+    EXPECT_FALSE(window.Contains(999));
+    EXPECT_TRUE(window.Contains(1000));
+    EXPECT_TRUE(window.Contains(2000));
+    EXPECT_FALSE(window.Contains(2001));
+    EXPECT_TRUE(Window().Contains(0));
+    EXPECT_TRUE(Window().Contains(0xFFFF));
+}
+
+TEST(AdcWatchdog, EffectiveWindow)
+{
+    EXPECT_EQ(8, GetWatchdogPrecision(1, 12));
+    EXPECT_EQ(12, GetWatchdogPrecision(0, 12));
+    EXPECT_EQ(6, GetWatchdogPrecision(2, 6));
+
+    // 8 bits out of 12: multiples of 16.
+    EXPECT_EQ((Window {992, 2015}), GetEffectiveWindow({1000, 2000}, 8, 12));
+    EXPECT_EQ((Window {1008, 2031}), GetEffectiveWindow({1008, 2031}, 8, 12));
+    EXPECT_EQ((Window {1000, 2000}), GetEffectiveWindow({1000, 2000}, 12, 12));
+}
+
+TEST(AdcWatchdog, PreciseWatchdogForPreciseWindows)
+{
+    WatchdogTable table;
+    table.Reset(12);
+
+    // Exact at 8 bits, gets a coarse watchdog.
+    EXPECT_EQ(2, table.Assign(4, {1008, 2031}));
+    // Needs every bit.
+    EXPECT_EQ(0, table.Assign(1, {1000, 2000}));
+    EXPECT_EQ((Window {1000, 2000}), table.GetWindow(0));
+    // Needs every bit too, but the precise one is taken: widened.
+    EXPECT_EQ(1, table.Assign(7, {1001, 1999}));
+    EXPECT_EQ((Window {992, 1999}), table.GetWindow(1));
+    // All in use.
+    EXPECT_EQ(NO_WATCHDOG, table.Assign(3, {0, 100}));
+
+    EXPECT_EQ(0, table.Find(1));
+    EXPECT_EQ(1, table.Find(7));
+    EXPECT_EQ(2, table.Find(4));
+    EXPECT_EQ(NO_WATCHDOG, table.Find(3));
+    EXPECT_EQ(4, table.GetChannel(2));
+}
+
+TEST(AdcWatchdog, ChannelKeepsItsWatchdog)
+{
+    WatchdogTable table;
+    table.Reset(12);
+    EXPECT_EQ(0, table.Assign(1, {1000, 2000}));
+    EXPECT_EQ(0, table.Assign(1, {0, 4095}));
+    EXPECT_EQ((Window {0, 4095}), table.GetWindow(0));
+
+    table.Release(1);
+    EXPECT_EQ(NO_WATCHDOG, table.Find(1));
+    EXPECT_EQ(NO_CHANNEL, table.GetChannel(0));
+    EXPECT_EQ(0, table.Assign(2, {1, 2}));
+}
+
+TEST(AdcWatchdog, TripAndRearm)
+{
+    WatchdogTable table;
+    table.Reset(12);
+
+    // Unused watchdogs are ignored.
+    EXPECT_EQ(NO_CHANNEL, table.Trip(0));
+    EXPECT_FALSE(table.IsTripped(0));
+
+    ASSERT_EQ(0, table.Assign(5, {1000, 2000}));
+    EXPECT_FALSE(table.Rearm(0, 1500));
+
+    EXPECT_EQ(5, table.Trip(0));
+    EXPECT_TRUE(table.IsTripped(0));
+    // Still outside.
+    EXPECT_FALSE(table.Rearm(0, 2500));
+    EXPECT_TRUE(table.IsTripped(0));
+    // Back inside.
+    EXPECT_TRUE(table.Rearm(0, 2000));
+    EXPECT_FALSE(table.IsTripped(0));
+
+    // Changing the window or releasing the channel clears the watchdog.
+    table.Trip(0);
+    table.Assign(5, {0, 100});
+    EXPECT_FALSE(table.IsTripped(0));
+    table.Trip(0);
+    table.Release(5);
+    EXPECT_FALSE(table.IsTripped(0));
+}
+
+TEST(AdcWatchdog, RearmUsesEffectiveWindow)
+{
+    WatchdogTable table;
+    table.Reset(12);
+    ASSERT_EQ(0, table.Assign(0, {1, 4094}));
+    ASSERT_EQ(1, table.Assign(1, {1000, 2000}));
+
+    // The watchdog only trips above 2015, 2010 is inside as far as it is concerned.
+    table.Trip(1);
+    EXPECT_TRUE(table.Rearm(1, 2010));
+}
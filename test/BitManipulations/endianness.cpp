@@ -0,0 +1,54 @@
+/**
+ ******************************************************************************
+ * @file    endianness.cpp
+ * @author  Samuel Martel
+ * @brief
+ *
+ * @date 2021-11-18
+ *
+ ******************************************************************************
+ */
+#include "defines/bitManipulations.hpp"
+#include <gtest/gtest.h>
+
+using namespace cep;
+
+TEST(BitManipulation, ToBytes)
+{
+    uint8_t b[4] = {};
+
+    toBytes<Endianness::Big>(uint32_t(0x11223344), &b[0]);
+    EXPECT_EQ(0x11, b[0]);
+    EXPECT_EQ(0x44, b[3]);
+
+    toBytes<Endianness::Little>(uint32_t(0x11223344), &b[0]);
+    EXPECT_EQ(0x44, b[0]);
+    EXPECT_EQ(0x11, b[3]);
+}
+
+TEST(BitManipulation, FromBytes)
+{
+    uint8_t b[2] = {0xFF, 0x38};
+
+    EXPECT_EQ(0xFF38, (fromBytes<Endianness::Big, uint16_t>(&b[0])));
+    EXPECT_EQ(0x38FF, (fromBytes<Endianness::Little, uint16_t>(&b[0])));
+    // Signed values are sign-extended.
+    EXPECT_EQ(-200, (fromBytes<Endianness::Big, int16_t>(&b[0])));
+}
+
+TEST(BitManipulation, BytesRoundTrip)
+{
+    constexpr int64_t v    = -0x0123456789ABCDEF;
+    uint8_t           b[8] = {};
+
+    toBytes<Endianness::Big>(v, &b[0]);
+    EXPECT_EQ(v, (fromBytes<Endianness::Big, int64_t>(&b[0])));
+    toBytes<Endianness::Little>(v, &b[0]);
+    EXPECT_EQ(v, (fromBytes<Endianness::Little, int64_t>(&b[0])));
+
+    static_assert([]() {
+        uint8_t c[2] = {};
+        toBytes<Endianness::Big>(uint16_t(0xABCD), &c[0]);
+        return fromBytes<Endianness::Big, uint16_t>(&c[0]);
+    }() == 0xABCD);
+}
@@ -0,0 +1,156 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests for the CAN filter bank planner.
+ *
+ * @date 2021-11-08
+ *
+ ******************************************************************************
+ */
+#include "drivers/canFilterPlanner.hpp"
+#include <gtest/gtest.h>
+
+#include <set>
+
+using namespace CEP_CAN;
+
+/**
+ * Does what the bxCAN does with a received standard data frame.
+ */
+static bool IsAccepted(const std::vector<PlannedBank>& banks, uint32_t id, bool extended)
+{
+    uint32_t r32 = extended ? ((id << 3) | 0x04) : (id << 21);
+    uint16_t r16 = extended ? 0xFFFF : (uint16_t)(id << 5);
+
+    for (const auto& b : banks)
+    {
+        if (b.is16Bit)
+        {
+            if (extended)
+            {
+                continue;
+            }
+            uint16_t a = b.fr1 & 0xFFFF, c = b.fr1 >> 16, d = b.fr2 & 0xFFFF, e = b.fr2 >> 16;
+            if (b.isList)
+            {
+                if (r16 == a || r16 == c || r16 == d || r16 == e)
+                {
+                    return true;
+                }
+            }
+            else if ((((r16 ^ a) & c) == 0) || (((r16 ^ d) & e) == 0))
+            {
+                return true;
+            }
+        }
+        else if (b.isList)
+        {
+            if (r32 == b.fr1 || r32 == b.fr2)
+            {
+                return true;
+            }
+        }
+        else if (((r32 ^ b.fr1) & b.fr2) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST(CanFilterPlanner, Empty)
+{
+    FilterPlanner planner;
+    FilterPlan    plan = planner.Plan(14);
+
+    EXPECT_TRUE(plan.banks.empty());
+    EXPECT_TRUE(plan.IsExact());
+}
+
+TEST(CanFilterPlanner, StandardIdsInLists)
+{
+    FilterPlanner planner;
+    std::set<uint32_t> ids = {0x001, 0x123, 0x456, 0x7FF, 0x080};
+    for (auto id : ids)
+    {
+        planner.AddId(id);
+    }
+
+    FilterPlan plan = planner.Plan(14, 3);
+    ASSERT_EQ(2, plan.banks.size());
+    EXPECT_EQ(3, plan.banks[0].bank);
+    EXPECT_TRUE(plan.IsExact());
+    EXPECT_EQ(5, plan.subscribedIds);
+
+    for (uint32_t id = 0; id <= FilterPlanner::STD_ID_MAX; id++)
+    {
+        EXPECT_EQ(ids.count(id) == 1, IsAccepted(plan.banks, id, false)) << "ID 0x" << std::hex << id;
+    }
+}
+
+TEST(CanFilterPlanner, RangeUsesMasks)
+{
+    FilterPlanner planner;
+    planner.AddRange(0x100, 0x1FF);
+    planner.AddRange(0x200, 0x203);
+
+    FilterPlan plan = planner.Plan(14);
+    // Both ranges are adjacent and merge into 0x100-0x203: 0x100/8 + 0x200/2 -> one bank.
+    ASSERT_EQ(1, plan.banks.size());
+    EXPECT_FALSE(plan.banks[0].isList);
+    EXPECT_TRUE(plan.banks[0].is16Bit);
+    EXPECT_TRUE(plan.IsExact());
+
+    for (uint32_t id = 0; id <= FilterPlanner::STD_ID_MAX; id++)
+    {
+        EXPECT_EQ(id >= 0x100 && id <= 0x203, IsAccepted(plan.banks, id, false));
+    }
+}
+
+TEST(CanFilterPlanner, MixedStandardAndExtended)
+{
+    FilterPlanner planner;
+    planner.AddId(0x010);
+    planner.AddId(0x12345678, true);
+
+    FilterPlan plan = planner.Plan(14);
+    // The standard ID fits in the free slot of the extended list.
+    ASSERT_EQ(1, plan.banks.size());
+    EXPECT_TRUE(IsAccepted(plan.banks, 0x010, false));
+    EXPECT_TRUE(IsAccepted(plan.banks, 0x12345678, true));
+    EXPECT_FALSE(IsAccepted(plan.banks, 0x12345679, true));
+    EXPECT_FALSE(IsAccepted(plan.banks, 0x011, false));
+    EXPECT_FALSE(IsAccepted(plan.banks, 0x010, true));
+}
+
+TEST(CanFilterPlanner, MergesWhenOverBudget)
+{
+    FilterPlanner planner;
+    std::set<uint32_t> ids;
+    for (uint32_t i = 0; i < 12; i++)
+    {
+        ids.insert(0x300 + i * 3);
+        planner.AddId(0x300 + i * 3);
+    }
+
+    EXPECT_EQ(3, planner.Plan(14).banks.size());
+
+    FilterPlan plan = planner.Plan(1);
+    ASSERT_EQ(1, plan.banks.size());
+    EXPECT_FALSE(plan.IsExact());
+    EXPECT_GT(plan.GetFalsePositiveRate(), 0.0f);
+    EXPECT_LT(plan.GetFalsePositiveRate(), 1.0f);
+
+    size_t accepted = 0;
+    for (uint32_t id = 0; id <= FilterPlanner::STD_ID_MAX; id++)
+    {
+        bool isAccepted = IsAccepted(plan.banks, id, false);
+        accepted += isAccepted ? 1 : 0;
+        if (ids.count(id) == 1)
+        {
+            EXPECT_TRUE(isAccepted) << "Subscribed ID 0x" << std::hex << id << " was rejected";
+        }
+    }
+    EXPECT_EQ(plan.acceptedIds, accepted);
+}
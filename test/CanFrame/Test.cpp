@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests for CEP_CAN::CompactFrame.
+ *
+ * @date 2021-11-12
+ *
+ ******************************************************************************
+ */
+#include "drivers/canFrame.hpp"
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace CEP_CAN;
+
+TEST(CanFrame, Size)
+{
+    EXPECT_EQ(16, sizeof(CompactFrame));
+}
+
+TEST(CanFrame, StandardFrame)
+{
+    uint8_t      payload[] = {0x11, 0x22, 0x33};
+    CompactFrame f         = CompactFrame::Make(0x123, false, false, payload, 3, 1000);
+
+    EXPECT_EQ(0x123, f.GetId());
+    EXPECT_FALSE(f.IsExtended());
+    EXPECT_FALSE(f.IsRemote());
+    EXPECT_EQ(3, f.GetDlc());
+    EXPECT_EQ(1000, f.GetTimestamp());
+    EXPECT_EQ(0x332211, f.data);
+    EXPECT_EQ(0x22, f.GetByte(1));
+    EXPECT_EQ(0x00, f.GetByte(3));
+}
+
+TEST(CanFrame, ExtendedRemoteFrame)
+{
+    CompactFrame f = CompactFrame::Make(0x1ABCDEF0, true, true, nullptr, 0);
+
+    EXPECT_EQ(0x1ABCDEF0, f.GetId());
+    EXPECT_TRUE(f.IsExtended());
+    EXPECT_TRUE(f.IsRemote());
+    EXPECT_EQ(0, f.GetDlc());
+    EXPECT_EQ(0, f.data);
+}
+
+TEST(CanFrame, LimitsAreEnforced)
+{
+    uint8_t payload[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+
+    // Standard IDs are 11 bits, payloads are 8 bytes.
+    CompactFrame f = CompactFrame::Make(0xFFFF, false, false, payload, sizeof(payload));
+    EXPECT_EQ(0x7FF, f.GetId());
+    EXPECT_EQ(8, f.GetDlc());
+    EXPECT_EQ(0x0807060504030201, f.data);
+
+    // The timestamp wraps around on 28 bits without touching the DLC.
+    f.SetTimestamp(0xFFFFFFFF);
+    EXPECT_EQ(0x0FFFFFFF, f.GetTimestamp());
+    EXPECT_EQ(8, f.GetDlc());
+}
+
+TEST(CanFrame, Compare)
+{
+    uint8_t      payload[] = {0xDE, 0xAD, 0xBE, 0xEF};
+    CompactFrame a         = CompactFrame::Make(0x42, false, false, payload, 4, 10);
+    CompactFrame b         = CompactFrame::Make(0x42, false, false, payload, 4, 20);
+
+    EXPECT_EQ(a, b) << "Timestamp should be ignored";
+
+    EXPECT_NE(a, CompactFrame::Make(0x43, false, false, payload, 4));
+    EXPECT_NE(a, CompactFrame::Make(0x42, true, false, payload, 4));
+    EXPECT_NE(a, CompactFrame::Make(0x42, false, false, payload, 3));
+
+    uint8_t out[8] = {};
+    a.CopyData(out);
+    EXPECT_EQ(0, memcmp(payload, out, sizeof(payload)));
+    EXPECT_EQ(0, out[4]);
+}
@@ -0,0 +1,173 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests for the CAN log writer and replay engine.
+ *
+ * @date 2021-11-15
+ *
+ ******************************************************************************
+ */
+#include "services/canLog.hpp"
+#include "test/Mocks/CAN/simulatedCanModule.h"
+#include <gtest/gtest.h>
+
+using namespace CEP_CAN;
+
+namespace
+{
+using Buffer = LogBuffer<1>;
+
+//! Does what CanRecorder does, with a vector as the file.
+void WriteReady(Buffer& buffer, std::vector<uint8_t>& file)
+{
+    const CompactFrame* ready = buffer.GetReadyBuffer();
+    if (ready != nullptr)
+    {
+        auto* bytes = reinterpret_cast<const uint8_t*>(ready);
+        file.insert(file.end(), bytes, bytes + Buffer::BUFFER_SIZE);
+        buffer.ReleaseReadyBuffer();
+    }
+}
+
+void WriteLast(Buffer& buffer, std::vector<uint8_t>& file)
+{
+    WriteReady(buffer, file);
+    size_t len   = 0;
+    auto*  bytes = reinterpret_cast<const uint8_t*>(buffer.Finish(len));
+    file.insert(file.end(), bytes, bytes + len);
+}
+
+CompactFrame MakeFrame(uint32_t id, uint32_t timestamp)
+{
+    uint8_t payload[] = {(uint8_t)id, (uint8_t)(id >> 8)};
+    return CompactFrame::Make(id, false, false, payload, sizeof(payload), timestamp);
+}
+}    // namespace
+
+TEST(CanLog, EmptyLogIsOneSector)
+{
+    Buffer               buffer;
+    std::vector<uint8_t> file;
+    buffer.Begin(1234);
+    WriteLast(buffer, file);
+
+    ASSERT_EQ(LOG_SECTOR_SIZE, file.size());
+
+    LogReplay replay(file);
+    ASSERT_TRUE(replay.IsValid());
+    EXPECT_EQ(1234, replay.GetHeader().startTick);
+    EXPECT_EQ(0, replay.GetFrameCount());
+    EXPECT_TRUE(replay.IsDone());
+}
+
+TEST(CanLog, InvalidLog)
+{
+    EXPECT_FALSE(LogReplay({}).IsValid());
+    EXPECT_FALSE(LogReplay(std::vector<uint8_t>(LOG_SECTOR_SIZE, 0)).IsValid());
+}
+
+TEST(CanLog, SectorAlignedRoundTrip)
+{
+    Buffer               buffer;
+    std::vector<uint8_t> file;
+    buffer.Begin(0);
+
+    // Enough frames to fill a few buffers.
+    constexpr uint32_t count = 100;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        ASSERT_TRUE(buffer.Push(MakeFrame(i, i * 10), (i % 2) == 0));
+        WriteReady(buffer, file);
+        EXPECT_EQ(0, file.size() % LOG_SECTOR_SIZE);
+    }
+    WriteLast(buffer, file);
+    EXPECT_EQ(0, file.size() % LOG_SECTOR_SIZE);
+
+    LogReplay replay(file);
+    ASSERT_TRUE(replay.IsValid());
+    ASSERT_EQ(count, replay.GetFrameCount());
+    EXPECT_EQ((count - 1) * 10, replay.GetDuration());
+
+    uint32_t i = 0;
+    replay.Start(0, 0.0f);
+    replay.Step(0,
+                [&i](const CompactFrame& frame, bool tx)
+                {
+                    EXPECT_EQ(MakeFrame(i, 0), frame);
+                    EXPECT_EQ(i * 10, frame.GetTimestamp());
+                    EXPECT_EQ((i % 2) == 0, tx);
+                    i++;
+                });
+    EXPECT_EQ(count, i);
+    EXPECT_TRUE(replay.IsDone());
+}
+
+TEST(CanLog, DropsWhenNotFlushed)
+{
+    Buffer buffer;
+    buffer.Begin(0);
+
+    // The header takes one record. Fill both buffers without ever writing them.
+    size_t accepted = 0;
+    for (size_t i = 0; i < 3 * Buffer::RECORDS_PER_BUFFER; i++)
+    {
+        accepted += buffer.Push(MakeFrame(1, 0), false) ? 1 : 0;
+    }
+
+    EXPECT_EQ(2 * Buffer::RECORDS_PER_BUFFER - 1, accepted);
+    EXPECT_EQ(3 * Buffer::RECORDS_PER_BUFFER - accepted, buffer.GetDropped());
+}
+
+TEST(CanLog, ReplayIntoSimulatedModule)
+{
+    Buffer               buffer;
+    std::vector<uint8_t> file;
+    buffer.Begin(0);
+    // Timestamps close to the 28-bit wrap-around.
+    uint32_t base = CompactFrame::TIMESTAMP_MASK - 15;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        buffer.Push(MakeFrame(0x100 + i, base + (i * 10)), false);
+    }
+    buffer.Push(MakeFrame(0x200, base + 40), true);
+    WriteLast(buffer, file);
+
+    LogReplay replay(file);
+    ASSERT_TRUE(replay.IsValid());
+    EXPECT_EQ(40, replay.GetDuration());
+
+    SimulatedCanModule can;
+    auto               sink = [&can](const CompactFrame& frame, bool tx)
+    {
+        if (tx)
+        {
+            can.TransmitFrame(frame);
+        }
+        else
+        {
+            can.Inject(frame);
+        }
+    };
+
+    // Twice as fast: 10ms of log per 5ms of replay.
+    replay.Start(1000, 2.0f);
+    EXPECT_EQ(1, replay.Step(1000, sink));
+    EXPECT_EQ(0, replay.Step(1004, sink));
+    EXPECT_EQ(1, replay.Step(1005, sink));
+    EXPECT_EQ(2, replay.Step(1015, sink));
+    EXPECT_EQ(4, can.GetNumberOfAvailableFrames());
+    EXPECT_TRUE(can.GetTransmitted().empty());
+
+    EXPECT_EQ(1, replay.Step(1020, sink));
+    EXPECT_TRUE(replay.IsDone());
+    ASSERT_EQ(1, can.GetTransmitted().size());
+    EXPECT_EQ(0x200, can.GetTransmitted()[0].GetId());
+
+    CompactFrame frame;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(can.ReceiveFrame(frame));
+        EXPECT_EQ(0x100 + i, frame.GetId());
+    }
+}
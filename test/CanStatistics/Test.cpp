@@ -0,0 +1,80 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests for the CAN statistics.
+ *
+ * @date 2021-11-11
+ *
+ ******************************************************************************
+ */
+#include "drivers/canStatistics.hpp"
+#include <gtest/gtest.h>
+
+using namespace CEP_CAN;
+
+TEST(CanStatistics, FrameBits)
+{
+    // Worst case lengths, interframe space included.
+    EXPECT_EQ(55, EstimateFrameBits(false, 0));
+    EXPECT_EQ(135, EstimateFrameBits(false, 8));
+    EXPECT_EQ(80, EstimateFrameBits(true, 0));
+    EXPECT_EQ(160, EstimateFrameBits(true, 8));
+    // DLC is capped at 8 bytes.
+    EXPECT_EQ(EstimateFrameBits(false, 8), EstimateFrameBits(false, 15));
+}
+
+TEST(CanStatistics, HistogramBins)
+{
+    EXPECT_EQ(0, LatencyHistogram::GetBin(0));
+    EXPECT_EQ(0, LatencyHistogram::GetBin(1));
+    EXPECT_EQ(1, LatencyHistogram::GetBin(2));
+    EXPECT_EQ(1, LatencyHistogram::GetBin(3));
+    EXPECT_EQ(8, LatencyHistogram::GetBin(256));
+    EXPECT_EQ(LatencyHistogram::BIN_COUNT - 1, LatencyHistogram::GetBin(UINT32_MAX));
+}
+
+TEST(CanStatistics, HistogramPercentile)
+{
+    LatencyHistogram h;
+    EXPECT_EQ(0, h.GetPercentile(0.5f));
+
+    for (int i = 0; i < 90; i++)
+    {
+        h.Add(100);
+    }
+    for (int i = 0; i < 10; i++)
+    {
+        h.Add(1000);
+    }
+
+    EXPECT_EQ(100, h.count);
+    EXPECT_EQ(100, h.min);
+    EXPECT_EQ(1000, h.max);
+    EXPECT_FLOAT_EQ(190.0f, h.GetAverage());
+    // 100us is in [64, 128), 1000us is in [512, 1024).
+    EXPECT_EQ(128, h.GetPercentile(0.5f));
+    EXPECT_EQ(128, h.GetPercentile(0.9f));
+    EXPECT_EQ(1000, h.GetPercentile(0.99f));
+}
+
+TEST(CanStatistics, Rates)
+{
+    Statistics s;
+    for (int i = 0; i < 100; i++)
+    {
+        s.CountRx(false, 8);
+        s.CountTx(true, 0);
+    }
+
+    s.UpdateRates(500, 500000);
+    EXPECT_FLOAT_EQ(200.0f, s.rxFramesPerSecond);
+    EXPECT_FLOAT_EQ(200.0f, s.txFramesPerSecond);
+    EXPECT_FLOAT_EQ((100.0f * 135.0f + 100.0f * 80.0f) / 250000.0f, s.busLoad);
+
+    // Nothing happened during the next period.
+    s.UpdateRates(1000, 500000);
+    EXPECT_FLOAT_EQ(0.0f, s.rxFramesPerSecond);
+    EXPECT_FLOAT_EQ(0.0f, s.busLoad);
+    EXPECT_EQ(100, s.rxFrames);
+}
@@ -0,0 +1,73 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests for CEP_I2C::Inventory.
+ *
+ * @date 2021-11-19
+ *
+ ******************************************************************************
+ */
+#include "drivers/i2cInventory.hpp"
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace CEP_I2C;
+
+TEST(I2cInventory, Empty)
+{
+    Inventory inventory;
+
+    EXPECT_FALSE(inventory.IsComplete());
+    EXPECT_EQ(0, inventory.Count());
+    EXPECT_FALSE(inventory.Contains(0x40));
+    EXPECT_EQ(Inventory::NO_DEVICE, inventory.Find(Inventory::FIRST_ADDRESS, Inventory::LAST_ADDRESS));
+}
+
+TEST(I2cInventory, AddAndFind)
+{
+    Inventory inventory;
+    inventory.Add(0x44);
+    inventory.Add(0x4E);
+    inventory.Add(0xA0);
+    inventory.Complete(3);
+
+    EXPECT_TRUE(inventory.IsComplete());
+    EXPECT_EQ(3, inventory.GetDuration());
+    EXPECT_EQ(3, inventory.Count());
+    EXPECT_TRUE(inventory.Contains(0x44));
+    // The read/write bit is ignored.
+    EXPECT_TRUE(inventory.Contains(0x45));
+    EXPECT_FALSE(inventory.Contains(0x42));
+
+    EXPECT_EQ(0x44, inventory.Find(0x40, 0x4E));
+    EXPECT_EQ(0x4E, inventory.Find(0x40, 0x4E, 1));
+    EXPECT_EQ(Inventory::NO_DEVICE, inventory.Find(0x40, 0x4E, 2));
+    EXPECT_EQ(0x4E, inventory.Find(0x46, 0x4E));
+    EXPECT_EQ(0xA0, inventory.Find(0xA0, 0xAE));
+    EXPECT_EQ(Inventory::NO_DEVICE, inventory.Find(0x10, 0x3E));
+}
+
+TEST(I2cInventory, ForEachInOrder)
+{
+    Inventory inventory;
+    inventory.Add(Inventory::LAST_ADDRESS);
+    inventory.Add(0x90);
+    inventory.Add(Inventory::FIRST_ADDRESS);
+
+    std::vector<uint8_t> found;
+    inventory.ForEach([&](uint8_t address) { found.push_back(address); });
+    EXPECT_EQ(std::vector<uint8_t>({0x10, 0x90, 0xEE}), found);
+}
+
+TEST(I2cInventory, Clear)
+{
+    Inventory inventory;
+    inventory.Add(0x40);
+    inventory.Complete(1);
+    inventory.Clear();
+
+    EXPECT_FALSE(inventory.IsComplete());
+    EXPECT_EQ(0, inventory.Count());
+}
@@ -0,0 +1,209 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the paged I2C memory transfers.
+ *
+ * @date 2021-11-19
+ *
+ ******************************************************************************
+ */
+#include "drivers/i2cMemory.hpp"
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+using namespace CEP_I2C;
+
+/*************************************************************************************************/
+/* Mocked memory ------------------------------------------------------------------------------- */
+/**
+ * Behaves like a 24xx EEPROM: writes wrap around within their page and the device doesn't
+ * acknowledge anything while a page is being written.
+ *
+ * Time only moves forward when the port is asked for it.
+ */
+struct MockEeprom
+{
+    static constexpr uint8_t DEVICE = 0xA0;
+
+    MemoryLayout         layout;
+    std::vector<uint8_t> memory;
+
+    uint32_t tick       = 0;
+    uint32_t busyUntil  = 0;
+    size_t   writes     = 0;
+    size_t   reads      = 0;
+    size_t   nacks      = 0;
+    bool     failWrites = false;
+
+    MockEeprom(size_t size, size_t pageSize, uint8_t addressSize)
+    : memory(size, 0xFF)
+    {
+        layout.pageSize       = pageSize;
+        layout.addressSize    = addressSize;
+        layout.writeCycleTime = 5;
+    }
+
+    uint32_t GetTick() { return tick++; }
+
+    size_t Locate(uint8_t device, uint16_t address) const
+    {
+        uint32_t block = (uint32_t)((device & 0x0E) >> 1);
+        return (size_t)((block << (8 * layout.addressSize)) | address);
+    }
+
+    MemoryAccess Write(uint8_t device, uint16_t address, const uint8_t* data, size_t len)
+    {
+        if (tick < busyUntil)
+        {
+            nacks++;
+            return MemoryAccess::Busy;
+        }
+        if (failWrites)
+        {
+            return MemoryAccess::Failed;
+        }
+
+        size_t start = Locate(device, address);
+        size_t page  = start - (start % layout.pageSize);
+        for (size_t i = 0; i < len; i++)
+        {
+            memory[page + ((start - page + i) % layout.pageSize)] = data[i];
+        }
+        writes++;
+        busyUntil = tick + 3;
+        return MemoryAccess::Done;
+    }
+
+    MemoryAccess Read(uint8_t device, uint16_t address, uint8_t* data, size_t len)
+    {
+        if (tick < busyUntil)
+        {
+            nacks++;
+            return MemoryAccess::Busy;
+        }
+
+        size_t start = Locate(device, address);
+        std::memcpy(data, &memory[start], len);
+        reads++;
+        return MemoryAccess::Done;
+    }
+};
+
+static std::vector<uint8_t> MakeImage(size_t size)
+{
+    std::vector<uint8_t> image(size);
+    std::iota(image.begin(), image.end(), (uint8_t)7);
+    return image;
+}
+
+/*************************************************************************************************/
+/* Tests --------------------------------------------------------------------------------------- */
+TEST(I2cMemory, ChunkSize)
+{
+    EXPECT_EQ(64, GetChunkSize(0, 100, 64));
+    EXPECT_EQ(4, GetChunkSize(60, 100, 64));
+    EXPECT_EQ(3, GetChunkSize(60, 3, 64));
+    EXPECT_EQ(64, GetChunkSize(128, 64, 64));
+    EXPECT_EQ(1, GetChunkSize(255, 10, 256));
+}
+
+TEST(I2cMemory, BlockAddress)
+{
+    EXPECT_EQ(0xA0, GetBlockAddress(0xA0, 0x00FF, 1));
+    EXPECT_EQ(0xA2, GetBlockAddress(0xA0, 0x0100, 1));
+    EXPECT_EQ(0xAE, GetBlockAddress(0xA0, 0x07FF, 1));
+    EXPECT_EQ(0xA0, GetBlockAddress(0xA0, 0xFFFF, 2));
+    EXPECT_EQ(0xA2, GetBlockAddress(0xA0, 0x10000, 2));
+    EXPECT_EQ(256, GetBlockSize(1));
+    EXPECT_EQ(65536, GetBlockSize(2));
+}
+
+TEST(I2cMemory, WholeImageRoundTrip)
+{
+    // 24C256: 32 KiB, 64-byte pages, 16-bit addresses.
+    MockEeprom           eeprom(32768, 64, 2);
+    std::vector<uint8_t> image = MakeImage(eeprom.memory.size());
+
+    ASSERT_TRUE(WriteMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 0, image));
+    EXPECT_EQ(32768 / 64, eeprom.writes);
+    EXPECT_EQ(image, eeprom.memory);
+
+    std::vector<uint8_t> readBack(image.size());
+    ASSERT_TRUE(ReadMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 0, readBack));
+    EXPECT_EQ(1, eeprom.reads);
+    EXPECT_EQ(image, readBack);
+}
+
+TEST(I2cMemory, UnalignedWriteDoesntWrap)
+{
+    MockEeprom           eeprom(1024, 16, 2);
+    std::vector<uint8_t> data = MakeImage(40);
+
+    ASSERT_TRUE(WriteMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 10, data));
+    // 6 bytes to the end of the first page, two full pages, then 2 bytes.
+    EXPECT_EQ(4, eeprom.writes);
+    EXPECT_EQ(0xFF, eeprom.memory[9]);
+    EXPECT_EQ(0, std::memcmp(&eeprom.memory[10], data.data(), data.size()));
+    EXPECT_EQ(0xFF, eeprom.memory[50]);
+}
+
+TEST(I2cMemory, BlocksAreSelectedByTheDeviceAddress)
+{
+    // 24C16: 2 KiB in 8 blocks of 256 bytes, 16-byte pages, 8-bit addresses.
+    MockEeprom           eeprom(2048, 16, 1);
+    std::vector<uint8_t> image = MakeImage(eeprom.memory.size());
+
+    ASSERT_TRUE(WriteMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 0, image));
+    EXPECT_EQ(image, eeprom.memory);
+
+    std::vector<uint8_t> readBack(image.size());
+    ASSERT_TRUE(ReadMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 0, readBack));
+    // A read can't cross a block.
+    EXPECT_EQ(8, eeprom.reads);
+    EXPECT_EQ(image, readBack);
+}
+
+TEST(I2cMemory, WriteCycleIsPolled)
+{
+    MockEeprom           eeprom(256, 8, 1);
+    std::vector<uint8_t> data = MakeImage(16);
+
+    ASSERT_TRUE(WriteMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 0, data));
+    // The second page is retried until the first one is written, but the write cycle of the
+    // last page is left running.
+    EXPECT_NE(0, eeprom.nacks);
+    EXPECT_GT(eeprom.busyUntil, eeprom.tick);
+
+    // The read waits for it.
+    size_t               nacks = eeprom.nacks;
+    std::vector<uint8_t> readBack(16);
+    ASSERT_TRUE(ReadMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 0, readBack));
+    EXPECT_GT(eeprom.nacks, nacks);
+    EXPECT_EQ(data, readBack);
+}
+
+TEST(I2cMemory, BusyForTooLong)
+{
+    MockEeprom eeprom(256, 8, 1);
+    eeprom.busyUntil = 1000;
+    uint8_t byte     = 0;
+
+    EXPECT_FALSE(WriteMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 0, {&byte, 1}));
+    EXPECT_FALSE(ReadMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 0, {&byte, 1}));
+    EXPECT_LT(eeprom.tick, 20);
+}
+
+TEST(I2cMemory, FailureStopsTheWrite)
+{
+    MockEeprom           eeprom(256, 8, 1);
+    std::vector<uint8_t> data = MakeImage(32);
+    eeprom.failWrites         = true;
+
+    EXPECT_FALSE(WriteMemory(eeprom, MockEeprom::DEVICE, eeprom.layout, 0, data));
+    EXPECT_EQ(0, eeprom.writes);
+    EXPECT_EQ(0, eeprom.nacks);
+}
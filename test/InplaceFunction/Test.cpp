@@ -0,0 +1,91 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests for cep::InplaceFunction.
+ *
+ * @date 2021-11-09
+ *
+ ******************************************************************************
+ */
+#include "defines/inplaceFunction.hpp"
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+
+using namespace cep;
+
+TEST(InplaceFunction, Empty)
+{
+    InplaceFunction<void()> f;
+    EXPECT_FALSE(f);
+
+    InplaceFunction<void()> g = nullptr;
+    EXPECT_FALSE(g);
+}
+
+TEST(InplaceFunction, CallsLambda)
+{
+    int                     calls = 0;
+    InplaceFunction<void()> f     = [&calls]() { calls++; };
+    ASSERT_TRUE(f);
+
+    f();
+    f();
+    EXPECT_EQ(2, calls);
+}
+
+TEST(InplaceFunction, ForwardsArgumentsAndReturn)
+{
+    int                              offset = 10;
+    InplaceFunction<int(int, int)> f      = [offset](int a, int b) { return a + b + offset; };
+
+    EXPECT_EQ(13, f(1, 2));
+}
+
+TEST(InplaceFunction, HoldsStdFunction)
+{
+    int                     calls = 0;
+    std::function<void()>   stdF  = [&calls]() { calls++; };
+    InplaceFunction<void()> f     = stdF;
+
+    f();
+    EXPECT_EQ(1, calls);
+}
+
+TEST(InplaceFunction, CopyAndMove)
+{
+    int                     calls = 0;
+    InplaceFunction<void()> f     = [&calls]() { calls++; };
+
+    InplaceFunction<void()> copy = f;
+    copy();
+    f();
+    EXPECT_EQ(2, calls);
+
+    InplaceFunction<void()> moved = std::move(f);
+    EXPECT_FALSE(f);
+    moved();
+    EXPECT_EQ(3, calls);
+
+    f = copy;
+    f();
+    EXPECT_EQ(4, calls);
+}
+
+TEST(InplaceFunction, DestroysCallable)
+{
+    auto shared = std::make_shared<int>(0);
+    {
+        InplaceFunction<void()> f = [shared]() { (*shared)++; };
+        EXPECT_EQ(2, shared.use_count());
+
+        InplaceFunction<void()> copy = f;
+        EXPECT_EQ(3, shared.use_count());
+
+        f = nullptr;
+        EXPECT_EQ(2, shared.use_count());
+    }
+    EXPECT_EQ(1, shared.use_count());
+}
@@ -0,0 +1,239 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the decoding of captured edges and of their statistics.
+ *
+ * @date 2021-11-28
+ *
+ ******************************************************************************
+ */
+#include "drivers/inputCapture.hpp"
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace CAPTURE;
+
+/**
+ * Timer whose counter wraps around at `max`, capturing a signal into two circular buffers like
+ * the DMA would.
+ */
+struct FakeCapture
+{
+    explicit FakeCapture(size_t size, uint32_t max = 0xFFFF)
+    : max(max), riseBuffer(size, 0), fallBuffer(size, 0)
+    {
+        rises.Reset(riseBuffer.data(), size);
+        falls.Reset(fallBuffer.data(), size);
+        decoder.Reset(max);
+    }
+
+    //! Generates one period, starting at the current time.
+    void AddPeriod(uint32_t period, uint32_t high)
+    {
+        Write(riseBuffer, risePos, rises, time);
+        Write(fallBuffer, fallPos, falls, time + high);
+        time += period;
+    }
+
+    std::vector<Measurement> Process()
+    {
+        rises.Update([this]() { return risePos; });
+        falls.Update([this]() { return fallPos; });
+        std::vector<Measurement> out;
+        decoder.Process(rises, falls, [&out](const Measurement& m) { out.push_back(m); });
+        return out;
+    }
+
+    void Write(std::vector<uint32_t>& buffer, size_t& pos, EdgeRing& ring, uint64_t t)
+    {
+        buffer[pos] = (uint32_t)(t & max);
+        if (++pos == buffer.size())
+        {
+            pos = 0;
+            ring.HandleComplete();
+        }
+    }
+
+    uint32_t              max;
+    uint64_t              time = 12345;
+    std::vector<uint32_t> riseBuffer;
+    std::vector<uint32_t> fallBuffer;
+    size_t                risePos = 0;
+    size_t                fallPos = 0;
+    EdgeRing              rises;
+    EdgeRing              falls;
+    EdgeDecoder           decoder;
+};
+
+TEST(InputCapture, MeasuresPeriods)
+{
+    FakeCapture capture(16);
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        capture.AddPeriod(1000 + i, 250 + i);
+    }
+
+    // The last period isn't closed yet, the one before needs the last falling edge to be known.
+    std::vector<Measurement> measured = capture.Process();
+    ASSERT_EQ(9, measured.size());
+    for (uint32_t i = 0; i < measured.size(); i++)
+    {
+        EXPECT_EQ(1000 + i, measured[i].period);
+        EXPECT_EQ(250 + i, measured[i].high);
+    }
+    EXPECT_EQ(0, capture.decoder.GetMissed());
+    EXPECT_EQ(0, capture.rises.GetOverruns());
+}
+
+TEST(InputCapture, CounterWrapsAround)
+{
+    // 40 periods of 3000 ticks wrap the 16-bit counter, and the buffers, a few times.
+    FakeCapture              capture(8);
+    std::vector<Measurement> measured;
+    for (uint32_t i = 0; i < 40; i++)
+    {
+        capture.AddPeriod(3000, 2999);
+        std::vector<Measurement> out = capture.Process();
+        measured.insert(measured.end(), out.begin(), out.end());
+    }
+
+    ASSERT_EQ(39, measured.size());
+    for (const Measurement& m : measured)
+    {
+        EXPECT_EQ(3000, m.period);
+        EXPECT_EQ(2999, m.high);
+    }
+    EXPECT_EQ(0, capture.rises.GetOverruns());
+    EXPECT_EQ(0, capture.falls.GetOverruns());
+}
+
+TEST(InputCapture, StartsWithFallingEdge)
+{
+    FakeCapture capture(16);
+    // The capture starts while the signal is high.
+    capture.Write(capture.fallBuffer, capture.fallPos, capture.falls, capture.time);
+    capture.time += 500;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        capture.AddPeriod(800, 100);
+    }
+
+    std::vector<Measurement> measured = capture.Process();
+    ASSERT_EQ(3, measured.size());
+    EXPECT_EQ(800, measured[0].period);
+    EXPECT_EQ(100, measured[0].high);
+}
+
+TEST(InputCapture, WaitsForBothPolarities)
+{
+    FakeCapture capture(16);
+    capture.AddPeriod(1000, 500);
+    capture.AddPeriod(1000, 500);
+    // The second rising edge is only consumed once the falling edge after it is known.
+    capture.Write(capture.riseBuffer, capture.risePos, capture.rises, capture.time);
+    EXPECT_EQ(1, capture.Process().size());
+    EXPECT_EQ(0, capture.Process().size());
+
+    capture.Write(capture.fallBuffer, capture.fallPos, capture.falls, capture.time + 500);
+    EXPECT_EQ(1, capture.Process().size());
+}
+
+TEST(InputCapture, Overruns)
+{
+    FakeCapture capture(8);
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        capture.AddPeriod(1000, 400);
+    }
+
+    // Only the last 8 edges of each polarity are still there.
+    std::vector<Measurement> measured = capture.Process();
+    EXPECT_EQ(12, capture.rises.GetOverruns());
+    EXPECT_EQ(12, capture.falls.GetOverruns());
+    ASSERT_EQ(7, measured.size());
+    EXPECT_EQ(1000, measured[0].period);
+}
+
+TEST(InputCapture, InterruptNotHandledYet)
+{
+    FakeCapture capture(8);
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        capture.AddPeriod(1000, 400);
+    }
+    EXPECT_EQ(5, capture.Process().size());
+
+    // The DMA wrapped around, but the interrupt is still pending.
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        capture.riseBuffer[capture.risePos] = (uint32_t)(capture.time & capture.max);
+        capture.fallBuffer[capture.fallPos] = (uint32_t)((capture.time + 400) & capture.max);
+        capture.risePos = (capture.risePos + 1) % 8;
+        capture.fallPos = (capture.fallPos + 1) % 8;
+        capture.time += 1000;
+    }
+    EXPECT_EQ(4, capture.Process().size());
+    EXPECT_EQ(0, capture.rises.GetOverruns());
+}
+
+TEST(InputCapture, MissingFallingEdge)
+{
+    FakeCapture capture(16);
+    capture.AddPeriod(1000, 500);
+    // A rising edge without a falling edge.
+    capture.Write(capture.riseBuffer, capture.risePos, capture.rises, capture.time);
+    capture.time += 1000;
+    capture.AddPeriod(1000, 500);
+    capture.AddPeriod(1000, 500);
+
+    std::vector<Measurement> measured = capture.Process();
+    EXPECT_EQ(2, measured.size());
+    EXPECT_EQ(1, capture.decoder.GetMissed());
+}
+
+TEST(InputCapture, Statistics)
+{
+    WindowStatistics windows;
+    windows.Reset(4, 1000000);
+
+    EXPECT_FALSE(windows.Add({1000, 250}));
+    EXPECT_FALSE(windows.Add({1002, 501}));
+    EXPECT_FALSE(windows.Add({998, 499}));
+    EXPECT_TRUE(windows.Add({1000, 750}));
+
+    const Statistics& stats = windows.GetLatest();
+    EXPECT_EQ(4, stats.count);
+    EXPECT_EQ(998, stats.minPeriod);
+    EXPECT_EQ(1002, stats.maxPeriod);
+    EXPECT_FLOAT_EQ(1000.0f, stats.meanPeriod);
+    // Deviations of 0, 2, -2 and 0.
+    EXPECT_FLOAT_EQ(std::sqrt(2.0f), stats.jitter);
+    EXPECT_FLOAT_EQ(25.0f, stats.minDuty);
+    EXPECT_FLOAT_EQ(75.0f, stats.maxDuty);
+    EXPECT_FLOAT_EQ(50.0f, stats.meanDuty);
+    EXPECT_FLOAT_EQ(1000.0f, stats.GetFrequency());
+    EXPECT_FLOAT_EQ(1000.0f, stats.ToMicroseconds(stats.meanPeriod));
+
+    // The next window starts from scratch.
+    EXPECT_FALSE(windows.Add({2000, 0}));
+    EXPECT_FALSE(windows.Add({2000, 0}));
+    EXPECT_FALSE(windows.Add({2000, 0}));
+    EXPECT_TRUE(windows.Add({2000, 0}));
+    EXPECT_EQ(2000, windows.GetLatest().minPeriod);
+    EXPECT_FLOAT_EQ(0.0f, windows.GetLatest().jitter);
+    EXPECT_FLOAT_EQ(0.0f, windows.GetLatest().maxDuty);
+}
+
+TEST(InputCapture, StatisticsOfLongPeriods)
+{
+    // Periods of a 32-bit timer, the sum of whose squares wouldn't fit in 64 bits.
+    WindowStatistics windows;
+    windows.Reset(2, 80000000);
+    windows.Add({4000000000, 1000000000});
+    EXPECT_TRUE(windows.Add({4000000010, 3000000000}));
+    EXPECT_FLOAT_EQ(4000000005.0f, windows.GetLatest().meanPeriod);
+    EXPECT_FLOAT_EQ(5.0f, windows.GetLatest().jitter);
+    EXPECT_FLOAT_EQ(50.0f, windows.GetLatest().meanDuty);
+}
@@ -0,0 +1,42 @@
+/**
+******************************************************************************
+* @file    simulatedCanModule.h
+* @author  Samuel Martel
+* @brief   Host-side stand-in for CanModule, fed by a replayed log.
+*
+* @date 2021/11/15
+*
+******************************************************************************
+*/
+#ifndef GUARD_SIMULATED_CAN_MODULE_H
+#define GUARD_SIMULATED_CAN_MODULE_H
+
+#include "defines/ringBuffer.hpp"
+#include "drivers/canFrame.hpp"
+
+#include <vector>
+
+/**
+ * Exposes the same frame API as CanModule. Frames injected with Inject are read back with
+ * ReceiveFrame, frames sent with TransmitFrame are kept in GetTransmitted.
+ */
+class SimulatedCanModule
+{
+public:
+    static constexpr size_t RX_RING_SIZE = 32;
+
+    size_t GetNumberOfAvailableFrames() const { return m_rxFrames.Size(); }
+    bool   ReceiveFrame(CEP_CAN::CompactFrame& frame) { return m_rxFrames.Pop(frame); }
+    void   TransmitFrame(const CEP_CAN::CompactFrame& frame) { m_transmitted.push_back(frame); }
+
+    //! Simulates the reception of a frame. Returns false if the frame is dropped.
+    bool Inject(const CEP_CAN::CompactFrame& frame) { return m_rxFrames.Push(frame); }
+
+    const std::vector<CEP_CAN::CompactFrame>& GetTransmitted() const { return m_transmitted; }
+
+private:
+    cep::RingBuffer<CEP_CAN::CompactFrame, RX_RING_SIZE> m_rxFrames;
+    std::vector<CEP_CAN::CompactFrame>                    m_transmitted;
+};
+
+#endif    // GUARD_SIMULATED_CAN_MODULE_H
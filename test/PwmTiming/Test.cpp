@@ -0,0 +1,268 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the PWM's prescaler and period solver, pulse placement and dead time.
+ *
+ * @date 2021-11-26
+ *
+ ******************************************************************************
+ */
+#include "drivers/pwmTiming.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+using namespace PWM;
+
+static constexpr uint32_t CLOCK = 80000000;
+
+//! Reference: tries every prescaler, like the PWM module used to.
+static Timing SearchTiming(uint32_t clock, uint64_t hz, uint32_t maxPeriod = 0xFFFF)
+{
+    Timing timing;
+    for (uint64_t psc = 0; psc <= 0xFFFF; psc++)
+    {
+        uint64_t count = (((uint64_t)clock * 2 / (hz * (psc + 1))) + 1) / 2;
+        if ((count != 0) && (count - 1 <= maxPeriod))
+        {
+            timing.prescaler = (uint32_t)psc;
+            timing.period    = (uint32_t)(count - 1);
+            timing.frequency = 1;
+            return timing;
+        }
+    }
+    return timing;
+}
+
+//! Reference: the smallest divisor of `clock / hz` leaving a 16-bit period, if there is one.
+static Timing WalkDivisors(uint32_t clock, uint64_t hz)
+{
+    Timing   timing;
+    uint64_t ticks = clock / hz;
+    for (uint64_t divider = 1; divider <= 0x10000; divider++)
+    {
+        if (((ticks % divider) == 0) && ((ticks / divider) <= 0x10000))
+        {
+            timing.prescaler = (uint32_t)(divider - 1);
+            timing.period    = (uint32_t)((ticks / divider) - 1);
+            timing.frequency = (uint32_t)hz;
+            return timing;
+        }
+    }
+    return timing;
+}
+
+static double GetFrequency(uint32_t clock, const Timing& timing)
+{
+    return (double)clock / (((double)timing.prescaler + 1) * ((double)timing.period + 1));
+}
+
+TEST(PwmTiming, InvalidFrequencies)
+{
+    EXPECT_EQ(0, SolveTiming(CLOCK, 0).frequency);
+    EXPECT_EQ(0, SolveTiming(CLOCK, (uint64_t)CLOCK + 1).frequency);
+    // Below clock / 2^32.
+    EXPECT_EQ(0, SolveTiming(CLOCK, 1, FitMode::Nearest, 0xFFFF, 0xFF).frequency);
+    EXPECT_EQ(0, SolveTiming(CLOCK, 1, FitMode::Exact, 0xFFFF, 0xFF).frequency);
+}
+
+TEST(PwmTiming, NearestUsesSmallestPrescaler)
+{
+    Timing timing = SolveTiming(CLOCK, 20000);
+    EXPECT_EQ(0, timing.prescaler);
+    EXPECT_EQ(3999, timing.period);
+    EXPECT_EQ(20000, timing.frequency);
+
+    timing = SolveTiming(CLOCK, 1000);
+    EXPECT_EQ(1, timing.prescaler);
+    EXPECT_EQ(39999, timing.period);
+    EXPECT_EQ(1000, timing.frequency);
+
+    // A 32-bit timer doesn't need a prescaler.
+    timing = SolveTiming(CLOCK, 1, FitMode::Nearest, 0xFFFFFFFF);
+    EXPECT_EQ(0, timing.prescaler);
+    EXPECT_EQ(CLOCK - 1, timing.period);
+}
+
+TEST(PwmTiming, NearestMatchesSearch)
+{
+    for (uint64_t hz = 2; hz < CLOCK; hz = (hz * 13) / 10 + 1)
+    {
+        Timing solved   = SolveTiming(CLOCK, hz);
+        Timing searched = SearchTiming(CLOCK, hz);
+        ASSERT_NE(0, solved.frequency) << hz;
+        EXPECT_EQ(searched.prescaler, solved.prescaler) << hz;
+        // Rounding the total number of ticks first can be one count off.
+        EXPECT_LE(std::abs((int64_t)searched.period - (int64_t)solved.period), 1) << hz;
+
+        // Within half a count of the requested frequency.
+        double actual = GetFrequency(CLOCK, solved);
+        double step   = actual / ((double)solved.period + 1);
+        EXPECT_LE(std::abs(actual - (double)hz), step) << hz;
+        EXPECT_LE(solved.period, 0xFFFFu) << hz;
+    }
+}
+
+TEST(PwmTiming, Exact)
+{
+    // 80MHz / 3kHz isn't an integer.
+    EXPECT_EQ(0, SolveTiming(CLOCK, 3000, FitMode::Exact).frequency);
+    EXPECT_NE(0, SolveTiming(CLOCK, 3000, FitMode::Nearest).frequency);
+
+    // 80MHz / 7Hz isn't either, 80MHz / 5Hz needs a prescaler of at least 245.
+    EXPECT_EQ(0, SolveTiming(CLOCK, 7, FitMode::Exact).frequency);
+    Timing timing = SolveTiming(CLOCK, 5, FitMode::Exact);
+    EXPECT_EQ(5, timing.frequency);
+    EXPECT_EQ(16000000u, (timing.prescaler + 1) * (timing.period + 1));
+    EXPECT_EQ(249, timing.prescaler);
+
+    // 65.537MHz / 1Hz is 1000 * 65537, which no prescaler splits into a 16-bit period.
+    EXPECT_EQ(0, SolveTiming(65537000, 1, FitMode::Exact).frequency);
+
+    for (uint32_t clock : {CLOCK, 65537000u})
+    {
+        for (uint64_t hz : {1, 2, 3, 5, 7, 16, 50, 64, 100, 125, 256, 1000, 1001, 1024, 3000,
+                            4096, 20000, 31250, 40000, 65536, 65537, 78125, 100000, 1250000,
+                            40000000, 80000000})
+        {
+            timing = SolveTiming(clock, hz, FitMode::Exact);
+            if ((clock % hz) != 0)
+            {
+                EXPECT_EQ(0, timing.frequency) << clock << ", " << hz;
+                continue;
+            }
+
+            Timing walked = WalkDivisors(clock, hz);
+            EXPECT_EQ(walked.frequency, timing.frequency) << clock << ", " << hz;
+            EXPECT_EQ(walked.prescaler, timing.prescaler) << clock << ", " << hz;
+            EXPECT_EQ(walked.period, timing.period) << clock << ", " << hz;
+        }
+    }
+}
+
+TEST(PwmTiming, CacheRemembersLastFrequencies)
+{
+    TimingCache<2> cache;
+    EXPECT_EQ(SolveTiming(CLOCK, 1000).period, cache.Solve(CLOCK, 1000).period);
+    EXPECT_EQ(1, cache.GetMisses());
+    cache.Solve(CLOCK, 1000);
+    EXPECT_EQ(1, cache.GetMisses());
+
+    cache.Solve(CLOCK, 2000);
+    EXPECT_EQ(2, cache.GetMisses());
+    // 1000 was used last, 2000 is replaced.
+    cache.Solve(CLOCK, 1000);
+    cache.Solve(CLOCK, 3000);
+    EXPECT_EQ(3, cache.GetMisses());
+    cache.Solve(CLOCK, 1000);
+    EXPECT_EQ(3, cache.GetMisses());
+    cache.Solve(CLOCK, 2000);
+    EXPECT_EQ(4, cache.GetMisses());
+
+    // Every parameter is part of the key.
+    cache.Solve(CLOCK / 2, 2000);
+    cache.Solve(CLOCK, 2000, FitMode::Exact);
+    cache.Solve(CLOCK, 2000, FitMode::Exact, 0xFFFFFFFF);
+    EXPECT_EQ(7, cache.GetMisses());
+    EXPECT_EQ(SolveTiming(CLOCK, 2000, FitMode::Exact, 0xFFFFFFFF).period,
+              cache.Solve(CLOCK, 2000, FitMode::Exact, 0xFFFFFFFF).period);
+    EXPECT_EQ(7, cache.GetMisses());
+
+    cache.Clear();
+    cache.Solve(CLOCK, 2000, FitMode::Exact, 0xFFFFFFFF);
+    EXPECT_EQ(8, cache.GetMisses());
+}
+
+TEST(PwmTiming, DutyToCompare)
+{
+    EXPECT_EQ(0, DutyToCompare(3999, 0));
+    EXPECT_EQ(1000, DutyToCompare(3999, 25));
+    EXPECT_EQ(2000, DutyToCompare(3999, 50));
+    // Always active, even on the last tick of the period.
+    EXPECT_EQ(4000, DutyToCompare(3999, 100));
+    EXPECT_EQ(4000, DutyToCompare(3999, 250));
+    // Rounded to the nearest tick.
+    EXPECT_EQ(2, DutyToCompare(9, 15));
+    EXPECT_EQ(0x80000000, DutyToCompare(0xFFFFFFFF, 50));
+    EXPECT_EQ(0xFFFFFFFF, DutyToCompare(0xFFFFFFFE, 100));
+    EXPECT_EQ(0xFFFFFFFF, DutyToCompare(0xFFFFFFFF, 100));
+}
+
+//! Output of a channel pair in combined PWM mode at tick `cnt` of the period.
+static bool IsActive(const Pulse& pulse, uint32_t cnt)
+{
+    // Combined PWM mode 1 ORs PWM mode 1 with PWM mode 2, combined PWM mode 2 ANDs them.
+    return pulse.wraps ? ((cnt < pulse.first) || (cnt >= pulse.second))
+                       : ((cnt >= pulse.first) && (cnt < pulse.second));
+}
+
+TEST(PwmTiming, PlacePulse)
+{
+    constexpr uint32_t PERIOD = 19;
+    for (uint32_t start = 0; start <= PERIOD; start++)
+    {
+        for (uint32_t width = 0; width <= PERIOD + 1; width++)
+        {
+            Pulse pulse = PlacePulse(PERIOD, start, width);
+            for (uint32_t cnt = 0; cnt <= PERIOD; cnt++)
+            {
+                // Ticks since the start of the pulse, modulo the period.
+                uint32_t elapsed = (cnt + PERIOD + 1 - start) % (PERIOD + 1);
+                ASSERT_EQ(elapsed < width, IsActive(pulse, cnt))
+                  << "start " << start << ", width " << width << ", cnt " << cnt;
+            }
+        }
+    }
+
+    Pulse pulse = PlacePulse(3999, 3000, 2000);
+    EXPECT_TRUE(pulse.wraps);
+    EXPECT_EQ(1000, pulse.first);
+    EXPECT_EQ(3000, pulse.second);
+
+    // Ends with the period of a 32-bit timer.
+    pulse = PlacePulse(0xFFFFFFFF, 0x80000000, 0x80000000);
+    EXPECT_TRUE(pulse.wraps);
+    EXPECT_EQ(0, pulse.first);
+    EXPECT_EQ(0x80000000, pulse.second);
+    EXPECT_TRUE(IsActive(pulse, 0xFFFFFFFF));
+    EXPECT_FALSE(IsActive(pulse, 0x7FFFFFFF));
+}
+
+TEST(PwmTiming, PhaseToTicks)
+{
+    EXPECT_EQ(0, PhaseToTicks(3999, 0));
+    EXPECT_EQ(1000, PhaseToTicks(3999, 90));
+    EXPECT_EQ(2000, PhaseToTicks(3999, 180));
+    EXPECT_EQ(0, PhaseToTicks(3999, 360));
+    EXPECT_EQ(1000, PhaseToTicks(3999, 450));
+    // Rounded to the nearest tick, 120 degrees of 10 ticks being 3.33 ticks.
+    EXPECT_EQ(3, PhaseToTicks(9, 120));
+    EXPECT_EQ(7, PhaseToTicks(9, 240));
+}
+
+TEST(PwmTiming, DeadTime)
+{
+    // 80MHz, 12.5ns per tick.
+    EXPECT_EQ(0, EncodeDeadTime(CLOCK, 0));
+    EXPECT_EQ(8, EncodeDeadTime(CLOCK, 100));
+    // Rounded up to the next tick.
+    EXPECT_EQ(9, EncodeDeadTime(CLOCK, 101));
+    EXPECT_EQ(127, EncodeDeadTime(CLOCK, 1587));
+    EXPECT_EQ(0x80 | 0, EncodeDeadTime(CLOCK, 1588));
+    EXPECT_EQ(0x80 | 36, EncodeDeadTime(CLOCK, 2500));
+    EXPECT_EQ(0xC0 | 18, EncodeDeadTime(CLOCK, 5000));
+    EXPECT_EQ(0xE0 | 18, EncodeDeadTime(CLOCK, 10000));
+    // Clamped to the longest dead time.
+    EXPECT_EQ(0xFF, EncodeDeadTime(CLOCK, 100000));
+
+    // Every dead time is at least the one requested, and less than a step longer.
+    for (uint32_t ticks = 0; ticks <= 1008; ticks++)
+    {
+        uint32_t actual = DecodeDeadTime(EncodeDeadTime(1000000000, ticks));
+        uint32_t step   = ticks <= 127 ? 1 : ticks <= 254 ? 2 : ticks <= 504 ? 8 : 16;
+        ASSERT_GE(actual, ticks);
+        ASSERT_LT(actual - ticks, step);
+    }
+    EXPECT_EQ(1008, DecodeDeadTime(0xFF));
+}
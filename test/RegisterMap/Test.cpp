@@ -0,0 +1,177 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests for cep::RegisterMap.
+ *
+ * @date 2021-11-18
+ *
+ ******************************************************************************
+ */
+#include "defines/registerMap.hpp"
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <vector>
+
+using namespace cep;
+
+/**
+ * Records the bursts written by a flush.
+ */
+struct Recorder
+{
+    struct Burst
+    {
+        uint16_t             address;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<Burst> bursts;
+    size_t             failAt = SIZE_MAX;
+
+    bool operator()(uint16_t address, const uint8_t* data, size_t count)
+    {
+        if (bursts.size() == failAt)
+        {
+            failAt = SIZE_MAX;
+            return false;
+        }
+        bursts.push_back({address, std::vector<uint8_t>(data, data + count)});
+        return true;
+    }
+};
+
+TEST(RegisterMap, StartsDirty)
+{
+    RegisterMap<4> map(0x10);
+    Recorder       recorder;
+
+    EXPECT_TRUE(map.IsAnyDirty());
+    EXPECT_TRUE(map.Flush(std::ref(recorder)));
+    ASSERT_EQ(1, recorder.bursts.size());
+    EXPECT_EQ(0x10, recorder.bursts[0].address);
+    EXPECT_EQ(std::vector<uint8_t>({0, 0, 0, 0}), recorder.bursts[0].data);
+    EXPECT_FALSE(map.IsAnyDirty());
+}
+
+TEST(RegisterMap, OnlyChangesAreDirty)
+{
+    RegisterMap<4> map(0x10);
+    map.Flush([](uint16_t, const uint8_t*, size_t) { return true; });
+
+    EXPECT_FALSE(map.Set(0x11, 0x00));
+    EXPECT_FALSE(map.IsAnyDirty());
+
+    EXPECT_TRUE(map.Set(0x11, 0x42));
+    EXPECT_TRUE(map.IsDirty(0x11));
+    EXPECT_FALSE(map.IsDirty(0x10));
+    EXPECT_EQ(0x42, map.Get(0x11));
+
+    // Setting it back doesn't clean it, the device holds neither value yet.
+    EXPECT_TRUE(map.Set(0x11, 0x00));
+    EXPECT_TRUE(map.IsDirty(0x11));
+}
+
+TEST(RegisterMap, Modify)
+{
+    RegisterMap<1> map;
+    map.Set(0, 0xF0);
+
+    EXPECT_TRUE(map.Modify(0, 0x18, 0xFF));
+    EXPECT_EQ(0xF8, map.Get(0));
+    EXPECT_FALSE(map.Modify(0, 0x18, 0x18));
+}
+
+TEST(RegisterMap, MergesContiguousRegisters)
+{
+    RegisterMap<8> map;
+    map.Flush([](uint16_t, const uint8_t*, size_t) { return true; });
+
+    map.Set(1, 1);
+    map.Set(2, 2);
+    map.Set(3, 3);
+    map.Set(6, 6);
+
+    Recorder recorder;
+    EXPECT_TRUE(map.Flush(std::ref(recorder)));
+    ASSERT_EQ(2, recorder.bursts.size());
+    EXPECT_EQ(1, recorder.bursts[0].address);
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), recorder.bursts[0].data);
+    EXPECT_EQ(6, recorder.bursts[1].address);
+    EXPECT_EQ(std::vector<uint8_t>({6}), recorder.bursts[1].data);
+}
+
+TEST(RegisterMap, BurstsDontCrossPages)
+{
+    RegisterMap<29> map(0x08);
+    Recorder        recorder;
+
+    EXPECT_TRUE(map.Flush(std::ref(recorder), 8));
+    ASSERT_EQ(4, recorder.bursts.size());
+    EXPECT_EQ(0x08, recorder.bursts[0].address);
+    EXPECT_EQ(0x10, recorder.bursts[1].address);
+    EXPECT_EQ(0x18, recorder.bursts[2].address);
+    EXPECT_EQ(0x20, recorder.bursts[3].address);
+    EXPECT_EQ(8, recorder.bursts[0].data.size());
+    EXPECT_EQ(5, recorder.bursts[3].data.size());
+}
+
+TEST(RegisterMap, OneAtATime)
+{
+    RegisterMap<3> map;
+    Recorder       recorder;
+
+    EXPECT_TRUE(map.Flush(std::ref(recorder), 1));
+    EXPECT_EQ(3, recorder.bursts.size());
+}
+
+TEST(RegisterMap, ReservedAreNeverWritten)
+{
+    RegisterMap<6> map(0x0B);
+    map.Reserve(0x10);
+    Recorder recorder;
+
+    EXPECT_FALSE(map.Set(0x10, 0xAA));
+    EXPECT_FALSE(map.IsDirty(0x10));
+
+    EXPECT_TRUE(map.Flush(std::ref(recorder)));
+    ASSERT_EQ(1, recorder.bursts.size());
+    EXPECT_EQ(0x0B, recorder.bursts[0].address);
+    EXPECT_EQ(5, recorder.bursts[0].data.size());
+
+    map.MarkAllDirty();
+    EXPECT_FALSE(map.IsDirty(0x10));
+    map.MarkDirty(0x0F, 2);
+    EXPECT_FALSE(map.IsDirty(0x10));
+}
+
+TEST(RegisterMap, FailureKeepsRegistersDirty)
+{
+    RegisterMap<16> map;
+    map.Flush([](uint16_t, const uint8_t*, size_t) { return true; });
+    map.Set(0, 1);
+    map.Set(8, 2);
+
+    Recorder recorder;
+    recorder.failAt = 1;
+    EXPECT_FALSE(map.Flush(std::ref(recorder), 8));
+    EXPECT_FALSE(map.IsDirty(0));
+    EXPECT_TRUE(map.IsDirty(8));
+
+    EXPECT_TRUE(map.Flush(std::ref(recorder), 8));
+    ASSERT_EQ(2, recorder.bursts.size());
+    EXPECT_EQ(8, recorder.bursts[1].address);
+    EXPECT_FALSE(map.IsAnyDirty());
+}
+
+TEST(RegisterMap, MarkDirty)
+{
+    RegisterMap<4> map;
+    map.Flush([](uint16_t, const uint8_t*, size_t) { return true; });
+
+    map.MarkDirty(2, 10);
+    EXPECT_FALSE(map.IsDirty(1));
+    EXPECT_TRUE(map.IsDirty(2));
+    EXPECT_TRUE(map.IsDirty(3));
+}
@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests for cep::RingBuffer.
+ *
+ * @date 2021-11-10
+ *
+ ******************************************************************************
+ */
+#include "defines/ringBuffer.hpp"
+#include <gtest/gtest.h>
+
+using namespace cep;
+
+TEST(RingBuffer, Empty)
+{
+    RingBuffer<int, 4> rb;
+    int                v = 0;
+
+    EXPECT_TRUE(rb.Empty());
+    EXPECT_EQ(0, rb.Size());
+    EXPECT_EQ(4, rb.Free());
+    EXPECT_FALSE(rb.Pop(v));
+}
+
+TEST(RingBuffer, PushPopInOrder)
+{
+    RingBuffer<int, 4> rb;
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(rb.Push(i));
+    }
+    EXPECT_TRUE(rb.Full());
+    EXPECT_FALSE(rb.Push(4)) << "Pushed into a full buffer";
+
+    for (int i = 0; i < 4; i++)
+    {
+        int v = -1;
+        EXPECT_TRUE(rb.Pop(v));
+        EXPECT_EQ(i, v);
+    }
+    EXPECT_TRUE(rb.Empty());
+}
+
+TEST(RingBuffer, WrapsAround)
+{
+    RingBuffer<int, 4> rb;
+    int                v = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_TRUE(rb.Push(i));
+        EXPECT_TRUE(rb.Push(i + 1000));
+        EXPECT_TRUE(rb.Pop(v));
+        EXPECT_EQ(i, v);
+        EXPECT_TRUE(rb.Pop(v));
+        EXPECT_EQ(i + 1000, v);
+    }
+}
+
+TEST(RingBuffer, BatchCommit)
+{
+    RingBuffer<int, 8> rb;
+    rb.Push(-1);
+
+    rb.Slot(0) = 10;
+    rb.Slot(1) = 11;
+    rb.Slot(2) = 12;
+    EXPECT_EQ(1, rb.Size()) << "Uncommitted slots are visible";
+
+    rb.Commit(3);
+    EXPECT_EQ(4, rb.Size());
+
+    int v = 0;
+    for (int expected : {-1, 10, 11, 12})
+    {
+        EXPECT_TRUE(rb.Pop(v));
+        EXPECT_EQ(expected, v);
+    }
+}
+
+TEST(RingBuffer, Clear)
+{
+    RingBuffer<int, 4> rb;
+    rb.Push(1);
+    rb.Push(2);
+    rb.Clear();
+
+    EXPECT_TRUE(rb.Empty());
+    EXPECT_TRUE(rb.Push(3));
+    EXPECT_EQ(3, rb.Front());
+}
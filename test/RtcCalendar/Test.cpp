@@ -0,0 +1,161 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the conversions between dates and Unix epochs.
+ *
+ * @date 2021-11-30
+ *
+ ******************************************************************************
+ */
+#include "drivers/rtcCalendar.hpp"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+using namespace CEP_RTC;
+
+// Must all be evaluated at compile time.
+static_assert(DaysFromCivil(1970, 1, 1) == 0);
+static_assert(DaysFromCivil(1969, 12, 31) == -1);
+static_assert(ToEpoch({2038, 1, 19, 3, 14, 8}) == 2147483648);
+static_assert(ToEpochMs({2021, 11, 30, 12, 0, 0, 500}) == 1638273600500);
+static_assert(FromEpoch(-1).year == 1969);
+static_assert(FromEpochMs(-1).milliseconds == 999);
+static_assert(WeekdayFromDays(0) == 4);
+
+TEST(RtcCalendar, KnownDates)
+{
+    EXPECT_EQ(0, ToEpoch({1970, 1, 1, 0, 0, 0}));
+    EXPECT_EQ(951782400, ToEpoch({2000, 2, 29, 0, 0, 0}));
+    EXPECT_EQ(1638278712, ToEpoch({2021, 11, 30, 13, 25, 12}));
+    EXPECT_EQ(4102444800, ToEpoch({2100, 1, 1, 0, 0, 0}));
+    EXPECT_EQ(253402300799, ToEpoch({9999, 12, 31, 23, 59, 59}));
+    EXPECT_EQ(-62167219200, ToEpoch({0, 1, 1, 0, 0, 0}));
+
+    CivilTime time = FromEpoch(-1);
+    EXPECT_EQ(1969, time.year);
+    EXPECT_EQ(12, time.month);
+    EXPECT_EQ(31, time.day);
+    EXPECT_EQ(23, time.hours);
+    EXPECT_EQ(59, time.minutes);
+    EXPECT_EQ(59, time.seconds);
+
+    // 2021-11-30 was a Tuesday, 2000-01-01 a Saturday.
+    EXPECT_EQ(2, WeekdayFromDays(DaysFromCivil(2021, 11, 30)));
+    EXPECT_EQ(6, WeekdayFromDays(DaysFromCivil(2000, 1, 1)));
+    EXPECT_EQ(3, WeekdayFromDays(DaysFromCivil(1969, 12, 31)));
+}
+
+/**
+ * Every day from 0000-01-01 to 9999-12-31, against a date moved forward one day at a time.
+ */
+TEST(RtcCalendar, EveryDay)
+{
+    CivilTime expected = {0, 1, 1};
+    int64_t   days     = DaysFromCivil(0, 1, 1);
+    uint8_t   weekday  = WeekdayFromDays(days);
+    for (; expected.year < 10000; days++)
+    {
+        ASSERT_EQ(days, DaysFromCivil(expected.year, expected.month, expected.day));
+        CivilTime civil = CivilFromDays(days);
+        ASSERT_EQ(expected.year, civil.year);
+        ASSERT_EQ(expected.month, civil.month);
+        ASSERT_EQ(expected.day, civil.day);
+        ASSERT_EQ(weekday, WeekdayFromDays(days));
+
+        weekday = (weekday % 7) + 1;
+        if (++expected.day > DaysInMonth(expected.year, expected.month))
+        {
+            expected.day = 1;
+            if (++expected.month > 12)
+            {
+                expected.month = 1;
+                expected.year++;
+            }
+        }
+    }
+}
+
+/**
+ * Against the host's C library, every 7919 seconds (a prime, to hit every time of the day) from
+ * 1900 to 2200, which covers 2038 and the epochs before 1970.
+ */
+TEST(RtcCalendar, MatchesHost)
+{
+    constexpr int64_t FIRST = -2208988800;
+    constexpr int64_t LAST  = 7258118400;
+    for (int64_t epoch = FIRST; epoch < LAST; epoch += 7919)
+    {
+        time_t    hostEpoch = (time_t)epoch;
+        struct tm host      = {};
+        ASSERT_NE(nullptr, gmtime_r(&hostEpoch, &host));
+
+        CivilTime time = FromEpoch(epoch);
+        ASSERT_EQ(host.tm_year + 1900, time.year) << epoch;
+        ASSERT_EQ(host.tm_mon + 1, time.month) << epoch;
+        ASSERT_EQ(host.tm_mday, time.day) << epoch;
+        ASSERT_EQ(host.tm_hour, time.hours) << epoch;
+        ASSERT_EQ(host.tm_min, time.minutes) << epoch;
+        ASSERT_EQ(host.tm_sec, time.seconds) << epoch;
+        ASSERT_EQ(epoch, ToEpoch(time));
+    }
+}
+
+TEST(RtcCalendar, Milliseconds)
+{
+    for (int64_t epochMs : {0LL, 1LL, 999LL, 1000LL, -1LL, -999LL, -1000LL, -1001LL,
+                            1638278712345LL, 2147483648001LL, -2208988800500LL})
+    {
+        CivilTime time = FromEpochMs(epochMs);
+        EXPECT_LT(time.milliseconds, 1000) << epochMs;
+        EXPECT_EQ(epochMs, ToEpochMs(time)) << epochMs;
+        EXPECT_EQ(time.milliseconds, ((epochMs % 1000) + 1000) % 1000) << epochMs;
+    }
+
+    CivilTime time = FromEpochMs(-1);
+    EXPECT_EQ(1969, time.year);
+    EXPECT_EQ(59, time.seconds);
+    EXPECT_EQ(999, time.milliseconds);
+}
+
+/*************************************************************************************************/
+/* Benchmark ----------------------------------------------------------------------------------- */
+/**
+ * Compares the conversions with the host's gmtime_r and timegm, for a record every 10 seconds.
+ *
+ * Only prints the results, the timings depend too much on the host to be asserted. Disabled so
+ * that it doesn't slow down the tests, run it with --gtest_also_run_disabled_tests.
+ */
+TEST(RtcCalendar, DISABLED_Benchmark)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t  CALLS = 1000000;
+    constexpr int64_t FIRST = 1638278712;
+
+    volatile int64_t sink  = 0;
+    auto             start = Clock::now();
+    for (size_t i = 0; i < CALLS; i++)
+    {
+        time_t    epoch = (time_t)(FIRST + ((int64_t)i * 10));
+        struct tm tim   = {};
+        gmtime_r(&epoch, &tim);
+        sink = timegm(&tim);
+    }
+    auto hostTime = Clock::now() - start;
+
+    start = Clock::now();
+    for (size_t i = 0; i < CALLS; i++)
+    {
+        sink = ToEpoch(FromEpoch(FIRST + ((int64_t)i * 10)));
+    }
+    auto calendarTime = Clock::now() - start;
+    (void)sink;
+
+    auto perCall = [](Clock::duration d)
+    { return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / CALLS; };
+    std::printf("[ BENCHMARK] gmtime_r + timegm:   %.1f ns/round-trip\n", perCall(hostTime));
+    std::printf("[ BENCHMARK] FromEpoch + ToEpoch: %.1f ns/round-trip\n", perCall(calendarTime));
+}
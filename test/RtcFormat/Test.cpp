@@ -0,0 +1,140 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the text and binary encodings of dates and times.
+ *
+ * @date 2021-12-01
+ *
+ ******************************************************************************
+ */
+#include "drivers/rtcFormat.hpp"
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace CEP_RTC;
+
+static_assert(DIGIT_PAIRS[0] == '0' && DIGIT_PAIRS[1] == '0');
+static_assert(DIGIT_PAIRS[2 * 42] == '4' && DIGIT_PAIRS[(2 * 42) + 1] == '2');
+static_assert(DIGIT_PAIRS[198] == '9' && DIGIT_PAIRS[199] == '9');
+static_assert(CompactTime::Make({9999, 12, 31, 23, 59, 59, 999}).value < (1ULL << 50));
+
+TEST(RtcFormat, Text)
+{
+    const CivilTime time = {2021, 12, 1, 9, 5, 7, 42};
+    char            buf[32];
+
+    EXPECT_EQ(TIME_LENGTH, FormatTime(time, buf, sizeof(buf)));
+    EXPECT_STREQ("09:05:07", buf);
+    EXPECT_EQ(DATE_LENGTH, FormatDate(time, buf, sizeof(buf)));
+    EXPECT_STREQ("21-12-01", buf);
+    EXPECT_EQ(ISO8601_MS_LENGTH, FormatIso8601(time, buf, sizeof(buf)));
+    EXPECT_STREQ("2021-12-01T09:05:07.042Z", buf);
+    EXPECT_EQ(ISO8601_LENGTH, FormatIso8601(time, buf, sizeof(buf), false));
+    EXPECT_STREQ("2021-12-01T09:05:07Z", buf);
+
+    EXPECT_EQ(ISO8601_MS_LENGTH, FormatIso8601({987, 1, 31, 23, 59, 59, 999}, buf, sizeof(buf)));
+    EXPECT_STREQ("0987-01-31T23:59:59.999Z", buf);
+}
+
+/**
+ * A thousand dates and times, covering every value of every field, against snprintf.
+ */
+TEST(RtcFormat, MatchesPrintf)
+{
+    // Room for the widest values of the fields' types, so that snprintf can't truncate.
+    char expected[64];
+    char buf[32];
+    for (uint16_t i = 0; i < 1000; i++)
+    {
+        CivilTime time = {(uint16_t)(2000 + i),
+                          (uint8_t)((i % 12) + 1),
+                          (uint8_t)((i % 31) + 1),
+                          (uint8_t)(i % 24),
+                          (uint8_t)(i % 60),
+                          (uint8_t)((i * 7) % 60),
+                          i};
+        std::snprintf(expected,
+                      sizeof(expected),
+                      "%04i-%02i-%02iT%02i:%02i:%02i.%03iZ",
+                      time.year,
+                      time.month,
+                      time.day,
+                      time.hours,
+                      time.minutes,
+                      time.seconds,
+                      time.milliseconds);
+        ASSERT_EQ(ISO8601_MS_LENGTH, FormatIso8601(time, buf, sizeof(buf)));
+        ASSERT_STREQ(expected, buf);
+    }
+}
+
+TEST(RtcFormat, BufferTooSmall)
+{
+    const CivilTime time = {2021, 12, 1, 9, 5, 7, 42};
+    char            buf[32];
+
+    // The null must fit as well.
+    std::memset(buf, 'x', sizeof(buf));
+    EXPECT_EQ(0, FormatTime(time, buf, TIME_LENGTH));
+    EXPECT_EQ('\0', buf[0]);
+    EXPECT_EQ('x', buf[1]);
+    EXPECT_EQ(TIME_LENGTH, FormatTime(time, buf, TIME_LENGTH + 1));
+
+    std::memset(buf, 'x', sizeof(buf));
+    EXPECT_EQ(0, FormatDate(time, buf, DATE_LENGTH));
+    EXPECT_EQ('\0', buf[0]);
+    EXPECT_EQ(0, FormatIso8601(time, buf, ISO8601_MS_LENGTH));
+    EXPECT_EQ(0, FormatIso8601(time, buf, ISO8601_LENGTH, false));
+    EXPECT_EQ('x', buf[1]);
+    EXPECT_EQ(ISO8601_LENGTH, FormatIso8601(time, buf, ISO8601_LENGTH + 1, false));
+    EXPECT_STREQ("2021-12-01T09:05:07Z", buf);
+
+    // Nothing at all is written without room for the null.
+    buf[0] = 'x';
+    EXPECT_EQ(0, FormatTime(time, buf, 0));
+    EXPECT_EQ('x', buf[0]);
+}
+
+TEST(RtcFormat, Names)
+{
+    EXPECT_STREQ("MON", WeekdayName(1));
+    EXPECT_STREQ("SUN", WeekdayName(7));
+    EXPECT_STREQ("ERR", WeekdayName(0));
+    EXPECT_STREQ("ERR", WeekdayName(8));
+
+    EXPECT_STREQ("JAN", MonthName(1));
+    EXPECT_STREQ("OCT", MonthName(10));
+    EXPECT_STREQ("DEC", MonthName(12));
+    EXPECT_STREQ("ERR", MonthName(0));
+    EXPECT_STREQ("ERR", MonthName(13));
+}
+
+TEST(RtcFormat, Compact)
+{
+    const CivilTime time    = {2021, 12, 1, 9, 5, 7, 42};
+    CompactTime     compact = CompactTime::Make(time);
+
+    CivilTime decoded = compact.ToCivil();
+    EXPECT_EQ(time.year, decoded.year);
+    EXPECT_EQ(time.month, decoded.month);
+    EXPECT_EQ(time.day, decoded.day);
+    EXPECT_EQ(time.hours, decoded.hours);
+    EXPECT_EQ(time.minutes, decoded.minutes);
+    EXPECT_EQ(time.seconds, decoded.seconds);
+    EXPECT_EQ(time.milliseconds, decoded.milliseconds);
+
+    uint8_t bytes[CompactTime::SIZE + 1] = {};
+    EXPECT_EQ(0, compact.EncodeTo(bytes, CompactTime::SIZE - 1));
+    EXPECT_EQ(CompactTime::SIZE, compact.EncodeTo(bytes, sizeof(bytes)));
+    EXPECT_EQ(0, bytes[CompactTime::SIZE]);
+    EXPECT_EQ(compact, CompactTime::DecodeFrom(bytes));
+
+    // The packed values sort like the times, down to the millisecond.
+    EXPECT_LT(compact, CompactTime::Make({2021, 12, 1, 9, 5, 7, 43}));
+    EXPECT_LT(compact, CompactTime::Make({2021, 12, 1, 9, 5, 8, 0}));
+    EXPECT_LT(compact, CompactTime::Make({2022, 1, 1, 0, 0, 0, 0}));
+    EXPECT_LT(CompactTime::Make({2021, 11, 30, 23, 59, 59, 999}), compact);
+}
@@ -0,0 +1,46 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests for the SPI clock divider selection.
+ *
+ * @date 2021-11-16
+ *
+ ******************************************************************************
+ */
+#include "drivers/spiClock.hpp"
+#include <gtest/gtest.h>
+
+using namespace CEP_SPI;
+
+TEST(SpiClock, ExactFit)
+{
+    // 80MHz / 2 = 40MHz.
+    EXPECT_EQ(0, GetBaudRateDivider(80000000, 40000000));
+    // 80MHz / 8 = 10MHz.
+    EXPECT_EQ(2, GetBaudRateDivider(80000000, 10000000));
+}
+
+TEST(SpiClock, NeverFasterThanTheDevice)
+{
+    // 84MHz / 256 = 328kHz, the slowest clock available.
+    for (uint32_t maxClock = 330000; maxClock <= 50000000; maxClock += 99991)
+    {
+        uint32_t br = GetBaudRateDivider(84000000, maxClock);
+        EXPECT_LE(GetSpiClock(84000000, br), maxClock);
+        // The next faster setting would be too fast.
+        if (br != 0)
+        {
+            EXPECT_GT(GetSpiClock(84000000, br - 1), maxClock);
+        }
+    }
+}
+
+TEST(SpiClock, Limits)
+{
+    // Faster than the peripheral can go.
+    EXPECT_EQ(0, GetBaudRateDivider(16000000, 100000000));
+    // Slower than the largest divider.
+    EXPECT_EQ(MAX_BAUD_RATE_DIVIDER, GetBaudRateDivider(80000000, 1000));
+    EXPECT_EQ(MAX_BAUD_RATE_DIVIDER, GetBaudRateDivider(80000000, 0));
+}
@@ -0,0 +1,274 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests and microbenchmark of the allocation-free SPI transfers.
+ *
+ * @date 2021-11-17
+ *
+ ******************************************************************************
+ */
+#include "drivers/spiTransfer.hpp"
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace CEP_SPI;
+
+/*************************************************************************************************/
+/* Allocation counting ------------------------------------------------------------------------- */
+static size_t s_allocations = 0;
+
+void* operator new(size_t size)
+{
+    s_allocations++;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+/*************************************************************************************************/
+/* Mocked peripheral --------------------------------------------------------------------------- */
+/**
+ * Records every byte put on MOSI and answers on MISO with an incrementing counter.
+ */
+struct MockPort
+{
+    std::array<uint8_t, 256> mosi     = {};
+    size_t                   sent     = 0;
+    uint8_t                  miso     = 0;
+    size_t                   calls    = 0;
+    bool                     failRead = false;
+
+    void Clock(uint8_t out, uint8_t* in)
+    {
+        mosi[sent++ % mosi.size()] = out;
+        uint8_t next               = miso++;
+        if (in != nullptr)
+        {
+            *in = next;
+        }
+    }
+
+    bool Write(const uint8_t* data, size_t len)
+    {
+        calls++;
+        for (size_t i = 0; i < len; i++)
+        {
+            Clock(data[i], nullptr);
+        }
+        return true;
+    }
+
+    bool Read(uint8_t* data, size_t len)
+    {
+        calls++;
+        for (size_t i = 0; i < len; i++)
+        {
+            Clock(data[i], &data[i]);
+        }
+        return !failRead;
+    }
+
+    bool Exchange(const uint8_t* tx, uint8_t* rx, size_t len)
+    {
+        calls++;
+        for (size_t i = 0; i < len; i++)
+        {
+            Clock(tx[i], &rx[i]);
+        }
+        return true;
+    }
+};
+
+/*************************************************************************************************/
+/* Tests --------------------------------------------------------------------------------------- */
+TEST(SpiTransfer, WriteThenRead)
+{
+    MockPort                     port;
+    const std::array<uint8_t, 2> cmd = {0x03, 0x10};
+    std::array<uint8_t, 4>       rx  = {};
+
+    ASSERT_TRUE(WriteThenRead(port, cmd, rx));
+
+    ASSERT_EQ(6, port.sent);
+    EXPECT_EQ(0x03, port.mosi[0]);
+    EXPECT_EQ(0x10, port.mosi[1]);
+    // The read phase sends the dummy byte.
+    for (size_t i = 2; i < 6; i++)
+    {
+        EXPECT_EQ(DUMMY_BYTE, port.mosi[i]);
+    }
+    // The bytes clocked in during the write phase are discarded.
+    EXPECT_EQ((std::array<uint8_t, 4> {2, 3, 4, 5}), rx);
+}
+
+TEST(SpiTransfer, ReadOnlyWithCustomDummy)
+{
+    MockPort port;
+    uint8_t  rx[3] = {};
+
+    ASSERT_TRUE(WriteThenRead(port, {}, rx, 0x00));
+
+    EXPECT_EQ(1, port.calls);
+    EXPECT_EQ(3, port.sent);
+    EXPECT_EQ(0x00, port.mosi[0]);
+    EXPECT_EQ(2, rx[2]);
+}
+
+TEST(SpiTransfer, WriteOnly)
+{
+    MockPort      port;
+    const uint8_t tx[2] = {0xAA, 0x55};
+
+    ASSERT_TRUE(WriteThenRead(port, tx, {}));
+
+    EXPECT_EQ(1, port.calls);
+    EXPECT_EQ(2, port.sent);
+}
+
+TEST(SpiTransfer, ExchangeLongerWrite)
+{
+    MockPort      port;
+    const uint8_t tx[4] = {1, 2, 3, 4};
+    uint8_t       rx[2] = {};
+
+    ASSERT_TRUE(Exchange(port, tx, rx));
+
+    EXPECT_EQ(4, port.sent);
+    EXPECT_EQ(4, port.mosi[3]);
+    EXPECT_EQ(0, rx[0]);
+    EXPECT_EQ(1, rx[1]);
+}
+
+TEST(SpiTransfer, ExchangeLongerRead)
+{
+    MockPort      port;
+    const uint8_t tx[1] = {0x42};
+    uint8_t       rx[3] = {};
+
+    ASSERT_TRUE(Exchange(port, tx, rx, 0xA5));
+
+    EXPECT_EQ(3, port.sent);
+    EXPECT_EQ(0x42, port.mosi[0]);
+    EXPECT_EQ(0xA5, port.mosi[1]);
+    EXPECT_EQ(0xA5, port.mosi[2]);
+    EXPECT_EQ(0, rx[0]);
+    EXPECT_EQ(2, rx[2]);
+}
+
+TEST(SpiTransfer, ErrorsArePropagated)
+{
+    MockPort port;
+    port.failRead = true;
+    uint8_t rx[2] = {};
+
+    EXPECT_FALSE(WriteThenRead(port, {}, rx));
+    EXPECT_FALSE(Exchange(port, {}, rx));
+}
+
+TEST(SpiTransfer, SpanViews)
+{
+    std::vector<uint8_t> v = {1, 2, 3, 4, 5};
+    cep::Span<uint8_t>   s = v;
+
+    EXPECT_EQ(5, s.size());
+    EXPECT_EQ(3, s.subspan(2).size());
+    EXPECT_EQ(2, s.subspan(3, 10).size());
+    EXPECT_EQ(4, s.subspan(3)[0]);
+    EXPECT_EQ(2, s.first(2).size());
+
+    cep::Span<const uint8_t> c = s;
+    EXPECT_EQ(v.data(), c.data());
+    EXPECT_TRUE(cep::Span<const uint8_t>().empty());
+}
+
+TEST(SpiTransfer, NoAllocations)
+{
+    MockPort                     port;
+    const std::array<uint8_t, 2> cmd = {0x0B, 0x00};
+    std::array<uint8_t, 8>       rx  = {};
+
+    size_t before = s_allocations;
+    for (size_t i = 0; i < 100; i++)
+    {
+        WriteThenRead(port, cmd, rx);
+        Exchange(port, cmd, rx);
+    }
+    EXPECT_EQ(before, s_allocations);
+}
+
+/*************************************************************************************************/
+/* Benchmark ----------------------------------------------------------------------------------- */
+/**
+ * Compares a 2-byte command followed by an 8-byte read done the way the vector API forces it
+ * (padded transmit vector, resized receive vector, copy out of the response) with the span API.
+ *
+ * Only prints the results, the timings depend too much on the host to be asserted. Disabled so
+ * that it doesn't slow down the tests, run it with --gtest_also_run_disabled_tests.
+ */
+TEST(SpiTransfer, DISABLED_Benchmark)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t CALLS = 200000;
+
+    MockPort                     port;
+    const std::array<uint8_t, 2> cmd  = {0x0B, 0x00};
+    std::array<uint8_t, 8>       out  = {};
+    volatile uint8_t             sink = 0;
+
+    size_t allocations = s_allocations;
+    auto   start       = Clock::now();
+    for (size_t i = 0; i < CALLS; i++)
+    {
+        std::vector<uint8_t> tx(cmd.size() + out.size(), DUMMY_BYTE);
+        std::copy(cmd.begin(), cmd.end(), tx.begin());
+        std::vector<uint8_t> rx;
+        rx.resize(tx.size());
+        port.Exchange(tx.data(), rx.data(), tx.size());
+        std::copy(rx.begin() + cmd.size(), rx.end(), out.begin());
+        sink = out[0];
+    }
+    auto   vectorTime        = Clock::now() - start;
+    size_t vectorAllocations = s_allocations - allocations;
+
+    allocations = s_allocations;
+    start       = Clock::now();
+    for (size_t i = 0; i < CALLS; i++)
+    {
+        WriteThenRead(port, cmd, out);
+        sink = out[0];
+    }
+    auto   spanTime        = Clock::now() - start;
+    size_t spanAllocations = s_allocations - allocations;
+    (void)sink;
+
+    auto perCall = [](Clock::duration d)
+    { return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / CALLS; };
+    std::printf("[ BENCHMARK] vector: %.1f ns/call, %.2f allocations/call\n",
+                perCall(vectorTime),
+                (double)vectorAllocations / CALLS);
+    std::printf("[ BENCHMARK] span:   %.1f ns/call, %.2f allocations/call\n",
+                perCall(spanTime),
+                (double)spanAllocations / CALLS);
+
+    EXPECT_EQ(0, spanAllocations);
+}
@@ -0,0 +1,111 @@
+/**
+ ******************************************************************************
+ * @file    Test.cpp
+ * @author  Samuel Martel
+ * @brief   Tests of the logger's cached RTC timestamps.
+ *
+ * @date 2021-11-29
+ *
+ ******************************************************************************
+ */
+#include "services/timestampCache.hpp"
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace CEP_RTC;
+
+TEST(TimestampCache, DaysInMonth)
+{
+    EXPECT_EQ(31, DaysInMonth(2021, 1));
+    EXPECT_EQ(28, DaysInMonth(2021, 2));
+    EXPECT_EQ(29, DaysInMonth(2024, 2));
+    EXPECT_EQ(28, DaysInMonth(2100, 2));
+    EXPECT_EQ(29, DaysInMonth(2000, 2));
+    EXPECT_EQ(30, DaysInMonth(2021, 11));
+    EXPECT_EQ(31, DaysInMonth(2021, 12));
+}
+
+TEST(TimestampCache, AddSeconds)
+{
+    CivilTime time = {2021, 11, 29, 13, 45, 12};
+    AddSeconds(time, 0);
+    EXPECT_EQ(12, time.seconds);
+
+    AddSeconds(time, 48);
+    EXPECT_EQ(0, time.seconds);
+    EXPECT_EQ(46, time.minutes);
+
+    // To the last second of the year, then past it.
+    time = {2021, 12, 31, 23, 59, 58};
+    AddSeconds(time, 1);
+    EXPECT_EQ(59, time.seconds);
+    EXPECT_EQ(31, time.day);
+    AddSeconds(time, 1);
+    EXPECT_EQ(2022, time.year);
+    EXPECT_EQ(1, time.month);
+    EXPECT_EQ(1, time.day);
+    EXPECT_EQ(0, time.hours);
+    EXPECT_EQ(0, time.minutes);
+    EXPECT_EQ(0, time.seconds);
+
+    // Leap day.
+    time = {2024, 2, 28, 12, 0, 0};
+    AddSeconds(time, 86400);
+    EXPECT_EQ(2, time.month);
+    EXPECT_EQ(29, time.day);
+    AddSeconds(time, 86400);
+    EXPECT_EQ(3, time.month);
+    EXPECT_EQ(1, time.day);
+    EXPECT_EQ(12, time.hours);
+
+    // A few days at once.
+    time = {2021, 11, 29, 1, 2, 3};
+    AddSeconds(time, (3 * 86400) + 3600);
+    EXPECT_EQ(12, time.month);
+    EXPECT_EQ(2, time.day);
+    EXPECT_EQ(2, time.hours);
+}
+
+TEST(TimestampCache, Format)
+{
+    TimestampCache cache;
+    EXPECT_TRUE(cache.NeedsSync(0));
+
+    cache.Sync({2021, 11, 29, 13, 45, 12, 250}, 100000);
+    EXPECT_FALSE(cache.NeedsSync(100000));
+    EXPECT_STREQ("21-11-29 13:45:12.250", cache.Format(100000));
+    EXPECT_STREQ("21-11-29 13:45:12.999", cache.Format(100749));
+    EXPECT_STREQ("21-11-29 13:45:13.000", cache.Format(100750));
+    EXPECT_STREQ("21-11-29 13:45:13.007", cache.Format(100757));
+    EXPECT_EQ(TimestampCache::LENGTH, std::string(cache.Format(100757)).size());
+
+    // Still formats without a sync, the time just drifts with the tick.
+    EXPECT_TRUE(cache.NeedsSync(101000));
+    EXPECT_STREQ("21-11-29 13:45:14.750", cache.Format(102500));
+
+    cache.Sync({2021, 12, 31, 23, 59, 59, 900}, 200000);
+    EXPECT_STREQ("21-12-31 23:59:59.900", cache.Format(200000));
+    EXPECT_STREQ("22-01-01 00:00:00.000", cache.Format(200100));
+}
+
+TEST(TimestampCache, TickWrapsAround)
+{
+    TimestampCache cache;
+    cache.Sync({2021, 11, 29, 8, 0, 0}, 0xFFFFFF00);
+    EXPECT_FALSE(cache.NeedsSync(0x00000010));
+    EXPECT_STREQ("21-11-29 08:00:00.272", cache.Format(0x00000010));
+}
+
+TEST(TimestampCache, Invalidate)
+{
+    TimestampCache cache;
+    cache.Sync({2021, 11, 29, 8, 0, 0}, 0);
+    EXPECT_FALSE(cache.NeedsSync(10));
+    cache.Invalidate();
+    EXPECT_TRUE(cache.NeedsSync(10));
+
+    // The time was set in between.
+    cache.Sync({2021, 11, 29, 9, 30, 0, 500}, 20);
+    EXPECT_STREQ("21-11-29 09:30:00.510", cache.Format(30));
+}